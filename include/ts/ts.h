@@ -1981,6 +1981,24 @@ tsapi struct sockaddr const *TSHostLookupResultAddrGet(TSHostLookupResult lookup
  */
 tsapi TSAction TSCacheRead(TSCont contp, TSCacheKey key);
 
+/**
+    Does a TSCacheRead for each of the nkeys keys in keys, calling back
+    contps[i] for keys[i] as TSCacheRead would. The keys are looked up
+    together, one cache volume lock for all of those in the same volume,
+    which is cheaper than as many separate calls.
+
+    All of the continuations must share a mutex and the keys must have
+    the same data type. The action for each key is stored in actions,
+    which may be null.
+
+    @param contps continuations to be called back, one per key.
+    @param keys cache keys of the objects to be read.
+    @param actions something allowing the user to cancel each read.
+    @param nkeys number of keys.
+
+ */
+tsapi void TSCacheReadBatch(TSCont *contps, TSCacheKey *keys, TSAction *actions, int nkeys);
+
 /**
     Asks the Traffic Server cache if contp can start writing the
     object (corresponding to key) to the cache. If the object
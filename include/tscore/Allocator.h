@@ -109,6 +109,13 @@ public:
     ink_freelist_madvise_init(&this->fl, name, element_size, chunk_size, alignment, advice);
   }
 
+  /** Back the memory allocated from now on with hugepages of @a page_size bytes. */
+  void
+  use_hugepages(uint32_t page_size)
+  {
+    ink_freelist_hugepage_init(this->fl, page_size);
+  }
+
   // Dummies
   void
   destroy_if_enabled(void *)
@@ -27,3 +27,12 @@ bool ats_hugepage_enabled();
 void ats_hugepage_init(int);
 void *ats_alloc_hugepage(size_t);
 bool ats_free_hugepage(void *, size_t);
+
+/** Allocate @a s bytes backed by hugepages of @a page_size bytes (e.g. 2MB or 1GB), whether or not
+    hugepages are enabled for the allocators. When there are none of that size left this falls back
+    to the system's default hugepage size, then to transparent hugepages. @a actual is set to the
+    size of the hugepages used, 0 for transparent hugepages, and must be passed to
+    ats_free_hugepage_sized(). Returns nullptr only if no memory could be mapped at all.
+ */
+void *ats_alloc_hugepage_sized(size_t s, size_t page_size, size_t *actual);
+bool ats_free_hugepage_sized(void *ptr, size_t s, size_t actual);
@@ -173,6 +173,7 @@ struct _InkFreeList {
   uint32_t type_size, chunk_size, used, allocated, alignment;
   uint32_t allocated_base, used_base;
   int advice;
+  uint32_t hugepage_size; // hugepages for this freelist only, see ink_freelist_hugepage_init()
 };
 
 typedef struct ink_freelist_ops InkFreeListOps;
@@ -190,6 +191,11 @@ InkFreeList *ink_freelist_create(const char *name, uint32_t type_size, uint32_t
 void ink_freelist_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32_t chunk_size, uint32_t alignment);
 void ink_freelist_madvise_init(InkFreeList **fl, const char *name, uint32_t type_size, uint32_t chunk_size, uint32_t alignment,
                                int advice);
+/*
+ * back the chunks allocated from now on with hugepages of page_size bytes, whether or not hugepages are
+ * enabled for every freelist.
+ */
+void ink_freelist_hugepage_init(InkFreeList *f, uint32_t page_size);
 void *ink_freelist_new(InkFreeList *f);
 void ink_freelist_free(InkFreeList *f, void *item);
 void ink_freelist_free_bulk(InkFreeList *f, void *head, void *tail, size_t num_item);
@@ -29,9 +29,29 @@
 
 #include "P_AIO.h"
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 #define AIO_PERIOD -HRTIME_MSECONDS(10)
-#else
+#endif
+
+#if AIO_MODE == AIO_MODE_IO_URING
+#include <sys/resource.h>
+#include <algorithm>
+#include <atomic>
+
+#define AIO_REGISTER_RETRY HRTIME_SECONDS(5)
+
+// Buffers and files the per thread rings may register. DiskHandlers pick up changes by
+// comparing aio_register_generation against the generation they last copied.
+static ink_mutex aio_register_mutex;
+static std::vector<iovec> aio_register_buffers;
+static std::vector<int> aio_register_fds;
+static std::atomic<int> aio_register_generation{0};
+// Every ring pins the buffers it registers, and the kernel charges them all to RLIMIT_MEMLOCK.
+static std::atomic<size_t> aio_pinned_bytes{0};
+static size_t aio_pinned_limit = SIZE_MAX;
+#endif
+
+#if AIO_MODE == AIO_MODE_THREAD
 
 #define MAX_DISKS_POSSIBLE 100
 
@@ -48,7 +68,7 @@ int num_filedes = 1;
 static ink_mutex insert_mutex;
 
 int thread_is_created = 0;
-#endif // AIO_MODE == AIO_MODE_NATIVE
+#endif // AIO_MODE == AIO_MODE_THREAD
 RecInt cache_config_threads_per_disk = 12;
 RecInt api_config_threads_per_disk   = 12;
 
@@ -158,14 +178,23 @@ ink_aio_init(ts::ModuleVersion v)
                      (int)AIO_STAT_KB_READ_PER_SEC, aio_stats_cb);
   RecRegisterRawStat(aio_rsb, RECT_PROCESS, "proxy.process.cache.KB_write_per_sec", RECD_FLOAT, RECP_PERSISTENT,
                      (int)AIO_STAT_KB_WRITE_PER_SEC, aio_stats_cb);
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_THREAD
   memset(&aio_reqs, 0, MAX_DISKS_POSSIBLE * sizeof(AIO_Reqs *));
   ink_mutex_init(&insert_mutex);
+#elif AIO_MODE == AIO_MODE_IO_URING
+  ink_mutex_init(&aio_register_mutex);
+  struct rlimit rl;
+  if (getrlimit(RLIMIT_MEMLOCK, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY) {
+    aio_pinned_limit = rl.rlim_cur;
+  }
 #endif
   REC_ReadConfigInteger(cache_config_threads_per_disk, "proxy.config.cache.threads_per_disk");
 #if TS_USE_LINUX_NATIVE_AIO
   Warning("Running with Linux AIO, there are known issues with this feature");
 #endif
+#if TS_USE_LINUX_IO_URING
+  Note("Running with Linux io_uring AIO");
+#endif
 }
 
 int
@@ -178,7 +207,19 @@ ink_aio_start()
   return 0;
 }
 
-#if AIO_MODE != AIO_MODE_NATIVE
+#if AIO_MODE != AIO_MODE_IO_URING
+void
+ink_aio_register_buffer(void * /* buf ATS_UNUSED */, size_t /* len ATS_UNUSED */)
+{
+}
+
+void
+ink_aio_register_fd(int /* fd ATS_UNUSED */)
+{
+}
+#endif
+
+#if AIO_MODE == AIO_MODE_THREAD
 
 static void *aio_thread_main(void *arg);
 
@@ -491,7 +532,7 @@ aio_thread_main(void *arg)
   }
   return nullptr;
 }
-#else
+#elif AIO_MODE == AIO_MODE_NATIVE
 int
 DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
 {
@@ -647,4 +688,397 @@ ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
   }
   return 1;
 }
-#endif // AIO_MODE != AIO_MODE_NATIVE
+#else // AIO_MODE == AIO_MODE_IO_URING
+
+void
+ink_aio_register_buffer(void *buf, size_t len)
+{
+  ink_scoped_mutex_lock lock(aio_register_mutex);
+  char *b = static_cast<char *>(buf);
+  // A buffer that is there already, or is part of one that is, would only be pinned twice.
+  if (std::any_of(aio_register_buffers.begin(), aio_register_buffers.end(), [b, len](const iovec &v) {
+        char *base = static_cast<char *>(v.iov_base);
+        return b >= base && b + len <= base + v.iov_len;
+      })) {
+    return;
+  }
+  aio_register_buffers.push_back(iovec{buf, len});
+  aio_register_generation++;
+}
+
+void
+ink_aio_register_fd(int fd)
+{
+  ink_scoped_mutex_lock lock(aio_register_mutex);
+  if (std::find(aio_register_fds.begin(), aio_register_fds.end(), fd) == aio_register_fds.end()) {
+    aio_register_fds.push_back(fd);
+    aio_register_generation++;
+  }
+}
+
+static size_t
+aio_buffer_bytes(const std::vector<iovec> &v)
+{
+  size_t n = 0;
+  for (const iovec &i : v) {
+    n += i.iov_len;
+  }
+  return n;
+}
+
+DiskHandler::DiskHandler()
+{
+  SET_HANDLER(&DiskHandler::startAIOEvent);
+  int ret = io_uring_queue_init(MAX_AIO_EVENTS, &ring, 0);
+  if (ret < 0) {
+    Fatal("io_uring_queue_init failed: %s (%d)", strerror(-ret), -ret);
+  }
+  ring_ready = true;
+}
+
+DiskHandler::~DiskHandler()
+{
+  if (ring_ready) {
+    io_uring_queue_exit(&ring);
+    aio_pinned_bytes -= aio_buffer_bytes(buffers);
+  }
+}
+
+static bool
+aio_buffer_has(const iovec &v, const ink_aiocb *a)
+{
+  char *buf  = static_cast<char *>(a->aio_buf);
+  char *base = static_cast<char *>(v.iov_base);
+  return buf >= base && buf + a->aio_nbytes <= base + v.iov_len;
+}
+
+/* The registrations the ring should have: those it has, and the buffers and files of the
+   global registry that its ready requests use, as long as the buffers fit in what is left of
+   RLIMIT_MEMLOCK. False if that is no more than it has. A ring so ends up with the agg
+   buffers and spans of the stripes its thread writes to. */
+bool
+DiskHandler::wanted_registrations(std::vector<iovec> &want_buffers, std::vector<int> &want_fds)
+{
+  if (register_retry_at && Thread::get_hrtime() < register_retry_at) {
+    return false;
+  }
+  int generation = aio_register_generation.load(std::memory_order_acquire);
+  if (generation != known_generation) {
+    ink_scoped_mutex_lock lock(aio_register_mutex);
+    known_generation = aio_register_generation.load(std::memory_order_relaxed);
+    known_buffers    = aio_register_buffers;
+    known_fds        = aio_register_fds;
+  }
+  if (buffers.size() + over_limit.size() == known_buffers.size() && fds.size() == known_fds.size()) {
+    return false;
+  }
+
+  want_buffers = buffers;
+  want_fds     = fds;
+  size_t avail = aio_pinned_limit - std::min(aio_pinned_limit, aio_pinned_bytes.load(std::memory_order_relaxed));
+  for (AIOCallback *op = ready_list.head; op; op = static_cast<AIOCallback *>(op->link.next)) {
+    ink_aiocb *a = &op->aiocb;
+    if (std::none_of(want_buffers.begin(), want_buffers.end(), [a](const iovec &v) { return aio_buffer_has(v, a); })) {
+      auto i = std::find_if(known_buffers.begin(), known_buffers.end(), [a](const iovec &v) { return aio_buffer_has(v, a); });
+      if (i != known_buffers.end() && std::find(over_limit.begin(), over_limit.end(), i->iov_base) == over_limit.end()) {
+        if (i->iov_len <= avail) {
+          want_buffers.push_back(*i);
+          avail -= i->iov_len;
+        } else {
+          // Left for unregistered I/O, and not looked at again.
+          Warning("io_uring buffer %p of %zu bytes is not registered, it would exceed RLIMIT_MEMLOCK (%zu bytes)", i->iov_base,
+                  i->iov_len, aio_pinned_limit);
+          over_limit.push_back(i->iov_base);
+        }
+      }
+    }
+    if (std::find(want_fds.begin(), want_fds.end(), a->aio_fildes) == want_fds.end() &&
+        std::find(known_fds.begin(), known_fds.end(), a->aio_fildes) != known_fds.end()) {
+      want_fds.push_back(a->aio_fildes);
+    }
+  }
+  return want_buffers.size() > buffers.size() || want_fds.size() > fds.size();
+}
+
+/* Replace the registrations of the ring with @a want_buffers and @a want_fds. Only while
+   nothing is in flight: older kernels wait for the ring to be idle to change its tables. A
+   registration that fails is tried again after AIO_REGISTER_RETRY, the requests meanwhile
+   use unregistered buffers and files. */
+void
+DiskHandler::update_registrations(std::vector<iovec> &want_buffers, std::vector<int> &want_fds)
+{
+  ink_assert(inflight == 0);
+  register_retry_at = 0;
+
+  if (want_buffers.size() > buffers.size()) {
+    if (!buffers.empty()) {
+      io_uring_unregister_buffers(&ring);
+      aio_pinned_bytes -= aio_buffer_bytes(buffers);
+      buffers.clear();
+    }
+    size_t bytes = aio_buffer_bytes(want_buffers);
+    int ret      = io_uring_register_buffers(&ring, want_buffers.data(), want_buffers.size());
+    if (ret < 0) {
+      Warning("io_uring_register_buffers failed, using unregistered buffers for now: %s (%d)", strerror(-ret), -ret);
+      register_retry_at = Thread::get_hrtime() + AIO_REGISTER_RETRY;
+    } else {
+      aio_pinned_bytes += bytes;
+      buffers = std::move(want_buffers);
+    }
+  }
+  if (want_fds.size() > fds.size()) {
+    if (!fds.empty()) {
+      io_uring_unregister_files(&ring);
+      fds.clear();
+    }
+    int ret = io_uring_register_files(&ring, want_fds.data(), want_fds.size());
+    if (ret < 0) {
+      Warning("io_uring_register_files failed, using unregistered files for now: %s (%d)", strerror(-ret), -ret);
+      register_retry_at = Thread::get_hrtime() + AIO_REGISTER_RETRY;
+    } else {
+      fds = std::move(want_fds);
+    }
+  }
+  Debug("aio", "io_uring registered %zu buffers and %zu files", buffers.size(), fds.size());
+}
+
+void
+DiskHandler::prepare(AIOCallback *op, io_uring_sqe *sqe)
+{
+  ink_aiocb *a   = &op->aiocb;
+  char *buf      = static_cast<char *>(a->aio_buf);
+  int buf_index  = -1;
+  int fd         = a->aio_fildes;
+  bool fixed_fd  = false;
+  bool is_read   = (a->aio_lio_opcode == LIO_READ);
+  unsigned nbyte = static_cast<unsigned>(a->aio_nbytes);
+
+  for (unsigned i = 0; i < buffers.size(); ++i) {
+    if (aio_buffer_has(buffers[i], a)) {
+      buf_index = i;
+      break;
+    }
+  }
+  for (unsigned i = 0; i < fds.size(); ++i) {
+    if (fds[i] == fd) {
+      fd       = i;
+      fixed_fd = true;
+      break;
+    }
+  }
+
+  if (is_read) {
+    if (buf_index >= 0) {
+      io_uring_prep_read_fixed(sqe, fd, buf, nbyte, a->aio_offset, buf_index);
+    } else {
+      io_uring_prep_read(sqe, fd, buf, nbyte, a->aio_offset);
+    }
+    aio_num_read++;
+    aio_bytes_read += a->aio_nbytes;
+  } else {
+    if (buf_index >= 0) {
+      io_uring_prep_write_fixed(sqe, fd, buf, nbyte, a->aio_offset, buf_index);
+    } else {
+      io_uring_prep_write(sqe, fd, buf, nbyte, a->aio_offset);
+    }
+    aio_num_write++;
+    aio_bytes_written += a->aio_nbytes;
+  }
+  if (fixed_fd) {
+    sqe->flags |= IOSQE_FIXED_FILE;
+  }
+  io_uring_sqe_set_data(sqe, op);
+}
+
+/* Put the ring in front of @a t's tail handler, from @a t itself. */
+void
+DiskHandler::attach(EThread *t)
+{
+  ink_assert(t == this_ethread());
+  if (tail_handler) {
+    return;
+  }
+#ifdef HAVE_EVENTFD
+  // Completions wake the event loop through the thread's eventfd.
+  int ret = io_uring_register_eventfd(&ring, t->evfd);
+  if (ret < 0) {
+    Debug("aio", "io_uring_register_eventfd failed: %s (%d)", strerror(-ret), -ret);
+  }
+#endif
+  tail_handler = t->tail_cb;
+  t->set_tail_handler(this);
+}
+
+int
+DiskHandler::startAIOEvent(int /* event ATS_UNUSED */, Event *e)
+{
+  SET_HANDLER(&DiskHandler::mainAIOEvent);
+  attach(e->ethread);
+  e->schedule_every(AIO_PERIOD);
+  trigger_event = e;
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::mainAIOEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  service();
+  return EVENT_CONT;
+}
+
+int
+DiskHandler::waitForActivity(ink_hrtime timeout)
+{
+  // Requests queued during this pass go out before the thread blocks, and what completed while
+  // it was blocked is called back before the next pass.
+  submit();
+  tail_handler->waitForActivity(timeout);
+  service();
+  return EVENT_CONT;
+}
+
+void
+DiskHandler::signalActivity()
+{
+  tail_handler->signalActivity();
+}
+
+/* Reap the completion queue, submit what is ready and call back the completed requests. */
+void
+DiskHandler::service()
+{
+  AIOCallback *op = nullptr;
+  io_uring_cqe *cqe;
+  unsigned head;
+  unsigned completed = 0;
+
+  io_uring_for_each_cqe(&ring, head, cqe)
+  {
+    op             = static_cast<AIOCallback *>(io_uring_cqe_get_data(cqe));
+    op->aio_result = cqe->res;
+    ink_assert(op->action.continuation);
+    complete_list.enqueue(op);
+    ++completed;
+  }
+  io_uring_cq_advance(&ring, completed);
+  inflight -= completed;
+
+  submit();
+
+  // A ring made with the first request of its thread is serviced before its start event has run.
+  EThread *t = this_ethread();
+  while ((op = complete_list.dequeue()) != nullptr) {
+    op->mutex = op->action.mutex;
+    MUTEX_TRY_LOCK(lock, op->mutex, t);
+    if (!lock.is_locked()) {
+      t->schedule_imm(op);
+    } else {
+      op->handleEvent(EVENT_NONE, nullptr);
+    }
+  }
+}
+
+/* Turn the ready requests into SQEs and submit them with one call. */
+void
+DiskHandler::submit()
+{
+  if (!ready_list.head) {
+    return;
+  }
+  std::vector<iovec> want_buffers;
+  std::vector<int> want_fds;
+  if (wanted_registrations(want_buffers, want_fds)) {
+    // The new requests wait for what is in flight, so that a busy ring also gets idle long enough
+    // to register. service() submits them once it has reaped the last completion.
+    if (inflight > 0) {
+      return;
+    }
+    update_registrations(want_buffers, want_fds);
+  }
+
+  // The completion queue is twice the size of the submission queue, so capping the number of
+  // requests in flight at MAX_AIO_EVENTS keeps it from overflowing.
+  int num = 0;
+  while (inflight + num < MAX_AIO_EVENTS && ready_list.head) {
+    io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+    if (!sqe) {
+      break;
+    }
+    AIOCallback *op = ready_list.dequeue();
+    ink_assert(op->action.continuation);
+    prepare(op, sqe);
+    ++num;
+  }
+
+  if (num > 0) {
+    int ret;
+    do {
+      ret = io_uring_submit(&ring);
+    } while (ret == -EINTR || ret == -EAGAIN);
+
+    if (ret < 0) {
+      Fatal("could not submit IOs, io_uring_submit(%p) of %d requests returned %d", &ring, num, ret);
+    }
+    inflight += num;
+  }
+}
+
+/* Queue @a op and any requests chained to it with AIOCallback::then on this thread's ring. */
+static int
+aio_uring_queue(AIOCallback *op, int opcode)
+{
+  EThread *t      = this_ethread();
+  DiskHandler *dh = t->diskHandler;
+  AIOCallback *io = op;
+  int sz          = 0;
+
+  if (!dh) {
+    // Threads outside ET_NET, such as ET_TASK threads, get their ring with their first request. It goes in
+    // their wait loop right away, as the rings of the net threads do, so this request is submitted and reaped
+    // by the tail handler rather than waiting for the AIO_PERIOD poll.
+    dh = t->diskHandler = new DiskHandler();
+    dh->attach(t);
+    t->schedule_imm(dh);
+  }
+  while (io) {
+    io->aiocb.aio_lio_opcode = opcode;
+    dh->ready_list.enqueue(io);
+    ++sz;
+    io = io->then;
+  }
+
+  if (sz > 1) {
+    ink_assert(op->action.continuation);
+    AIOVec *vec = new AIOVec(sz, op);
+    while (--sz >= 0) {
+      op->action = vec;
+      op         = op->then;
+    }
+  }
+  return 1;
+}
+
+int
+ink_aio_read(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_uring_queue(op, LIO_READ);
+}
+
+int
+ink_aio_write(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_uring_queue(op, LIO_WRITE);
+}
+
+int
+ink_aio_readv(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_uring_queue(op, LIO_READ);
+}
+
+int
+ink_aio_writev(AIOCallback *op, int /* fromAPI ATS_UNUSED */)
+{
+  return aio_uring_queue(op, LIO_WRITE);
+}
+#endif // AIO_MODE == AIO_MODE_IO_URING
@@ -40,8 +40,11 @@ static constexpr ts::ModuleVersion AIO_MODULE_PUBLIC_VERSION(1, 0, ts::ModuleVer
 
 #define AIO_MODE_THREAD 0
 #define AIO_MODE_NATIVE 1
+#define AIO_MODE_IO_URING 2
 
-#if TS_USE_LINUX_NATIVE_AIO
+#if TS_USE_LINUX_IO_URING
+#define AIO_MODE AIO_MODE_IO_URING
+#elif TS_USE_LINUX_NATIVE_AIO
 #define AIO_MODE AIO_MODE_NATIVE
 #else
 #define AIO_MODE AIO_MODE_THREAD
@@ -64,6 +67,23 @@ typedef struct io_event ink_io_event_t;
 #define aio_offset u.c.offset
 #define aio_buf u.c.buf
 
+#elif AIO_MODE == AIO_MODE_IO_URING
+
+#include <liburing.h>
+
+#include <vector>
+
+#define MAX_AIO_EVENTS 1024
+
+struct ink_aiocb {
+  int aio_fildes    = -1;      /* file descriptor */
+  void *aio_buf     = nullptr; /* buffer location */
+  size_t aio_nbytes = 0;       /* length of transfer */
+  off_t aio_offset  = 0;       /* file offset */
+
+  int aio_lio_opcode = 0; /* LIO_READ or LIO_WRITE */
+};
+
 #else
 
 struct ink_aiocb {
@@ -98,7 +118,7 @@ struct AIOCallback : public Continuation {
   AIOCallback() {}
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
 
 struct AIOVec : public Continuation {
   Action action;
@@ -115,6 +135,10 @@ struct AIOVec : public Continuation {
   int mainEvent(int event, Event *e);
 };
 
+#endif
+
+#if AIO_MODE == AIO_MODE_NATIVE
+
 struct DiskHandler : public Continuation {
   Event *trigger_event;
   io_context_t ctx;
@@ -133,6 +157,52 @@ struct DiskHandler : public Continuation {
     }
   }
 };
+
+#elif AIO_MODE == AIO_MODE_IO_URING
+
+/**
+  Per EThread io_uring submission and completion handler.
+
+  Requests queued on @a ready_list are turned into SQEs and submitted with a single
+  io_uring_submit() per event loop iteration. The DiskHandler puts itself in front of the
+  thread's tail handler: queued requests are submitted right before the thread blocks, and
+  the ring signals the thread's eventfd on completion so the completions are reaped as soon
+  as the wait returns rather than on the next pass of the AIO_PERIOD poll event. Of the
+  buffers and fds registered with ink_aio_register_buffer() and ink_aio_register_fd(), the
+  ring registers those its own requests use, after the completions in flight are reaped, so
+  the matching requests use fixed buffers and fixed files.
+*/
+struct DiskHandler : public Continuation, public EThread::LoopTailHandler {
+  Event *trigger_event = nullptr;
+  struct io_uring ring;
+  bool ring_ready = false;
+  int inflight    = 0;
+  Que(AIOCallback, link) ready_list;
+  Que(AIOCallback, link) complete_list;
+  int startAIOEvent(int event, Event *e);
+  int mainAIOEvent(int event, Event *e);
+  int waitForActivity(ink_hrtime timeout) override;
+  void signalActivity() override;
+  void attach(EThread *t);
+  DiskHandler();
+  ~DiskHandler() override;
+
+private:
+  void service();
+  void submit();
+  bool wanted_registrations(std::vector<iovec> &want_buffers, std::vector<int> &want_fds);
+  void update_registrations(std::vector<iovec> &want_buffers, std::vector<int> &want_fds);
+  void prepare(AIOCallback *op, io_uring_sqe *sqe);
+
+  EThread::LoopTailHandler *tail_handler = nullptr; ///< The thread's own, usually its NetHandler.
+  int known_generation                   = 0;
+  ink_hrtime register_retry_at           = 0; ///< After a registration failed, when to try again.
+  std::vector<iovec> known_buffers;           ///< Copy of the global registry, as of @a known_generation.
+  std::vector<int> known_fds;
+  std::vector<iovec> buffers; ///< Registered with the ring, in the order of their fixed indexes.
+  std::vector<int> fds;
+  std::vector<void *> over_limit; ///< Buffers left to unregistered I/O by RLIMIT_MEMLOCK.
+};
 #endif
 
 void ink_aio_init(ts::ModuleVersion version);
@@ -146,3 +216,8 @@ int ink_aio_readv(AIOCallback *op,
                   int fromAPI = 0); // fromAPI is a boolean to indicate if this is from a API call such as upload proxy feature
 int ink_aio_writev(AIOCallback *op, int fromAPI = 0);
 AIOCallback *new_AIOCallback();
+
+// Register memory and files which are the target of frequent IO. These are no-ops unless the
+// AIO backend can take advantage of them (currently only AIO_MODE_IO_URING).
+void ink_aio_register_buffer(void *buf, size_t len);
+void ink_aio_register_fd(int fd);
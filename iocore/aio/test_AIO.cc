@@ -26,8 +26,10 @@
 #include "tscore/I_Layout.h"
 #include "tscore/TSSystemState.h"
 #include "tscore/Random.h"
+#include <algorithm>
 #include <iostream>
 #include <fstream>
+#include <vector>
 
 using std::cout;
 using std::endl;
@@ -98,11 +100,14 @@ struct AIO_Device : public Continuation {
   int hotset_idx;
   int mode;
   AIOCallback *io;
+  ink_hrtime io_start;
+  std::vector<ink_hrtime> latencies;
   AIO_Device(ProxyMutex *m) : Continuation(m)
   {
     hotset_idx = 0;
     io         = new_AIOCallback();
     time_start = 0;
+    io_start   = 0;
     SET_HANDLER(&AIO_Device::do_hotset);
   }
   int
@@ -154,6 +159,18 @@ struct AIO_Device : public Continuation {
   int do_fd(int event, Event *e);
 };
 
+static const char *
+aio_mode_name()
+{
+#if AIO_MODE == AIO_MODE_IO_URING
+  return "io_uring";
+#elif AIO_MODE == AIO_MODE_NATIVE
+  return "native";
+#else
+  return "thread";
+#endif
+}
+
 void
 dump_summary()
 {
@@ -163,6 +180,7 @@ dump_summary()
   printf("----------\n");
   printf("parameters\n");
   printf("----------\n");
+  printf("%s aio mode\n", aio_mode_name());
   printf("%d disks\n", n_disk_path);
   printf("%d chains\n", chains);
   printf("%d threads_per_disk\n", threads_per_disk);
@@ -211,6 +229,20 @@ dump_summary()
   printf("%f ops %0.2f mbytes/sec %0.1f ops/sec %0.1f ops/sec/disk rand_read\n", total_rand_reads, rr,
          total_rand_reads / total_secs, total_rand_reads / total_secs / n_disk_path);
   printf("%0.2f total mbytes/sec\n", sr + sw + rr);
+
+  // IOPS and completion latency, for comparing the thread, native and io_uring AIO modes.
+  std::vector<ink_hrtime> latencies;
+  for (int i = 0; i < orig_n_accessors; i++) {
+    latencies.insert(latencies.end(), dev[i]->latencies.begin(), dev[i]->latencies.end());
+  }
+  printf("%0.1f total ops/sec (%s)\n", (total_seq_reads + total_seq_writes + total_rand_reads) / total_secs, aio_mode_name());
+  if (!latencies.empty()) {
+    std::sort(latencies.begin(), latencies.end());
+    size_t p50 = latencies.size() / 2;
+    size_t p99 = std::min(latencies.size() - 1, latencies.size() * 99 / 100);
+    printf("latency usec p50 %0.1f p99 %0.1f max %0.1f (%s)\n", latencies[p50] / 1000.0, latencies[p99] / 1000.0,
+           latencies.back() / 1000.0, aio_mode_name());
+  }
   printf("----------------------------------------------------------\n");
 
   if (delete_disks) {
@@ -255,6 +287,8 @@ AIO_Device::do_fd(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   if (!time_start) {
     time_start = Thread::get_hrtime();
     fprintf(stderr, "Starting the aio_testing \n");
+  } else if (io_start) {
+    latencies.push_back(Thread::get_hrtime_updated() - io_start);
   }
   if ((Thread::get_hrtime() - time_start) > (run_time * HRTIME_SECOND)) {
     time_end = Thread::get_hrtime();
@@ -282,6 +316,7 @@ AIO_Device::do_fd(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   io->aiocb.aio_buf    = buf;
   io->action           = this;
   io->thread           = mutex->thread_holding;
+  io_start             = Thread::get_hrtime_updated();
 
   switch (select_mode(ts::Random::drandom())) {
   case READ_MODE:
@@ -422,7 +457,7 @@ main(int /* argc ATS_UNUSED */, char *argv[])
   Thread *main_thread = new EThread;
   main_thread->set_specific();
 
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   for (EThread *et : eventProcessor.active_group_threads(ET_NET)) {
     et->diskHandler = new DiskHandler();
     et->schedule_imm(et->diskHandler);
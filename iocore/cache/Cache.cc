@@ -62,12 +62,25 @@ int64_t cache_config_ram_cache_size            = AUTO_SIZE_RAM_CACHE;
 int cache_config_ram_cache_algorithm           = 1;
 int cache_config_ram_cache_compress            = 0;
 int cache_config_ram_cache_compress_percent    = 90;
+int cache_config_ram_cache_compress_adaptive   = 1;
+int cache_config_ram_cache_compress_dict_size  = 0;
 int cache_config_ram_cache_use_seen_filter     = 1;
+int cache_config_ram_cache_snapshot            = 0;
+int cache_config_ram_cache_snapshot_interval   = 3600;
+int64_t cache_config_ram_cache_warm_rate       = 10 * 1024 * 1024;
 int cache_config_http_max_alts                 = 3;
 int cache_config_log_alternate_eviction        = 0;
 int cache_config_dir_sync_frequency            = 60;
+int cache_config_dir_sync_incremental          = 0;
+int cache_config_init_serve_partial            = 0;
+int cache_config_hugepages                     = 0;
+int cache_config_dir_filter                    = 0;
+int cache_config_dir_filter_counters           = 8;
+int cache_config_tier_promote_hits             = 2;
+int cache_config_tier_demote                   = 1;
 int cache_config_permit_pinning                = 0;
 int cache_config_select_alternate              = 1;
+int cache_config_alt_vector_compact            = 0;
 int cache_config_max_doc_size                  = 0;
 int cache_config_min_average_object_size       = ESTIMATED_OBJECT_SIZE;
 int64_t cache_config_ram_cache_cutoff          = AGG_SIZE;
@@ -77,7 +90,16 @@ int cache_config_hit_evacuate_size_limit       = 0;
 int cache_config_force_sector_size             = 0;
 int cache_config_target_fragment_size          = DEFAULT_TARGET_FRAGMENT_SIZE;
 int cache_config_agg_write_backlog             = AGG_SIZE * 2;
+int cache_config_write_throttle                = 0;
+int cache_config_write_throttle_read_p99       = 50;
+int cache_config_write_throttle_queue_depth    = 0;
+int64_t cache_config_write_throttle_max_size   = 1024 * 1024;
+int cache_config_write_throttle_interval       = 1000;
+int cache_config_agg_buffers                   = 1;
+int cache_config_agg_size                      = AGG_SIZE;
+int64_t cache_config_log_segment_size          = 256 * 1024 * 1024;
 int cache_config_enable_checksum               = 0;
+int64_t cache_config_zero_copy_min_size        = 0;
 int cache_config_alt_rewrite_max_size          = 4096;
 int cache_config_read_while_writer             = 0;
 int cache_config_mutex_retry_delay             = 2;
@@ -134,7 +156,7 @@ struct VolInitInfo {
   }
 };
 
-#if AIO_MODE == AIO_MODE_NATIVE
+// Stripes and spans are initialized on the event threads, in parallel, rather than one after another.
 struct VolInit : public Continuation {
   Vol *vol;
   char *path;
@@ -182,7 +204,9 @@ struct DiskInit : public Continuation {
     SET_HANDLER(&DiskInit::mainEvent);
   }
 };
-#endif
+
+// Serializes a stripe going into service against cacheInitialized(), so each one is set up exactly once.
+static ink_mutex vol_online_mutex = INK_MUTEX_INIT;
 void cplist_init();
 static void cplist_update();
 int cplist_reconfigure();
@@ -210,7 +234,12 @@ cache_bytes_used(int volume)
 
   for (int i = 0; i < gnvol; i++) {
     if (!DISK_BAD(gvol[i]->disk) && (volume == -1 || gvol[i]->cache_vol->vol_number == volume)) {
-      if (!gvol[i]->header->cycle) {
+      if (gvol[i]->lseg_live) {
+        // the segments are not filled in order, count what is in them
+        for (int s = 0; s < gvol[i]->lsegs; s++) {
+          used += std::max<int64_t>(gvol[i]->lseg_live[s], 0);
+        }
+      } else if (!gvol[i]->header->cycle) {
         used += gvol[i]->header->write_pos - gvol[i]->start;
       } else {
         used += gvol[i]->len - gvol[i]->dirlen() - EVACUATION_SIZE;
@@ -574,12 +603,13 @@ CacheProcessor::start_internal(int flags)
   ink_assert((int)TS_EVENT_CACHE_SCAN_OPERATION_BLOCKED == (int)CACHE_EVENT_SCAN_OPERATION_BLOCKED);
   ink_assert((int)TS_EVENT_CACHE_SCAN_OPERATION_FAILED == (int)CACHE_EVENT_SCAN_OPERATION_FAILED);
   ink_assert((int)TS_EVENT_CACHE_SCAN_DONE == (int)CACHE_EVENT_SCAN_DONE);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   for (EThread *et : eventProcessor.active_group_threads(ET_NET)) {
     et->diskHandler = new DiskHandler();
     et->schedule_imm(et->diskHandler);
   }
 #endif
+  start_time           = Thread::get_hrtime();
   start_internal_flags = flags;
   clear                = !!(flags & PROCESSOR_RECONFIGURE) || auto_clear_flag;
   fix                  = !!(flags & PROCESSOR_FIX);
@@ -671,6 +701,13 @@ CacheProcessor::start_internal(int flags)
         if (sd->hash_base_string) {
           gdisks[gndisks]->hash_base_string = ats_strdup(sd->hash_base_string);
         }
+        // sendfile(2) fails on the O_DIRECT descriptor for the unaligned data of a fragment, it gets one of its own
+        if (cache_config_zero_copy_min_size > 0 && !check) {
+          gdisks[gndisks]->file_fd = open(paths[gndisks], O_RDONLY | O_CLOEXEC);
+          if (gdisks[gndisks]->file_fd < 0) {
+            Warning("cache unable to open '%s' for zero copy reads: %s", paths[gndisks], strerror(errno));
+          }
+        }
 
         if (sector_size < cache_config_force_sector_size) {
           sector_size = cache_config_force_sector_size;
@@ -735,11 +772,7 @@ CacheProcessor::start_internal(int flags)
     ink_release_assert(sds[j] != nullptr); // Defeat clang-analyzer
     off_t skip     = ROUND_TO_STORE_BLOCK((sd->offset < START_POS ? START_POS + sd->alignment : sd->offset));
     int64_t blocks = sd->blocks - (skip >> STORE_BLOCK_SHIFT);
-#if AIO_MODE == AIO_MODE_NATIVE
     eventProcessor.schedule_imm(new DiskInit(gdisks[j], paths[j], blocks, skip, sector_sizes[j], fds[j], clear));
-#else
-    gdisks[j]->open(paths[j], blocks, skip, sector_sizes[j], fds[j], clear);
-#endif
 
     Debug("cache_hosting", "Disk: %d:%s, blocks: %" PRId64 "", gndisks, paths[j], blocks);
   }
@@ -759,6 +792,7 @@ CacheProcessor::diskInitialized()
   if (n_init != gndisks - 1) {
     return;
   }
+  GLOBAL_CACHE_SET_DYN_STAT(cache_init_span_time_stat, ink_hrtime_to_msec(Thread::get_hrtime() - start_time));
 
   // Check and remove bad disks from gdisks[]
   for (i = 0; i < gndisks; i++) {
@@ -865,23 +899,10 @@ CacheProcessor::cacheInitialized()
 
   int caches_ready  = 0;
   int cache_init_ok = 0;
-  /* allocate ram size in proportion to the disk space the
-     volume occupies */
-  int64_t total_size             = 0; // count in HTTP & MIXT
-  uint64_t total_cache_bytes     = 0; // bytes that can used in total_size
-  uint64_t total_direntries      = 0; // all the direntries in the cache
-  uint64_t used_direntries       = 0; //   and used
-  uint64_t vol_total_cache_bytes = 0;
-  uint64_t vol_total_direntries  = 0;
-  uint64_t vol_used_direntries   = 0;
-  Vol *vol;
-
-  ProxyMutex *mutex = this_ethread()->mutex.get();
 
   if (theCache) {
-    total_size += theCache->cache_size;
-    Debug("cache_init", "CacheProcessor::cacheInitialized - theCache, total_size = %" PRId64 " = %" PRId64 " MB", total_size,
-          total_size / ((1024 * 1024) / STORE_BLOCK_SIZE));
+    Debug("cache_init", "CacheProcessor::cacheInitialized - theCache, total_size = %" PRId64 " = %" PRId64 " MB",
+          theCache->cache_size, theCache->cache_size / ((1024 * 1024) / STORE_BLOCK_SIZE));
     if (theCache->ready == CACHE_INIT_FAILED) {
       Debug("cache_init", "CacheProcessor::cacheInitialized - failed to initialize the cache for http: cache disabled");
       Warning("failed to initialize the cache for http: cache disabled\n");
@@ -893,157 +914,87 @@ CacheProcessor::cacheInitialized()
     }
   }
 
-  // Update stripe version data.
-  if (gnvol) { // start with whatever the first stripe is.
-    cacheProcessor.min_stripe_version = cacheProcessor.max_stripe_version = gvol[0]->header->version;
-  }
-  // scan the rest of the stripes.
-  for (i = 1; i < gnvol; i++) {
-    Vol *v = gvol[i];
-    if (v->header->version < cacheProcessor.min_stripe_version) {
-      cacheProcessor.min_stripe_version = v->header->version;
-    }
-    if (cacheProcessor.max_stripe_version < v->header->version) {
-      cacheProcessor.max_stripe_version = v->header->version;
-    }
-  }
+  {
+    // Stripes that finish from here on wait for this, then go through vol_online() themselves.
+    ink_scoped_mutex_lock lock(vol_online_mutex);
 
-  if (caches_ready) {
-    Debug("cache_init", "CacheProcessor::cacheInitialized - caches_ready=0x%0X, gnvol=%d", (unsigned int)caches_ready,
-          gnvol.load());
+    // Update stripe version data, vol_online() scans the rest of the stripes.
+    if (gnvol) { // start with whatever the first stripe is.
+      cacheProcessor.min_stripe_version = cacheProcessor.max_stripe_version = gvol[0]->header->version;
+    }
 
-    int64_t ram_cache_bytes = 0;
+    if (caches_ready) {
+      Debug("cache_init", "CacheProcessor::cacheInitialized - caches_ready=0x%0X, gnvol=%d", (unsigned int)caches_ready,
+            gnvol.load());
 
-    if (gnvol) {
-      // new ram_caches, with algorithm from the config
-      for (i = 0; i < gnvol; i++) {
-        switch (cache_config_ram_cache_algorithm) {
+      if (gnvol) {
+        switch (cache_config_ram_cache_compress) {
         default:
-        case RAM_CACHE_ALGORITHM_CLFUS:
-          gvol[i]->ram_cache = new_RamCacheCLFUS();
+          Fatal("unknown RAM cache compression type: %d", cache_config_ram_cache_compress);
+        case CACHE_COMPRESSION_NONE:
+        case CACHE_COMPRESSION_FASTLZ:
           break;
-        case RAM_CACHE_ALGORITHM_LRU:
-          gvol[i]->ram_cache = new_RamCacheLRU();
+        case CACHE_COMPRESSION_LIBZ:
+#ifndef HAVE_ZLIB_H
+          Fatal("libz not available for RAM cache compression");
+#endif
           break;
-        }
-      }
-      // let us calculate the Size
-      if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
-        Debug("cache_init", "CacheProcessor::cacheInitialized - cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE");
-        for (i = 0; i < gnvol; i++) {
-          vol = gvol[i];
-
-          if (gvol[i]->cache_vol->ramcache_enabled) {
-            gvol[i]->ram_cache->init(vol->dirlen() * DEFAULT_RAM_CACHE_MULTIPLIER, vol);
-            ram_cache_bytes += gvol[i]->dirlen();
-            Debug("cache_init", "CacheProcessor::cacheInitialized - ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb", ram_cache_bytes,
-                  ram_cache_bytes / (1024 * 1024));
-            CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t)gvol[i]->dirlen());
+        case CACHE_COMPRESSION_LIBLZMA:
+#ifndef HAVE_LZMA_H
+          Fatal("lzma not available for RAM cache compression");
+#endif
+          break;
+        case CACHE_COMPRESSION_ZSTD:
+#ifndef HAVE_ZSTD_H
+          Fatal("zstd not available for RAM cache compression");
+#endif
+#ifndef HAVE_ZDICT_H
+          if (cache_config_ram_cache_compress_dict_size) {
+            Warning("zstd dictionary training not available, compressing the RAM cache without a dictionary");
           }
-          vol_total_cache_bytes = gvol[i]->len - gvol[i]->dirlen();
-          total_cache_bytes += vol_total_cache_bytes;
-          Debug("cache_init", "CacheProcessor::cacheInitialized - total_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
-                total_cache_bytes, total_cache_bytes / (1024 * 1024));
-
-          CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
-
-          vol_total_direntries = gvol[i]->buckets * gvol[i]->segments * DIR_DEPTH;
-          total_direntries += vol_total_direntries;
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
-
-          vol_used_direntries = dir_entries_used(gvol[i]);
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
-          used_direntries += vol_used_direntries;
+#endif
+          break;
+        case CACHE_COMPRESSION_LZ4:
+#ifndef HAVE_LZ4_H
+          Fatal("lz4 not available for RAM cache compression");
+#endif
+          break;
         }
 
-      } else {
-        // we got configured memory size
-        // TODO, should we check the available system memories, or you will
-        //   OOM or swapout, that is not a good situation for the server
-        Debug("cache_init", "CacheProcessor::cacheInitialized - %" PRId64 " != AUTO_SIZE_RAM_CACHE", cache_config_ram_cache_size);
-        int64_t http_ram_cache_size =
-          (theCache) ?
-            static_cast<int64_t>((static_cast<double>(theCache->cache_size) / total_size) * cache_config_ram_cache_size) :
-            0;
-        Debug("cache_init", "CacheProcessor::cacheInitialized - http_ram_cache_size = %" PRId64 " = %" PRId64 "Mb",
-              http_ram_cache_size, http_ram_cache_size / (1024 * 1024));
-        int64_t stream_ram_cache_size = cache_config_ram_cache_size - http_ram_cache_size;
-        Debug("cache_init", "CacheProcessor::cacheInitialized - stream_ram_cache_size = %" PRId64 " = %" PRId64 "Mb",
-              stream_ram_cache_size, stream_ram_cache_size / (1024 * 1024));
-
-        // Dump some ram_cache size information in debug mode.
-        Debug("ram_cache", "config: size = %" PRId64 ", cutoff = %" PRId64 "", cache_config_ram_cache_size,
-              cache_config_ram_cache_cutoff);
-
+        if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
+          Debug("cache_init", "CacheProcessor::cacheInitialized - cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE");
+        } else {
+          // Dump some ram_cache size information in debug mode.
+          Debug("ram_cache", "config: size = %" PRId64 ", cutoff = %" PRId64 "", cache_config_ram_cache_size,
+                cache_config_ram_cache_cutoff);
+        }
         for (i = 0; i < gnvol; i++) {
-          vol = gvol[i];
-          double factor;
-          if (gvol[i]->cache == theCache && gvol[i]->cache_vol->ramcache_enabled) {
-            ink_assert(gvol[i]->cache != nullptr);
-            factor = static_cast<double>(static_cast<int64_t>(gvol[i]->len >> STORE_BLOCK_SHIFT)) / theCache->cache_size;
-            Debug("cache_init", "CacheProcessor::cacheInitialized - factor = %f", factor);
-            gvol[i]->ram_cache->init(static_cast<int64_t>(http_ram_cache_size * factor), vol);
-            ram_cache_bytes += static_cast<int64_t>(http_ram_cache_size * factor);
-            CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, (int64_t)(http_ram_cache_size * factor));
-          } else if (gvol[i]->cache_vol->ramcache_enabled) {
-            ink_release_assert(!"Unexpected non-HTTP cache volume");
+          // Stripes that failed took their span offline, they stay out of service.
+          if (!DISK_BAD(gvol[i]->disk)) {
+            vol_online(gvol[i]);
           }
-          Debug("cache_init", "CacheProcessor::cacheInitialized[%d] - ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb", i,
-                ram_cache_bytes, ram_cache_bytes / (1024 * 1024));
-          vol_total_cache_bytes = gvol[i]->len - gvol[i]->dirlen();
-          total_cache_bytes += vol_total_cache_bytes;
-          CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
-          Debug("cache_init", "CacheProcessor::cacheInitialized - total_cache_bytes = %" PRId64 " = %" PRId64 "Mb",
-                total_cache_bytes, total_cache_bytes / (1024 * 1024));
-
-          vol_total_direntries = gvol[i]->buckets * gvol[i]->segments * DIR_DEPTH;
-          total_direntries += vol_total_direntries;
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
-
-          vol_used_direntries = dir_entries_used(gvol[i]);
-          CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
-          used_direntries += vol_used_direntries;
         }
+        if (!check) {
+          dir_sync_init();
+          if (cache_config_ram_cache_snapshot) {
+            ram_cache_snapshot_init();
+          }
+        }
+        cache_init_ok = 1;
+      } else {
+        Warning("cache unable to open any vols, disabled");
       }
-      switch (cache_config_ram_cache_compress) {
-      default:
-        Fatal("unknown RAM cache compression type: %d", cache_config_ram_cache_compress);
-      case CACHE_COMPRESSION_NONE:
-      case CACHE_COMPRESSION_FASTLZ:
-        break;
-      case CACHE_COMPRESSION_LIBZ:
-#ifndef HAVE_ZLIB_H
-        Fatal("libz not available for RAM cache compression");
-#endif
-        break;
-      case CACHE_COMPRESSION_LIBLZMA:
-#ifndef HAVE_LZMA_H
-        Fatal("lzma not available for RAM cache compression");
-#endif
-        break;
-      }
-
-      GLOBAL_CACHE_SET_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
-      GLOBAL_CACHE_SET_DYN_STAT(cache_bytes_total_stat, total_cache_bytes);
-      GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_total_stat, total_direntries);
-      GLOBAL_CACHE_SET_DYN_STAT(cache_direntries_used_stat, used_direntries);
-      if (!check) {
-        dir_sync_init();
-      }
-      cache_init_ok = 1;
+    }
+    if (cache_init_ok) {
+      // Initialize virtual cache
+      CacheProcessor::initialized = CACHE_INITIALIZED;
+      CacheProcessor::cache_ready = caches_ready;
+      Note("cache enabled");
     } else {
-      Warning("cache unable to open any vols, disabled");
+      CacheProcessor::initialized = CACHE_INIT_FAILED;
+      Note("cache disabled");
     }
   }
-  if (cache_init_ok) {
-    // Initialize virtual cache
-    CacheProcessor::initialized = CACHE_INITIALIZED;
-    CacheProcessor::cache_ready = caches_ready;
-    Note("cache enabled");
-  } else {
-    CacheProcessor::initialized = CACHE_INIT_FAILED;
-    Note("cache disabled");
-  }
 
   // Fire callback to signal initialization finished.
   if (cb_after_init) {
@@ -1056,6 +1007,81 @@ CacheProcessor::cacheInitialized()
   }
 }
 
+/*
+  Put a stripe whose directory is loaded into service: give it a RAM cache, add
+  it to the cache totals and let the requests that hash to it through. Called
+  with vol_online_mutex held, from cacheInitialized() for the stripes ready by
+  then and from Vol::dir_init_done() for each one that finishes later.
+*/
+void
+CacheProcessor::vol_online(Vol *vol)
+{
+  ProxyMutex *mutex       = this_ethread()->mutex.get();
+  int64_t ram_cache_bytes = 0;
+
+  switch (cache_config_ram_cache_algorithm) {
+  default:
+  case RAM_CACHE_ALGORITHM_CLFUS:
+    vol->ram_cache = new_RamCacheCLFUS();
+    break;
+  case RAM_CACHE_ALGORITHM_LRU:
+    vol->ram_cache = new_RamCacheLRU();
+    break;
+  case RAM_CACHE_ALGORITHM_TINYLFU:
+    vol->ram_cache = new_RamCacheTinyLFU();
+    break;
+  }
+
+  if (vol->cache_vol->ramcache_enabled) {
+    if (cache_config_ram_cache_size == AUTO_SIZE_RAM_CACHE) {
+      vol->ram_cache->init(vol->dirlen() * DEFAULT_RAM_CACHE_MULTIPLIER, vol);
+      ram_cache_bytes = vol->dirlen();
+    } else {
+      // RAM is handed out in proportion to the disk space the stripe occupies.
+      ink_release_assert(vol->cache == theCache && "Unexpected non-HTTP cache volume");
+      double factor = static_cast<double>(static_cast<int64_t>(vol->len >> STORE_BLOCK_SHIFT)) / theCache->cache_size;
+      Debug("cache_init", "CacheProcessor::vol_online - factor = %f", factor);
+      ram_cache_bytes = static_cast<int64_t>(cache_config_ram_cache_size * factor);
+      vol->ram_cache->init(ram_cache_bytes, vol);
+    }
+    CACHE_VOL_SUM_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
+    GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_ram_cache_bytes_total_stat, ram_cache_bytes);
+  }
+
+  uint64_t vol_total_cache_bytes = vol->len - vol->dirlen();
+  CACHE_VOL_SUM_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_bytes_total_stat, vol_total_cache_bytes);
+
+  uint64_t vol_total_direntries = vol->buckets * vol->segments * DIR_DEPTH;
+  CACHE_VOL_SUM_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_direntries_total_stat, vol_total_direntries);
+
+  uint64_t vol_used_direntries = dir_entries_used(vol);
+  CACHE_VOL_SUM_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
+  GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_direntries_used_stat, vol_used_direntries);
+
+  Debug("cache_init", "CacheProcessor::vol_online - %s: ram_cache_bytes = %" PRId64 " = %" PRId64 "Mb, cache_bytes = %" PRIu64
+        " = %" PRIu64 "Mb",
+        vol->hash_text.get(), ram_cache_bytes, ram_cache_bytes / (1024 * 1024), vol_total_cache_bytes,
+        vol_total_cache_bytes / (1024 * 1024));
+
+  if (vol->header->version < cacheProcessor.min_stripe_version) {
+    cacheProcessor.min_stripe_version = vol->header->version;
+  }
+  if (cacheProcessor.max_stripe_version < vol->header->version) {
+    cacheProcessor.max_stripe_version = vol->header->version;
+  }
+
+  CACHE_SET_DYN_STAT(cache_init_ready_time_stat, ink_hrtime_to_msec(Thread::get_hrtime() - start_time));
+  CACHE_SUM_DYN_STAT_THREAD(cache_init_vols_ready_stat, 1);
+  dir_filter_build(vol);
+  vol->ready = true;
+
+  if (cache_config_ram_cache_snapshot && vol->cache_vol->ramcache_enabled) {
+    ram_cache_warm(vol);
+  }
+}
+
 void
 CacheProcessor::stop()
 {
@@ -1091,6 +1117,12 @@ CacheProcessor::open_read(Continuation *cont, const CacheKey *key, CacheFragType
   return caches[frag_type]->open_read(cont, key, frag_type, hostname, hostlen);
 }
 
+void
+CacheProcessor::open_read_batch(CacheReadRequest *reqs, int n, CacheFragType frag_type)
+{
+  caches[frag_type]->open_read_batch(reqs, n, frag_type);
+}
+
 Action *
 CacheProcessor::open_write(Continuation *cont, CacheKey *key, CacheFragType frag_type, int expected_size ATS_UNUSED, int options,
                            time_t pin_in_cache, char *hostname, int host_len)
@@ -1161,7 +1193,14 @@ vol_init_data_internal(Vol *d)
   d->segments = (total_buckets + (((1 << 16) - 1) / DIR_DEPTH)) / ((1 << 16) / DIR_DEPTH);
   // step4: divide total_buckets into segments on average.
   d->buckets = (total_buckets + d->segments - 1) / d->segments;
-  // step5: set the start pointer.
+  // step5: divide the data into log segments, a cyclic volume is a single one.
+  if (d->segmented) {
+    off_t data   = d->len - (d->start - d->skip);
+    d->lseg_size = ROUND_TO_STORE_BLOCK(
+      std::max<off_t>({static_cast<off_t>(cache_config_log_segment_size), MIN_LOG_SEGMENT_SIZE, data / MAX_LOG_SEGMENTS + 1}));
+    d->lsegs = std::max<off_t>(data / d->lseg_size, 1);
+  }
+  // step6: set the start pointer.
   d->start = d->skip + 2 * d->dirlen();
 }
 
@@ -1196,6 +1235,11 @@ vol_clear_init(Vol *d)
 {
   size_t dir_len = d->dirlen();
   memset(d->raw_dir, 0, dir_len);
+  if (d->dir_filter) {
+    for (int s = 0; s < d->segments; s++) {
+      d->dir_filter->clear_segment(s);
+    }
+  }
   vol_init_dir(d);
   d->header->magic          = VOL_MAGIC;
   d->header->version._major = CACHE_DB_MAJOR_VERSION;
@@ -1206,8 +1250,13 @@ vol_clear_init(Vol *d)
   d->header->cycle                                        = 0;
   d->header->create_time                                  = time(nullptr);
   d->header->dirty                                        = 0;
+  d->header->flags                                        = d->wide_tags ? VOL_FLAG_WIDE_TAGS : 0;
   d->sector_size = d->header->sector_size = d->disk->hw_sector_size;
-  *d->footer                              = *d->header;
+  if (d->segmented) {
+    d->header->flags |= VOL_FLAG_SEGMENTED;
+    d->lseg_clear();
+  }
+  *d->footer = *d->header;
 }
 
 int
@@ -1242,6 +1291,33 @@ Vol::clear_dir()
   return 0;
 }
 
+/*
+  Allocate the aggregation buffers, as many as volume.config or
+  proxy.config.cache.agg_buffers asks for.
+*/
+void
+Vol::agg_buffers_init()
+{
+  int count = cache_vol && cache_vol->agg_buffers ? cache_vol->agg_buffers : cache_config_agg_buffers;
+  int size  = cache_vol && cache_vol->agg_size ? cache_vol->agg_size : cache_config_agg_size;
+
+  agg_buffer_count = std::clamp(count, 1, MAX_AGG_BUFFERS);
+  agg_size         = std::clamp(size, static_cast<int>(CACHE_BLOCK_SIZE), AGG_SIZE);
+  agg_buffers      = new AggBuffer[agg_buffer_count];
+  for (int i = 0; i < agg_buffer_count; i++) {
+    AggBuffer *b = &agg_buffers[i];
+    b->mutex     = mutex;
+    b->vol       = this;
+    b->buf       = static_cast<char *>(ats_memalign(ats_pagesize(), AGG_SIZE));
+    memset(b->buf, 0, AGG_SIZE);
+    // The agg buffers are the source of every document write on this volume.
+    ink_aio_register_buffer(b->buf, AGG_SIZE);
+  }
+  agg_fill   = 0;
+  agg_writes = 0;
+  agg_buffer = agg_buffers[0].buf;
+}
+
 int
 Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
 {
@@ -1261,13 +1337,35 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   ink_assert(len <= MAX_VOL_SIZE);
   skip             = dir_skip;
   prev_recover_pos = 0;
+  init_start       = Thread::get_hrtime();
+
+  // the tag extension array and the log segment table are part of the directory, so these have to be known before sizing it
+  wide_tags = cache_vol && cache_vol->wide_tags;
+  segmented = cache_vol && cache_vol->segmented;
 
   // successive approximation, directory/meta data eats up some storage
   start = dir_skip;
   vol_init_data(this);
+  if (segmented && lsegs < 2) {
+    Warning("'%s' is too small for log segments of %" PRId64 " bytes, using the cyclic layout", hash_text.get(), lseg_size);
+    segmented = false;
+    lsegs     = 1;
+    start     = dir_skip;
+    vol_init_data(this);
+  }
+  if (segmented) {
+    lseg_live = new int64_t[lsegs]();
+  } else {
+    lseg_size = skip + len - start;
+  }
   data_blocks         = (len - (start - skip)) / STORE_BLOCK_SIZE;
   hit_evacuate_window = (data_blocks * cache_config_hit_evacuate_percent) / 100;
 
+  dir_seq       = new std::atomic<uint32_t>[segments]();
+  dir_seg_dirty = new uint8_t[segments];
+  // Neither copy on disk is known to match memory until it has been synced once.
+  memset(dir_seg_dirty, DIR_SEG_DIRTY_ALL, segments);
+
   evacuate_size = static_cast<int>(len / EVACUATION_BUCKET_SIZE) + 2;
   int evac_len  = evacuate_size * sizeof(DLL<EvacuationBlock>);
   evacuate      = static_cast<DLL<EvacuationBlock> *>(ats_malloc(evac_len));
@@ -1277,7 +1375,15 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
         (long long)this->len, (double)dirlen() / (double)this->len * 100.0);
 
   raw_dir = nullptr;
-  if (ats_hugepage_enabled()) {
+  if (cache_config_hugepages) {
+    size_t page_size = cache_config_hugepages == 2 ? CACHE_HUGEPAGE_1GB : CACHE_HUGEPAGE_2MB;
+    size_t actual    = 0;
+    raw_dir          = static_cast<char *>(ats_alloc_hugepage_sized(this->dirlen(), page_size, &actual));
+    if (raw_dir && actual != page_size) {
+      Warning("no %zuMB hugepages for the directory of '%s', using %s", page_size >> 20, hash_text.get(),
+              actual ? "the default hugepage size" : "transparent hugepages");
+    }
+  } else if (ats_hugepage_enabled()) {
     raw_dir = static_cast<char *>(ats_alloc_hugepage(this->dirlen()));
   }
   if (raw_dir == nullptr) {
@@ -1287,6 +1393,15 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
   dir    = reinterpret_cast<Dir *>(raw_dir + this->headerlen());
   header = reinterpret_cast<VolHeaderFooter *>(raw_dir);
   footer = reinterpret_cast<VolHeaderFooter *>(raw_dir + this->dirlen() - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  if (segmented) {
+    lseg_geometry = reinterpret_cast<VolLogSegmentGeometry *>(reinterpret_cast<char *>(footer) - this->lseg_table_len());
+    lseg_table    = reinterpret_cast<VolLogSegment *>(lseg_geometry + 1);
+  }
+  if (wide_tags) {
+    tag_ext = reinterpret_cast<uint16_t *>(reinterpret_cast<char *>(footer) - this->lseg_table_len() - this->tag_ext_len());
+  }
+
+  agg_buffers_init();
 
   if (clear) {
     Note("clearing cache directory '%s'", hash_text.get());
@@ -1316,7 +1431,7 @@ Vol::init(char *s, off_t blocks, off_t dir_skip, bool clear)
     aio->thread           = AIO_CALLBACK_THREAD_ANY;
     aio->then             = (i < 3) ? &(init_info->vol_aio[i + 1]) : nullptr;
   }
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   ink_assert(ink_aio_readv(init_info->vol_aio));
 #else
   ink_assert(ink_aio_read(init_info->vol_aio));
@@ -1379,10 +1494,29 @@ Vol::handle_dir_read(int event, void *data)
     clear_dir();
     return EVENT_DONE;
   }
+  if (((header->flags & VOL_FLAG_WIDE_TAGS) != 0) != wide_tags) {
+    Note("directory tag width changed for '%s' (wide_tags=%d), clearing", hash_text.get(), wide_tags);
+    clear_dir();
+    return EVENT_DONE;
+  }
+  if (((header->flags & VOL_FLAG_SEGMENTED) != 0) != segmented) {
+    Note("directory layout changed for '%s' (segmented=%d), clearing", hash_text.get(), segmented);
+    clear_dir();
+    return EVENT_DONE;
+  }
+  if (!lseg_attach()) {
+    Warning("bad log segment table in cache directory for '%s', clearing", hash_text.get());
+    clear_dir();
+    return EVENT_DONE;
+  }
   CHECK_DIR(this);
 
   sector_size = header->sector_size;
 
+  Vol *vol      = this;
+  recover_start = Thread::get_hrtime();
+  CACHE_SUM_DYN_STAT_THREAD(cache_init_dir_read_time_stat, ink_hrtime_to_msec(recover_start - init_start));
+
   return this->recover_data();
 }
 
@@ -1445,15 +1579,20 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
     recover_wrapped   = false;
     last_sync_serial  = 0;
     last_write_serial = 0;
+    recover_lseg      = lseg_cur;
     recover_pos       = header->last_write_pos;
-    if (recover_pos >= skip + len) {
-      recover_wrapped = true;
-      recover_pos     = start;
+    io.aiocb.aio_buf  = static_cast<char *>(ats_memalign(ats_pagesize(), RECOVERY_SIZE));
+    if (lseg_table && (recover_pos < lseg_start(lseg_cur) || recover_pos >= lseg_end(lseg_cur))) {
+      // synced after the segment was opened and before anything was written to it
+      recover_pos = header->write_pos;
+    }
+    if (recover_pos >= lseg_end(recover_lseg) && !recover_next_lseg()) {
+      Warning("no valid directory found while recovering '%s', clearing", hash_text.get());
+      goto Lclear;
     }
-    io.aiocb.aio_buf    = static_cast<char *>(ats_memalign(ats_pagesize(), RECOVERY_SIZE));
     io.aiocb.aio_nbytes = RECOVERY_SIZE;
-    if (static_cast<off_t>(recover_pos + io.aiocb.aio_nbytes) > static_cast<off_t>(skip + len)) {
-      io.aiocb.aio_nbytes = (skip + len) - recover_pos;
+    if (static_cast<off_t>(recover_pos + io.aiocb.aio_nbytes) > static_cast<off_t>(lseg_end(recover_lseg))) {
+      io.aiocb.aio_nbytes = lseg_end(recover_lseg) - recover_pos;
     }
   } else if (event == AIO_EVENT_DONE) {
     if (io.aiocb.aio_nbytes != static_cast<size_t>(io.aio_result)) {
@@ -1499,10 +1638,11 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
   if (got_len) {
     Doc *doc = nullptr;
 
-    if (recover_wrapped && start == io.aiocb.aio_offset) {
+    if (recover_wrapped && lseg_start(recover_lseg) == io.aiocb.aio_offset) {
+      // a segment other than the first one starts with the copy of its table entry
       doc = reinterpret_cast<Doc *>(s);
-      if (doc->magic != DOC_MAGIC || doc->write_serial < last_write_serial) {
-        recover_pos = skip + len - EVACUATION_SIZE;
+      if (doc->magic != DOC_MAGIC || doc->write_serial < last_write_serial || (lseg_table && !lseg_recover_summary(doc))) {
+        recover_pos = lseg_table ? lseg_start(recover_lseg) : skip + len - EVACUATION_SIZE;
         goto Ldone;
       }
     }
@@ -1555,9 +1695,11 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
           // (doc->sync_serial < last_sync_serial) ||
           // (doc->sync_serial > header->sync_serial + 1).
           // if we are too close to the end, wrap around
-          else if (recover_pos - (e - s) > (skip + len) - AGG_SIZE) {
-            recover_wrapped     = true;
-            recover_pos         = start;
+          else if (recover_pos - (e - s) > lseg_end(recover_lseg) - AGG_SIZE) {
+            if (!recover_next_lseg()) {
+              Warning("no valid directory found while recovering '%s', clearing", hash_text.get());
+              goto Lclear;
+            }
             io.aiocb.aio_nbytes = RECOVERY_SIZE;
 
             break;
@@ -1570,9 +1712,11 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
           // If we are in the danger zone - recover_pos is within AGG_SIZE
           // from the end, then wrap around
           recover_pos -= e - s;
-          if (recover_pos > (skip + len) - AGG_SIZE) {
-            recover_wrapped     = true;
-            recover_pos         = start;
+          if (recover_pos > lseg_end(recover_lseg) - AGG_SIZE) {
+            if (!recover_next_lseg()) {
+              Warning("no valid directory found while recovering '%s', clearing", hash_text.get());
+              goto Lclear;
+            }
             io.aiocb.aio_nbytes = RECOVERY_SIZE;
 
             break;
@@ -1595,13 +1739,13 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
         s -= round_to_approx_size(doc->len);
       }
       recover_pos -= e - s;
-      if (recover_pos >= skip + len) {
-        recover_wrapped = true;
-        recover_pos     = start;
+      if (recover_pos >= lseg_end(recover_lseg) && !recover_next_lseg()) {
+        Warning("no valid directory found while recovering '%s', clearing", hash_text.get());
+        goto Lclear;
       }
       io.aiocb.aio_nbytes = RECOVERY_SIZE;
-      if (static_cast<off_t>(recover_pos + io.aiocb.aio_nbytes) > static_cast<off_t>(skip + len)) {
-        io.aiocb.aio_nbytes = (skip + len) - recover_pos;
+      if (static_cast<off_t>(recover_pos + io.aiocb.aio_nbytes) > static_cast<off_t>(lseg_end(recover_lseg))) {
+        io.aiocb.aio_nbytes = lseg_end(recover_lseg) - recover_pos;
       }
     }
   }
@@ -1615,7 +1759,7 @@ Vol::handle_recover_from_data(int event, void * /* data ATS_UNUSED */)
 
 Ldone : {
   /* if we come back to the starting position, then we don't have to recover anything */
-  if (recover_pos == header->write_pos && recover_wrapped) {
+  if (!lseg_table && recover_pos == header->write_pos && recover_wrapped) {
     SET_HANDLER(&Vol::handle_recover_write_dir);
     if (is_debug_tag_set("cache_init")) {
       Note("recovery wrapped around. nothing to clear\n");
@@ -1624,13 +1768,13 @@ Ldone : {
   }
 
   recover_pos += EVACUATION_SIZE; // safely cover the max write size
-  if (recover_pos < header->write_pos && (recover_pos + EVACUATION_SIZE >= header->write_pos)) {
+  if (!lseg_table && recover_pos < header->write_pos && (recover_pos + EVACUATION_SIZE >= header->write_pos)) {
     Debug("cache_init", "Head Pos: %" PRIu64 ", Rec Pos: %" PRIu64 ", Wrapped:%d", header->write_pos, recover_pos, recover_wrapped);
     Warning("no valid directory found while recovering '%s', clearing", hash_text.get());
     goto Lclear;
   }
 
-  if (recover_pos > skip + len) {
+  if (!lseg_table && recover_pos > skip + len) {
     recover_pos -= skip + len;
   }
   // bump sync number so it is different from that in the Doc structs
@@ -1642,7 +1786,9 @@ Ldone : {
   // clear effected portion of the cache
   off_t clear_start = this->offset_to_vol_offset(header->write_pos);
   off_t clear_end   = this->offset_to_vol_offset(recover_pos);
-  if (clear_start <= clear_end) {
+  if (lseg_table) {
+    lseg_recover_clear(recover_pos);
+  } else if (clear_start <= clear_end) {
     dir_clear_range(clear_start, clear_end, this);
   } else {
     dir_clear_range(clear_start, DIR_OFFSET_MAX, this);
@@ -1677,7 +1823,7 @@ Ldone : {
   init_info->vol_aio[2].aiocb.aio_offset = ss + dirlen - footerlen;
 
   SET_HANDLER(&Vol::handle_recover_write_dir);
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   ink_assert(ink_aio_writev(init_info->vol_aio));
 #else
   ink_assert(ink_aio_write(init_info->vol_aio));
@@ -1773,10 +1919,31 @@ Vol::dir_init_done(int /* event ATS_UNUSED */, void * /* data ATS_UNUSED */)
     eventProcessor.schedule_in(this, HRTIME_MSECONDS(5), ET_CALL);
     return EVENT_CONT;
   } else {
-    int vol_no = gnvol++;
-    ink_assert(!gvol[vol_no]);
-    gvol[vol_no] = this;
+    Vol *vol       = this;
+    ink_hrtime now = Thread::get_hrtime();
+    if (recover_start) {
+      CACHE_SUM_DYN_STAT_THREAD(cache_init_recover_time_stat, ink_hrtime_to_msec(now - recover_start));
+    }
+    lseg_count_live();
     SET_HANDLER(&Vol::aggWrite);
+    {
+      ink_scoped_mutex_lock lock(vol_online_mutex);
+      if (fd == -1) {
+        // The directory could be neither read nor cleared. Take the span out of service so the requests that hash
+        // to this stripe go to the others, instead of failing as not ready for as long as the process runs.
+        Warning("unable to initialize cache stripe '%s', marking its span offline", hash_text.get());
+        cacheProcessor.mark_storage_offline(disk);
+      } else if (CacheProcessor::initialized == CACHE_INITIALIZED && !DISK_BAD(disk)) {
+        // The cache is already open for the stripes that were faster, so this one starts serving right away.
+        cacheProcessor.vol_online(this);
+      }
+      int vol_no = gnvol;
+      ink_assert(!gvol[vol_no]);
+      gvol[vol_no] = this;
+      gnvol        = vol_no + 1;
+    }
+    Debug("cache_init", "Vol %s: %s in %" PRId64 "ms", hash_text.get(), fd == -1 ? "failed" : "initialized",
+          static_cast<int64_t>(ink_hrtime_to_msec(now - init_start)));
     cache->vol_initialized(fd != -1);
     return EVENT_DONE;
   }
@@ -1918,7 +2085,9 @@ Cache::vol_initialized(bool result)
   if (result) {
     ink_atomic_increment(&total_good_nvol, 1);
   }
-  if (total_nvol == ink_atomic_increment(&total_initialized_vol, 1) + 1) {
+  bool last = total_nvol == ink_atomic_increment(&total_initialized_vol, 1) + 1;
+  // With proxy.config.cache.init.serve_partial the cache opens with the first good stripe, the rest come online as they finish.
+  if ((last || (result && cache_config_init_serve_partial)) && ink_atomic_cas(&open_started, 0, 1)) {
     open_done();
   }
 }
@@ -1946,8 +2115,9 @@ CacheProcessor::mark_storage_offline(CacheDisk *d, ///< Target disk
     SET_DISK_BAD(d);
   }
 
+  // Only the stripes in service are in the totals.
   for (p = 0; p < gnvol; p++) {
-    if (d->fd == gvol[p]->fd) {
+    if (d->fd == gvol[p]->fd && gvol[p]->ready) {
       total_dir_delete += gvol[p]->buckets * gvol[p]->segments * DIR_DEPTH;
       used_dir_delete += dir_entries_used(gvol[p]);
       total_bytes_delete += gvol[p]->len - gvol[p]->dirlen();
@@ -1963,7 +2133,8 @@ CacheProcessor::mark_storage_offline(CacheDisk *d, ///< Target disk
   RecIncrGlobalRawStat(cache_rsb, admin ? cache_span_online_stat : cache_span_failing_stat, -1);
   RecIncrGlobalRawStat(cache_rsb, cache_span_offline_stat, 1);
 
-  if (theCache) {
+  // Before the cache opens there is no host table yet, it is built without the bad spans.
+  if (theCache && theCache->hosttable) {
     rebuild_host_table(theCache);
   }
 
@@ -1972,7 +2143,7 @@ CacheProcessor::mark_storage_offline(CacheDisk *d, ///< Target disk
     Warning("All storage devices offline, cache disabled");
     CacheProcessor::cache_ready = 0;
   } else { // check cache types specifically
-    if (theCache && !theCache->hosttable->gen_host_rec.vol_hash_table) {
+    if (theCache && theCache->hosttable && !theCache->hosttable->gen_host_rec.vol_hash_table) {
       unsigned int caches_ready = 0;
       caches_ready              = caches_ready | (1 << CACHE_FRAG_TYPE_HTTP);
       caches_ready              = caches_ready | (1 << CACHE_FRAG_TYPE_NONE);
@@ -2097,11 +2268,7 @@ Cache::open(bool clear, bool /* fix ATS_UNUSED */)
             blocks                      = q->b->len;
 
             bool vol_clear = clear || d->cleared || q->new_block;
-#if AIO_MODE == AIO_MODE_NATIVE
             eventProcessor.schedule_imm(new VolInit(cp->vols[vol_no], d->path, blocks, q->b->offset, vol_clear));
-#else
-            cp->vols[vol_no]->init(d->path, blocks, q->b->offset, vol_clear);
-#endif
             vol_no++;
             cache_size += blocks;
           }
@@ -2138,7 +2305,7 @@ CacheVC::is_pread_capable()
 
 #define STORE_COLLISION 1
 
-static void
+void
 unmarshal_helper(Doc *doc, Ptr<IOBufferData> &buf, int &okay)
 {
   using UnmarshalFunc           = int(char *buf, int len, RefCountObj *block_ref);
@@ -2153,6 +2320,9 @@ unmarshal_helper(Doc *doc, Ptr<IOBufferData> &buf, int &okay)
 
   char *tmp = doc->hdr();
   int len   = doc->hlen;
+  int hlen  = CacheAltVectorHeader::length(tmp, len);
+  tmp += hlen;
+  len -= hlen;
   while (len > 0) {
     int r = unmarshal_func(tmp, len, buf.get());
     if (r < 0) {
@@ -2165,6 +2335,66 @@ unmarshal_helper(Doc *doc, Ptr<IOBufferData> &buf, int &okay)
   }
 }
 
+// Media types whose bodies are already compressed, as a prefix of the Content-Type.
+static const std::string_view precompressed_types[] = {
+  "image/jpeg", "image/png", "image/gif", "image/webp", "image/avif", "video/", "audio/", "font/woff",
+  "application/zip", "application/gzip", "application/x-gzip", "application/zstd", "application/x-xz", "application/x-bzip2",
+  "application/x-7z-compressed", "application/vnd.rar",
+};
+
+// Leading bytes of common compressed formats, for fragments with no response header to look at.
+static bool
+precompressed_body(const char *data, uint32_t len)
+{
+  static const std::string_view magics[] = {
+    {"\x1f\x8b", 2},                 // gzip
+    {"\x28\xb5\x2f\xfd", 4},         // zstd
+    {"\xfd\x37\x7a\x58\x5a\x00", 6}, // xz
+    {"BZh", 3},                      // bzip2
+    {"PK\x03\x04", 4},               // zip and everything built on it
+    {"\x89PNG", 4},                  // png
+    {"\xff\xd8\xff", 3},             // jpeg
+    {"GIF8", 4},                     // gif
+    {"wOF2", 4},                     // woff2
+    {"wOFF", 4},                     // woff
+  };
+  std::string_view body(data, len);
+
+  for (auto const &magic : magics) {
+    if (body.substr(0, magic.size()) == magic) {
+      return true;
+    }
+  }
+  // RIFF containers (webp, avi, wav) and ISO media (mp4, mov, avif, heic).
+  return (len >= 12 && (body.substr(0, 4) == "RIFF" || body.substr(4, 4) == "ftyp"));
+}
+
+// Whether @a doc is worth compressing in the RAM cache, going by the @a response of its alternate when we have it.
+bool
+ram_cache_compressible(Doc *doc, HTTPHdr *response)
+{
+  if (!cache_config_ram_cache_compress || !cache_config_ram_cache_compress_adaptive) {
+    return true;
+  }
+  if (doc->doc_type == CACHE_FRAG_TYPE_HTTP && response) {
+    MIMEField *field = response->field_find(MIME_FIELD_CONTENT_ENCODING, MIME_LEN_CONTENT_ENCODING);
+    if (field) {
+      std::string_view encoding = field->value_get();
+      return encoding.empty() || (encoding.size() == 8 && strncasecmp(encoding.data(), "identity", 8) == 0);
+    }
+    if ((field = response->field_find(MIME_FIELD_CONTENT_TYPE, MIME_LEN_CONTENT_TYPE)) != nullptr) {
+      std::string_view type = field->value_get();
+      for (auto const &prefix : precompressed_types) {
+        if (type.size() >= prefix.size() && strncasecmp(type.data(), prefix.data(), prefix.size()) == 0) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+  return !precompressed_body(doc->data(), doc->data_len());
+}
+
 // [amc] I think this is where all disk reads from cache funnel through here.
 int
 CacheVC::handleReadDone(int event, Event *e)
@@ -2175,6 +2405,10 @@ CacheVC::handleReadDone(int event, Event *e)
   Doc *doc = nullptr;
   if (event == AIO_EVENT_DONE) {
     set_io_not_in_progress();
+    if (read_issued) {
+      vol->disk->load.read_done(Thread::get_hrtime_updated() - read_issued);
+      read_issued = 0;
+    }
   } else if (is_io_in_progress()) {
     return EVENT_CONT;
   }
@@ -2229,7 +2463,8 @@ CacheVC::handleReadDone(int event, Event *e)
       if (!f.doc_from_ram_cache) {
         f.not_from_ram_cache = 1;
       }
-      if (cache_config_enable_checksum && doc->checksum != DOC_NO_CHECKSUM) {
+      // only the header was read when the data goes to the client straight from disk
+      if (cache_config_enable_checksum && doc->checksum != DOC_NO_CHECKSUM && !f.header_only) {
         // verify that the checksum matches
         uint32_t checksum = 0;
         for (char *b = doc->hdr(); b < reinterpret_cast<char *>(doc) + doc->len; b++) {
@@ -2254,7 +2489,7 @@ CacheVC::handleReadDone(int event, Event *e)
         unmarshal_helper(doc, buf, okay);
       }
       // Put the request in the ram cache only if its a open_read or lookup
-      if (vio.op == VIO::READ && okay) {
+      if (vio.op == VIO::READ && okay && !f.header_only) {
         bool cutoff_check;
         // cutoff_check :
         // doc_len == 0 for the first fragment (it is set from the vector)
@@ -2267,7 +2502,8 @@ CacheVC::handleReadDone(int event, Event *e)
            (doc_len && static_cast<int64_t>(doc_len) < cache_config_ram_cache_cutoff) || !cache_config_ram_cache_cutoff);
         if (cutoff_check && !f.doc_from_ram_cache) {
           uint64_t o = dir_offset(&dir);
-          vol->ram_cache->put(read_key, buf.get(), doc->len, http_copy_hdr, o);
+          vol->ram_cache->put(read_key, buf.get(), doc->len, http_copy_hdr, o,
+                              ram_cache_compressible(doc, alternate.valid() ? alternate.response_get() : nullptr));
         }
         if (!doc_len) {
           // keep a pointer to it. In case the state machine decides to
@@ -2307,16 +2543,16 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
 
   // check if it was read in the last open_read call
   if (*read_key == vol->first_fragment_key && dir_offset(&dir) == vol->first_fragment_offset) {
-    buf = vol->first_fragment_data;
+    buf           = vol->first_fragment_data;
+    f.header_only = 0;
     goto LmemHit;
   }
   // see if its in the aggregation buffer
   if (dir_agg_buf_valid(vol, &dir)) {
-    int agg_offset = vol->vol_offset(&dir) - vol->header->write_pos;
-    buf            = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
-    ink_assert((agg_offset + io.aiocb.aio_nbytes) <= (unsigned)vol->agg_buf_pos);
+    f.header_only = 0;
+    char *agg = vol->agg_buf_data(vol->vol_offset(&dir), io.aiocb.aio_nbytes);
+    buf       = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
     char *doc = buf->data();
-    char *agg = vol->agg_buffer + agg_offset;
     memcpy(doc, agg, io.aiocb.aio_nbytes);
     io.aio_result = io.aiocb.aio_nbytes;
     SET_HANDLER(&CacheVC::handleReadDone);
@@ -2328,17 +2564,26 @@ CacheVC::handleRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   if (static_cast<off_t>(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > static_cast<off_t>(vol->skip + vol->len)) {
     io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
   }
+  // the data is sent to the client from disk, only the header is needed here
+  if (f.header_only && vol->clear_of_write_head(&dir)) {
+    io.aiocb.aio_nbytes = std::min<size_t>(io.aiocb.aio_nbytes, CACHE_BLOCK_SIZE);
+  } else {
+    f.header_only = 0;
+  }
   buf              = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
   io.aiocb.aio_buf = buf->data();
   io.action        = this;
   io.thread        = mutex->thread_holding->tt == DEDICATED ? AIO_CALLBACK_THREAD_ANY : mutex->thread_holding;
   SET_HANDLER(&CacheVC::handleReadDone);
+  read_issued = Thread::get_hrtime();
+  vol->disk->load.read_start();
   ink_assert(ink_aio_read(&io) >= 0);
   CACHE_DEBUG_INCREMENT_DYN_STAT(cache_pread_count_stat);
   return EVENT_CONT;
 
 LramHit : {
   f.doc_from_ram_cache = true;
+  f.header_only        = 0;
   io.aio_result        = io.aiocb.aio_nbytes;
   Doc *doc             = reinterpret_cast<Doc *>(buf->data());
   if (cache_config_ram_cache_compress && doc->doc_type == CACHE_FRAG_TYPE_HTTP && doc->hlen) {
@@ -2361,7 +2606,12 @@ Cache::lookup(Continuation *cont, const CacheKey *key, CacheFragType type, const
     return ACTION_RESULT_DONE;
   }
 
-  Vol *vol          = key_to_vol(key, hostname, host_len);
+  Vol *vol = key_to_vol(key, hostname, host_len);
+  if (vol_not_ready(vol)) {
+    cont->handleEvent(CACHE_EVENT_LOOKUP_FAILED, nullptr);
+    return ACTION_RESULT_DONE;
+  }
+
   ProxyMutex *mutex = cont->mutex.get();
   CacheVC *c        = new_CacheVC(cont);
   SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
@@ -2430,6 +2680,7 @@ CacheVC::removeEvent(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
       if (doc->first_key == key) {
         ink_assert(doc->magic == DOC_MAGIC);
         if (dir_delete(&key, vol, &dir) > 0) {
+          tier_invalidate(&key, vol);
           if (od) {
             vol->close_write(this);
           }
@@ -2481,6 +2732,10 @@ Cache::remove(Continuation *cont, const CacheKey *key, CacheFragType type, const
   CACHE_TRY_LOCK(lock, cont->mutex, this_ethread());
   ink_assert(lock.is_locked());
   Vol *vol = key_to_vol(key, hostname, host_len);
+  if (vol_not_ready(vol)) {
+    cont->handleEvent(CACHE_EVENT_REMOVE_FAILED, nullptr);
+    return ACTION_RESULT_DONE;
+  }
   // coverity[var_decl]
   Dir result;
   dir_clear(&result); // initialized here, set result empty so we can recognize missed lock
@@ -2560,6 +2815,11 @@ cplist_update()
       if (config_vol->number == cp->vol_number) {
         if (cp->scheme == config_vol->scheme) {
           cp->ramcache_enabled = config_vol->ramcache_enabled;
+          cp->wide_tags        = config_vol->wide_tags;
+          cp->fast_tier        = config_vol->fast_tier;
+          cp->segmented        = config_vol->segmented;
+          cp->agg_buffers      = config_vol->agg_buffers;
+          cp->agg_size         = config_vol->agg_size;
           config_vol->cachep   = cp;
         } else {
           /* delete this volume from all the disks */
@@ -2809,8 +3069,8 @@ cplist_reconfigure()
                 (int64_t)config_vol->size, 128);
         Warning("volume %d is not created", config_vol->number);
       }
-      Debug("cache_hosting", "Volume: %d Size: %" PRId64 " Ramcache: %d", config_vol->number, (int64_t)config_vol->size,
-            config_vol->ramcache_enabled);
+      Debug("cache_hosting", "Volume: %d Size: %" PRId64 " Ramcache: %d Wide tags: %d Fast tier: %d", config_vol->number,
+            (int64_t)config_vol->size, config_vol->ramcache_enabled, config_vol->wide_tags, config_vol->fast_tier);
     }
     cplist_update();
 
@@ -2833,8 +3093,13 @@ cplist_reconfigure()
       if (!config_vol->cachep) {
         // we did not find a corresponding entry in cache vol...create one
 
-        CacheVol *new_cp  = new CacheVol();
-        new_cp->disk_vols = static_cast<DiskVol **>(ats_malloc(gndisks * sizeof(DiskVol *)));
+        CacheVol *new_cp    = new CacheVol();
+        new_cp->wide_tags   = config_vol->wide_tags;
+        new_cp->fast_tier   = config_vol->fast_tier;
+        new_cp->segmented   = config_vol->segmented;
+        new_cp->agg_buffers = config_vol->agg_buffers;
+        new_cp->agg_size    = config_vol->agg_size;
+        new_cp->disk_vols   = static_cast<DiskVol **>(ats_malloc(gndisks * sizeof(DiskVol *)));
         memset(new_cp->disk_vols, 0, gndisks * sizeof(DiskVol *));
         if (create_volume(config_vol->number, size_in_blocks, config_vol->scheme, new_cp)) {
           ats_free(new_cp->disk_vols);
@@ -3009,6 +3274,9 @@ void
 rebuild_host_table(Cache *cache)
 {
   build_vol_hash_table(&cache->hosttable->gen_host_rec);
+  if (cache->hosttable->tier_host_rec.num_vols) {
+    build_vol_hash_table(&cache->hosttable->tier_host_rec);
+  }
   if (cache->hosttable->m_numEntries != 0) {
     CacheHostMatcher *hm   = cache->hosttable->getHostMatcher();
     CacheHostRecord *h_rec = hm->getDataArray();
@@ -3055,6 +3323,18 @@ Cache::key_to_vol(const CacheKey *key, const char *hostname, int host_len)
   }
 }
 
+Vol *
+Cache::key_to_tier_vol(const CacheKey *key)
+{
+  CacheHostRecord *tier_rec  = &hosttable->tier_host_rec;
+  unsigned short *hash_table = tier_rec->vol_hash_table;
+
+  if (!hash_table) {
+    return nullptr;
+  }
+  return tier_rec->vols[hash_table[(key->slice32(2) >> DIR_TAG_WIDTH) % VOL_HASH_TABLE_SIZE]];
+}
+
 static void
 reg_int(const char *str, int stat, RecRawStatBlock *rsb, const char *prefix, RecRawStatSyncCb sync_cb = RecRawStatSyncSum)
 {
@@ -3077,6 +3357,26 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("ram_cache.bytes_used", cache_ram_cache_bytes_stat);
   REG_INT("ram_cache.hits", cache_ram_cache_hits_stat);
   REG_INT("ram_cache.misses", cache_ram_cache_misses_stat);
+  REG_INT("ram_cache.admission_rejected", cache_ram_cache_admission_rejected_stat);
+  REG_INT("ram_cache.compress.skipped", cache_ram_cache_compress_skipped_stat);
+  REG_INT("ram_cache.warm.pending", cache_ram_cache_warm_pending_stat);
+  REG_INT("ram_cache.warm.objects", cache_ram_cache_warm_objects_stat);
+  REG_INT("ram_cache.warm.bytes", cache_ram_cache_warm_bytes_stat);
+  REG_INT("ram_cache.warm.misses", cache_ram_cache_warm_misses_stat);
+  {
+    static const char *compression_names[CACHE_COMPRESSION_TYPES] = {"fastlz", "libz", "liblzma", "zstd", "lz4"};
+    char name[64];
+    for (int i = 0; i < CACHE_COMPRESSION_TYPES; ++i) {
+      snprintf(name, sizeof(name), "ram_cache.compress.%s.in_bytes", compression_names[i]);
+      REG_INT(name, cache_ram_cache_compress_in_bytes_stat + i);
+      snprintf(name, sizeof(name), "ram_cache.compress.%s.out_bytes", compression_names[i]);
+      REG_INT(name, cache_ram_cache_compress_out_bytes_stat + i);
+      snprintf(name, sizeof(name), "ram_cache.compress.%s.time", compression_names[i]);
+      REG_INT(name, cache_ram_cache_compress_time_stat + i);
+      snprintf(name, sizeof(name), "ram_cache.compress.%s.decompress_time", compression_names[i]);
+      REG_INT(name, cache_ram_cache_decompress_time_stat + i);
+    }
+  }
   REG_INT("pread_count", cache_pread_count_stat);
   REG_INT("percent_full", cache_percent_full_stat);
   REG_INT("lookup.active", cache_lookup_active_stat);
@@ -3104,11 +3404,26 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("direntries.total", cache_direntries_total_stat);
   REG_INT("direntries.used", cache_direntries_used_stat);
   REG_INT("directory_collision", cache_directory_collision_count_stat);
+  REG_INT("directory_collision_read", cache_directory_collision_read_stat);
+  REG_INT("directory_collision_avoided", cache_directory_collision_avoided_stat);
+  REG_INT("directory_seqlock_retry", cache_directory_seqlock_retry_stat);
+  REG_INT("vol_lock.contention", cache_vol_lock_contention_stat);
+  REG_INT("vol_lock.bypassed", cache_vol_lock_bypass_stat);
+  REG_INT("vol_lock.batched", cache_vol_lock_batched_stat);
+  REG_INT("dir_filter.lookups", cache_dir_filter_lookup_stat);
+  REG_INT("dir_filter.misses", cache_dir_filter_miss_stat);
+  REG_INT("dir_filter.false_positives", cache_dir_filter_false_positive_stat);
+  REG_INT("write_throttle.shed_once", cache_write_throttle_once_stat);
+  REG_INT("write_throttle.shed_large", cache_write_throttle_large_stat);
+  REG_INT("write_throttle.slow_disks", cache_write_throttle_slow_disks_stat);
   REG_INT("frags_per_doc.1", cache_single_fragment_document_count_stat);
   REG_INT("frags_per_doc.2", cache_two_fragment_document_count_stat);
   REG_INT("frags_per_doc.3+", cache_three_plus_plus_fragment_document_count_stat);
   REG_INT("read_busy.success", cache_read_busy_success_stat);
   REG_INT("read_busy.failure", cache_read_busy_failure_stat);
+  REG_INT("read_busy.wakeups", cache_read_busy_wakeup_stat);
+  REG_INT("read_busy.timeouts", cache_read_busy_timeout_stat);
+  REG_INT("read_busy.wait_time", cache_read_busy_wait_stat);
   REG_INT("write_bytes_stat", cache_write_bytes_stat);
   REG_INT("vector_marshals", cache_hdr_vector_marshal_stat);
   REG_INT("hdr_marshals", cache_hdr_marshal_stat);
@@ -3119,6 +3434,32 @@ register_cache_stats(RecRawStatBlock *rsb, const char *prefix)
   REG_INT("sync.count", cache_directory_sync_count_stat);
   REG_INT("sync.bytes", cache_directory_sync_bytes_stat);
   REG_INT("sync.time", cache_directory_sync_time_stat);
+  REG_INT("sync.last_bytes", cache_directory_sync_last_bytes_stat);
+  REG_INT("sync.last_time", cache_directory_sync_last_time_stat);
+  REG_INT("sync.segments", cache_directory_sync_segments_stat);
+  REG_INT("init.span_time", cache_init_span_time_stat);
+  REG_INT("init.dir_read_time", cache_init_dir_read_time_stat);
+  REG_INT("init.recover_time", cache_init_recover_time_stat);
+  REG_INT("init.ready_time", cache_init_ready_time_stat);
+  REG_INT("init.stripes_ready", cache_init_vols_ready_stat);
+  REG_INT("vol.not_ready", cache_vol_not_ready_stat);
+
+  REG_INT("tier.fast.hits", cache_tier_fast_hit_stat);
+  REG_INT("tier.fast.misses", cache_tier_fast_miss_stat);
+  REG_INT("tier.slow.hits", cache_tier_slow_hit_stat);
+  REG_INT("tier.slow.misses", cache_tier_slow_miss_stat);
+  REG_INT("tier.promoted", cache_tier_promote_stat);
+  REG_INT("tier.promoted_bytes", cache_tier_promote_bytes_stat);
+  REG_INT("tier.move_aborted", cache_tier_move_aborted_stat);
+  REG_INT("tier.demoted", cache_tier_demote_stat);
+  REG_INT("tier.demoted_bytes", cache_tier_demote_bytes_stat);
+  REG_INT("tier.invalidated", cache_tier_invalidate_stat);
+
+  REG_INT("agg_buffer.wait_time", cache_agg_buffer_wait_stat);
+  REG_INT("agg_buffer.overflow", cache_agg_buffer_overflow_stat);
+  REG_INT("log_segment.opened", cache_log_segment_open_stat);
+  REG_INT("log_segment.live_bytes_overwritten", cache_log_segment_live_stat);
+
   REG_INT("span.errors.read", cache_span_errors_read_stat);
   REG_INT("span.errors.write", cache_span_errors_write_stat);
   REG_INT("span.failing", cache_span_failing_stat);
@@ -3152,7 +3493,13 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_algorithm, "proxy.config.cache.ram_cache.algorithm");
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress, "proxy.config.cache.ram_cache.compress");
   REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress_percent, "proxy.config.cache.ram_cache.compress_percent");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress_adaptive, "proxy.config.cache.ram_cache.compress_adaptive");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_compress_dict_size,
+                                 "proxy.config.cache.ram_cache.compress_dictionary_size");
   REC_ReadConfigInt32(cache_config_ram_cache_use_seen_filter, "proxy.config.cache.ram_cache.use_seen_filter");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_snapshot, "proxy.config.cache.ram_cache.snapshot.enabled");
+  REC_EstablishStaticConfigInt32(cache_config_ram_cache_snapshot_interval, "proxy.config.cache.ram_cache.snapshot.interval");
+  REC_EstablishStaticConfigInteger(cache_config_ram_cache_warm_rate, "proxy.config.cache.ram_cache.snapshot.warm_rate");
 
   REC_EstablishStaticConfigInt32(cache_config_http_max_alts, "proxy.config.cache.limits.http.max_alts");
   Debug("cache_init", "proxy.config.cache.limits.http.max_alts = %d", cache_config_http_max_alts);
@@ -3170,9 +3517,38 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_dir_sync_frequency, "proxy.config.cache.dir.sync_frequency");
   Debug("cache_init", "proxy.config.cache.dir.sync_frequency = %d", cache_config_dir_sync_frequency);
 
+  REC_EstablishStaticConfigInt32(cache_config_dir_sync_incremental, "proxy.config.cache.dir.sync_incremental");
+  Debug("cache_init", "proxy.config.cache.dir.sync_incremental = %d", cache_config_dir_sync_incremental);
+
+  REC_ReadConfigInt32(cache_config_init_serve_partial, "proxy.config.cache.init.serve_partial");
+  Debug("cache_init", "proxy.config.cache.init.serve_partial = %d", cache_config_init_serve_partial);
+
+  REC_EstablishStaticConfigInt32(cache_config_tier_promote_hits, "proxy.config.cache.tier.promote_hits");
+  Debug("cache_init", "proxy.config.cache.tier.promote_hits = %d", cache_config_tier_promote_hits);
+  REC_EstablishStaticConfigInt32(cache_config_tier_demote, "proxy.config.cache.tier.demote");
+  Debug("cache_init", "proxy.config.cache.tier.demote = %d", cache_config_tier_demote);
+
+  REC_ReadConfigInt32(cache_config_hugepages, "proxy.config.cache.hugepages");
+  Debug("cache_init", "proxy.config.cache.hugepages = %d", cache_config_hugepages);
+  if (cache_config_hugepages) {
+    // The RAM cache holds on to the buffers documents are read into, so back those with hugepages as well. A chunk
+    // of buffers is nowhere near 1GB, so these always use 2MB pages.
+    for (auto &allocator : ioBufAllocator) {
+      allocator.use_hugepages(CACHE_HUGEPAGE_2MB);
+    }
+  }
+
+  REC_ReadConfigInt32(cache_config_dir_filter, "proxy.config.cache.dir_filter.enabled");
+  Debug("cache_init", "proxy.config.cache.dir_filter.enabled = %d", cache_config_dir_filter);
+  REC_ReadConfigInt32(cache_config_dir_filter_counters, "proxy.config.cache.dir_filter.counters_per_entry");
+  Debug("cache_init", "proxy.config.cache.dir_filter.counters_per_entry = %d", cache_config_dir_filter_counters);
+
   REC_EstablishStaticConfigInt32(cache_config_select_alternate, "proxy.config.cache.select_alternate");
   Debug("cache_init", "proxy.config.cache.select_alternate = %d", cache_config_select_alternate);
 
+  REC_EstablishStaticConfigInt32(cache_config_alt_vector_compact, "proxy.config.cache.alt_vector.compact");
+  Debug("cache_init", "proxy.config.cache.alt_vector.compact = %d", cache_config_alt_vector_compact);
+
   REC_EstablishStaticConfigInt32(cache_config_max_doc_size, "proxy.config.cache.max_doc_size");
   Debug("cache_init", "proxy.config.cache.max_doc_size = %d = %dMb", cache_config_max_doc_size,
         cache_config_max_doc_size / (1024 * 1024));
@@ -3208,9 +3584,30 @@ ink_cache_init(ts::ModuleVersion v)
   REC_EstablishStaticConfigInt32(cache_config_agg_write_backlog, "proxy.config.cache.agg_write_backlog");
   Debug("cache_init", "proxy.config.cache.agg_write_backlog = %d", cache_config_agg_write_backlog);
 
+  REC_EstablishStaticConfigInt32(cache_config_write_throttle, "proxy.config.cache.write_throttle.enabled");
+  REC_EstablishStaticConfigInt32(cache_config_write_throttle_read_p99, "proxy.config.cache.write_throttle.read_p99");
+  REC_EstablishStaticConfigInt32(cache_config_write_throttle_queue_depth, "proxy.config.cache.write_throttle.queue_depth");
+  REC_EstablishStaticConfigInteger(cache_config_write_throttle_max_size, "proxy.config.cache.write_throttle.max_object_size");
+  REC_EstablishStaticConfigInt32(cache_config_write_throttle_interval, "proxy.config.cache.write_throttle.interval");
+  Debug("cache_init",
+        "proxy.config.cache.write_throttle.enabled = %d, read_p99 = %d ms, queue_depth = %d, max_object_size = %" PRId64
+        ", interval = %d ms",
+        cache_config_write_throttle, cache_config_write_throttle_read_p99, cache_config_write_throttle_queue_depth,
+        cache_config_write_throttle_max_size, cache_config_write_throttle_interval);
+
+  REC_ReadConfigInt32(cache_config_agg_buffers, "proxy.config.cache.agg_buffers");
+  Debug("cache_init", "proxy.config.cache.agg_buffers = %d", cache_config_agg_buffers);
+  REC_ReadConfigInt32(cache_config_agg_size, "proxy.config.cache.agg_size");
+  Debug("cache_init", "proxy.config.cache.agg_size = %d", cache_config_agg_size);
+  REC_ReadConfigInteger(cache_config_log_segment_size, "proxy.config.cache.log_segment_size");
+  Debug("cache_init", "proxy.config.cache.log_segment_size = %" PRId64, cache_config_log_segment_size);
+
   REC_EstablishStaticConfigInt32(cache_config_enable_checksum, "proxy.config.cache.enable_checksum");
   Debug("cache_init", "proxy.config.cache.enable_checksum = %d", cache_config_enable_checksum);
 
+  REC_EstablishStaticConfigInteger(cache_config_zero_copy_min_size, "proxy.config.cache.zero_copy_min_size");
+  Debug("cache_init", "proxy.config.cache.zero_copy_min_size = %" PRId64, cache_config_zero_copy_min_size);
+
   REC_EstablishStaticConfigInt32(cache_config_alt_rewrite_max_size, "proxy.config.cache.alt_rewrite_max_size");
   Debug("cache_init", "proxy.config.cache.alt_rewrite_max_size = %d", cache_config_alt_rewrite_max_size);
 
@@ -27,12 +27,18 @@
 #include "tscore/Regression.h"
 #include "tscore/Random.h"
 
+#include <algorithm>
+
 // #define LOOP_CHECK_MODE 1
 #ifdef LOOP_CHECK_MODE
 #define DIR_LOOP_THRESHOLD 1000
 #endif
 #include "tscore/ink_stack_trace.h"
 
+#if DIR_PROBE_SIMD
+#include <tmmintrin.h>
+#endif
+
 #define CACHE_INC_DIR_USED(_m)                            \
   do {                                                    \
     ProxyMutex *mutex = _m.get();                         \
@@ -51,6 +57,12 @@
     CACHE_INCREMENT_DYN_STAT(cache_directory_collision_count_stat); \
   } while (0);
 
+#define CACHE_INC_DIR_COLLISIONS_AVOIDED(_m)                          \
+  do {                                                                \
+    ProxyMutex *mutex = _m.get();                                     \
+    CACHE_INCREMENT_DYN_STAT(cache_directory_collision_avoided_stat); \
+  } while (0);
+
 // Globals
 
 ClassAllocator<OpenDirEntry> openDirEntryAllocator("openDirEntry");
@@ -58,11 +70,6 @@ Dir empty_dir;
 
 // OpenDir
 
-OpenDir::OpenDir()
-{
-  SET_HANDLER(&OpenDir::signal_readers);
-}
-
 /*
    If allow_if_writers is false, open_write fails if there are other writers.
    max_writers sets the maximum number of concurrent writers that are
@@ -103,47 +110,23 @@ OpenDir::open_write(CacheVC *cont, int allow_if_writers, int max_writers)
   cont->od           = od;
   cont->write_vector = &od->vector;
   bucket[b].push(od);
+  bucket_entries[b].fetch_add(1, std::memory_order_release);
   return 1;
 }
 
-int
-OpenDir::signal_readers(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
-{
-  Queue<CacheVC, Link_CacheVC_opendir_link> newly_delayed_readers;
-  EThread *t = mutex->thread_holding;
-  CacheVC *c = nullptr;
-  while ((c = delayed_readers.dequeue())) {
-    CACHE_TRY_LOCK(lock, c->mutex, t);
-    if (lock.is_locked()) {
-      c->f.open_read_timeout = 0;
-      c->handleEvent(EVENT_IMMEDIATE, nullptr);
-      continue;
-    }
-    newly_delayed_readers.push(c);
-  }
-  if (newly_delayed_readers.head) {
-    delayed_readers = newly_delayed_readers;
-    EThread *t1     = newly_delayed_readers.head->mutex->thread_holding;
-    if (!t1) {
-      t1 = mutex->thread_holding;
-    }
-    t1->schedule_in(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
-  }
-  return 0;
-}
-
 int
 OpenDir::close_write(CacheVC *cont)
 {
   ink_assert(cont->vol->mutex->thread_holding == this_ethread());
   cont->od->writers.remove(cont);
   cont->od->num_writers--;
+  // Readers that picked this writer must notice it is gone.
+  cont->od->signal_readers();
   if (!cont->od->writers.head) {
     unsigned int h = cont->first_key.slice32(0);
     int b          = h % OPEN_DIR_BUCKETS;
     bucket[b].remove(cont->od);
-    delayed_readers.append(cont->od->readers);
-    signal_readers(0, nullptr);
+    bucket_entries[b].fetch_sub(1, std::memory_order_release);
     cont->od->vector.clear();
     THREAD_FREE(cont->od, openDirEntryAllocator, cont->mutex->thread_holding);
   }
@@ -164,17 +147,46 @@ OpenDir::open_read(const CryptoHash *key)
   return nullptr;
 }
 
+/*
+   Park a reader until one of the writers makes progress. The reader keeps
+   its retry timer as a fallback in case the wakeup cannot be delivered.
+   */
 int
-OpenDirEntry::wait(CacheVC *cont, int msec)
+OpenDirEntry::wait(CacheVC *cont, ink_hrtime delay)
 {
   ink_assert(cont->vol->mutex->thread_holding == this_ethread());
-  cont->f.open_read_timeout = 1;
-  ink_assert(!cont->trigger);
-  cont->trigger = cont->vol->mutex->thread_holding->schedule_in_local(cont, HRTIME_MSECONDS(msec));
+  ink_assert(!cont->trigger && !cont->f.wait_for_writer);
+  cont->f.wait_for_writer = 1;
+  cont->wait_od           = this;
+  cont->wait_woken        = false;
+  cont->wait_start        = Thread::get_hrtime();
+  cont->trigger           = cont->mutex->thread_holding->schedule_in_local(cont, delay);
   readers.push(cont);
   return EVENT_CONT;
 }
 
+/*
+   Wake every parked reader on the thread it is waiting on. Readers whose
+   mutex is busy are left to their retry timer, which counts as a timeout
+   rather than a wakeup. Called with the Vol lock held.
+   */
+void
+OpenDirEntry::signal_readers()
+{
+  CacheVC *c = nullptr;
+  while ((c = readers.pop())) {
+    c->wait_od = nullptr;
+    CACHE_TRY_LOCK(lock, c->mutex, this_ethread());
+    if (!lock.is_locked() || !c->trigger) {
+      continue;
+    }
+    EThread *t = c->trigger->ethread;
+    c->cancel_trigger();
+    c->trigger    = t->schedule_imm(c, EVENT_INTERVAL);
+    c->wait_woken = true;
+  }
+}
+
 //
 // Cache Directory
 //
@@ -210,11 +222,132 @@ dir_bucket_loop_check(Dir *start_dir, Dir *seg)
   return 1;
 }
 
+/*
+  Marks segment @a s as being modified for the lifetime of the scope, the
+  writer side of the seqlock read by dir_probe_unlocked(). Writers already
+  hold the Vol lock so there is only ever one, and a scope opened inside
+  another one on the same segment does nothing. The segment is also flagged
+  for the next incremental sync of both directory copies.
+*/
+class DirSegmentWriteScope
+{
+public:
+  DirSegmentWriteScope(Vol *d, int s) : seq(d->dir_seq ? &d->dir_seq[s] : nullptr)
+  {
+    if (d->dir_seg_dirty) {
+      d->dir_seg_dirty[s] = DIR_SEG_DIRTY_ALL;
+    }
+    if (seq) {
+      uint32_t v = seq->load(std::memory_order_relaxed);
+      if (v & 1) {
+        seq = nullptr;
+      } else {
+        seq->store(v + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+      }
+    }
+  }
+
+  ~DirSegmentWriteScope()
+  {
+    if (seq) {
+      seq->store(seq->load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+  }
+
+private:
+  std::atomic<uint32_t> *seq;
+};
+
+//
+// Directory filter
+//
+
+DirFilter::DirFilter(int nsegments, int64_t buckets, int counters_per_entry) : segments(nsegments)
+{
+  // 16 counters per word
+  seg_words = std::max<int64_t>(1, (buckets * DIR_DEPTH * counters_per_entry + 15) / 16);
+  words     = new std::atomic<uint64_t>[segments * seg_words]();
+}
+
+DirFilter::~DirFilter()
+{
+  delete[] words;
+}
+
+std::atomic<uint64_t> &
+DirFilter::word(int s, int64_t b, uint32_t tag, uint16_t tag_ext, uint64_t *h) const
+{
+  uint64_t x = (static_cast<uint64_t>(b) << 32) | (static_cast<uint64_t>(tag) << 16) | tag_ext;
+  // 64 bit finalizer of MurmurHash3, the bucket and tag bits are anything but random.
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  *h = x;
+  return words[s * seg_words + static_cast<int64_t>(((x >> 32) * seg_words) >> 32)];
+}
+
+void
+DirFilter::update(int s, int64_t b, uint32_t tag, uint16_t tag_ext, bool inc)
+{
+  uint64_t h;
+  std::atomic<uint64_t> &w = word(s, b, tag, tag_ext, &h);
+  uint64_t v               = w.load(std::memory_order_relaxed);
+  for (int i = 0; i < DIR_FILTER_HASHES; ++i) {
+    int shift  = ((h >> (4 * i)) & 0xF) * 4;
+    uint64_t c = (v >> shift) & 0xF;
+    if (c == DIR_FILTER_COUNTER_MAX || (!inc && c == 0)) {
+      continue;
+    }
+    v = inc ? v + (1ULL << shift) : v - (1ULL << shift);
+  }
+  w.store(v, std::memory_order_relaxed);
+}
+
+void
+DirFilter::add(int s, int64_t b, uint32_t tag, uint16_t tag_ext)
+{
+  update(s, b, tag, tag_ext, true);
+}
+
+void
+DirFilter::remove(int s, int64_t b, uint32_t tag, uint16_t tag_ext)
+{
+  update(s, b, tag, tag_ext, false);
+}
+
+bool
+DirFilter::maybe_contains(int s, int64_t b, uint32_t tag, uint16_t tag_ext) const
+{
+  uint64_t h;
+  uint64_t v = word(s, b, tag, tag_ext, &h).load(std::memory_order_relaxed);
+  for (int i = 0; i < DIR_FILTER_HASHES; ++i) {
+    if (!((v >> (((h >> (4 * i)) & 0xF) * 4)) & 0xF)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+DirFilter::clear_segment(int s)
+{
+  for (int64_t i = 0; i < seg_words; ++i) {
+    words[s * seg_words + i].store(0, std::memory_order_relaxed);
+  }
+}
+
 // adds all the directory entries
 // in a segment to the segment freelist
 void
 dir_init_segment(int s, Vol *d)
 {
+  DirSegmentWriteScope write_scope(d, s);
+  if (d->dir_filter) {
+    d->dir_filter->clear_segment(s);
+  }
   d->header->freelist[s] = 0;
   Dir *seg               = d->dir_segment(s);
   int l, b;
@@ -315,8 +448,36 @@ unlink_from_freelist(Dir *e, int s, Vol *d)
   }
 }
 
-inline Dir *
-dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
+// With wide tags the entry's upper tag bits live in a parallel array indexed like the directory.
+static inline uint16_t *
+dir_tag_ext(const Dir *e, Vol *d)
+{
+  return d->tag_ext + (e - d->dir);
+}
+
+/*
+  The filter counts every entry linked into the chain of bucket @a b, the
+  bucket head only while it holds a Doc. Entries are counted with the tag they
+  were linked with, which does not change until they are unlinked.
+*/
+static inline void
+dir_filter_add(Vol *d, int s, int64_t b, const Dir *e)
+{
+  if (d->dir_filter) {
+    d->dir_filter->add(s, b, dir_tag(e), d->tag_ext ? *dir_tag_ext(e, d) : 0);
+  }
+}
+
+static inline void
+dir_filter_remove(Vol *d, int s, int64_t b, const Dir *e)
+{
+  if (d->dir_filter) {
+    d->dir_filter->remove(s, b, dir_tag(e), d->tag_ext ? *dir_tag_ext(e, d) : 0);
+  }
+}
+
+static Dir *
+dir_unlink_entry(Dir *e, Dir *p, int s, Vol *d)
 {
   Dir *seg         = d->dir_segment(s);
   int no           = dir_next(e);
@@ -335,7 +496,11 @@ dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
     Dir *n = next_dir(e, seg);
     if (n) {
       dir_assign(e, n);
-      dir_delete_entry(n, e, s, d);
+      if (d->tag_ext) {
+        *dir_tag_ext(e, d) = *dir_tag_ext(n, d);
+      }
+      // n lives on in the bucket head, so it stays in the filter
+      dir_unlink_entry(n, e, s, d);
       return e;
     } else {
       dir_clear(e);
@@ -345,11 +510,22 @@ dir_delete_entry(Dir *e, Dir *p, int s, Vol *d)
   return dir_from_offset(no, seg);
 }
 
+// Unlink @a e, following @a p in the chain of bucket @a b, and drop it from the filter.
+inline Dir *
+dir_delete_entry(Dir *e, Dir *p, int64_t b, int s, Vol *d)
+{
+  if (p || dir_offset(e)) {
+    dir_filter_remove(d, s, b, e);
+  }
+  return dir_unlink_entry(e, p, s, d);
+}
+
 inline void
 dir_clean_bucket(Dir *b, int s, Vol *vol)
 {
   Dir *e = b, *p = nullptr;
-  Dir *seg = vol->dir_segment(s);
+  Dir *seg   = vol->dir_segment(s);
+  int64_t bi = (b - seg) / DIR_DEPTH;
 #ifdef LOOP_CHECK_MODE
   int loop_count = 0;
 #endif
@@ -369,7 +545,7 @@ dir_clean_bucket(Dir *b, int s, Vol *vol)
       if (dir_offset(e)) {
         CACHE_DEC_DIR_USED(vol->mutex);
       }
-      e = dir_delete_entry(e, p, s, vol);
+      e = dir_delete_entry(e, p, bi, s, vol);
       continue;
     }
     p = e;
@@ -380,6 +556,7 @@ dir_clean_bucket(Dir *b, int s, Vol *vol)
 void
 dir_clean_segment(int s, Vol *d)
 {
+  DirSegmentWriteScope write_scope(d, s);
   Dir *seg = d->dir_segment(s);
   for (int64_t i = 0; i < d->buckets; i++) {
     dir_clean_bucket(dir_bucket(i, seg), s, d);
@@ -399,11 +576,19 @@ dir_clean_vol(Vol *d)
 void
 dir_clear_range(off_t start, off_t end, Vol *vol)
 {
-  for (off_t i = 0; i < vol->buckets * DIR_DEPTH * vol->segments; i++) {
-    Dir *e = dir_index(vol, i);
-    if (dir_offset(e) >= static_cast<int64_t>(start) && dir_offset(e) < static_cast<int64_t>(end)) {
-      CACHE_DEC_DIR_USED(vol->mutex);
-      dir_set_offset(e, 0); // delete
+  for (int s = 0; s < vol->segments; s++) {
+    DirSegmentWriteScope write_scope(vol, s);
+    Dir *seg = vol->dir_segment(s);
+    for (off_t i = 0; i < vol->buckets * DIR_DEPTH; i++) {
+      Dir *e = dir_in_seg(seg, i);
+      if (dir_offset(e) >= static_cast<int64_t>(start) && dir_offset(e) < static_cast<int64_t>(end)) {
+        CACHE_DEC_DIR_USED(vol->mutex);
+        // a bucket head without a Doc is no longer counted, dir_clean_vol() takes care of the rest
+        if (!(i % DIR_DEPTH) && dir_offset(e)) {
+          dir_filter_remove(vol, s, i / DIR_DEPTH, e);
+        }
+        dir_set_offset(e, 0); // delete
+      }
     }
   }
   dir_clean_vol(vol);
@@ -438,6 +623,10 @@ freelist_clean(int s, Vol *vol)
       Dir *e = dir_bucket_row(b, l);
       if (dir_head(e) && !(n++ % 10)) {
         CACHE_DEC_DIR_USED(vol->mutex);
+        if (!l) {
+          dir_filter_remove(vol, s, bi, e);
+        }
+        vol->lseg_sub(e);
         dir_set_offset(e, 0); // delete
       }
     }
@@ -533,6 +722,58 @@ dir_free_entry(Dir *e, int s, Vol *d)
   d->header->freelist[s] = eo;
 }
 
+#if DIR_PROBE_SIMD
+/*
+  Gather the tag and next fields of the DIR_DEPTH entries of bucket @a b into
+  one register, compare every tag against @a tag at once and then follow the
+  chain through the gathered next fields. Returns true only if the chain never
+  leaves the bucket and no entry in it has a matching tag, i.e. the probe is a
+  certain miss. Anything else is left to the regular chain walk.
+*/
+static inline bool
+dir_bucket_certain_miss(const Dir *bucket, int64_t b, uint32_t tag)
+{
+  static_assert(SIZEOF_DIR == 10 && DIR_DEPTH == 4, "shuffles below assume 4 x 10 byte entries");
+  const char *p = reinterpret_cast<const char *>(bucket);
+  // 40 bytes of bucket, loaded so that nothing past the bucket is read.
+  __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+  __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 16));
+  __m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 24));
+  // Lanes 0-3: tag word (w[2]) of entries 0-3, lanes 4-7: next word (w[3]) of entries 0-3.
+  const __m128i s0 = _mm_setr_epi8(4, 5, 14, 15, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, -1, -1);
+  const __m128i s1 = _mm_setr_epi8(-1, -1, -1, -1, 8, 9, -1, -1, -1, -1, 0, 1, 10, 11, -1, -1);
+  const __m128i s2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 10, 11, -1, -1, -1, -1, -1, -1, 12, 13);
+  __m128i words    = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, s0), _mm_shuffle_epi8(v1, s1)), _mm_shuffle_epi8(v2, s2));
+
+  const __m128i tag_mask = _mm_setr_epi16(DIR_MASK_TAG(0xFFFF), DIR_MASK_TAG(0xFFFF), DIR_MASK_TAG(0xFFFF), DIR_MASK_TAG(0xFFFF),
+                                          0, 0, 0, 0);
+  __m128i match = _mm_cmpeq_epi16(_mm_and_si128(words, tag_mask), _mm_set1_epi16(static_cast<int16_t>(tag)));
+  // one bit per entry, entry i in bit i
+  int hits = _mm_movemask_epi8(match);
+  hits     = (hits & 0x1) | ((hits >> 1) & 0x2) | ((hits >> 2) & 0x4) | ((hits >> 3) & 0x8);
+
+  alignas(16) uint16_t lanes[8];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), words);
+
+  int64_t base = b * DIR_DEPTH;
+  int i        = 0;
+  for (int steps = 0; steps < DIR_DEPTH; ++steps) {
+    if (hits & (1 << i)) {
+      return false;
+    }
+    int64_t next = lanes[DIR_DEPTH + i];
+    if (!next) {
+      return true;
+    }
+    if (next <= base || next >= base + DIR_DEPTH) {
+      return false; // chain leaves the bucket
+    }
+    i = next - base;
+  }
+  return false; // loop, let the walk deal with it
+}
+#endif
+
 int
 dir_probe(const CacheKey *key, Vol *d, Dir *result, Dir **last_collision)
 {
@@ -549,10 +790,21 @@ dir_probe(const CacheKey *key, Vol *d, Dir *result, Dir **last_collision)
 #endif
 Lagain:
   e = dir_bucket(b, seg);
+#if DIR_PROBE_SIMD
+  if (!collision && dir_offset(e) && dir_bucket_certain_miss(e, b, DIR_MASK_TAG(key->slice32(2)))) {
+    goto Lmiss;
+  }
+#endif
   if (dir_offset(e)) {
     do {
       if (dir_compare_tag(e, key)) {
         ink_assert(dir_offset(e));
+        if (d->tag_ext && *dir_tag_ext(e, d) != DIR_TAG_EXT(key)) {
+          // Without the extension bits this would have been a read of the wrong Doc.
+          DDebug("dir_probe_tag", "tag extension mismatch %p %X vs expected %X", e, *dir_tag_ext(e, d), DIR_TAG_EXT(key));
+          CACHE_INC_DIR_COLLISIONS_AVOIDED(d->mutex);
+          goto Lcont;
+        }
         // Bug: 51680. Need to check collision before checking
         // dir_valid(). In case of a collision, if !dir_valid(), we
         // don't want to call dir_delete_entry.
@@ -578,7 +830,8 @@ Lagain:
           return 1;
         } else { // delete the invalid entry
           CACHE_DEC_DIR_USED(d->mutex);
-          e = dir_delete_entry(e, p, s, d);
+          DirSegmentWriteScope write_scope(d, s);
+          e = dir_delete_entry(e, p, b, s, d);
           continue;
         }
       } else {
@@ -595,11 +848,112 @@ Lagain:
     collision = nullptr;
     goto Lagain;
   }
+#if DIR_PROBE_SIMD
+Lmiss:
+#endif
   DDebug("dir_probe_miss", "missed %X %X on vol %d bucket %d at %p", key->slice32(0), key->slice32(1), d->fd, b, seg);
   CHECK_DIR(d);
   return 0;
 }
 
+/*
+  Check the directory for @a key without the Vol lock. Returns 0 only if no
+  entry in the key's chain carries its tag, so the key is certainly not in
+  the directory. Returns 1 if it may be, or if the segment kept changing
+  underneath the read, in which case the caller has to dir_probe() under the
+  Vol lock as usual. Nothing is modified here, invalid entries are left for
+  dir_probe() to clean up. With a directory filter most misses are answered
+  by the filter without reading the directory at all.
+*/
+int
+dir_probe_unlocked(const CacheKey *key, Vol *d)
+{
+  if (!d->dir_seq) {
+    return 1;
+  }
+  int s                      = key->slice32(0) % d->segments;
+  int b                      = key->slice32(1) % d->buckets;
+  unsigned int t             = DIR_MASK_TAG(key->slice32(2));
+  uint16_t t_ext             = DIR_TAG_EXT(key);
+  int seg_entries            = d->buckets * DIR_DEPTH;
+  Dir *seg                   = d->dir_segment(s);
+  std::atomic<uint32_t> &seq = d->dir_seq[s];
+  DirFilter *filter          = d->dir_filter;
+
+  if (filter) {
+    RecIncrRawStat(cache_rsb, this_ethread(), cache_dir_filter_lookup_stat, 1);
+    if (!filter->maybe_contains(s, b, t, d->tag_ext ? t_ext : 0)) {
+      RecIncrRawStat(cache_rsb, this_ethread(), cache_dir_filter_miss_stat, 1);
+      return 0;
+    }
+  }
+
+  for (int attempt = 0; attempt < DIR_SEQLOCK_RETRIES; ++attempt) {
+    uint32_t v = seq.load(std::memory_order_acquire);
+    if (v & 1) {
+      continue;
+    }
+    // A concurrent writer can leave the chain in any state, so only follow in-segment links and
+    // never more of them than the segment has entries. The result only counts if the sequence
+    // number is unchanged afterwards.
+    bool found = false;
+    Dir *e     = dir_bucket(b, seg);
+    if (dir_offset(e)) {
+      for (int n = 0; n < seg_entries; ++n) {
+        if (dir_tag(e) == t && (!d->tag_ext || *dir_tag_ext(e, d) == t_ext)) {
+          found = true;
+          break;
+        }
+        int next = dir_next(e);
+        if (!next || next >= seg_entries) {
+          break;
+        }
+        e = dir_in_seg(seg, next);
+      }
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (seq.load(std::memory_order_relaxed) == v) {
+      if (filter && !found) {
+        RecIncrRawStat(cache_rsb, this_ethread(), cache_dir_filter_false_positive_stat, 1);
+      }
+      return found ? 1 : 0;
+    }
+    RecIncrRawStat(cache_rsb, this_ethread(), cache_directory_seqlock_retry_stat, 1);
+  }
+  return 1;
+}
+
+/*
+  Count every directory entry of @a d in a new filter. Called once the
+  directory is recovered, before the volume takes traffic, after which the
+  directory functions keep the filter in step.
+*/
+void
+dir_filter_build(Vol *d)
+{
+  if (!cache_config_dir_filter) {
+    return;
+  }
+  DirFilter *filter = new DirFilter(d->segments, d->buckets, cache_config_dir_filter_counters);
+  int seg_entries   = d->buckets * DIR_DEPTH;
+  for (int s = 0; s < d->segments; s++) {
+    Dir *seg = d->dir_segment(s);
+    for (int64_t b = 0; b < d->buckets; b++) {
+      Dir *e = dir_bucket(b, seg);
+      if (!dir_offset(e)) {
+        continue;
+      }
+      // a looping chain can only add extra counts, which is safe
+      for (int n = 0; e && n < seg_entries; ++n) {
+        filter->add(s, b, dir_tag(e), d->tag_ext ? *dir_tag_ext(e, d) : 0);
+        e = next_dir(e, seg);
+      }
+    }
+  }
+  Debug("cache_init", "Vol %s: %zu byte directory filter", d->hash_text.get(), filter->size());
+  d->dir_filter = filter;
+}
+
 int
 dir_insert(const CacheKey *key, Vol *d, Dir *to_part)
 {
@@ -611,6 +965,7 @@ dir_insert(const CacheKey *key, Vol *d, Dir *to_part)
   Dir *e   = nullptr;
   Dir *b   = dir_bucket(bi, seg);
   Vol *vol = d;
+  DirSegmentWriteScope write_scope(d, s);
 #if defined(DEBUG) && defined(DO_CHECK_DIR_FAST)
   unsigned int t = DIR_MASK_TAG(key->slice32(2));
   Dir *col       = b;
@@ -645,6 +1000,11 @@ Llink:
 Lfill:
   dir_assign_data(e, to_part);
   dir_set_tag(e, key->slice32(2));
+  if (d->tag_ext) {
+    *dir_tag_ext(e, d) = DIR_TAG_EXT(key);
+  }
+  dir_filter_add(d, s, bi, e);
+  d->lseg_add(e);
   ink_assert(d->vol_offset(e) < (d->skip + d->len));
   DDebug("dir_insert", "insert %p %X into vol %d bucket %d at %p tag %X %X boffset %" PRId64 "", e, key->slice32(0), d->fd, bi, e,
          key->slice32(1), dir_tag(e), dir_offset(e));
@@ -670,6 +1030,7 @@ dir_overwrite(const CacheKey *key, Vol *d, Dir *dir, Dir *overwrite, bool must_o
   bool loop_possible = true;
 #endif
   Vol *vol = d;
+  DirSegmentWriteScope write_scope(d, s);
   CHECK_DIR(d);
 
   ink_assert((unsigned int)dir_approx_size(dir) <= (unsigned int)(MAX_FRAG_SIZE + sizeof(Doc))); // XXX - size should be unsigned
@@ -688,6 +1049,7 @@ Lagain:
       }
 #endif
       if (dir_tag(e) == t && dir_offset(e) == dir_offset(overwrite)) {
+        d->lseg_sub(e);
         goto Lfill;
       }
       e = next_dir(e, seg);
@@ -720,8 +1082,22 @@ Llink:
   dir_set_next(e, dir_next(b));
   dir_set_next(b, dir_to_offset(e, seg));
 Lfill:
+  // An overwritten entry is counted already, unless its wide tag belonged to another key.
+  uint16_t old_ext = d->tag_ext ? *dir_tag_ext(e, d) : 0;
+  bool counted     = res && (!d->tag_ext || old_ext == DIR_TAG_EXT(key));
   dir_assign_data(e, dir);
   dir_set_tag(e, t);
+  if (d->tag_ext) {
+    *dir_tag_ext(e, d) = DIR_TAG_EXT(key);
+  }
+  if (!counted) {
+    // add before remove, so a lookup never sees the new key missing
+    dir_filter_add(d, s, bi, e);
+    if (res && d->dir_filter) {
+      d->dir_filter->remove(s, bi, t, old_ext);
+    }
+  }
+  d->lseg_add(e);
   ink_assert(d->vol_offset(e) < d->skip + d->len);
   DDebug("dir_overwrite", "overwrite %p %X into vol %d bucket %d at %p tag %X %X boffset %" PRId64 "", e, key->slice32(0), d->fd,
          bi, e, t, dir_tag(e), dir_offset(e));
@@ -756,7 +1132,9 @@ dir_delete(const CacheKey *key, Vol *d, Dir *del)
 #endif
       if (dir_compare_tag(e, key) && dir_offset(e) == dir_offset(del)) {
         CACHE_DEC_DIR_USED(d->mutex);
-        dir_delete_entry(e, p, s, d);
+        d->lseg_sub(e);
+        DirSegmentWriteScope write_scope(d, s);
+        dir_delete_entry(e, p, b, s, d);
         CHECK_DIR(d);
         return 1;
       }
@@ -963,6 +1341,14 @@ sync_cache_dir_on_shutdown()
     // recompute hit_evacuate_window
     d->hit_evacuate_window = (d->data_blocks * cache_config_hit_evacuate_percent) / 100;
 
+    // the header already counts the writes in flight, so make sure they are on disk
+    for (int i = d->agg_writes; i > 0; i--) {
+      AggBuffer *b = d->agg_issued(i);
+      if (pwrite(d->fd, b->buf, b->len, b->offset) != b->len) {
+        ink_assert(!"flushing agg buffer failed");
+      }
+    }
+
     // check if we have data in the agg buffer
     // dont worry about the cachevc s in the agg queue
     // directories have not been inserted for these writes
@@ -1030,6 +1416,80 @@ sync_cache_dir_on_shutdown()
   }
 }
 
+/*
+  Decide what to write to directory @a copy of @a vol and snapshot it into buf.
+  A full sync writes everything between the header and the footer. An
+  incremental sync writes only the segments changed since that copy was last
+  synced, their wide tag bits if any, the log segment table if any, and
+  the freelist heads. The copy still only becomes valid once the footer
+  with the new sync serial lands after everything else, so a crash part way
+  through leaves the other copy to recover from exactly as with a full sync.
+*/
+void
+CacheSync::plan(Vol *vol, int copy)
+{
+  off_t headerlen = ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+  off_t dirlen    = vol->dirlen();
+  off_t body_end  = dirlen - headerlen;
+  uint8_t bit     = 1 << copy;
+
+  ranges.clear();
+  segments.clear();
+  range_idx = 0;
+
+  if (!cache_config_dir_sync_incremental || !vol->dir_seg_dirty) {
+    for (int s = 0; s < vol->segments; s++) {
+      if (vol->dir_seg_dirty) {
+        vol->dir_seg_dirty[s] &= ~bit;
+      }
+      segments.push_back(s);
+    }
+    ranges.emplace_back(headerlen, body_end);
+    memcpy(buf, vol->raw_dir, dirlen);
+    return;
+  }
+
+  off_t dir_start = reinterpret_cast<char *>(vol->dir) - vol->raw_dir;
+  off_t ext_start = vol->tag_ext ? reinterpret_cast<char *>(vol->tag_ext) - vol->raw_dir : 0;
+  off_t seg_bytes = vol->buckets * DIR_DEPTH * SIZEOF_DIR;
+  off_t ext_bytes = vol->buckets * DIR_DEPTH * sizeof(uint16_t);
+  auto add_range  = [&](off_t lo, off_t hi) {
+    lo = std::max<off_t>(headerlen, lo - lo % STORE_BLOCK_SIZE);
+    hi = std::min<off_t>(body_end, ROUND_TO_STORE_BLOCK(hi));
+    if (!ranges.empty() && lo <= ranges.back().second) {
+      ranges.back().second = std::max(ranges.back().second, hi);
+    } else if (lo < hi) {
+      ranges.emplace_back(lo, hi);
+    }
+  };
+
+  // The rest of the header carries the per segment freelist heads.
+  add_range(headerlen, dir_start);
+  for (int s = 0; s < vol->segments; s++) {
+    if (vol->dir_seg_dirty[s] & bit) {
+      vol->dir_seg_dirty[s] &= ~bit;
+      segments.push_back(s);
+      add_range(dir_start + s * seg_bytes, dir_start + (s + 1) * seg_bytes);
+    }
+  }
+  if (vol->tag_ext) {
+    for (int s : segments) {
+      add_range(ext_start + s * ext_bytes, ext_start + (s + 1) * ext_bytes);
+    }
+  }
+  // The log segment table is small and changes with the write head, it always goes.
+  if (vol->lseg_geometry) {
+    off_t lseg_start = reinterpret_cast<char *>(vol->lseg_geometry) - vol->raw_dir;
+    add_range(lseg_start, lseg_start + vol->lseg_table_len());
+  }
+
+  memcpy(buf, vol->raw_dir, headerlen);
+  for (auto &r : ranges) {
+    memcpy(buf + r.first, vol->raw_dir + r.first, r.second - r.first);
+  }
+  memcpy(buf + body_end, vol->raw_dir + body_end, headerlen);
+}
+
 int
 CacheSync::mainEvent(int event, Event *e)
 {
@@ -1066,10 +1526,17 @@ Lrestart:
     // AIO Thread
     if (io.aio_result != static_cast<int64_t>(io.aiocb.aio_nbytes)) {
       Warning("vol write error during directory sync '%s'", gvol[vol_idx]->hash_text.get());
+      // This copy is now only partly written, write all of these segments again next time.
+      if (vol->dir_seg_dirty) {
+        for (int s : segments) {
+          vol->dir_seg_dirty[s] = DIR_SEG_DIRTY_ALL;
+        }
+      }
       event = EVENT_NONE;
       goto Ldone;
     }
     CACHE_SUM_DYN_STAT(cache_directory_sync_bytes_stat, io.aio_result);
+    sync_bytes += io.aio_result;
 
     trigger = eventProcessor.schedule_in(this, SYNC_DELAY);
     return EVENT_CONT;
@@ -1107,7 +1574,7 @@ Lrestart:
         Debug("cache_dir_sync", "Dir %s not dirty", vol->hash_text.get());
         goto Ldone;
       }
-      if (vol->is_io_in_progress() || vol->agg_buf_pos) {
+      if (vol->is_io_in_progress() || vol->agg_buf_pos || vol->agg_writes) {
         Debug("cache_dir_sync", "Dir %s: waiting for agg buffer", vol->hash_text.get());
         vol->dir_sync_waiting = true;
         if (!vol->is_io_in_progress()) {
@@ -1139,7 +1606,8 @@ Lrestart:
       vol->header->sync_serial++;
       vol->footer->sync_serial = vol->header->sync_serial;
       CHECK_DIR(d);
-      memcpy(buf, vol->raw_dir, dirlen);
+      plan(vol, vol->header->sync_serial & 1);
+      sync_bytes                = 0;
       vol->dir_sync_in_progress = true;
     }
     size_t B    = vol->header->sync_serial & 1;
@@ -1149,23 +1617,31 @@ Lrestart:
       // write header
       aio_write(vol->fd, buf + writepos, headerlen, start + writepos);
       writepos += headerlen;
-    } else if (writepos < static_cast<off_t>(dirlen) - headerlen) {
+    } else if (range_idx < ranges.size()) {
       // write part of body
-      int l = SYNC_MAX_WRITE;
-      if (writepos + l > static_cast<off_t>(dirlen) - headerlen) {
-        l = dirlen - headerlen - writepos;
-      }
+      auto &r  = ranges[range_idx];
+      writepos = std::max(writepos, r.first);
+      int l    = std::min<off_t>(SYNC_MAX_WRITE, r.second - writepos);
       aio_write(vol->fd, buf + writepos, l, start + writepos);
       writepos += l;
-    } else if (writepos < static_cast<off_t>(dirlen)) {
-      ink_assert(writepos == (off_t)dirlen - headerlen);
+      if (writepos >= r.second) {
+        ++range_idx;
+      }
+    } else if (writepos < static_cast<off_t>(dirlen) - headerlen) {
       // write footer
+      writepos = dirlen - headerlen;
       aio_write(vol->fd, buf + writepos, headerlen, start + writepos);
-      writepos += headerlen;
+      writepos = dirlen;
     } else {
+      ink_hrtime elapsed        = Thread::get_hrtime() - start_time;
       vol->dir_sync_in_progress = false;
       CACHE_INCREMENT_DYN_STAT(cache_directory_sync_count_stat);
-      CACHE_SUM_DYN_STAT(cache_directory_sync_time_stat, Thread::get_hrtime() - start_time);
+      CACHE_SUM_DYN_STAT(cache_directory_sync_time_stat, elapsed);
+      CACHE_SUM_DYN_STAT(cache_directory_sync_segments_stat, segments.size());
+      CACHE_SET_DYN_STAT(cache_directory_sync_last_bytes_stat, sync_bytes);
+      CACHE_SET_DYN_STAT(cache_directory_sync_last_time_stat, ink_hrtime_to_msec(elapsed));
+      Debug("cache_dir_sync", "Dir %s: wrote %zu of %d segments, %" PRId64 " bytes in %" PRId64 "ms", vol->hash_text.get(),
+            segments.size(), vol->segments, sync_bytes, static_cast<int64_t>(ink_hrtime_to_msec(elapsed)));
       start_time = 0;
       goto Ldone;
     }
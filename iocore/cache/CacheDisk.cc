@@ -23,6 +23,8 @@
 
 #include "P_Cache.h"
 
+#include <algorithm>
+
 void
 CacheDisk::incrErrors(const AIOCallback *io)
 {
@@ -52,6 +54,85 @@ CacheDisk::incrErrors(const AIOCallback *io)
   Warning("failed operation: %s (opcode=%d), span: %s (fd=%d)", opname, opcode, path, fd);
 }
 
+int
+CacheDiskLoad::bucket(ink_hrtime latency)
+{
+  uint64_t us = latency > 0 ? latency / HRTIME_USECOND : 0;
+  if (us < 4) {
+    return static_cast<int>(us);
+  }
+  int msb = 63 - __builtin_clzll(us);
+  int b   = (msb - 1) * 4 + static_cast<int>((us >> (msb - 2)) & 3);
+  return std::min(b, DISK_LOAD_BUCKETS - 1);
+}
+
+// Upper bound of the latencies counted in bucket b.
+ink_hrtime
+CacheDiskLoad::bucket_limit(int b)
+{
+  if (b < 4) {
+    return HRTIME_USECONDS(b + 1);
+  }
+  return HRTIME_USECONDS(static_cast<ink_hrtime>(5 + b % 4) << (b / 4 - 1));
+}
+
+// Close the window once the interval is over; true when the disk became slow or recovered.
+bool
+CacheDiskLoad::roll(ink_hrtime now)
+{
+  ink_hrtime start = window_start.load(std::memory_order_relaxed);
+  if (now - start < HRTIME_MSECONDS(cache_config_write_throttle_interval) || !window_start.compare_exchange_strong(start, now)) {
+    return false;
+  }
+
+  uint32_t counts[DISK_LOAD_BUCKETS];
+  uint64_t total = 0;
+  for (int b = 0; b < DISK_LOAD_BUCKETS; ++b) {
+    counts[b] = read_hist[b].exchange(0, std::memory_order_relaxed);
+    total += counts[b];
+  }
+
+  ink_hrtime p99 = 0;
+  uint64_t rank  = total - total / 100;
+  uint64_t seen  = 0;
+  for (int b = 0; total && b < DISK_LOAD_BUCKETS; ++b) {
+    seen += counts[b];
+    if (seen >= rank) {
+      p99 = bucket_limit(b);
+      break;
+    }
+  }
+  read_p99.store(p99, std::memory_order_relaxed);
+
+  bool was_slow = slow.load(std::memory_order_relaxed);
+  bool is_slow  = p99 > HRTIME_MSECONDS(cache_config_write_throttle_read_p99);
+  slow.store(is_slow, std::memory_order_relaxed);
+  return was_slow != is_slow;
+}
+
+bool
+CacheDiskLoad::overloaded() const
+{
+  if (slow.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  return cache_config_write_throttle_queue_depth > 0 &&
+         reads.load(std::memory_order_relaxed) + writes.load(std::memory_order_relaxed) > cache_config_write_throttle_queue_depth;
+}
+
+bool
+CacheDisk::overloaded()
+{
+  if (load.roll(Thread::get_hrtime())) {
+    bool slow = load.slow.load(std::memory_order_relaxed);
+    GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_write_throttle_slow_disks_stat, slow ? 1 : -1);
+    Debug("cache_throttle", "span %s read p99 %" PRId64 "us %s target, %d reads and %d writes in flight", path,
+          ink_hrtime_to_usec(load.read_p99.load(std::memory_order_relaxed)), slow ? "above" : "back under",
+          load.reads.load(std::memory_order_relaxed), load.writes.load(std::memory_order_relaxed));
+  }
+  return load.overloaded();
+}
+
 int
 CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fildes, bool clear)
 {
@@ -64,6 +145,7 @@ CacheDisk::open(char *s, off_t blocks, off_t askip, int ahw_sector_size, int fil
   len                 = blocks;
   io.aiocb.aio_fildes = fd;
   io.action           = this;
+  ink_aio_register_fd(fd);
   // determine header size and hence start point by successive approximation
   uint64_t l;
   for (int i = 0; i < 3; i++) {
@@ -127,6 +209,9 @@ CacheDisk::~CacheDisk()
     }
     delete free_blocks;
   }
+  if (file_fd >= 0) {
+    close(file_fd);
+  }
 }
 
 int
@@ -195,6 +195,9 @@ CacheHostTable::CacheHostTable(Cache *c, CacheType typ)
   ink_release_assert(config_path);
 
   m_numEntries = this->BuildTable(config_path);
+  if (cache_vols_tiered(type) && tier_host_rec.Init(type, true)) {
+    Warning("Problems encountered while initializing the fast tier volumes");
+  }
 }
 
 CacheHostTable::~CacheHostTable()
@@ -417,8 +420,31 @@ CacheHostTable::BuildTable(const char *config_file_path)
   return BuildTableFromString(config_file_path, content.data());
 }
 
+/*
+  Volumes marked tier=fast in volume.config only hold copies of objects promoted
+  from the other volumes, so they are kept out of the generic record and hashed
+  separately. Without any other volume of the type they are used like any volume.
+*/
+bool
+cache_vols_tiered(CacheType type)
+{
+  extern Queue<CacheVol> cp_list;
+  bool fast = false, slow = false;
+
+  for (CacheVol *cachep = cp_list.head; cachep; cachep = cachep->link.next) {
+    if (cachep->scheme == type) {
+      if (cachep->fast_tier) {
+        fast = true;
+      } else {
+        slow = true;
+      }
+    }
+  }
+  return fast && slow;
+}
+
 int
-CacheHostRecord::Init(CacheType typ)
+CacheHostRecord::Init(CacheType typ, bool fast_tier)
 {
   int i, j;
   extern Queue<CacheVol> cp_list;
@@ -429,9 +455,10 @@ CacheHostRecord::Init(CacheType typ)
   cp       = static_cast<CacheVol **>(ats_malloc(cp_list_len * sizeof(CacheVol *)));
   memset(cp, 0, cp_list_len * sizeof(CacheVol *));
   num_cachevols    = 0;
+  bool tiered      = cache_vols_tiered(type);
   CacheVol *cachep = cp_list.head;
   for (; cachep; cachep = cachep->link.next) {
-    if (cachep->scheme == type) {
+    if (cachep->scheme == type && (!tiered || cachep->fast_tier == fast_tier)) {
       Debug("cache_hosting", "Host Record: %p, Volume: %d, size: %" PRId64, this, cachep->vol_number, (int64_t)cachep->size);
       cp[num_cachevols] = cachep;
       num_cachevols++;
@@ -659,6 +686,11 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
     int size              = 0;
     int in_percent        = 0;
     bool ramcache_enabled = true;
+    bool wide_tags        = false;
+    bool fast_tier        = false;
+    bool segmented        = false;
+    int agg_buffers       = 0;
+    int agg_size          = 0;
 
     while (true) {
       // skip all blank spaces at beginning of line
@@ -758,6 +790,62 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
           err = "Unexpected end of line";
           break;
         }
+      } else if (strcasecmp(tmp, "wide_tags") == 0) { // match wide_tags
+        tmp += 10;
+        if (!strcasecmp(tmp, "false")) {
+          tmp += 5;
+          wide_tags = false;
+        } else if (!strcasecmp(tmp, "true")) {
+          tmp += 4;
+          wide_tags = true;
+        } else {
+          err = "Unexpected end of line";
+          break;
+        }
+      } else if (strcasecmp(tmp, "agg_buffers") == 0) { // match agg_buffers
+        tmp += 12;
+        agg_buffers = atoi(tmp);
+        if (agg_buffers < 1 || agg_buffers > MAX_AGG_BUFFERS) {
+          err = "Bad number of aggregation buffers";
+          break;
+        }
+        while (ParseRules::is_digit(*tmp)) {
+          tmp++;
+        }
+      } else if (strcasecmp(tmp, "agg_size") == 0) { // match agg_size
+        tmp += 9;
+        agg_size = atoi(tmp);
+        if (agg_size < CACHE_BLOCK_SIZE || agg_size > AGG_SIZE) {
+          err = "Bad aggregation buffer size";
+          break;
+        }
+        while (ParseRules::is_digit(*tmp)) {
+          tmp++;
+        }
+      } else if (strcasecmp(tmp, "tier") == 0) { // match tier
+        tmp += 5;
+        if (!strcasecmp(tmp, "fast")) {
+          tmp += 4;
+          fast_tier = true;
+        } else if (!strcasecmp(tmp, "slow")) {
+          tmp += 4;
+          fast_tier = false;
+        } else {
+          err = "Unexpected end of line";
+          break;
+        }
+      } else if (strcasecmp(tmp, "layout") == 0) { // match layout
+        tmp += 7;
+        if (!strcasecmp(tmp, "cyclic")) {
+          tmp += 6;
+          segmented = false;
+        } else if (!strcasecmp(tmp, "segmented")) {
+          tmp += 9;
+          segmented = true;
+        } else {
+          err = "Unexpected end of line";
+          break;
+        }
       }
 
       // ends here
@@ -784,6 +872,11 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
       configp->size             = size;
       configp->cachep           = nullptr;
       configp->ramcache_enabled = ramcache_enabled;
+      configp->wide_tags        = wide_tags;
+      configp->fast_tier        = fast_tier;
+      configp->segmented        = segmented;
+      configp->agg_buffers      = agg_buffers;
+      configp->agg_size         = agg_size;
       cp_queue.enqueue(configp);
       num_volumes++;
       if (scheme == CACHE_HTTP_TYPE) {
@@ -791,8 +884,10 @@ ConfigVolumes::BuildListFromString(char *config_file_path, char *file_buf)
       } else {
         ink_release_assert(!"Unexpected non-HTTP cache volume");
       }
-      Debug("cache_hosting", "added volume=%d, scheme=%d, size=%d percent=%d, ramcache enabled=%d", volume_number, scheme, size,
-            in_percent, ramcache_enabled);
+      Debug("cache_hosting",
+            "added volume=%d, scheme=%d, size=%d percent=%d, ramcache enabled=%d, wide tags=%d, fast tier=%d, segmented=%d, "
+            "agg buffers=%d, agg size=%d",
+            volume_number, scheme, size, in_percent, ramcache_enabled, wide_tags, fast_tier, segmented, agg_buffers, agg_size);
     }
 
     tmp = bufTok.iterNext(&i_state);
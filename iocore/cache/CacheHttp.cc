@@ -23,7 +23,9 @@
 
 #include "tscore/ink_config.h"
 #include <cstring>
+#include <memory>
 #include "P_Cache.h"
+#include "tscore/ink_string.h"
 
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
@@ -32,6 +34,142 @@ static vec_info default_vec_info;
 
 static CacheHTTPInfo default_http_info;
 
+// Compact form of a vector, the alternates stripped of what the shared alternate holds.
+struct CacheAltVectorCompact {
+  CacheHTTPInfo shared;
+  std::unique_ptr<CacheHTTPInfo[]> alts;
+  int count = 0;
+
+  ~CacheAltVectorCompact()
+  {
+    shared.destroy();
+    for (int i = 0; i < count; i++) {
+      alts[i].destroy();
+    }
+  }
+};
+
+namespace
+{
+// Response fields alternate selection looks at. These are never shared, so that selection
+// works on the alternates of a compact vector without expanding them.
+bool
+selection_field(std::string_view name)
+{
+  const std::pair<const char *, int> fields[] = {
+    {MIME_FIELD_CONTENT_TYPE, MIME_LEN_CONTENT_TYPE},
+    {MIME_FIELD_CONTENT_ENCODING, MIME_LEN_CONTENT_ENCODING},
+    {MIME_FIELD_CONTENT_LANGUAGE, MIME_LEN_CONTENT_LANGUAGE},
+    {MIME_FIELD_VARY, MIME_LEN_VARY},
+    {MIME_FIELD_DATE, MIME_LEN_DATE},
+    {MIME_FIELD_AGE, MIME_LEN_AGE},
+  };
+  for (auto const &field : fields) {
+    if (ptr_len_casecmp(name.data(), name.size(), field.first, field.second) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Request fields kept in a compact alternate: the ones named by Vary, those compared against
+// the response when computing the quality of a match, and Cookie, which HttpTransact checks in
+// the cached request to decide whether cookies prevent serving it.
+bool
+request_field(std::string_view name, StrList const &vary)
+{
+  const std::pair<const char *, int> fields[] = {
+    {MIME_FIELD_ACCEPT, MIME_LEN_ACCEPT},
+    {MIME_FIELD_ACCEPT_CHARSET, MIME_LEN_ACCEPT_CHARSET},
+    {MIME_FIELD_ACCEPT_ENCODING, MIME_LEN_ACCEPT_ENCODING},
+    {MIME_FIELD_ACCEPT_LANGUAGE, MIME_LEN_ACCEPT_LANGUAGE},
+    {MIME_FIELD_COOKIE, MIME_LEN_COOKIE},
+  };
+  for (auto const &field : fields) {
+    if (ptr_len_casecmp(name.data(), name.size(), field.first, field.second) == 0) {
+      return true;
+    }
+  }
+  for (Str *field = vary.head; field != nullptr; field = field->next) {
+    if (ptr_len_casecmp(name.data(), name.size(), field->str, field->len) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// True if @a hdr has a single @a name field with @a value.
+bool
+same_field(HTTPHdr *hdr, std::string_view name, std::string_view value)
+{
+  MIMEField *field = hdr->field_find(name.data(), name.size());
+  return field && !field->has_dups() && field->value_get() == value;
+}
+
+// Append a copy of @a from to @a to, without its value unless @a with_value.
+void
+copy_field(HTTPHdr *to, MIMEField const &from, bool with_value = true)
+{
+  std::string_view name = from.name_get();
+  MIMEField *field      = to->field_create(name.data(), name.size());
+  if (with_value) {
+    std::string_view value = from.value_get();
+    to->field_value_set(field, value.data(), value.size());
+  }
+  to->field_attach(field);
+}
+
+void
+compact_alternate(CacheHTTPInfo *to, CacheHTTPInfo *from, HTTPHdr *shared)
+{
+  HTTPCacheAlt *src = from->m_alt;
+  to->create();
+  HTTPCacheAlt *alt = to->m_alt;
+  alt->m_id         = src->m_id;
+  alt->m_rid        = src->m_rid;
+  memcpy(alt->m_object_key, src->m_object_key, sizeof(alt->m_object_key));
+  alt->m_object_size[0]         = src->m_object_size[0];
+  alt->m_object_size[1]         = src->m_object_size[1];
+  alt->m_request_sent_time      = src->m_request_sent_time;
+  alt->m_response_received_time = src->m_response_received_time;
+  alt->copy_frag_offsets_from(src);
+
+  HTTPHdr *req  = from->request_get();
+  HTTPHdr *resp = from->response_get();
+  StrList vary;
+  int len;
+
+  resp->value_get_comma_list(MIME_FIELD_VARY, MIME_LEN_VARY, &vary);
+  alt->m_request_hdr.create(HTTP_TYPE_REQUEST);
+  const char *method = req->method_get(&len);
+  if (method) {
+    alt->m_request_hdr.method_set(method, len);
+  }
+  if (req->url_get()) {
+    alt->m_request_hdr.url_set(req->url_get());
+  }
+  alt->m_request_hdr.version_set(req->version_get());
+  for (auto &field : *req) {
+    if (request_field(field.name_get(), vary)) {
+      copy_field(&alt->m_request_hdr, field);
+    }
+  }
+
+  alt->m_response_hdr.create(HTTP_TYPE_RESPONSE);
+  alt->m_response_hdr.version_set(resp->version_get());
+  alt->m_response_hdr.status_set(resp->status_get());
+  const char *reason = resp->reason_get(&len);
+  if (reason) {
+    alt->m_response_hdr.reason_set(reason, len);
+  }
+  // A shared field leaves its name behind, so that expanding puts its value back in the same place.
+  for (auto &field : *resp) {
+    std::string_view name = field.name_get();
+    copy_field(&alt->m_response_hdr, field, !shared->field_find(name.data(), name.size()));
+  }
+}
+} // namespace
+
 CacheHTTPInfoVector::CacheHTTPInfoVector() : data(&default_vec_info, 4) {}
 
 /*-------------------------------------------------------------------------
@@ -45,6 +183,7 @@ CacheHTTPInfoVector::~CacheHTTPInfoVector()
     data[i].alternate.destroy();
   }
   vector_buf.clear();
+  release_compact();
   magic = nullptr;
 }
 
@@ -116,6 +255,8 @@ CacheHTTPInfoVector::clear(bool destroy)
   xcount = 0;
   data.clear();
   vector_buf.clear();
+  shared.clear();
+  release_compact();
 }
 
 /*-------------------------------------------------------------------------
@@ -162,11 +303,85 @@ CacheHTTPInfoVector::print(char *buffer, size_t buf_size, bool temps)
 /*-------------------------------------------------------------------------
   -------------------------------------------------------------------------*/
 
+/*
+   A vector with several alternates is written in the compact form if
+   proxy.config.cache.alt_vector.compact is set.
+   */
+bool
+CacheHTTPInfoVector::use_compact()
+{
+  if (!cache_config_alt_vector_compact || xcount < 2) {
+    return false;
+  }
+  for (int i = 0; i < xcount; i++) {
+    CacheHTTPInfo *info = &data[i].alternate;
+    if (!info->valid() || !info->request_get()->valid() || !info->response_get()->valid()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void
+CacheHTTPInfoVector::prepare_compact()
+{
+  if (compact_prep) {
+    return;
+  }
+  compact_prep = new CacheAltVectorCompact;
+  compact_prep->shared.create();
+  HTTPHdr *shared_resp = &compact_prep->shared.m_alt->m_response_hdr;
+  shared_resp->create(HTTP_TYPE_RESPONSE);
+
+  HTTPHdr *first = data[0].alternate.response_get();
+  for (auto &field : *first) {
+    std::string_view name  = field.name_get();
+    std::string_view value = field.value_get();
+    if (selection_field(name) || !same_field(first, name, value)) {
+      continue;
+    }
+    int i = 1;
+    while (i < xcount && same_field(data[i].alternate.response_get(), name, value)) {
+      i++;
+    }
+    if (i == xcount) {
+      copy_field(shared_resp, field);
+    }
+  }
+
+  compact_prep->alts.reset(new CacheHTTPInfo[xcount]);
+  compact_prep->count = xcount;
+  for (int i = 0; i < xcount; i++) {
+    compact_alternate(&compact_prep->alts[i], &data[i].alternate, shared_resp);
+  }
+}
+
+void
+CacheHTTPInfoVector::release_compact()
+{
+  delete compact_prep;
+  compact_prep = nullptr;
+}
+
 int
 CacheHTTPInfoVector::marshal_length()
 {
   int length = 0;
 
+  // Writing out a vector needs every alternate whole.
+  if (compact()) {
+    expand();
+  }
+  if (use_compact()) {
+    release_compact();
+    prepare_compact();
+    length = sizeof(CacheAltVectorHeader) + compact_prep->shared.marshal_length();
+    for (int i = 0; i < compact_prep->count; i++) {
+      length += compact_prep->alts[i].marshal_length();
+    }
+    return length;
+  }
+
   for (int i = 0; i < xcount; i++) {
     length += data[i].alternate.marshal_length();
   }
@@ -184,11 +399,33 @@ CacheHTTPInfoVector::marshal(char *buf, int length)
 
   ink_assert(!(((intptr_t)buf) & 3)); // buf must be aligned
 
-  for (int i = 0; i < xcount; i++) {
-    int tmp = data[i].alternate.marshal(buf, length);
+  if (compact()) {
+    expand();
+  }
+  if (use_compact()) {
+    prepare_compact();
+    CacheAltVectorHeader *h = reinterpret_cast<CacheAltVectorHeader *>(buf);
+    h->magic                = CACHE_ALT_VECTOR_MAGIC;
+    h->count                = xcount;
+    buf += sizeof(CacheAltVectorHeader);
+    length -= sizeof(CacheAltVectorHeader);
+    int tmp = compact_prep->shared.marshal(buf, length);
     length -= tmp;
     buf += tmp;
-    count++;
+    for (int i = 0; i < compact_prep->count; i++) {
+      tmp = compact_prep->alts[i].marshal(buf, length);
+      length -= tmp;
+      buf += tmp;
+      count++;
+    }
+    release_compact();
+  } else {
+    for (int i = 0; i < xcount; i++) {
+      int tmp = data[i].alternate.marshal(buf, length);
+      length -= tmp;
+      buf += tmp;
+      count++;
+    }
   }
 
   GLOBAL_CACHE_SUM_GLOBAL_DYN_STAT(cache_hdr_vector_marshal_stat, 1);
@@ -205,6 +442,17 @@ CacheHTTPInfoVector::unmarshal(const char *buf, int length, RefCountObj *block_p
   const char *start = buf;
   CacheHTTPInfo info;
   xcount = 0;
+  shared.clear();
+
+  if (int hlen = CacheAltVectorHeader::length(buf, length)) {
+    buf += hlen;
+    int tmp = HTTPInfo::unmarshal(const_cast<char *>(buf), length - (buf - start), block_ptr);
+    if (tmp < 0) {
+      return -1;
+    }
+    shared.m_alt = (HTTPCacheAlt *)buf;
+    buf += tmp;
+  }
 
   while (length - (buf - start) > static_cast<int>(sizeof(HTTPCacheAlt))) {
     int tmp = HTTPInfo::unmarshal(const_cast<char *>(buf), length - (buf - start), block_ptr);
@@ -233,6 +481,17 @@ CacheHTTPInfoVector::get_handles(const char *buf, int length, RefCountObj *block
   xcount = 0;
 
   vector_buf = block_ptr;
+  shared.clear();
+
+  if (int hlen = CacheAltVectorHeader::length(buf, length)) {
+    buf += hlen;
+    int tmp = shared.get_handle(const_cast<char *>(buf), length - (buf - start));
+    if (tmp < 0) {
+      ink_assert(!"CacheHTTPInfoVector::unmarshal get_handle() failed");
+      return static_cast<uint32_t>(-1);
+    }
+    buf += tmp;
+  }
 
   while (length - (buf - start) > static_cast<int>(sizeof(HTTPCacheAlt))) {
     int tmp = info.get_handle(const_cast<char *>(buf), length - (buf - start));
@@ -248,3 +507,42 @@ CacheHTTPInfoVector::get_handles(const char *buf, int length, RefCountObj *block
 
   return (const_cast<caddr_t>(buf) - const_cast<caddr_t>(start));
 }
+
+/*-------------------------------------------------------------------------
+  -------------------------------------------------------------------------*/
+
+/*
+   Put the shared response fields back into alternate @a idx of a compact
+   vector. The alternate becomes a private copy owned by the vector.
+   */
+void
+CacheHTTPInfoVector::expand(int idx)
+{
+  CacheHTTPInfo *info = &data[idx].alternate;
+  if (!shared.valid() || !info->valid() || info->m_alt->m_writeable) {
+    return;
+  }
+
+  CacheHTTPInfo full;
+  full.copy(info);
+  HTTPHdr *resp = full.response_get();
+  for (auto &field : *shared.response_get()) {
+    std::string_view name  = field.name_get();
+    std::string_view value = field.value_get();
+    if (MIMEField *place = resp->field_find(name.data(), name.size())) {
+      resp->field_value_set(place, value.data(), value.size());
+    } else {
+      copy_field(resp, field);
+    }
+  }
+  *info = full;
+}
+
+void
+CacheHTTPInfoVector::expand()
+{
+  for (int i = 0; i < xcount; i++) {
+    expand(i);
+  }
+  shared.clear();
+}
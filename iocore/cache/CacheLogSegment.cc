@@ -0,0 +1,259 @@
+/** @file
+
+  Segmented volume layout: the write head moves between log segments picked by how little they hold.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// With volume.config layout=segmented the data area of each stripe is divided
+// into log segments of proxy.config.cache.log_segment_size. The write head fills
+// one segment at a time, exactly as it fills a cyclic stripe, but when the
+// segment is full it moves to the segment picked by vol_lseg_victim() instead
+// of the next one on disk. Segments whose documents have mostly been replaced or
+// removed are picked first, as log structured file systems pick the segments
+// they clean, so fewer valid documents are overwritten or evacuated.
+//
+// Documents and directory entries are the same as in the cyclic layout. Each
+// segment has a phase, flipped when it is opened: the one being written uses
+// the cyclic validity rules with header->phase, the entries of the others are
+// valid while their phase matches that of their segment. The table of segments
+// is saved with the directory, and every segment starts with a copy of its
+// table entry so recovery can follow the write head from one to the next.
+
+#include "P_Cache.h"
+
+/*
+  The segment to open after @a cur, by the cost-benefit policy of LFS: the
+  free space it yields, weighted by how long ago it was written, against the
+  cost of reading and rewriting what is still live in it.
+*/
+int
+vol_lseg_victim(const VolLogSegment *table, const int64_t *live, int n, int cur, off_t size)
+{
+  int victim  = cur;
+  double best = -1;
+
+  // Ties go to the segment that follows on disk, so an empty stripe fills in order.
+  for (int i = 1; i < n; i++) {
+    int s          = (cur + i) % n;
+    double u       = std::min(1.0, static_cast<double>(std::max<int64_t>(live[s], 0)) / size);
+    double age     = static_cast<double>(table[cur].seq - table[s].seq) + 1;
+    double benefit = (1 - u) * age / (1 + u);
+    if (benefit > best) {
+      best   = benefit;
+      victim = s;
+    }
+  }
+  return victim;
+}
+
+// A cleared stripe starts writing at the beginning of segment 0.
+void
+Vol::lseg_clear()
+{
+  if (!lseg_table) {
+    return;
+  }
+  memset(lseg_live, 0, lsegs * sizeof(int64_t));
+  lseg_geometry->size  = lseg_size;
+  lseg_geometry->count = lsegs;
+  for (int i = 0; i < lsegs; i++) {
+    lseg_table[i].index = i;
+  }
+  lseg_cur           = 0;
+  lseg_table[0].seq  = 1;
+  lseg_table[0].next = vol_lseg_victim(lseg_table, lseg_live, lsegs, 0, lseg_size);
+}
+
+// Find the segment of the write head in a directory read from disk, false if the table does not hold together.
+bool
+Vol::lseg_attach()
+{
+  if (!lseg_table) {
+    return true;
+  }
+  if (lseg_geometry->size != lseg_size || lseg_geometry->count != static_cast<uint32_t>(lsegs)) {
+    return false;
+  }
+  lseg_cur = 0;
+  for (int i = 0; i < lsegs; i++) {
+    if (lseg_table[i].index != static_cast<uint32_t>(i) || lseg_table[i].next >= static_cast<uint32_t>(lsegs)) {
+      return false;
+    }
+    if (lseg_table[i].seq > lseg_table[lseg_cur].seq) {
+      lseg_cur = i;
+    }
+  }
+  return header->phase == lseg_table[lseg_cur].phase && header->write_pos >= lseg_start(lseg_cur) &&
+         header->write_pos <= lseg_end(lseg_cur);
+}
+
+// Add up the valid documents of each segment, once the directory is loaded and recovered.
+void
+Vol::lseg_count_live()
+{
+  if (!lseg_live) {
+    return;
+  }
+  memset(lseg_live, 0, lsegs * sizeof(int64_t));
+  for (int i = 0; i < direntries(); i++) {
+    if (dir_offset(&dir[i]) && dir_valid(this, &dir[i])) {
+      lseg_add(&dir[i]);
+    }
+  }
+}
+
+/*
+  Move the write head to the start of segment @a s, once nothing is left to
+  be written to the current one. The aggregation buffer starts out with the
+  copy of the segment's entry.
+*/
+void
+Vol::lseg_open(int s)
+{
+  Vol *vol           = this;
+  VolLogSegment *seg = &lseg_table[s];
+
+  CACHE_INCREMENT_DYN_STAT(cache_log_segment_open_stat);
+  CACHE_SUM_DYN_STAT(cache_log_segment_live_stat, std::max<int64_t>(lseg_live[s], 0));
+  Debug("cache_lseg", "Vol %s: log segment %d full, opening %d with %" PRId64 " live bytes", hash_text.get(), lseg_cur, s,
+        lseg_live[s]);
+
+  seg->seq     = lseg_table[lseg_cur].seq + 1;
+  seg->phase   = !seg->phase;
+  lseg_live[s] = 0;
+  lseg_cur     = s;
+  seg->next    = vol_lseg_victim(lseg_table, lseg_live, lsegs, s, lseg_size);
+
+  header->write_pos = lseg_start(s);
+  header->agg_pos   = header->write_pos;
+  header->phase     = seg->phase;
+  header->cycle++;
+  dir_lookaside_cleanup(this);
+  // Entries left in the segment from the generation before the last one have its phase again, they have to go
+  // before the write head gets to their offsets and makes them look valid.
+  dir_clean_vol(this);
+  // Evacuations behind the write head are only freed near it, the rest of the stripe is done here.
+  for (int i = 0; i < evacuate_size; i++) {
+    evacuate_cleanup_blocks(i);
+  }
+  agg_buf_pos = lseg_summary(agg_buffer);
+  scan_pos    = header->write_pos;
+  periodic_scan();
+}
+
+// Write the copy of the current segment's entry at @a buf, a Doc with no key like the sync marker.
+int
+Vol::lseg_summary(char *buf)
+{
+  int l  = round_to_approx_size(sizeof(Doc) + sizeof(VolLogSegment));
+  Doc *d = reinterpret_cast<Doc *>(buf);
+  memset(static_cast<void *>(d), 0, l);
+  d->magic        = DOC_MAGIC;
+  d->len          = l;
+  d->sync_serial  = header->sync_serial;
+  d->write_serial = header->write_serial;
+  memcpy(d->data(), &lseg_table[lseg_cur], sizeof(VolLogSegment));
+  return l;
+}
+
+/*
+  How many blocks the write head has to go before it gets to @a e, -1 if it
+  is not in the rest of the current segment or in the next one.
+*/
+off_t
+Vol::lseg_ahead(Dir *e)
+{
+  int s      = lseg_of(e);
+  int n      = lseg_table[lseg_cur].next;
+  off_t head = offset_to_vol_offset(header->write_pos);
+
+  if (s == lseg_cur) {
+    return dir_phase(e) != header->phase && dir_offset(e) >= head ? dir_offset(e) - head : -1;
+  }
+  if (s == n && dir_phase(e) == lseg_table[n].phase) {
+    return offset_to_vol_offset(lseg_end(lseg_cur)) - head + dir_offset(e) - offset_to_vol_offset(lseg_start(n));
+  }
+  return -1;
+}
+
+/*
+  Move recovery on to the segment opened after the one it is in. False if it
+  has been there already, the write head went through the whole stripe.
+*/
+bool
+Vol::recover_next_lseg()
+{
+  recover_wrapped = true;
+  if (!lseg_table) {
+    recover_pos = start;
+    return true;
+  }
+  int n = lseg_table[recover_lseg].next;
+  if (n == lseg_cur || lseg_table[n].seq > lseg_table[lseg_cur].seq) {
+    return false;
+  }
+  recover_lseg = n;
+  recover_pos  = lseg_start(n);
+  return true;
+}
+
+// Check that @a doc, first in the segment recovery moved to, is the copy of its entry written when it was opened.
+bool
+Vol::lseg_recover_summary(Doc *doc)
+{
+  VolLogSegment seg;
+
+  if (doc->len != round_to_approx_size(sizeof(Doc) + sizeof(VolLogSegment)) || doc->hlen || !(doc->first_key == zero_key)) {
+    return false;
+  }
+  memcpy(&seg, doc->data(), sizeof(seg));
+  if (seg.index != static_cast<uint32_t>(recover_lseg) || seg.next >= static_cast<uint32_t>(lsegs) || seg.phase > 1 ||
+      seg.seq <= lseg_table[lseg_cur].seq) {
+    return false;
+  }
+  lseg_table[recover_lseg] = seg;
+  return true;
+}
+
+/*
+  Remove the directory entries of everything the write head may have
+  overwritten since the directory was synced: from header->write_pos
+  through the segments recovery followed, up to @a end in the last one.
+*/
+void
+Vol::lseg_recover_clear(off_t end)
+{
+  int s      = lseg_cur;
+  off_t from = header->write_pos;
+
+  for (int i = 0; i < lsegs; i++) {
+    if (s == recover_lseg) {
+      dir_clear_range(offset_to_vol_offset(from), offset_to_vol_offset(std::min(end, lseg_end(s))), this);
+      if (end > lseg_end(s)) {
+        off_t next = lseg_start(lseg_table[s].next);
+        dir_clear_range(offset_to_vol_offset(next), offset_to_vol_offset(next + (end - lseg_end(s))), this);
+      }
+      return;
+    }
+    dir_clear_range(offset_to_vol_offset(from), offset_to_vol_offset(lseg_end(s)), this);
+    s    = lseg_table[s].next;
+    from = lseg_start(s);
+  }
+}
@@ -25,6 +25,44 @@
 
 #include "HttpCacheSM.h" //Added to get the scope of HttpCacheSM object.
 
+namespace
+{
+// The span of a stripe, for fragments whose data is sent to the client from disk.
+class VolFile : public IOBufferFile
+{
+public:
+  VolFile(Vol *v, Dir *d) : vol(v), dir(*d) { fd = v->disk->file_fd; }
+
+  bool
+  stable(off_t /* offset ATS_UNUSED */, int64_t /* len ATS_UNUSED */) override
+  {
+    return dir_valid(vol, &dir) && vol->clear_of_write_head(&dir);
+  }
+
+private:
+  Vol *vol;
+  Dir dir;
+};
+
+// A CacheVC to read @a key from @a vol, a fast tier stripe if it is not @a home.
+CacheVC *
+new_read_CacheVC(Continuation *cont, const CacheKey *key, Vol *vol, Vol *home, CacheFragType type, OpenDirEntry *od)
+{
+  ProxyMutex *mutex = cont->mutex.get();
+  CacheVC *c        = new_CacheVC(cont);
+  SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
+  c->vio.op    = VIO::READ;
+  c->base_stat = cache_read_active_stat;
+  CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
+  c->first_key = c->key = c->earliest_key = *key;
+  c->vol                                  = vol;
+  c->tier_home                            = vol != home ? home : nullptr;
+  c->frag_type                            = type;
+  c->od                                   = od;
+  return c;
+}
+} // namespace
+
 Action *
 Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int host_len)
 {
@@ -34,23 +72,29 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
   }
   ink_assert(caches[type] == this);
 
-  Vol *vol = key_to_vol(key, hostname, host_len);
+  Vol *home = key_to_vol(key, hostname, host_len);
+  if (vol_not_ready(home)) {
+    cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
+  Vol *vol = tier_read_vol(key, home);
   Dir result, *last_collision = nullptr;
   ProxyMutex *mutex = cont->mutex.get();
   OpenDirEntry *od  = nullptr;
   CacheVC *c        = nullptr;
+Lprobe:
+  // Misses with no writer in progress are answered from the directory without the Vol lock.
+  if (!vol->open_dir.maybe_open(key) && !dir_probe_unlocked(key, vol)) {
+    CACHE_INCREMENT_DYN_STAT(cache_vol_lock_bypass_stat);
+    goto Lmiss;
+  }
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked()) {
+      CACHE_INCREMENT_DYN_STAT(cache_vol_lock_contention_stat);
+    }
     if (!lock.is_locked() || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
-      c = new_CacheVC(cont);
-      SET_CONTINUATION_HANDLER(c, &CacheVC::openReadStartHead);
-      c->vio.op    = VIO::READ;
-      c->base_stat = cache_read_active_stat;
-      CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
-      c->first_key = c->key = c->earliest_key = *key;
-      c->vol                                  = vol;
-      c->frag_type                            = type;
-      c->od                                   = od;
+      c = new_read_CacheVC(cont, key, vol, home, type, od);
     }
     if (!c) {
       goto Lmiss;
@@ -74,6 +118,13 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheFragType type, co
     }
   }
 Lmiss:
+  if (vol != home) {
+    // The fast tier copy went away after tier_read_vol() saw it.
+    vol            = home;
+    last_collision = nullptr;
+    goto Lprobe;
+  }
+  tier_read_miss(vol);
   CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
   cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
   return ACTION_RESULT_DONE;
@@ -90,6 +141,141 @@ Lcallreturn:
   return &c->_action;
 }
 
+/*
+  Like open_read() for each request, but the keys that may be in the cache
+  are sorted by stripe and probed with one lock of each. The reads of those
+  found are started under that lock, so the AIO backends that submit a
+  thread's queued requests together send them to the disks as one batch.
+  Callbacks are made once the stripe lock is released, as in open_read().
+*/
+void
+Cache::open_read_batch(CacheReadRequest *reqs, int n, CacheFragType type)
+{
+  struct Probe {
+    Vol *vol;
+    Vol *home;
+    int i;
+  };
+  // What is left to do for a request once the stripe lock is released.
+  struct Deferred {
+    enum { CALL_RETURN, FROM_WRITER, MISS, AGAIN } what;
+    int i;
+    CacheVC *c;
+  };
+  std::vector<Probe> probes;
+  std::vector<Deferred> after;
+
+  for (int i = 0; i < n; i++) {
+    reqs[i].action = ACTION_RESULT_DONE;
+  }
+  if (!n) {
+    return;
+  }
+  if (!CacheProcessor::IsCacheReady(type)) {
+    for (int i = 0; i < n; i++) {
+      reqs[i].cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NOT_READY);
+    }
+    return;
+  }
+  ink_assert(caches[type] == this);
+
+  ProxyMutex *mutex = reqs[0].cont->mutex.get();
+  probes.reserve(n);
+  for (int i = 0; i < n; i++) {
+    const CacheKey *key = reqs[i].key;
+    ink_assert(reqs[i].cont->mutex.get() == mutex);
+    Vol *home = key_to_vol(key, reqs[i].hostname, reqs[i].host_len);
+    if (vol_not_ready(home)) {
+      reqs[i].cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NOT_READY);
+      continue;
+    }
+    Vol *vol = tier_read_vol(key, home);
+    while (vol && !vol->open_dir.maybe_open(key) && !dir_probe_unlocked(key, vol)) {
+      CACHE_INCREMENT_DYN_STAT(cache_vol_lock_bypass_stat);
+      vol = vol != home ? home : nullptr;
+    }
+    if (!vol) {
+      vol = home; // the miss is counted against the stripe the key hashes to
+      tier_read_miss(home);
+      CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
+      reqs[i].cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
+      continue;
+    }
+    probes.push_back({vol, home, i});
+  }
+  std::stable_sort(probes.begin(), probes.end(), [](const Probe &a, const Probe &b) { return a.vol < b.vol; });
+
+  for (size_t b = 0, e; b < probes.size(); b = e) {
+    Vol *vol = probes[b].vol;
+    for (e = b + 1; e < probes.size() && probes[e].vol == vol; e++) {
+    }
+    after.clear();
+    {
+      CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+      if (!lock.is_locked()) {
+        // Each one retries on its own, as a single read does.
+        CACHE_INCREMENT_DYN_STAT(cache_vol_lock_contention_stat);
+        for (size_t p = b; p < e; p++) {
+          CacheReadRequest &r = reqs[probes[p].i];
+          CacheVC *c          = new_read_CacheVC(r.cont, r.key, vol, probes[p].home, type, nullptr);
+          CONT_SCHED_LOCK_RETRY(c);
+          r.action = &c->_action;
+        }
+        continue;
+      }
+      CACHE_SUM_DYN_STAT(cache_vol_lock_batched_stat, e - b - 1);
+      for (size_t p = b; p < e; p++) {
+        CacheReadRequest &r = reqs[probes[p].i];
+        Dir result, *last_collision = nullptr;
+        OpenDirEntry *od = vol->open_read(r.key);
+        if (!od && !dir_probe(r.key, vol, &result, &last_collision)) {
+          // A fast tier copy that went away is looked for again in its home stripe.
+          after.push_back({vol != probes[p].home ? Deferred::AGAIN : Deferred::MISS, probes[p].i, nullptr});
+          continue;
+        }
+        CacheVC *c = new_read_CacheVC(r.cont, r.key, vol, probes[p].home, type, od);
+        if (od) {
+          after.push_back({Deferred::FROM_WRITER, probes[p].i, c});
+          continue;
+        }
+        c->dir            = result;
+        c->last_collision = last_collision;
+        switch (c->do_read_call(&c->key)) {
+        case EVENT_DONE:
+          break;
+        case EVENT_RETURN:
+          after.push_back({Deferred::CALL_RETURN, probes[p].i, c});
+          break;
+        default:
+          r.action = &c->_action;
+          break;
+        }
+      }
+    }
+    for (Deferred &d : after) {
+      CacheReadRequest &r = reqs[d.i];
+      CacheVC *c          = d.c;
+      switch (d.what) {
+      case Deferred::AGAIN:
+        r.action = open_read(r.cont, r.key, type, r.hostname, r.host_len);
+        break;
+      case Deferred::MISS:
+        tier_read_miss(vol);
+        CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
+        r.cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
+        break;
+      case Deferred::FROM_WRITER:
+        SET_CONTINUATION_HANDLER(c, &CacheVC::openReadFromWriter);
+        r.action = c->handleEvent(EVENT_IMMEDIATE, nullptr) == EVENT_DONE ? ACTION_RESULT_DONE : &c->_action;
+        break;
+      case Deferred::CALL_RETURN:
+        r.action = c->handleEvent(AIO_EVENT_DONE, nullptr) == EVENT_DONE ? ACTION_RESULT_DONE : &c->_action;
+        break;
+      }
+    }
+  }
+}
+
 Action *
 Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request, const OverridableHttpConfigParams *params,
                  CacheFragType type, const char *hostname, int host_len)
@@ -100,18 +286,31 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
   }
   ink_assert(caches[type] == this);
 
-  Vol *vol = key_to_vol(key, hostname, host_len);
+  Vol *home = key_to_vol(key, hostname, host_len);
+  if (vol_not_ready(home)) {
+    cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
+  Vol *vol = tier_read_vol(key, home);
   Dir result, *last_collision = nullptr;
   ProxyMutex *mutex = cont->mutex.get();
   OpenDirEntry *od  = nullptr;
   CacheVC *c        = nullptr;
-
+Lprobe:
+  if (!vol->open_dir.maybe_open(key) && !dir_probe_unlocked(key, vol)) {
+    CACHE_INCREMENT_DYN_STAT(cache_vol_lock_bypass_stat);
+    goto Lmiss;
+  }
   {
     CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+    if (!lock.is_locked()) {
+      CACHE_INCREMENT_DYN_STAT(cache_vol_lock_contention_stat);
+    }
     if (!lock.is_locked() || (od = vol->open_read(key)) || dir_probe(key, vol, &result, &last_collision)) {
       c            = new_CacheVC(cont);
       c->first_key = c->key = c->earliest_key = *key;
       c->vol                                  = vol;
+      c->tier_home                            = vol != home ? home : nullptr;
       c->vio.op                               = VIO::READ;
       c->base_stat                            = cache_read_active_stat;
       CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
@@ -145,6 +344,13 @@ Cache::open_read(Continuation *cont, const CacheKey *key, CacheHTTPHdr *request,
     }
   }
 Lmiss:
+  if (vol != home) {
+    // The fast tier copy went away after tier_read_vol() saw it.
+    vol            = home;
+    last_collision = nullptr;
+    goto Lprobe;
+  }
+  tier_read_miss(vol);
   CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
   cont->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-ECACHE_NO_DOC);
   return ACTION_RESULT_DONE;
@@ -314,6 +520,13 @@ CacheVC::openReadFromWriter(int event, Event *e)
   intptr_t err = ECACHE_DOC_BUSY;
   DDebug("cache_read_agg", "%p: key: %X In openReadFromWriter", this, first_key.slice32(1));
   if (_action.cancelled) {
+    if (f.wait_for_writer) {
+      CACHE_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+      if (!lock.is_locked()) {
+        VC_SCHED_LOCK_RETRY();
+      }
+      writer_wait_done();
+    }
     od = nullptr; // only open for read so no need to close
     return free_CacheVC(this);
   }
@@ -321,6 +534,7 @@ CacheVC::openReadFromWriter(int event, Event *e)
   if (!lock.is_locked()) {
     VC_SCHED_LOCK_RETRY();
   }
+  writer_wait_done();
   od = vol->open_read(&first_key); // recheck in case the lock failed
   if (!od) {
     MUTEX_RELEASE(lock);
@@ -535,6 +749,7 @@ CacheVC::openReadClose(int event, Event * /* e ATS_UNUSED */)
   if (!lock.is_locked()) {
     VC_SCHED_LOCK_RETRY();
   }
+  writer_wait_done();
   if (f.hit_evacuate && dir_valid(vol, &first_dir) && closed > 0) {
     if (f.single_fragment) {
       vol->force_evacuate_head(&first_dir, dir_pinned(&first_dir));
@@ -562,6 +777,7 @@ CacheVC::openReadReadDone(int event, Event *e)
     if (!lock.is_locked()) {
       VC_SCHED_LOCK_RETRY();
     }
+    writer_wait_done();
     if (event == AIO_EVENT_DONE && !io.ok()) {
       goto Lerror;
     }
@@ -771,7 +987,16 @@ CacheVC::openReadMain(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   if (bytes > vio.ntodo()) {
     bytes = vio.ntodo();
   }
-  b           = new_IOBufferBlock(buf, bytes, doc_pos);
+  if (f.header_only) {
+    Ptr<IOBufferData> d = make_ptr(new_file_IOBufferData(new VolFile(vol, &dir), vol->vol_offset(&dir) + doc_pos, bytes));
+    b                   = new_IOBufferBlock(d, bytes, 0);
+  } else {
+    // RAM cache data stays as it is, the socket may send it without copying it
+    if (f.doc_from_ram_cache && zero_copy()) {
+      buf->_immutable = true;
+    }
+    b = new_IOBufferBlock(buf, bytes, doc_pos);
+  }
   b->_buf_end = b->_end;
   vio.buffer.writer()->append_block(b);
   vio.ndone += bytes;
@@ -806,9 +1031,11 @@ Lread : {
     SET_HANDLER(&CacheVC::openReadMain);
     VC_SCHED_LOCK_RETRY();
   }
+  writer_wait_done();
   if (dir_probe(&key, vol, &dir, &last_collision)) {
     SET_HANDLER(&CacheVC::openReadReadDone);
-    int ret = do_read_call(&key);
+    f.header_only = zero_copy() && !cache_config_enable_checksum && vol->disk->file_fd >= 0;
+    int ret       = do_read_call(&key);
     if (ret == EVENT_RETURN) {
       goto Lcallreturn;
     }
@@ -901,6 +1128,7 @@ CacheVC::openReadStartEarliest(int /* event ATS_UNUSED */, Event * /* e ATS_UNUS
       goto Lread;
     }
     if (!(doc->key == key)) { // collision
+      CACHE_INCREMENT_DYN_STAT(cache_directory_collision_read_stat);
       goto Lread;
     }
     // success
@@ -931,6 +1159,7 @@ CacheVC::openReadStartEarliest(int /* event ATS_UNUSED */, Event * /* e ATS_UNUS
         Doc *doc1    = reinterpret_cast<Doc *>(first_buf->data());
         uint32_t len = this->load_http_info(write_vector, doc1);
         ink_assert(len == doc1->hlen && write_vector->count() > 0);
+        write_vector->expand();
         write_vector->remove(alternate_index, true);
         // if the vector had one alternate, delete it's directory entry
         if (len != doc1->hlen || !write_vector->count()) {
@@ -1103,7 +1332,8 @@ CacheVC::openReadStartHead(int event, Event *e)
       last_collision = nullptr;
       goto Lread;
     }
-    if (!(doc->first_key == key)) {
+    if (!(doc->first_key == key)) { // collision
+      CACHE_INCREMENT_DYN_STAT(cache_directory_collision_read_stat);
       goto Lread;
     }
     if (f.lookup) {
@@ -1152,6 +1382,7 @@ CacheVC::openReadStartHead(int event, Event *e)
       } else {
         alternate_index = 0;
       }
+      vector.expand(alternate_index);
       alternate_tmp = vector.get(alternate_index);
       if (!alternate_tmp->valid()) {
         if (buf) {
@@ -1199,6 +1430,7 @@ CacheVC::openReadStartHead(int event, Event *e)
       f.hit_evacuate = 1;
     }
 
+    tier_read_done(this, doc);
     first_buf = buf;
     vol->begin_read(this);
 
@@ -1229,9 +1461,21 @@ CacheVC::openReadStartHead(int event, Event *e)
       }
       return ret;
     }
+    if (tier_home) {
+      // The fast tier entry was a tag collision or is gone, read the object from the slow tier.
+      CACHE_DECREMENT_DYN_STAT(base_stat + CACHE_STAT_ACTIVE);
+      vol            = tier_home;
+      tier_home      = nullptr;
+      last_collision = nullptr;
+      buf            = nullptr;
+      CACHE_INCREMENT_DYN_STAT(base_stat + CACHE_STAT_ACTIVE);
+      MUTEX_RELEASE(lock);
+      return openReadStartHead(event, e);
+    }
   }
 Ldone:
   if (!f.lookup) {
+    tier_read_miss(vol);
     CACHE_INCREMENT_DYN_STAT(cache_read_failure_stat);
     _action.continuation->handleEvent(CACHE_EVENT_OPEN_READ_FAILED, (void *)-err);
   } else {
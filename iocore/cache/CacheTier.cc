@@ -0,0 +1,319 @@
+/** @file
+
+  Tiered storage: hot objects are copied to the tier=fast volume, cold ones go back on eviction.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// Objects are always written to the slow tier stripe their key hashes to, which
+// stays the authoritative copy. Reads probe the fast tier stripe for the key
+// first and fall back to the slow tier on a miss.
+//
+// A read served from the slow tier is counted against the key. Once the count
+// reaches proxy.config.cache.tier.promote_hits, the first Doc is copied into the
+// fast tier stripe through its aggregation buffer, the way evacuated documents
+// are rewritten. Only objects held entirely by their first Doc are promoted, so
+// a fast tier copy never depends on fragments stored elsewhere.
+//
+// The fast tier is reclaimed by its write head like any stripe. Ahead of it, the
+// periodic scan schedules the heads it is about to overwrite for evacuation. When
+// such a Doc has been read in and nobody is reading it, it is dropped, and if the
+// slow tier lost the object in the meantime it is written back there (demotion).
+// Documents that are being read are evacuated within the fast tier as usual.
+//
+// A new version written to the slow tier, or a remove, deletes the fast tier copy.
+
+#include "P_Cache.h"
+
+#define TIER_FREQ_MIN_SIZE 1024   // read counters per stripe
+#define TIER_FREQ_SAMPLE_FACTOR 8 // halve the counters after this many reads per counter
+
+// The copy is made into a single buffer, and has to fit the aggregation buffer of the target.
+static bool
+tier_movable(Doc *doc)
+{
+  return doc->single_fragment() && doc->len <= static_cast<uint32_t>(BUFFER_SIZE_FOR_INDEX(MAX_BUFFER_SIZE_INDEX)) &&
+         doc->len <= AGG_SIZE;
+}
+
+static IOBufferData *
+tier_copy(Doc *doc)
+{
+  IOBufferData *data = new_IOBufferData(iobuffer_size_to_index(doc->len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+  memcpy(data->data(), doc, doc->len);
+  return data;
+}
+
+/*
+  Build the CacheVC that writes @a data, a copy of the head Doc found at @a dir
+  on @a from, into @a to. It is created under the lock of @a from and runs under
+  the lock of @a to once tier_move() schedules it.
+*/
+static CacheVC *
+new_TierMover(IOBufferData *data, Vol *from, Vol *to, Dir *dir)
+{
+  CacheVC *c        = new_CacheVC(from);
+  Doc *doc          = reinterpret_cast<Doc *>(data->data());
+  Vol *vol          = to;
+  ProxyMutex *mutex = from->mutex.get();
+  c->base_stat      = cache_evacuate_active_stat;
+  CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
+  c->buf           = data;
+  c->vol           = to;
+  c->f.evacuator   = 1;
+  c->first_key     = doc->first_key;
+  c->key           = doc->key;
+  c->earliest_key  = zero_key;
+  c->first_dir     = *dir;
+  c->overwrite_dir = *dir;
+  SET_CONTINUATION_HANDLER(c, &CacheVC::tierMoveStart);
+  return c;
+}
+
+static void
+tier_move(CacheVC *c)
+{
+  c->mutex = c->vol->mutex;
+  eventProcessor.schedule_imm(c, ET_CALL);
+}
+
+int
+Vol::tier_read_count(const CacheKey *key)
+{
+  if (!tier_freq) {
+    uint32_t n = TIER_FREQ_MIN_SIZE;
+    while (n < static_cast<uint32_t>(direntries() / DIR_DEPTH)) {
+      n <<= 1;
+    }
+    tier_freq      = static_cast<uint8_t *>(ats_calloc(n, sizeof(uint8_t)));
+    tier_freq_mask = n - 1;
+  }
+  // Two counters per key, the smaller one is the estimate.
+  uint8_t &a = tier_freq[key->slice32(0) & tier_freq_mask];
+  uint8_t &b = tier_freq[key->slice32(1) & tier_freq_mask];
+  if (a < UINT8_MAX) {
+    ++a;
+  }
+  if (b < UINT8_MAX) {
+    ++b;
+  }
+  int count = std::min(a, b);
+  if (++tier_freq_adds >= (tier_freq_mask + 1) * TIER_FREQ_SAMPLE_FACTOR) {
+    for (uint32_t i = 0; i <= tier_freq_mask; ++i) {
+      tier_freq[i] >>= 1;
+    }
+    tier_freq_adds = 0;
+  }
+  return count;
+}
+
+/*
+  Pick the stripe to read @a key from: the fast tier stripe if its directory has
+  the key, @a home otherwise. Called without any Vol lock.
+*/
+Vol *
+tier_read_vol(const CacheKey *key, Vol *home)
+{
+  if (home->cache_vol->fast_tier) {
+    return home;
+  }
+  Vol *vol = home->cache->key_to_tier_vol(key);
+  if (!vol) {
+    return home;
+  }
+  // A writer on the slow tier has a newer version than any copy, the read goes there to find it.
+  if (vol->ready && !home->open_dir.maybe_open(key) && dir_probe_unlocked(key, vol)) {
+    return vol;
+  }
+  CACHE_SUM_DYN_STAT_THREAD(cache_tier_fast_miss_stat, 1);
+  return home;
+}
+
+/*
+  Account a successful read of @a doc, the head of the object, and promote the
+  object if it has been read often enough from the slow tier. Called with the
+  lock of vc->vol held.
+*/
+void
+tier_read_done(CacheVC *vc, Doc *doc)
+{
+  Vol *vol = vc->vol;
+
+  if (vc->tier_home) {
+    CACHE_SUM_DYN_STAT_THREAD(cache_tier_fast_hit_stat, 1);
+    return;
+  }
+  Vol *fast = vol->cache_vol->fast_tier ? nullptr : vol->cache->key_to_tier_vol(&vc->first_key);
+  if (!fast) {
+    return;
+  }
+  CACHE_SUM_DYN_STAT_THREAD(cache_tier_slow_hit_stat, 1);
+
+  // The copy has to be readable on its own: one alternate, with its data in the first Doc.
+  if (!cache_config_tier_promote_hits || !vc->f.single_fragment ||
+      (vc->frag_type == CACHE_FRAG_TYPE_HTTP && vc->vector.count() != 1) || !tier_movable(doc)) {
+    return;
+  }
+  if (vol->tier_read_count(&vc->first_key) < cache_config_tier_promote_hits) {
+    return;
+  }
+  if (!fast->ready || fast->agg_todo_size > cache_config_agg_write_backlog || dir_probe_unlocked(&vc->first_key, fast)) {
+    return;
+  }
+  DDebug("cache_tier", "promote %X from %s to %s", vc->first_key.slice32(0), vol->hash_text.get(), fast->hash_text.get());
+  CacheVC *c   = new_TierMover(tier_copy(doc), vol, fast, &vc->dir);
+  c->tier_home = vol;
+  tier_move(c);
+}
+
+void
+tier_read_miss(Vol *vol)
+{
+  if (vol->cache->hosttable->tier_host_rec.vol_hash_table) {
+    CACHE_SUM_DYN_STAT_THREAD(cache_tier_slow_miss_stat, 1);
+  }
+}
+
+/*
+  The fast tier stripe @a vol is about to overwrite the head at @a dir, read in
+  by @a evacuator. Write it back to its slow tier stripe if that no longer has
+  the object. Called with the lock of @a vol held.
+*/
+void
+tier_demote(Vol *vol, CacheVC *evacuator, Dir *dir)
+{
+  Doc *doc             = reinterpret_cast<Doc *>(evacuator->buf->data());
+  const char *hostname = nullptr;
+  int host_len         = 0;
+
+  if (!dir_head(dir) || !dir_compare_tag(dir, &doc->first_key) || !tier_movable(doc)) {
+    return;
+  }
+  // Unmarshalling the vector rewrites it in place, so copy the Doc first.
+  Ptr<IOBufferData> data = make_ptr(tier_copy(doc));
+  if (doc->doc_type == CACHE_FRAG_TYPE_HTTP) {
+    if (!doc->hlen || evacuator->load_http_info(&evacuator->vector, doc) != doc->hlen || evacuator->vector.count() != 1) {
+      return;
+    }
+    // The slow tier stripe depends on hosting.config, find it the way the read did.
+    hostname = evacuator->vector.get(0)->request_get()->url_get()->host_get(&host_len);
+  }
+  Vol *home = vol->cache->key_to_vol(&doc->first_key, hostname, host_len);
+  if (home == vol || home->cache_vol->fast_tier || !home->ready || dir_probe_unlocked(&doc->first_key, home)) {
+    return;
+  }
+  DDebug("cache_tier", "demote %X from %s to %s", doc->first_key.slice32(0), vol->hash_text.get(), home->hash_text.get());
+  tier_move(new_TierMover(data.get(), vol, home, dir));
+}
+
+/*
+  Delete the fast tier copy of @a key after a new version was written to, or the
+  object removed from, the slow tier stripe @a home. Called with the lock of
+  @a home held.
+*/
+void
+tier_invalidate(const CacheKey *key, Vol *home)
+{
+  if (home->cache_vol->fast_tier) {
+    return;
+  }
+  Vol *vol = home->cache->key_to_tier_vol(key);
+  if (!vol || !dir_probe_unlocked(key, vol)) {
+    return;
+  }
+  CacheVC *c        = new_CacheVC(home);
+  ProxyMutex *mutex = home->mutex.get();
+  c->base_stat      = cache_remove_active_stat;
+  CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
+  c->vol       = vol;
+  c->first_key = *key;
+  SET_CONTINUATION_HANDLER(c, &CacheVC::tierInvalidate);
+  tier_move(c);
+}
+
+int
+CacheVC::tierMoveStart(int event, Event * /* e ATS_UNUSED */)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  Doc *doc = reinterpret_cast<Doc *>(buf->data());
+
+  agg_len = vol->round_to_approx_size(doc->len);
+  if (agg_len > AGG_SIZE || vol->agg_todo_size > cache_config_agg_write_backlog) {
+    CACHE_INCREMENT_DYN_STAT(cache_tier_move_aborted_stat);
+    return free_CacheVC(this);
+  }
+  // agg_copy() places the copy with the flags of the original directory entry.
+  dir_set_approx_size(&overwrite_dir, agg_len);
+  SET_HANDLER(&CacheVC::tierMoveDone);
+  vol->agg_todo_size += agg_len;
+  vol->agg.enqueue(this);
+  if (!vol->is_io_in_progress()) {
+    return vol->aggWrite(event, this);
+  }
+  return EVENT_CONT;
+}
+
+int
+CacheVC::tierMoveDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  Doc *doc = reinterpret_cast<Doc *>(buf->data());
+  Dir probe, *collision = nullptr;
+  // A zero offset means the aggregation buffer gave up on the write.
+  bool publish = dir_offset(&dir) && !dir_probe(&first_key, vol, &probe, &collision);
+
+  if (publish && tier_home) {
+    // A promoted copy is only good while the slow tier still has the version it was made from.
+    publish = false;
+    CACHE_TRY_LOCK(lock, tier_home->mutex, mutex->thread_holding);
+    if (lock.is_locked()) {
+      collision = nullptr;
+      while (!publish && dir_probe(&first_key, tier_home, &probe, &collision)) {
+        publish = dir_offset(&probe) == dir_offset(&first_dir) && dir_phase(&probe) == dir_phase(&first_dir);
+      }
+    }
+  }
+  if (!publish) {
+    CACHE_INCREMENT_DYN_STAT(cache_tier_move_aborted_stat);
+  } else {
+    dir_insert(&first_key, vol, &dir);
+    if (tier_home) {
+      CACHE_INCREMENT_DYN_STAT(cache_tier_promote_stat);
+      CACHE_SUM_DYN_STAT(cache_tier_promote_bytes_stat, doc->len);
+    } else {
+      CACHE_INCREMENT_DYN_STAT(cache_tier_demote_stat);
+      CACHE_SUM_DYN_STAT(cache_tier_demote_bytes_stat, doc->len);
+    }
+  }
+  return free_CacheVC(this);
+}
+
+int
+CacheVC::tierInvalidate(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  Dir del, *collision = nullptr;
+
+  while (dir_probe(&first_key, vol, &del, &collision)) {
+    dir_delete(&first_key, vol, &del);
+    collision = nullptr;
+    CACHE_INCREMENT_DYN_STAT(cache_tier_invalidate_stat);
+  }
+  return free_CacheVC(this);
+}
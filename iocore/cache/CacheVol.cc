@@ -249,6 +249,9 @@ CacheVC::scanObject(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     {
       char *tmp = doc->hdr();
       int len   = doc->hlen;
+      int hlen  = CacheAltVectorHeader::length(tmp, len);
+      tmp += hlen;
+      len -= hlen;
       while (len > 0) {
         int r = HTTPInfo::unmarshal(tmp, len, buf.get());
         if (r < 0) {
@@ -262,6 +265,7 @@ CacheVC::scanObject(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
     if (this->load_http_info(&vector, doc) != doc->hlen) {
       goto Lskip;
     }
+    vector.expand();
     changed         = false;
     hostinfo_copied = false;
     for (i = 0; i < vector.count(); i++) {
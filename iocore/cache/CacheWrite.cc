@@ -182,6 +182,43 @@ CacheVC::updateVector(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
   }
   return ret;
 }
+
+#define WRITE_SEEN_ENTRIES (1 << 16)
+
+// Whether the disk under the stripe is too busy for low value writes, see CacheDiskLoad.
+static inline bool
+write_throttled(Vol *vol)
+{
+  return cache_config_write_throttle && vol->disk && vol->disk->overloaded();
+}
+
+/*
+  Admission of a new write while the disk of the stripe is overloaded. The
+  first key is turned away the first time it asks and remembered, so only
+  objects requested again are written while reads are suffering. Updates
+  and removes always go through. Returns 0 or ECACHE_WRITE_FAIL, called
+  under the Vol lock.
+*/
+int
+Vol::admit_write(CacheVC *cont)
+{
+  if (cont->f.update || cont->f.remove || !write_throttled(this)) {
+    return 0;
+  }
+  if (!write_seen) {
+    write_seen = new uint16_t[WRITE_SEEN_ENTRIES]();
+  }
+  uint16_t &seen = write_seen[cont->first_key.slice32(1) % WRITE_SEEN_ENTRIES];
+  uint16_t tag   = static_cast<uint16_t>(cont->first_key.slice32(3)) | 1; // 0 is an empty slot
+  if (seen == tag) {
+    return 0;
+  }
+  seen     = tag;
+  Vol *vol = this;
+  CACHE_INCREMENT_DYN_STAT(cache_write_throttle_once_stat);
+  return ECACHE_WRITE_FAIL;
+}
+
 /*
    The following fields of the CacheVC are used when writing down a fragment.
    Make sure that each of the fields is set to a valid value before calling
@@ -235,9 +272,13 @@ CacheVC::handleWrite(int event, Event * /* e ATS_UNUSED */)
 #endif
   bool max_doc_error = (cache_config_max_doc_size && (cache_config_max_doc_size < vio.ndone ||
                                                       (vio.nbytes != INT64_MAX && (cache_config_max_doc_size < vio.nbytes))));
+  // While the disk is overloaded, large objects are not worth the bandwidth they would take from reads.
+  bool throttle_error = (!f.readers && !f.update && write_len && cache_config_write_throttle_max_size &&
+                         (vio.nbytes != INT64_MAX ? vio.nbytes : vio.ndone) > cache_config_write_throttle_max_size &&
+                         write_throttled(vol));
 
-  if (agg_error || max_doc_error) {
-    CACHE_INCREMENT_DYN_STAT(cache_write_backlog_failure_stat);
+  if (agg_error || max_doc_error || throttle_error) {
+    CACHE_INCREMENT_DYN_STAT(throttle_error ? cache_write_throttle_large_stat : cache_write_backlog_failure_stat);
     CACHE_INCREMENT_DYN_STAT(base_stat + CACHE_STAT_FAILURE);
     vol->agg_todo_size -= agg_len;
     io.aio_result = AIO_SOFT_FAILURE;
@@ -252,9 +293,12 @@ CacheVC::handleWrite(int event, Event * /* e ATS_UNUSED */)
   } else {
     vol->agg.enqueue(this);
   }
+  agg_wait_start = Thread::get_hrtime_updated();
   if (!vol->is_io_in_progress()) {
     return vol->aggWrite(event, this);
   }
+  // no aggregation buffer to copy into until a write finishes
+  CACHE_INCREMENT_DYN_STAT(cache_agg_buffer_overflow_stat);
   return EVENT_CONT;
 }
 
@@ -310,10 +354,16 @@ Vol::force_evacuate_head(Dir *evac_dir, int pinned)
   return b;
 }
 
+/*
+  Schedule the pinned documents ahead of the write head for evacuation. On a
+  fast tier stripe the other heads there are scheduled too, marked to be
+  demoted rather than kept.
+*/
 void
 Vol::scan_for_pinned_documents()
 {
-  if (cache_config_permit_pinning) {
+  bool demote = cache_config_tier_demote && cache_vol->fast_tier && cache->hosttable->tier_host_rec.vol_hash_table;
+  if (cache_config_permit_pinning || demote) {
     // we can't evacuate anything between header->write_pos and
     // header->write_pos + AGG_SIZE.
     int ps                = this->offset_to_vol_offset(header->write_pos + AGG_SIZE);
@@ -322,11 +372,16 @@ Vol::scan_for_pinned_documents()
     int before_end_of_vol = pe < vol_end_offset;
     DDebug("cache_evac", "scan %d %d", ps, pe);
     for (int i = 0; i < this->direntries(); i++) {
-      // is it a valid pinned object?
-      if (!dir_is_empty(&dir[i]) && dir_pinned(&dir[i]) && dir_head(&dir[i])) {
+      // is it a valid pinned object, or one to demote?
+      if (!dir_is_empty(&dir[i]) && dir_head(&dir[i]) && (dir_pinned(&dir[i]) ? cache_config_permit_pinning : demote)) {
         // select objects only within this PIN_SCAN region
         int o = dir_offset(&dir[i]);
-        if (dir_phase(&dir[i]) == header->phase) {
+        if (lseg_table) {
+          // the rest of the segment being written and the one after it
+          if (lseg_ahead(&dir[i]) < AGG_SIZE / CACHE_BLOCK_SIZE) {
+            continue;
+          }
+        } else if (dir_phase(&dir[i]) == header->phase) {
           if (before_end_of_vol || o >= (pe - vol_end_offset)) {
             continue;
           }
@@ -335,7 +390,11 @@ Vol::scan_for_pinned_documents()
             continue;
           }
         }
-        force_evacuate_head(&dir[i], 1);
+        if (dir_pinned(&dir[i])) {
+          force_evacuate_head(&dir[i], 1);
+        } else if (!evacuation_block_exists(&dir[i], this)) {
+          force_evacuate_head(&dir[i], 0)->f.demote = 1;
+        }
         //      DDebug("cache_evac", "scan pinned at offset %d %d %d %d %d %d",
         //            (int)dir_offset(&b->dir), ps, o , pe, i, (int)b->f.done);
       }
@@ -343,13 +402,19 @@ Vol::scan_for_pinned_documents()
   }
 }
 
+int
+AggBuffer::handle_write_done(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  return vol->aggWriteDone(this);
+}
+
 /* NOTE:: This state can be called by an AIO thread, so DON'T DON'T
    DON'T schedule any events on this thread using VC_SCHED_XXX or
    mutex->thread_holding->schedule_xxx_local(). ALWAYS use
    eventProcessor.schedule_xxx().
    */
 int
-Vol::aggWriteDone(int event, Event *e)
+Vol::aggWriteDone(AggBuffer *b)
 {
   cancel_trigger();
 
@@ -357,56 +422,59 @@ Vol::aggWriteDone(int event, Event *e)
   // retaking the current mutex recursively is a NOOP
   CACHE_TRY_LOCK(lock, dir_sync_waiting ? cacheDirSync->mutex : mutex, mutex->thread_holding);
   if (!lock.is_locked()) {
-    eventProcessor.schedule_in(this, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
+    eventProcessor.schedule_in(b, HRTIME_MSECONDS(cache_config_mutex_retry_delay));
     return EVENT_CONT;
   }
-  if (io.ok()) {
-    header->last_write_pos = header->write_pos;
-    header->write_pos += io.aiocb.aio_nbytes;
-    ink_assert(header->write_pos >= start);
-    DDebug("cache_agg", "Dir %s, Write: %" PRIu64 ", last Write: %" PRIu64 "", hash_text.get(), header->write_pos,
-           header->last_write_pos);
-    ink_assert(header->write_pos == header->agg_pos);
-    if (header->write_pos + EVACUATION_SIZE > scan_pos) {
-      periodic_scan();
-    }
-    agg_buf_pos = 0;
-    header->write_serial++;
-  } else {
-    // delete all the directory entries that we inserted
-    // for fragments is this aggregation buffer
-    Debug("cache_disk_error", "Write error on disk %s\n \
+  disk->load.write_done();
+  b->done = true;
+
+  // The writes are retired in the order they were issued, so that the sync
+  // CacheVCs and the directory sync only see data that is all on disk.
+  uint32_t written_serial = 0;
+  bool retired            = false;
+  while (agg_writes && (b = agg_issued(agg_writes))->done) {
+    if (b->io.ok()) {
+      DDebug("cache_agg", "Dir %s, Written: %" PRIu64 " - %" PRIu64 "", hash_text.get(), (uint64_t)b->offset,
+             (uint64_t)(b->offset + b->len));
+    } else {
+      // delete all the directory entries that we inserted
+      // for fragments is this aggregation buffer
+      Debug("cache_disk_error", "Write error on disk %s\n \
               write range : [%" PRIu64 " - %" PRIu64 " bytes]  [%" PRIu64 " - %" PRIu64 " blocks] \n",
-          hash_text.get(), (uint64_t)io.aiocb.aio_offset, (uint64_t)io.aiocb.aio_offset + io.aiocb.aio_nbytes,
-          (uint64_t)io.aiocb.aio_offset / CACHE_BLOCK_SIZE,
-          (uint64_t)(io.aiocb.aio_offset + io.aiocb.aio_nbytes) / CACHE_BLOCK_SIZE);
-    Dir del_dir;
-    dir_clear(&del_dir);
-    for (int done = 0; done < agg_buf_pos;) {
-      Doc *doc = reinterpret_cast<Doc *>(agg_buffer + done);
-      dir_set_offset(&del_dir, header->write_pos + done);
-      dir_delete(&doc->key, this, &del_dir);
-      done += round_to_approx_size(doc->len);
+            hash_text.get(), (uint64_t)b->offset, (uint64_t)b->offset + b->len, (uint64_t)b->offset / CACHE_BLOCK_SIZE,
+            (uint64_t)(b->offset + b->len) / CACHE_BLOCK_SIZE);
+      Dir del_dir;
+      dir_clear(&del_dir);
+      for (int done = 0; done < b->len;) {
+        Doc *doc = reinterpret_cast<Doc *>(b->buf + done);
+        dir_set_offset(&del_dir, b->offset + done);
+        dir_delete(&doc->key, this, &del_dir);
+        done += round_to_approx_size(doc->len);
+      }
     }
-    agg_buf_pos = 0;
+    // header->write_serial as it was when this write finished before the next one was issued
+    written_serial = b->write_serial + 1;
+    retired        = true;
+    b->len         = 0;
+    b->done        = false;
+    agg_writes--;
   }
-  set_io_not_in_progress();
   // callback ready sync CacheVCs
   CacheVC *c = nullptr;
-  while ((c = sync.dequeue())) {
-    if (UINT_WRAP_LTE(c->write_serial + 2, header->write_serial)) {
+  while (retired && (c = sync.dequeue())) {
+    if (UINT_WRAP_LTE(c->write_serial + 2, written_serial)) {
       eventProcessor.schedule_imm(c, ET_CALL, AIO_EVENT_DONE);
     } else {
       sync.push(c); // put it back on the front
       break;
     }
   }
-  if (dir_sync_waiting) {
+  if (dir_sync_waiting && !agg_writes) {
     dir_sync_waiting = false;
     cacheDirSync->handleEvent(EVENT_IMMEDIATE, nullptr);
   }
-  if (agg.head || sync.head) {
-    return aggWrite(event, e);
+  if ((agg.head || sync.head) && !is_io_in_progress()) {
+    return aggWrite(AIO_EVENT_DONE, nullptr);
   }
   return EVENT_CONT;
 }
@@ -673,6 +741,11 @@ Vol::evacuateDocReadDone(int event, Event *e)
   if ((b->f.pinned && !b->readers) && doc->pinned < static_cast<uint32_t>(Thread::get_hrtime() / HRTIME_SECOND)) {
     goto Ldone;
   }
+  if (b->f.demote && !b->f.pinned && !b->readers) {
+    // fast tier space is given up rather than evacuated
+    tier_demote(this, doc_evacuator, &b->dir);
+    goto Ldone;
+  }
 
   if (dir_head(&b->dir) && b->f.evacuate_head) {
     ink_assert(!b->evac_frags.key.fold());
@@ -925,13 +998,14 @@ agg_copy(char *p, CacheVC *vc)
   }
 }
 
-inline void
+void
 Vol::evacuate_cleanup_blocks(int i)
 {
   EvacuationBlock *b = evacuate[i].head;
   while (b) {
-    if (b->f.done && ((header->phase != dir_phase(&b->dir) && header->write_pos > this->vol_offset(&b->dir)) ||
-                      (header->phase == dir_phase(&b->dir) && header->write_pos <= this->vol_offset(&b->dir)))) {
+    if (b->f.done && (lseg_table ? lseg_ahead(&b->dir) < 0 :
+                                   ((header->phase != dir_phase(&b->dir) && header->write_pos > this->vol_offset(&b->dir)) ||
+                                    (header->phase == dir_phase(&b->dir) && header->write_pos <= this->vol_offset(&b->dir))))) {
       EvacuationBlock *x = b;
       DDebug("cache_evac", "evacuate cleanup free %X offset %d", (int)b->evac_frags.key.slice32(0), (int)dir_offset(&b->dir));
       b = b->link.next;
@@ -988,6 +1062,10 @@ Vol::periodic_scan()
 void
 Vol::agg_wrap()
 {
+  if (lseg_table) {
+    lseg_open(lseg_table[lseg_cur].next);
+    return;
+  }
   header->write_pos = start;
   header->phase     = !header->phase;
 
@@ -1013,10 +1091,15 @@ Vol::agg_wrap()
 int
 Vol::aggWrite(int event, void * /* e ATS_UNUSED */)
 {
-  ink_assert(!is_io_in_progress());
+  ink_assert(io.aiocb.aio_fildes == AIO_NOT_IN_PROGRESS);
+  if (is_io_in_progress()) {
+    // a directory sync is waiting for the buffers being written, the last of them calls back
+    return EVENT_CONT;
+  }
 
   Que(CacheVC, link) tocall;
   CacheVC *c;
+  off_t end;
 
   cancel_trigger();
 
@@ -1026,7 +1109,8 @@ Lagain:
     int writelen = c->agg_len;
     // [amc] this is checked multiple places, on here was it strictly less.
     ink_assert(writelen <= AGG_SIZE);
-    if (agg_buf_pos + writelen > AGG_SIZE || header->write_pos + agg_buf_pos + writelen > (skip + len)) {
+    // the buffer holds up to agg_size, but always takes a first write of any size
+    if ((agg_buf_pos && agg_buf_pos + writelen > agg_size) || header->write_pos + agg_buf_pos + writelen > lseg_end(lseg_cur)) {
       break;
     }
     DDebug("agg_read", "copying: %d, %" PRIu64 ", key: %d", agg_buf_pos, header->write_pos + agg_buf_pos, c->first_key.slice32(0));
@@ -1034,6 +1118,11 @@ Lagain:
     ink_assert(writelen == wrotelen);
     agg_todo_size -= writelen;
     agg_buf_pos += writelen;
+    if (c->agg_wait_start) {
+      Vol *vol = this;
+      CACHE_SUM_DYN_STAT(cache_agg_buffer_wait_stat, ink_hrtime_to_usec(Thread::get_hrtime_updated() - c->agg_wait_start));
+      c->agg_wait_start = 0;
+    }
     CacheVC *n = (CacheVC *)c->link.next;
     agg.dequeue();
     if (c->f.sync && c->f.use_first_key) {
@@ -1066,27 +1155,34 @@ Lagain:
       }
       return EVENT_CONT;
     }
-    // start back
+    // start back, or go on to the next log segment, once the writes before the end are done
     if (agg.head) {
+      if (agg_writes) {
+        goto Lwait;
+      }
       agg_wrap();
       goto Lagain;
     }
   }
 
   // evacuate space
-  off_t end = header->write_pos + agg_buf_pos + EVACUATION_SIZE;
-  if (evac_range(header->write_pos, end, !header->phase) < 0) {
+  end = header->write_pos + agg_buf_pos + EVACUATION_SIZE;
+  if (evac_range(header->write_pos, std::min(end, lseg_end(lseg_cur)), !header->phase) < 0) {
     goto Lwait;
   }
-  if (end > skip + len) {
-    if (evac_range(start, start + (end - (skip + len)), header->phase) < 0) {
+  if (end > lseg_end(lseg_cur)) {
+    // the start of the volume, or of the log segment to be written next
+    int n         = lseg_table ? lseg_table[lseg_cur].next : 0;
+    int n_phase   = lseg_table ? lseg_table[n].phase : header->phase;
+    off_t n_start = lseg_start(n);
+    if (evac_range(n_start, n_start + (end - lseg_end(lseg_cur)), n_phase) < 0) {
       goto Lwait;
     }
   }
 
   // if agg.head, then we are near the end of the disk, so
   // write down the aggregation in whatever size it is.
-  if (agg_buf_pos < AGG_HIGH_WATER && !agg.head && !sync.head && !dir_sync_waiting) {
+  if (agg_buf_pos < agg_size / 2 && !agg.head && !sync.head && !dir_sync_waiting) {
     goto Lwait;
   }
 
@@ -1103,22 +1199,45 @@ Lagain:
     d->write_serial = header->write_serial;
   }
 
-  // set write limit
-  header->agg_pos = header->write_pos + agg_buf_pos;
+  {
+    AggBuffer *b           = &agg_buffers[agg_fill];
+    b->offset              = header->write_pos;
+    b->len                 = agg_buf_pos;
+    b->write_serial        = header->write_serial;
+    b->io.aiocb.aio_fildes = fd;
+    b->io.aiocb.aio_offset = b->offset;
+    b->io.aiocb.aio_buf    = b->buf;
+    b->io.aiocb.aio_nbytes = b->len;
+    b->io.action           = b;
+    /*
+      Callback on AIO thread so that we can issue a new write ASAP
+      as all writes are serialized in the volume.  This is not necessary
+      for reads proceed independently.
+     */
+    b->io.thread = AIO_CALLBACK_THREAD_AIO;
 
-  io.aiocb.aio_fildes = fd;
-  io.aiocb.aio_offset = header->write_pos;
-  io.aiocb.aio_buf    = agg_buffer;
-  io.aiocb.aio_nbytes = agg_buf_pos;
-  io.action           = this;
-  /*
-    Callback on AIO thread so that we can issue a new write ASAP
-    as all writes are serialized in the volume.  This is not necessary
-    for reads proceed independently.
-   */
-  io.thread = AIO_CALLBACK_THREAD_AIO;
-  SET_HANDLER(&Vol::aggWriteDone);
-  ink_aio_write(&io);
+    // The header moves past the write now, readers find its data in b until it is retired.
+    header->last_write_pos = header->write_pos;
+    header->write_pos += agg_buf_pos;
+    header->agg_pos = header->write_pos;
+    header->write_serial++;
+    ink_assert(header->write_pos >= start);
+    DDebug("cache_agg", "Dir %s, Write: %" PRIu64 ", last Write: %" PRIu64 "", hash_text.get(), header->write_pos,
+           header->last_write_pos);
+    agg_writes++;
+    agg_fill    = (agg_fill + 1) % agg_buffer_count;
+    agg_buffer  = agg_buffers[agg_fill].buf;
+    agg_buf_pos = 0;
+    disk->load.write_start();
+    ink_aio_write(&b->io);
+  }
+  if (header->write_pos + EVACUATION_SIZE > scan_pos) {
+    periodic_scan();
+  }
+  // fill the next buffer while this one is written
+  if (agg.head && !is_io_in_progress()) {
+    goto Lagain;
+  }
 
 Lwait:
   int ret = EVENT_CONT;
@@ -1224,6 +1343,7 @@ CacheVC::openWriteCloseHeadDone(int event, Event *e)
         }
       }
       od->first_dir = dir;
+      tier_invalidate(&first_key, vol);
       if (frag_type == CACHE_FRAG_TYPE_HTTP && f.single_fragment) {
         // fragment is tied to the vector
         od->move_resident_alt = true;
@@ -1296,6 +1416,9 @@ CacheVC::openWriteCloseDataDone(int event, Event *e)
     fragment++;
     write_pos += write_len;
     dir_insert(&key, vol, &dir);
+    if (od) {
+      od->signal_readers();
+    }
     blocks = iobufferblock_skip(blocks.get(), &offset, &length, write_len);
     next_CacheKey(&key, &key);
     if (length) {
@@ -1392,6 +1515,9 @@ CacheVC::openWriteWriteDone(int event, Event *e)
     ++fragment;
     write_pos += write_len;
     dir_insert(&key, vol, &dir);
+    if (od) {
+      od->signal_readers();
+    }
     DDebug("cache_insert", "WriteDone: %X, %X, %d", key.slice32(0), first_key.slice32(0), write_len);
     blocks = iobufferblock_skip(blocks.get(), &offset, &length, write_len);
     next_CacheKey(&key, &key);
@@ -1507,6 +1633,7 @@ CacheVC::openWriteOverwrite(int event, Event *e)
     }
     doc = reinterpret_cast<Doc *>(buf->data());
     if (!(doc->first_key == first_key)) {
+      CACHE_INCREMENT_DYN_STAT(cache_directory_collision_read_stat);
       goto Lcollision;
     }
     od->first_dir = dir;
@@ -1575,6 +1702,7 @@ CacheVC::openWriteStartDone(int event, Event *e)
         goto Lcollision;
       }
       if (!(doc->first_key == first_key)) {
+        CACHE_INCREMENT_DYN_STAT(cache_directory_collision_read_stat);
         goto Lcollision;
       }
 
@@ -1583,6 +1711,7 @@ CacheVC::openWriteStartDone(int event, Event *e)
         goto Lfailure;
       }
       ink_assert(write_vector->count() > 0);
+      write_vector->expand();
       od->first_dir = dir;
       first_dir     = dir;
       if (doc->single_fragment()) {
@@ -1599,7 +1728,8 @@ CacheVC::openWriteStartDone(int event, Event *e)
   Lcollision:
     int if_writers = ((uintptr_t)info == CACHE_ALLOW_MULTIPLE_WRITES);
     if (!od) {
-      if ((err = vol->open_write(this, if_writers, cache_config_http_max_alts > 1 ? cache_config_http_max_alts : 0)) > 0) {
+      if ((err = vol->admit_write(this)) > 0 ||
+          (err = vol->open_write(this, if_writers, cache_config_http_max_alts > 1 ? cache_config_http_max_alts : 0)) > 0) {
         goto Lfailure;
       }
       if (od->has_multiple_writers()) {
@@ -1684,14 +1814,19 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheFragType frag_ty
 
   ink_assert(caches[frag_type] == this);
 
+  Vol *vol = key_to_vol(key, hostname, host_len);
+  if (vol_not_ready(vol)) {
+    cont->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
+
   intptr_t res      = 0;
   CacheVC *c        = new_CacheVC(cont);
   ProxyMutex *mutex = cont->mutex.get();
   SCOPED_MUTEX_LOCK(lock, c->mutex, this_ethread());
   c->vio.op    = VIO::WRITE;
   c->base_stat = cache_write_active_stat;
-  c->vol       = key_to_vol(key, hostname, host_len);
-  Vol *vol     = c->vol;
+  c->vol       = vol;
   CACHE_INCREMENT_DYN_STAT(c->base_stat + CACHE_STAT_ACTIVE);
   c->first_key = c->key = *key;
   c->frag_type          = frag_type;
@@ -1720,6 +1855,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheFragType frag_ty
     return ACTION_RESULT_DONE;
   }
   if (res < 0) {
+    CACHE_INCREMENT_DYN_STAT(cache_vol_lock_contention_stat);
     SET_CONTINUATION_HANDLER(c, &CacheVC::openWriteStartBegin);
     c->trigger = CONT_SCHED_LOCK_RETRY(c);
     return &c->_action;
@@ -1749,6 +1885,12 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
   }
 
   ink_assert(caches[type] == this);
+  Vol *vol = key_to_vol(key, hostname, host_len);
+  if (vol_not_ready(vol)) {
+    cont->handleEvent(CACHE_EVENT_OPEN_WRITE_FAILED, (void *)-ECACHE_NOT_READY);
+    return ACTION_RESULT_DONE;
+  }
+
   intptr_t err      = 0;
   int if_writers    = (uintptr_t)info == CACHE_ALLOW_MULTIPLE_WRITES;
   CacheVC *c        = new_CacheVC(cont);
@@ -1767,8 +1909,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
   } while (DIR_MASK_TAG(c->key.slice32(2)) == DIR_MASK_TAG(c->first_key.slice32(2)));
   c->earliest_key = c->key;
   c->frag_type    = CACHE_FRAG_TYPE_HTTP;
-  c->vol          = key_to_vol(key, hostname, host_len);
-  Vol *vol        = c->vol;
+  c->vol          = vol;
   c->info         = info;
   if (c->info && (uintptr_t)info != CACHE_ALLOW_MULTIPLE_WRITES) {
     /*
@@ -1815,7 +1956,8 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
   {
     CACHE_TRY_LOCK(lock, c->vol->mutex, cont->mutex->thread_holding);
     if (lock.is_locked()) {
-      if ((err = c->vol->open_write(c, if_writers, cache_config_http_max_alts > 1 ? cache_config_http_max_alts : 0)) > 0) {
+      if ((err = c->vol->admit_write(c)) > 0 ||
+          (err = c->vol->open_write(c, if_writers, cache_config_http_max_alts > 1 ? cache_config_http_max_alts : 0)) > 0) {
         goto Lfailure;
       }
       // If there are multiple writers, then this one cannot be an update.
@@ -1848,6 +1990,7 @@ Cache::open_write(Continuation *cont, const CacheKey *key, CacheHTTPInfo *info,
       }
     }
     // missed lock
+    CACHE_INCREMENT_DYN_STAT(cache_vol_lock_contention_stat);
     SET_CONTINUATION_HANDLER(c, &CacheVC::openWriteStartDone);
     CONT_SCHED_LOCK_RETRY(c);
     return &c->_action;
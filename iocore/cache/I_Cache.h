@@ -40,16 +40,29 @@ static constexpr ts::ModuleVersion CACHE_MODULE_VERSION(1, 0);
 
 #define RAM_CACHE_ALGORITHM_CLFUS 0
 #define RAM_CACHE_ALGORITHM_LRU 1
+#define RAM_CACHE_ALGORITHM_TINYLFU 2
 
 #define CACHE_COMPRESSION_NONE 0
 #define CACHE_COMPRESSION_FASTLZ 1
 #define CACHE_COMPRESSION_LIBZ 2
 #define CACHE_COMPRESSION_LIBLZMA 3
-
-enum { RAM_HIT_COMPRESS_NONE = 1, RAM_HIT_COMPRESS_FASTLZ, RAM_HIT_COMPRESS_LIBZ, RAM_HIT_COMPRESS_LIBLZMA, RAM_HIT_LAST_ENTRY };
+#define CACHE_COMPRESSION_ZSTD 4
+#define CACHE_COMPRESSION_LZ4 5
+#define CACHE_COMPRESSION_TYPES 5 // not counting CACHE_COMPRESSION_NONE
+
+enum {
+  RAM_HIT_COMPRESS_NONE = 1,
+  RAM_HIT_COMPRESS_FASTLZ,
+  RAM_HIT_COMPRESS_LIBZ,
+  RAM_HIT_COMPRESS_LIBLZMA,
+  RAM_HIT_COMPRESS_ZSTD,
+  RAM_HIT_COMPRESS_LZ4,
+  RAM_HIT_LAST_ENTRY
+};
 
 struct CacheVC;
 struct CacheDisk;
+struct Vol;
 struct OverridableHttpConfigParams;
 class URL;
 class HTTPHdr;
@@ -59,6 +72,15 @@ typedef HTTPHdr CacheHTTPHdr;
 typedef URL CacheURL;
 typedef HTTPInfo CacheHTTPInfo;
 
+/// One key of CacheProcessor::open_read_batch().
+struct CacheReadRequest {
+  Continuation *cont   = nullptr; ///< Called back for this key, as by open_read().
+  const CacheKey *key  = nullptr;
+  const char *hostname = nullptr;
+  int host_len         = 0;
+  Action *action       = nullptr; ///< Set to what open_read() would have returned.
+};
+
 struct CacheProcessor : public Processor {
   CacheProcessor()
     : min_stripe_version(CACHE_DB_MAJOR_VERSION, CACHE_DB_MINOR_VERSION),
@@ -78,6 +100,12 @@ struct CacheProcessor : public Processor {
                  const char *hostname = nullptr, int host_len = 0);
   Action *open_read(Continuation *cont, const CacheKey *key, CacheFragType frag_type = CACHE_FRAG_TYPE_NONE,
                     const char *hostname = nullptr, int host_len = 0);
+  /** Open @a n keys for reading at once.
+      The keys are grouped by stripe and probed with a single lock of each, and the disk
+      reads of those found are queued together. Every continuation is called back as by
+      open_read() and must share the same mutex, held by the caller.
+  */
+  void open_read_batch(CacheReadRequest *reqs, int n, CacheFragType frag_type = CACHE_FRAG_TYPE_NONE);
   Action *open_write(Continuation *cont, CacheKey *key, CacheFragType frag_type = CACHE_FRAG_TYPE_NONE,
                      int expected_size = CACHE_EXPECTED_SIZE, int options = 0, time_t pin_in_cache = (time_t)0,
                      char *hostname = nullptr, int host_len = 0);
@@ -139,6 +167,8 @@ struct CacheProcessor : public Processor {
 
   void cacheInitialized();
 
+  void vol_online(Vol *vol);
+
   int
   waitForCache() const
   {
@@ -159,6 +189,7 @@ struct CacheProcessor : public Processor {
 
   CALLBACK_FUNC cb_after_init = nullptr;
   int wait_for_cache          = 0;
+  ink_hrtime start_time       = 0; ///< When start_internal() began, for the startup timing stats.
 };
 
 inline void
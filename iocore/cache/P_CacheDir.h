@@ -25,6 +25,10 @@
 
 #include "P_CacheHttp.h"
 
+#include <atomic>
+#include <utility>
+#include <vector>
+
 struct Vol;
 struct InterimCacheVol;
 struct CacheVC;
@@ -37,6 +41,9 @@ struct CacheVC;
 
 #define DIR_TAG_WIDTH 12
 #define DIR_MASK_TAG(_t) ((_t) & ((1 << DIR_TAG_WIDTH) - 1))
+// Upper tag bits kept in Vol::tag_ext for volumes with wide tags. Taken from a different
+// slice than the base tag since the bits of slice32(2) above the tag select the volume.
+#define DIR_TAG_EXT(_k) ((uint16_t)((_k)->slice32(3) >> 16))
 #define SIZEOF_DIR 10
 #define ESTIMATED_OBJECT_SIZE 8000
 
@@ -52,6 +59,10 @@ struct CacheVC;
 #define DIR_OFFSET_BITS 40
 #define DIR_OFFSET_MAX ((((off_t)1) << DIR_OFFSET_BITS) - 1)
 
+#define DIR_SEQLOCK_RETRIES 4 // unlocked probes give up and take the Vol lock after this many torn reads
+
+#define DIR_SEG_DIRTY_ALL 0x3 // Vol::dir_seg_dirty, one bit per on disk directory copy
+
 #define SYNC_MAX_WRITE (2 * 1024 * 1024)
 #define SYNC_DELAY HRTIME_MSECONDS(500)
 #define DO_NOT_REMOVE_THIS 0
@@ -61,6 +72,20 @@ struct CacheVC;
 //#define DO_CHECK_DIR_FAST
 //#define DO_CHECK_DIR
 
+// Probe Options
+
+// Resolve misses in buckets whose chain never leaves the bucket with a single
+// SSSE3 gather/compare of the bucket's tags instead of walking the chain. Build
+// with -mssse3 (or a -march which implies it) to enable, or define
+// DIR_PROBE_SIMD to 0 to force the scalar walk.
+#ifndef DIR_PROBE_SIMD
+#if defined(__SSSE3__) && DIR_DEPTH == 4
+#define DIR_PROBE_SIMD 1
+#else
+#define DIR_PROBE_SIMD 0
+#endif
+#endif
+
 // Macros
 
 #ifdef DO_CHECK_DIR
@@ -85,9 +110,13 @@ struct CacheVC;
     dir_set_next(_e, next);             \
   } while (0)
 // entry is valid
-#define dir_valid(_d, _e) (_d->header->phase == dir_phase(_e) ? _d->vol_in_phase_valid(_e) : _d->vol_out_of_phase_valid(_e))
+#define dir_valid(_d, _e)                                           \
+  (_d->lseg_table                     ? _d->lseg_valid(_e, false) : \
+   _d->header->phase == dir_phase(_e) ? _d->vol_in_phase_valid(_e) : _d->vol_out_of_phase_valid(_e))
 // entry is valid and outside of write aggregation region
-#define dir_agg_valid(_d, _e) (_d->header->phase == dir_phase(_e) ? _d->vol_in_phase_valid(_e) : _d->vol_out_of_phase_agg_valid(_e))
+#define dir_agg_valid(_d, _e)                                      \
+  (_d->lseg_table                     ? _d->lseg_valid(_e, true) : \
+   _d->header->phase == dir_phase(_e) ? _d->vol_in_phase_valid(_e) : _d->vol_out_of_phase_agg_valid(_e))
 // entry may be valid or overwritten in the last aggregated write
 #define dir_write_valid(_d, _e) \
   (_d->header->phase == dir_phase(_e) ? vol_in_phase_valid(_d, _e) : vol_out_of_phase_write_valid(_d, _e))
@@ -218,7 +247,7 @@ struct FreeDir {
 LINK_FORWARD_DECLARATION(CacheVC, opendir_link) // forward declaration
 struct OpenDirEntry {
   DLL<CacheVC, Link_CacheVC_opendir_link> writers; // list of all the current writers
-  DLL<CacheVC, Link_CacheVC_opendir_link> readers; // list of all the current readers - not used
+  DLL<CacheVC, Link_CacheVC_opendir_link> readers; // readers waiting for the writers to make progress
   CacheHTTPInfoVector vector;                      // Vector for the http document. Each writer
                                                    // maintains a pointer to this vector and
                                                    // writes it down to disk.
@@ -235,7 +264,8 @@ struct OpenDirEntry {
 
   LINK(OpenDirEntry, link);
 
-  int wait(CacheVC *c, int msec);
+  int wait(CacheVC *c, ink_hrtime delay);
+  void signal_readers();
 
   bool
   has_multiple_writers()
@@ -244,16 +274,56 @@ struct OpenDirEntry {
   }
 };
 
-struct OpenDir : public Continuation {
-  Queue<CacheVC, Link_CacheVC_opendir_link> delayed_readers;
+struct OpenDir {
   DLL<OpenDirEntry> bucket[OPEN_DIR_BUCKETS];
+  // Number of entries in each bucket, readable without the Vol lock.
+  std::atomic<int> bucket_entries[OPEN_DIR_BUCKETS] = {};
 
   int open_write(CacheVC *c, int allow_if_writers, int max_writers);
   int close_write(CacheVC *c);
   OpenDirEntry *open_read(const CryptoHash *key);
-  int signal_readers(int event, Event *e);
 
-  OpenDir();
+  /// False if there is certainly no writer open for @a key. Safe to call without the Vol lock.
+  bool
+  maybe_open(const CryptoHash *key) const
+  {
+    return bucket_entries[key->slice32(0) % OPEN_DIR_BUCKETS].load(std::memory_order_acquire) != 0;
+  }
+};
+
+/*
+  Counting Bloom filter over the directory of a Vol, to answer certain misses
+  without the Vol lock or a walk of the bucket chain. Its elements are the
+  (bucket, tag) pairs dir_probe() matches on, so every change to a chain can
+  be mirrored from the entry alone. Each segment owns a range of 64 bit words
+  of 4 bit counters and an element maps to DIR_FILTER_HASHES counters of one
+  word, so a lookup reads a single word. A counter that reaches 15 stays
+  there. Only the Vol lock holder updates the filter, lookups take no lock.
+*/
+#define DIR_FILTER_HASHES 3
+#define DIR_FILTER_COUNTER_MAX 15
+
+struct DirFilter {
+  DirFilter(int segments, int64_t buckets, int counters_per_entry);
+  ~DirFilter();
+
+  void add(int s, int64_t b, uint32_t tag, uint16_t tag_ext);
+  void remove(int s, int64_t b, uint32_t tag, uint16_t tag_ext);
+  bool maybe_contains(int s, int64_t b, uint32_t tag, uint16_t tag_ext) const;
+  void clear_segment(int s);
+  size_t
+  size() const
+  {
+    return segments * seg_words * sizeof(uint64_t);
+  }
+
+  std::atomic<uint64_t> *words = nullptr;
+  int64_t seg_words            = 0; // words per segment
+  int segments                 = 0;
+
+private:
+  std::atomic<uint64_t> &word(int s, int64_t b, uint32_t tag, uint16_t tag_ext, uint64_t *h) const;
+  void update(int s, int64_t b, uint32_t tag, uint16_t tag_ext, bool inc);
 };
 
 struct CacheSync : public Continuation {
@@ -265,8 +335,14 @@ struct CacheSync : public Continuation {
   AIOCallbackInternal io;
   Event *trigger        = nullptr;
   ink_hrtime start_time = 0;
+  // Byte ranges of the directory written between the header and the footer, and the segments they cover.
+  std::vector<std::pair<off_t, off_t>> ranges;
+  size_t range_idx = 0;
+  std::vector<int> segments;
+  int64_t sync_bytes = 0;
   int mainEvent(int event, Event *e);
   void aio_write(int fd, char *b, int n, off_t o);
+  void plan(Vol *vol, int copy);
 
   CacheSync() : Continuation(new_ProxyMutex()) { SET_HANDLER(&CacheSync::mainEvent); }
 };
@@ -276,6 +352,8 @@ struct CacheSync : public Continuation {
 void vol_init_dir(Vol *d);
 int dir_token_probe(const CacheKey *, Vol *, Dir *);
 int dir_probe(const CacheKey *, Vol *, Dir *, Dir **);
+int dir_probe_unlocked(const CacheKey *, Vol *);
+void dir_filter_build(Vol *d);
 int dir_insert(const CacheKey *key, Vol *d, Dir *to_part);
 int dir_overwrite(const CacheKey *key, Vol *d, Dir *to_part, Dir *overwrite, bool must_overwrite = true);
 int dir_delete(const CacheKey *key, Vol *d, Dir *del);
@@ -25,6 +25,8 @@
 
 #include "I_Cache.h"
 
+#include <atomic>
+
 extern int cache_config_max_disk_errors;
 
 #define DISK_BAD(_x) ((_x)->num_errors >= cache_config_max_disk_errors)
@@ -78,6 +80,53 @@ struct DiskHeader {
   DiskVolBlock vol_info[1];
 };
 
+#define DISK_LOAD_BUCKETS 96 // 4 per power of two of microseconds, up to about 30s
+
+/*
+  Load of a cache disk as seen by the cache: the document reads and the
+  aggregation writes in flight, and a histogram of read latencies which is
+  turned into a p99 once every proxy.config.cache.write_throttle.interval.
+  The disk is overloaded while that p99 is above the read_p99 target, or
+  while more AIO requests than queue_depth are in flight; stripes on it then
+  shed low value writes. Updated from any thread without a lock.
+*/
+struct CacheDiskLoad {
+  std::atomic<int> reads{0};
+  std::atomic<int> writes{0};
+  std::atomic<ink_hrtime> window_start{0};
+  std::atomic<ink_hrtime> read_p99{0}; // of the last complete window
+  std::atomic<bool> slow{false};       // read_p99 above the target
+  std::atomic<uint32_t> read_hist[DISK_LOAD_BUCKETS] = {};
+
+  void
+  read_start()
+  {
+    reads.fetch_add(1, std::memory_order_relaxed);
+  }
+  void
+  read_done(ink_hrtime latency)
+  {
+    reads.fetch_sub(1, std::memory_order_relaxed);
+    read_hist[bucket(latency)].fetch_add(1, std::memory_order_relaxed);
+  }
+  void
+  write_start()
+  {
+    writes.fetch_add(1, std::memory_order_relaxed);
+  }
+  void
+  write_done()
+  {
+    writes.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  bool roll(ink_hrtime now);
+  bool overloaded() const;
+
+  static int bucket(ink_hrtime latency);
+  static ink_hrtime bucket_limit(int b);
+};
+
 struct CacheDisk : public Continuation {
   DiskHeader *header = nullptr;
   char *path         = nullptr;
@@ -89,6 +138,7 @@ struct CacheDisk : public Continuation {
   off_t num_usable_blocks = 0;
   int hw_sector_size      = 0;
   int fd                  = -1;
+  int file_fd             = -1; // buffered and read only, for data sent to clients straight from the span
   off_t free_space        = 0;
   off_t wasted_space      = 0;
   DiskVol **disk_vols     = nullptr;
@@ -97,6 +147,7 @@ struct CacheDisk : public Continuation {
   int cleared             = 0;
   bool read_only_p        = false;
   bool online             = true; /* flag marking cache disk online or offline (because of too many failures or by the operator). */
+  CacheDiskLoad load;
 
   // Extra configuration values
   int forced_volume_num = -1;      ///< Volume number for this disk.
@@ -120,4 +171,5 @@ struct CacheDisk : public Continuation {
   void update_header();
   DiskVol *get_diskvol(int vol_number);
   void incrErrors(const AIOCallback *io);
+  bool overloaded();
 };
@@ -35,7 +35,7 @@ struct CacheHostResult;
 struct Cache;
 
 struct CacheHostRecord {
-  int Init(CacheType typ);
+  int Init(CacheType typ, bool fast_tier = false);
   int Init(matcher_line *line_info, CacheType typ);
 
   void UpdateMatch(CacheHostResult *r, char *rd);
@@ -61,6 +61,7 @@ struct CacheHostRecord {
 };
 
 void build_vol_hash_table(CacheHostRecord *cp);
+bool cache_vols_tiered(CacheType type);
 
 struct CacheHostResult {
   CacheHostRecord *record = nullptr;
@@ -142,6 +143,7 @@ public:
   Cache *cache     = nullptr;
   int m_numEntries = 0;
   CacheHostRecord gen_host_rec;
+  CacheHostRecord tier_host_rec; ///< The tier=fast volumes, only set up when there are slow volumes too.
 
 private:
   CacheHostMatcher *hostMatch    = nullptr;
@@ -177,6 +179,11 @@ struct ConfigVol {
   off_t size;
   bool in_percent;
   bool ramcache_enabled;
+  bool wide_tags;
+  bool fast_tier;
+  bool segmented;
+  int agg_buffers;
+  int agg_size;
   int percent;
   CacheVol *cachep;
   LINK(ConfigVol, link);
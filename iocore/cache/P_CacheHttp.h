@@ -42,6 +42,29 @@ struct vec_info {
   CacheHTTPInfo alternate;
 };
 
+#define CACHE_ALT_VECTOR_MAGIC 0xa17ec7a1
+
+/*
+   Header of a compact alternate vector. It is followed by an alternate
+   holding only the response fields shared by every alternate, then by the
+   alternates themselves, marshalled as usual but with those fields removed
+   from the response and with only the Vary relevant fields in the request.
+   */
+struct CacheAltVectorHeader {
+  uint32_t magic;
+  uint32_t count;
+
+  /// Length of the compact header at @a buf, 0 if the vector is not compact.
+  static int
+  length(const char *buf, int len)
+  {
+    const CacheAltVectorHeader *h = reinterpret_cast<const CacheAltVectorHeader *>(buf);
+    return len >= static_cast<int>(sizeof(CacheAltVectorHeader)) && h->magic == CACHE_ALT_VECTOR_MAGIC ?
+             sizeof(CacheAltVectorHeader) :
+             0;
+  }
+};
+
 struct CacheHTTPInfoVector {
   void *magic = nullptr;
 
@@ -63,6 +86,7 @@ struct CacheHTTPInfoVector {
   {
     xcount = 0;
     data.clear();
+    shared.clear();
   }
   void print(char *buffer, size_t buf_size, bool temps = true);
 
@@ -71,9 +95,24 @@ struct CacheHTTPInfoVector {
   uint32_t get_handles(const char *buf, int length, RefCountObj *block_ptr = nullptr);
   int unmarshal(const char *buf, int length, RefCountObj *block_ptr);
 
+  /// True if the alternates were loaded from a compact vector and some still lack the shared response fields.
+  bool
+  compact() const
+  {
+    return shared.valid();
+  }
+  void expand(int idx);
+  void expand();
+
+  bool use_compact();
+  void prepare_compact();
+  void release_compact();
+
   CacheArray<vec_info> data;
   int xcount = 0;
   Ptr<RefCountObj> vector_buf;
+  CacheHTTPInfo shared;                                 // response fields common to all alternates of a compact vector
+  struct CacheAltVectorCompact *compact_prep = nullptr; // compact form built by marshal_length() for marshal()
 };
 
 TS_INLINE CacheHTTPInfo *
@@ -41,6 +41,10 @@ struct EvacuationBlock;
 
 #define INTEGRAL_FRAGS 4
 
+// Page sizes for proxy.config.cache.hugepages.
+#define CACHE_HUGEPAGE_2MB (static_cast<size_t>(2) << 20)
+#define CACHE_HUGEPAGE_1GB (static_cast<size_t>(1) << 30)
+
 #ifdef CACHE_INSPECTOR_PAGES
 #ifdef DEBUG
 #define CACHE_STAT_PAGES
@@ -91,8 +95,7 @@ struct EvacuationBlock;
     ink_hrtime _t = HRTIME_MSECONDS(cache_read_while_writer_retry_delay); \
     if (writer_lock_retry > 2)                                            \
       _t = HRTIME_MSECONDS(cache_read_while_writer_retry_delay) * 2;      \
-    trigger = mutex->thread_holding->schedule_in_local(this, _t);         \
-    return EVENT_CONT;                                                    \
+    return writer_wait(_t);                                               \
   } while (0)
 
 // cache stats definitions
@@ -105,7 +108,18 @@ enum {
   cache_direntries_used_stat,
   cache_ram_cache_hits_stat,
   cache_ram_cache_misses_stat,
-  cache_pread_count_stat,
+  cache_ram_cache_admission_rejected_stat,
+  cache_ram_cache_compress_skipped_stat,
+  cache_ram_cache_warm_pending_stat,
+  cache_ram_cache_warm_objects_stat,
+  cache_ram_cache_warm_bytes_stat,
+  cache_ram_cache_warm_misses_stat,
+  // One of each per compression type, indexed by type - 1.
+  cache_ram_cache_compress_in_bytes_stat,
+  cache_ram_cache_compress_out_bytes_stat = cache_ram_cache_compress_in_bytes_stat + CACHE_COMPRESSION_TYPES,
+  cache_ram_cache_compress_time_stat      = cache_ram_cache_compress_out_bytes_stat + CACHE_COMPRESSION_TYPES,
+  cache_ram_cache_decompress_time_stat    = cache_ram_cache_compress_time_stat + CACHE_COMPRESSION_TYPES,
+  cache_pread_count_stat                  = cache_ram_cache_decompress_time_stat + CACHE_COMPRESSION_TYPES,
   cache_percent_full_stat,
   cache_lookup_active_stat,
   cache_lookup_success_stat,
@@ -130,11 +144,26 @@ enum {
   cache_scan_success_stat,
   cache_scan_failure_stat,
   cache_directory_collision_count_stat,
+  cache_directory_collision_read_stat,
+  cache_directory_collision_avoided_stat,
+  cache_directory_seqlock_retry_stat,
+  cache_vol_lock_contention_stat,
+  cache_vol_lock_bypass_stat,
+  cache_vol_lock_batched_stat,
+  cache_dir_filter_lookup_stat,
+  cache_dir_filter_miss_stat,
+  cache_dir_filter_false_positive_stat,
+  cache_write_throttle_once_stat,
+  cache_write_throttle_large_stat,
+  cache_write_throttle_slow_disks_stat,
   cache_single_fragment_document_count_stat,
   cache_two_fragment_document_count_stat,
   cache_three_plus_plus_fragment_document_count_stat,
   cache_read_busy_success_stat,
   cache_read_busy_failure_stat,
+  cache_read_busy_wakeup_stat,
+  cache_read_busy_timeout_stat,
+  cache_read_busy_wait_stat,
   cache_gc_bytes_evacuated_stat,
   cache_gc_frags_evacuated_stat,
   cache_write_bytes_stat,
@@ -145,6 +174,32 @@ enum {
   cache_directory_sync_count_stat,
   cache_directory_sync_time_stat,
   cache_directory_sync_bytes_stat,
+  cache_directory_sync_last_bytes_stat,
+  cache_directory_sync_last_time_stat,
+  cache_directory_sync_segments_stat,
+  /* Startup timing, in milliseconds */
+  cache_init_span_time_stat,
+  cache_init_dir_read_time_stat,
+  cache_init_recover_time_stat,
+  cache_init_ready_time_stat,
+  cache_init_vols_ready_stat,
+  cache_vol_not_ready_stat,
+  /* Tiered storage, reads by the tier that served them and objects moved between tiers */
+  cache_tier_fast_hit_stat,
+  cache_tier_fast_miss_stat,
+  cache_tier_slow_hit_stat,
+  cache_tier_slow_miss_stat,
+  cache_tier_promote_stat,
+  cache_tier_promote_bytes_stat,
+  cache_tier_move_aborted_stat,
+  cache_tier_demote_stat,
+  cache_tier_demote_bytes_stat,
+  cache_tier_invalidate_stat,
+  /* Writers waiting for an aggregation buffer */
+  cache_agg_buffer_wait_stat,
+  cache_agg_buffer_overflow_stat,
+  cache_log_segment_open_stat,
+  cache_log_segment_live_stat,
   /* AIO read/write error counters */
   cache_span_errors_read_stat,
   cache_span_errors_write_stat,
@@ -162,8 +217,11 @@ extern RecRawStatBlock *cache_rsb;
 
 #define GLOBAL_CACHE_SET_DYN_STAT(x, y) RecSetGlobalRawStatSum(cache_rsb, (x), (y))
 
-#define CACHE_SET_DYN_STAT(x, y) \
-  RecSetGlobalRawStatSum(cache_rsb, (x), (y)) RecSetGlobalRawStatSum(vol->cache_vol->vol_rsb, (x), (y))
+#define CACHE_SET_DYN_STAT(x, y)                               \
+  do {                                                         \
+    RecSetGlobalRawStatSum(cache_rsb, (x), (y));               \
+    RecSetGlobalRawStatSum(vol->cache_vol->vol_rsb, (x), (y)); \
+  } while (0);
 
 #define CACHE_INCREMENT_DYN_STAT(x)                                              \
   do {                                                                           \
@@ -206,20 +264,42 @@ extern RecRawStatBlock *cache_rsb;
 
 // Configuration
 extern int cache_config_dir_sync_frequency;
+extern int cache_config_dir_sync_incremental;
+extern int cache_config_init_serve_partial;
+extern int cache_config_hugepages;
+extern int cache_config_dir_filter;
+extern int cache_config_dir_filter_counters;
+extern int cache_config_tier_promote_hits;
+extern int cache_config_tier_demote;
 extern int cache_config_http_max_alts;
 extern int cache_config_log_alternate_eviction;
 extern int cache_config_permit_pinning;
 extern int cache_config_select_alternate;
+extern int cache_config_alt_vector_compact;
 extern int cache_config_max_doc_size;
 extern int cache_config_min_average_object_size;
 extern int cache_config_agg_write_backlog;
+extern int cache_config_write_throttle;
+extern int cache_config_write_throttle_read_p99;
+extern int cache_config_write_throttle_queue_depth;
+extern int64_t cache_config_write_throttle_max_size;
+extern int cache_config_write_throttle_interval;
+extern int cache_config_agg_buffers;
+extern int cache_config_agg_size;
+extern int64_t cache_config_log_segment_size;
+extern int64_t cache_config_zero_copy_min_size;
 extern int cache_config_enable_checksum;
 extern int cache_config_alt_rewrite_max_size;
 extern int cache_config_read_while_writer;
 extern int cache_config_agg_write_backlog;
 extern int cache_config_ram_cache_compress;
 extern int cache_config_ram_cache_compress_percent;
+extern int cache_config_ram_cache_compress_adaptive;
+extern int cache_config_ram_cache_compress_dict_size;
 extern int cache_config_ram_cache_use_seen_filter;
+extern int cache_config_ram_cache_snapshot;
+extern int cache_config_ram_cache_snapshot_interval;
+extern int64_t cache_config_ram_cache_warm_rate;
 extern int cache_config_hit_evacuate_percent;
 extern int cache_config_hit_evacuate_size_limit;
 extern int cache_config_force_sector_size;
@@ -312,6 +392,9 @@ struct CacheVC : public CacheVConnection {
   }
 
   bool writer_done();
+  int writer_wait(ink_hrtime delay);
+  void writer_wait_done();
+  bool zero_copy();
   int calluser(int event);
   int callcont(int event);
   int die();
@@ -384,6 +467,10 @@ struct CacheVC : public CacheVConnection {
   int evacuateDocDone(int event, Event *e);
   int evacuateReadHead(int event, Event *e);
 
+  int tierMoveStart(int event, Event *e);
+  int tierMoveDone(int event, Event *e);
+  int tierInvalidate(int event, Event *e);
+
   void cancel_trigger();
   int64_t get_object_size() override;
   void set_http_info(CacheHTTPInfo *info) override;
@@ -460,12 +547,16 @@ struct CacheVC : public CacheVConnection {
   uint32_t agg_len;      // for communicating with aggWrite
   uint32_t write_serial; // serial of the final write for SYNC
   Vol *vol;
+  Vol *tier_home; // slow tier stripe behind a fast tier read or promotion
   Dir *last_collision;
   Event *trigger;
   CacheKey *read_key;
   ContinuationHandler save_handler;
   uint32_t pin_in_cache;
   ink_hrtime start_time;
+  ink_hrtime agg_wait_start; // when the write was queued for an aggregation buffer
+  ink_hrtime wait_start;     // when the reader started waiting for a writer
+  ink_hrtime read_issued;    // when the document read went to the disk, for its load
   int base_stat;
   int recursive;
   int closed;
@@ -481,6 +572,8 @@ struct CacheVC : public CacheVConnection {
   int fragment;
   int scan_msec_delay;
   CacheVC *write_vc;
+  OpenDirEntry *wait_od; // writer entry this reader is parked on, protected by the Vol lock
+  bool wait_woken;       // a writer rescheduled this parked reader, protected by the Vol lock
   char *hostname;
   int host_len;
   int header_to_write_len;
@@ -500,7 +593,7 @@ struct CacheVC : public CacheVConnection {
       unsigned int update : 1;
       unsigned int remove : 1;
       unsigned int remove_aborted_writers : 1;
-      unsigned int open_read_timeout : 1; // UNUSED
+      unsigned int wait_for_writer : 1; // parked on OpenDirEntry::readers
       unsigned int data_done : 1;
       unsigned int read_from_writer_called : 1;
       unsigned int not_from_ram_cache : 1; // entire object was from ram cache
@@ -510,6 +603,7 @@ struct CacheVC : public CacheVConnection {
       unsigned int hit_evacuate : 1;
       unsigned int compressed_in_ram : 1; // compressed state in ram cache
       unsigned int allow_empty_doc : 1;   // used for cache empty http document
+      unsigned int header_only : 1;       // only the Doc header of the fragment is read, the data is sent from disk
     } f;
   };
   // BTF optimization used to skip reading stuff in cache partition that doesn't contain any
@@ -548,9 +642,35 @@ extern CacheSync *cacheDirSync;
 int cache_write(CacheVC *, CacheHTTPInfoVector *);
 int get_alternate_index(CacheHTTPInfoVector *cache_vector, CacheKey key);
 CacheVC *new_DocEvacuator(int nbytes, Vol *d);
+void unmarshal_helper(Doc *doc, Ptr<IOBufferData> &buf, int &okay);
+bool ram_cache_compressible(Doc *doc, HTTPHdr *response);
+// Tiered storage, see CacheTier.cc
+Vol *tier_read_vol(const CacheKey *key, Vol *home);
+void tier_read_done(CacheVC *vc, Doc *doc);
+void tier_read_miss(Vol *vol);
+void tier_demote(Vol *vol, CacheVC *evacuator, Dir *dir);
+void tier_invalidate(const CacheKey *key, Vol *home);
+// RAM cache snapshots, see RamCacheSnapshot.cc
+void ram_cache_snapshot_init();
+void ram_cache_snapshot_on_shutdown();
+void ram_cache_warm(Vol *vol);
+bool ram_cache_snapshot_read(const std::string &path, std::vector<RamCacheSnapshotVol> &vols);
+bool ram_cache_snapshot_save(const std::string &path, const std::vector<RamCacheSnapshotVol> &vols);
 
 // inline Functions
 
+// With proxy.config.cache.init.serve_partial the cache opens before every stripe
+// has loaded its directory, requests for the others fail as if the cache were not ready.
+TS_INLINE bool
+vol_not_ready(Vol *vol)
+{
+  if (likely(vol->ready)) {
+    return false;
+  }
+  CACHE_SUM_DYN_STAT_THREAD(cache_vol_not_ready_stat, 1);
+  return true;
+}
+
 TS_INLINE CacheVC *
 new_CacheVC(Continuation *cont)
 {
@@ -589,6 +709,7 @@ free_CacheVC(CacheVC *cont)
   }
   ink_assert(!cont->is_io_in_progress());
   ink_assert(!cont->od);
+  ink_assert(!cont->f.wait_for_writer);
   /* calling cont->io.action = nullptr causes compile problem on 2.6 solaris
      release build....weird??? For now, null out continuation and mutex
      of the action separately */
@@ -744,6 +865,14 @@ CacheVC::do_write_lock_call()
   return handleWriteLock(EVENT_CALL, nullptr);
 }
 
+// Whether the data of the document may go to the client without being copied, see MIOBuffer::file_blocks.
+TS_INLINE bool
+CacheVC::zero_copy()
+{
+  return cache_config_zero_copy_min_size > 0 && static_cast<int64_t>(doc_len) >= cache_config_zero_copy_min_size &&
+         vio.buffer.writer() && vio.buffer.writer()->file_blocks;
+}
+
 TS_INLINE bool
 CacheVC::writer_done()
 {
@@ -765,6 +894,46 @@ CacheVC::writer_done()
   return false;
 }
 
+// Wait for the writer of first_key to make progress, or for @a delay to pass.
+TS_INLINE int
+CacheVC::writer_wait(ink_hrtime delay)
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  OpenDirEntry *cod = vol->open_read(&first_key);
+  if (cod) {
+    return cod->wait(this, delay);
+  }
+  trigger = mutex->thread_holding->schedule_in_local(this, delay);
+  return EVENT_CONT;
+}
+
+// Must be called with the Vol lock held before a parked reader goes on or goes away.
+TS_INLINE void
+CacheVC::writer_wait_done()
+{
+  ink_assert(vol->mutex->thread_holding == this_ethread());
+  if (!f.wait_for_writer) {
+    return;
+  }
+  if (wait_od) {
+    wait_od->readers.remove(this);
+    wait_od = nullptr;
+  }
+  if (wait_woken) {
+    // Progress wakeups do not use up a retry.
+    if (writer_lock_retry > 0) {
+      writer_lock_retry--;
+    }
+    CACHE_INCREMENT_DYN_STAT(cache_read_busy_wakeup_stat);
+  } else {
+    // Including readers a writer could not reschedule, which wait for their timer.
+    CACHE_INCREMENT_DYN_STAT(cache_read_busy_timeout_stat);
+  }
+  f.wait_for_writer = 0;
+  wait_woken        = false;
+  CACHE_SUM_DYN_STAT(cache_read_busy_wait_stat, ink_hrtime_to_usec(Thread::get_hrtime() - wait_start));
+}
+
 TS_INLINE int
 Vol::close_write(CacheVC *cont)
 {
@@ -822,7 +991,8 @@ Vol::open_write_lock(CacheVC *cont, int allow_if_writers, int max_writers)
   if (!lock.is_locked()) {
     return -1;
   }
-  return open_write(cont, allow_if_writers, max_writers);
+  int err = admit_write(cont);
+  return err ? err : open_write(cont, allow_if_writers, max_writers);
 }
 
 TS_INLINE OpenDirEntry *
@@ -987,6 +1157,7 @@ struct Cache {
   int64_t cache_size        = 0; // in store block size
   CacheHostTable *hosttable = nullptr;
   int total_initialized_vol = 0;
+  int open_started          = 0; // open_done() has been called, possibly before every stripe is ready
   CacheType scheme          = CACHE_NONE_TYPE;
 
   int open(bool reconfigure, bool fix);
@@ -994,6 +1165,7 @@ struct Cache {
 
   Action *lookup(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int host_len);
   Action *open_read(Continuation *cont, const CacheKey *key, CacheFragType type, const char *hostname, int len);
+  void open_read_batch(CacheReadRequest *reqs, int n, CacheFragType type);
   Action *open_write(Continuation *cont, const CacheKey *key, CacheFragType frag_type, int options = 0,
                      time_t pin_in_cache = (time_t)0, const char *hostname = nullptr, int host_len = 0);
   Action *remove(Continuation *cont, const CacheKey *key, CacheFragType type = CACHE_FRAG_TYPE_HTTP, const char *hostname = nullptr,
@@ -1017,6 +1189,7 @@ struct Cache {
   int open_done();
 
   Vol *key_to_vol(const CacheKey *key, const char *hostname, int host_len);
+  Vol *key_to_tier_vol(const CacheKey *key); ///< Fast tier stripe for @a key, @c nullptr if there is no fast tier.
 
   Cache() {}
 };
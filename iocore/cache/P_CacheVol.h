@@ -34,11 +34,17 @@
 
 // Vol (volumes)
 #define VOL_MAGIC 0xF1D0F00D
+#define VOL_FLAG_WIDE_TAGS 0x1 // directory carries a tag extension array (volume.config wide_tags=true)
+#define VOL_FLAG_SEGMENTED 0x2 // data is written in log segments, directory carries their table (volume.config layout=segmented)
 #define START_BLOCKS 16 // 8k, STORE_BLOCK_SIZE
 #define START_POS ((off_t)START_BLOCKS * CACHE_BLOCK_SIZE)
 #define AGG_SIZE (4 * 1024 * 1024)     // 4MB
 #define AGG_HIGH_WATER (AGG_SIZE / 2)  // 2MB
-#define EVACUATION_SIZE (2 * AGG_SIZE) // 8MB
+#define MAX_AGG_BUFFERS 16
+#define EVACUATION_SIZE (2 * AGG_SIZE)             // 8MB
+#define MIN_LOG_SEGMENT_SIZE (4 * EVACUATION_SIZE) // 32MB
+#define ZERO_COPY_MARGIN (4 * EVACUATION_SIZE)     // 32MB
+#define MAX_LOG_SEGMENTS 65536
 #define MAX_VOL_SIZE ((off_t)512 * 1024 * 1024 * 1024 * 1024)
 #define STORE_BLOCKS_PER_CACHE_BLOCK (STORE_BLOCK_SIZE / CACHE_BLOCK_SIZE)
 #define MAX_VOL_BLOCKS (MAX_VOL_SIZE / CACHE_BLOCK_SIZE)
@@ -73,6 +79,7 @@ struct CacheDisk;
 struct VolInitInfo;
 struct DiskVol;
 struct CacheVol;
+struct Doc;
 
 struct VolHeaderFooter {
   unsigned int magic;
@@ -88,10 +95,29 @@ struct VolHeaderFooter {
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused; // pad out to 8 byte boundary
+  uint32_t flags; // VOL_FLAG_*, zero in directories written before flags existed
   uint16_t freelist[1];
 };
 
+/*
+  A log segment of a volume with the segmented layout. The table of them is kept
+  in the directory, and each segment starts with a copy of its entry, written
+  when the segment is opened, for recovery to follow the write head with.
+*/
+struct VolLogSegment {
+  uint32_t seq;   // one more than that of the segment opened before it
+  uint32_t next;  // segment to open when this one is full
+  uint32_t phase; // phase of the documents written since it was opened
+  uint32_t index; // position of the segment, checked by recovery
+};
+
+// In front of the log segment table, so the directory can be read without the configuration it was made with.
+struct VolLogSegmentGeometry {
+  int64_t size;   // lseg_size, the last segment also takes what is left over
+  uint32_t count; // lsegs
+  uint32_t unused;
+};
+
 // Key and Earliest key for each fragment that needs to be evacuated
 struct EvacuationKey {
   SLink<EvacuationKey> link;
@@ -106,7 +132,8 @@ struct EvacuationBlock {
       unsigned int done : 1;          // has been evacuated
       unsigned int pinned : 1;        // check pinning timeout
       unsigned int evacuate_head : 1; // check pinning timeout
-      unsigned int unused : 29;
+      unsigned int demote : 1;        // fast tier, reclaim instead of evacuating unless there are readers
+      unsigned int unused : 28;
     } f;
   };
 
@@ -119,6 +146,22 @@ struct EvacuationBlock {
   LINK(EvacuationBlock, link);
 };
 
+// One of the aggregation buffers of a Vol, and the write of its contents once it is full.
+struct AggBuffer : public Continuation {
+  Vol *vol              = nullptr;
+  char *buf             = nullptr; // AGG_SIZE bytes
+  off_t offset          = 0;       // where the contents are being written
+  int len               = 0;       // bytes being written, 0 while the buffer is free
+  uint32_t write_serial = 0;       // header->write_serial of the documents in it
+  bool done             = false;   // written, waiting for the writes issued before it
+  AIOCallbackInternal io;
+
+  int handle_write_done(int event, Event *e);
+
+  AggBuffer() { SET_HANDLER(&AggBuffer::handle_write_done); }
+  ~AggBuffer() override { ats_free(buf); }
+};
+
 struct Vol : public Continuation {
   char *path = nullptr;
   ats_scoped_str hash_text;
@@ -127,6 +170,24 @@ struct Vol : public Continuation {
 
   char *raw_dir           = nullptr;
   Dir *dir                = nullptr;
+  uint16_t *tag_ext       = nullptr; // upper tag bits, one per dir entry, only with wide_tags
+  // Per segment sequence numbers, odd while the segment is being modified under the Vol lock.
+  // dir_probe_unlocked() uses them to read a segment without taking the lock.
+  std::atomic<uint32_t> *dir_seq = nullptr;
+  // Counting Bloom filter of the directory entries, with proxy.config.cache.dir_filter.enabled.
+  DirFilter *dir_filter = nullptr;
+  // Tags of first keys turned away by write throttling, see Vol::admit_write().
+  uint16_t *write_seen = nullptr;
+  // Per segment DIR_SEG_DIRTY_* bits, set when a segment changes and cleared per copy by CacheSync.
+  uint8_t *dir_seg_dirty = nullptr;
+  // Log segments, written one at a time, see VolLogSegment. A cyclic volume is one segment without a table.
+  VolLogSegmentGeometry *lseg_geometry = nullptr; // in the directory before the footer, only with the segmented layout
+  VolLogSegment *lseg_table            = nullptr; // right after lseg_geometry
+  int64_t *lseg_live                   = nullptr; // bytes of valid documents in each segment
+  off_t lseg_size                      = 0;
+  int lsegs                            = 1;
+  int lseg_cur                         = 0; // segment of the write head
+  int recover_lseg                     = 0; // segment being scanned by recovery
   VolHeaderFooter *header = nullptr;
   VolHeaderFooter *footer = nullptr;
   int segments            = 0;
@@ -144,10 +205,17 @@ struct Vol : public Continuation {
   Queue<CacheVC, Continuation::Link_link> agg;
   Queue<CacheVC, Continuation::Link_link> stat_cache_vcs;
   Queue<CacheVC, Continuation::Link_link> sync;
-  char *agg_buffer  = nullptr;
+  char *agg_buffer  = nullptr; // the aggregation buffer being filled
   int agg_todo_size = 0;
   int agg_buf_pos   = 0;
 
+  // Aggregation buffers are used in turn: while some are being written, the next one fills.
+  AggBuffer *agg_buffers = nullptr;
+  int agg_buffer_count   = 1;
+  int agg_size           = AGG_SIZE; // a buffer is written once it holds this much
+  int agg_fill           = 0;        // index of agg_buffer in agg_buffers
+  int agg_writes         = 0;        // buffers being written
+
   Event *trigger = nullptr;
 
   OpenDir open_dir;
@@ -158,6 +226,10 @@ struct Vol : public Continuation {
   CacheVC *doc_evacuator = nullptr;
 
   VolInitInfo *init_info = nullptr;
+  // Set once the directory is loaded and recovered, and the stripe is taking traffic.
+  std::atomic<bool> ready{false};
+  ink_hrtime init_start    = 0; // when Vol::init() began reading the directory
+  ink_hrtime recover_start = 0; // when recovery from the data began, 0 if the directory was cleared
 
   CacheDisk *disk            = nullptr;
   Cache *cache               = nullptr;
@@ -169,15 +241,23 @@ struct Vol : public Continuation {
   bool dir_sync_waiting      = false;
   bool dir_sync_in_progress  = false;
   bool writing_end_marker    = false;
+  bool wide_tags             = false;
+  bool segmented             = false;
 
   CacheKey first_fragment_key;
   int64_t first_fragment_offset = 0;
   Ptr<IOBufferData> first_fragment_data;
 
+  // Read counts for fast tier promotion, allocated on the first counted read.
+  uint8_t *tier_freq      = nullptr;
+  uint32_t tier_freq_mask = 0;
+  uint32_t tier_freq_adds = 0;
+
   void cancel_trigger();
 
   int recover_data();
 
+  int admit_write(CacheVC *cont);
   int open_write(CacheVC *cont, int allow_if_writers, int max_writers);
   int open_write_lock(CacheVC *cont, int allow_if_writers, int max_writers);
   int close_write(CacheVC *cont);
@@ -206,10 +286,11 @@ struct Vol : public Continuation {
   int dir_check(bool fix);
   int db_check(bool fix);
 
+  // io is in use, or no aggregation buffer can be filled until a write finishes.
   int
   is_io_in_progress()
   {
-    return io.aiocb.aio_fildes != AIO_NOT_IN_PROGRESS;
+    return io.aiocb.aio_fildes != AIO_NOT_IN_PROGRESS || agg_writes == agg_buffer_count || (dir_sync_waiting && agg_writes);
   }
   int
   increment_generation()
@@ -227,9 +308,13 @@ struct Vol : public Continuation {
     io.aiocb.aio_fildes = AIO_NOT_IN_PROGRESS;
   }
 
-  int aggWriteDone(int event, Event *e);
+  int aggWriteDone(AggBuffer *b);
   int aggWrite(int event, void *e);
   void agg_wrap();
+  void agg_buffers_init();
+  AggBuffer *agg_issued(int i);
+  off_t agg_flush_pos();
+  char *agg_buf_data(off_t pos, size_t n);
 
   int evacuateWrite(CacheVC *evacuator, int event, Event *e);
   int evacuateDocReadDone(int event, Event *e);
@@ -238,16 +323,30 @@ struct Vol : public Continuation {
   int evac_range(off_t start, off_t end, int evac_phase);
   void periodic_scan();
   void scan_for_pinned_documents();
+  int tier_read_count(const CacheKey *key);
   void evacuate_cleanup_blocks(int i);
   void evacuate_cleanup();
   EvacuationBlock *force_evacuate_head(Dir *dir, int pinned);
   int within_hit_evacuate_window(Dir *dir);
+  bool clear_of_write_head(Dir *dir);
   uint32_t round_to_approx_size(uint32_t l);
 
+  void lseg_clear();
+  bool lseg_attach();
+  void lseg_count_live();
+  void lseg_open(int s);
+  int lseg_summary(char *buf);
+  bool lseg_recover_summary(Doc *doc);
+  void lseg_recover_clear(off_t end);
+  bool recover_next_lseg();
+  off_t lseg_ahead(Dir *e);
+
   // inline functions
   int headerlen();         // calculates the total length of the vol header and the freelist
   int direntries();        // total number of dir entries
   Dir *dir_segment(int s); // returns the first dir in the segment s
+  size_t tag_ext_len();    // length of the tag extension array, 0 unless wide_tags
+  size_t lseg_table_len(); // length of the log segment table, 0 unless segmented
   size_t dirlen();         // calculates the total length of header, directories and footer
   int vol_out_of_phase_valid(Dir *e);
 
@@ -261,15 +360,28 @@ struct Vol : public Continuation {
   off_t vol_offset_to_offset(off_t pos);
   off_t vol_relative_length(off_t start_offset);
 
+  off_t lseg_start(int s);
+  off_t lseg_end(int s);
+  int lseg_of(Dir *e);
+  int lseg_valid(Dir *e, bool agg);
+  void lseg_add(Dir *e);
+  void lseg_sub(Dir *e);
+
   Vol() : Continuation(new_ProxyMutex())
   {
-    open_dir.mutex = mutex;
-    agg_buffer     = (char *)ats_memalign(ats_pagesize(), AGG_SIZE);
-    memset(agg_buffer, 0, AGG_SIZE);
     SET_HANDLER(&Vol::aggWrite);
   }
 
-  ~Vol() override { ats_free(agg_buffer); }
+  ~Vol() override
+  {
+    delete[] agg_buffers;
+    delete[] dir_seq;
+    delete dir_filter;
+    delete[] write_seen;
+    delete[] dir_seg_dirty;
+    delete[] lseg_live;
+    ats_free(tier_freq);
+  }
 };
 
 struct AIO_Callback_handler : public Continuation {
@@ -284,6 +396,11 @@ struct CacheVol {
   off_t size            = 0;
   int num_vols          = 0;
   bool ramcache_enabled = true;
+  bool wide_tags        = false;
+  bool fast_tier        = false; // volume.config tier=fast
+  bool segmented        = false; // volume.config layout=segmented
+  int agg_buffers       = 0;     // volume.config agg_buffers, 0 for proxy.config.cache.agg_buffers
+  int agg_size          = 0;     // volume.config agg_size, 0 for proxy.config.cache.agg_size
   Vol **vols            = nullptr;
   DiskVol **disk_vols   = nullptr;
   LINK(CacheVol, link);
@@ -351,11 +468,23 @@ Vol::dir_segment(int s)
   return (Dir *)(((char *)this->dir) + (s * this->buckets) * DIR_DEPTH * SIZEOF_DIR);
 }
 
+TS_INLINE size_t
+Vol::tag_ext_len()
+{
+  return this->wide_tags ? ROUND_TO_STORE_BLOCK(((size_t)this->buckets) * DIR_DEPTH * this->segments * sizeof(uint16_t)) : 0;
+}
+
+TS_INLINE size_t
+Vol::lseg_table_len()
+{
+  return this->segmented ? ROUND_TO_STORE_BLOCK(sizeof(VolLogSegmentGeometry) + this->lsegs * sizeof(VolLogSegment)) : 0;
+}
+
 TS_INLINE size_t
 Vol::dirlen()
 {
   return this->headerlen() + ROUND_TO_STORE_BLOCK(((size_t)this->buckets) * DIR_DEPTH * this->segments * SIZEOF_DIR) +
-         ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
+         this->tag_ext_len() + this->lseg_table_len() + ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter));
 }
 
 TS_INLINE int
@@ -409,8 +538,100 @@ Vol::vol_offset_to_offset(off_t pos)
 TS_INLINE int
 Vol::vol_in_phase_agg_buf_valid(Dir *e)
 {
-  return (this->vol_offset(e) >= this->header->write_pos && this->vol_offset(e) < (this->header->write_pos + this->agg_buf_pos));
+  return (this->vol_offset(e) >= this->agg_flush_pos() && this->vol_offset(e) < (this->header->write_pos + this->agg_buf_pos));
+}
+
+// The aggregation buffer written @a i writes before the one being filled, 1 being the latest.
+TS_INLINE AggBuffer *
+Vol::agg_issued(int i)
+{
+  return &this->agg_buffers[(this->agg_fill + this->agg_buffer_count - i) % this->agg_buffer_count];
+}
+
+// Everything before this position is on disk, the data from it up to header->write_pos is still being written.
+TS_INLINE off_t
+Vol::agg_flush_pos()
+{
+  return this->agg_writes ? this->agg_issued(this->agg_writes)->offset : this->header->write_pos;
+}
+
+// The copy of the @a n bytes at @a pos that are in the aggregation buffers.
+TS_INLINE char *
+Vol::agg_buf_data(off_t pos, size_t n)
+{
+  if (pos >= this->header->write_pos) {
+    ink_assert(pos + static_cast<off_t>(n) <= this->header->write_pos + this->agg_buf_pos);
+    return this->agg_buffer + (pos - this->header->write_pos);
+  }
+  for (int i = 1; i <= this->agg_writes; i++) {
+    AggBuffer *b = this->agg_issued(i);
+    if (pos >= b->offset) {
+      ink_assert(pos + static_cast<off_t>(n) <= b->offset + b->len);
+      return b->buf + (pos - b->offset);
+    }
+  }
+  return nullptr;
+}
+
+TS_INLINE off_t
+Vol::lseg_start(int s)
+{
+  return this->start + s * this->lseg_size;
+}
+
+// The last log segment also takes what is left over at the end of the volume.
+TS_INLINE off_t
+Vol::lseg_end(int s)
+{
+  return s == this->lsegs - 1 ? this->skip + this->len : this->lseg_start(s + 1);
+}
+
+TS_INLINE int
+Vol::lseg_of(Dir *e)
+{
+  off_t s = (dir_offset(e) - 1) / (this->lseg_size / CACHE_BLOCK_SIZE);
+  return s < this->lsegs ? static_cast<int>(s) : this->lsegs - 1;
+}
+
+// The segment being written works like a cyclic volume, the documents of
+// any other segment are valid until it is opened again.
+TS_INLINE int
+Vol::lseg_valid(Dir *e, bool agg)
+{
+  int s = this->lseg_of(e);
+  if (s != this->lseg_cur) {
+    return dir_phase(e) == this->lseg_table[s].phase;
+  }
+  if (this->header->phase == dir_phase(e)) {
+    return this->vol_in_phase_valid(e);
+  }
+  return agg ? this->vol_out_of_phase_agg_valid(e) : this->vol_out_of_phase_valid(e);
+}
+
+// Account for an entry added to the directory in the live bytes of its segment.
+TS_INLINE void
+Vol::lseg_add(Dir *e)
+{
+  if (this->lseg_live) {
+    int s = this->lseg_of(e);
+    if (dir_phase(e) == this->lseg_table[s].phase) {
+      this->lseg_live[s] += dir_approx_size(e);
+    }
+  }
+}
+
+// Account for an entry about to be removed from the directory.
+TS_INLINE void
+Vol::lseg_sub(Dir *e)
+{
+  if (this->lseg_live && dir_offset(e) && dir_valid(this, e)) {
+    int s = this->lseg_of(e);
+    if (dir_phase(e) == this->lseg_table[s].phase) {
+      this->lseg_live[s] -= dir_approx_size(e);
+    }
+  }
 }
+
 // length of the partition not including the offset of location 0.
 TS_INLINE off_t
 Vol::vol_relative_length(off_t start_offset)
@@ -450,6 +671,7 @@ Doc::data()
 
 int vol_dir_clear(Vol *d);
 int vol_init(Vol *d, char *s, off_t blocks, off_t skip, bool clear);
+int vol_lseg_victim(const VolLogSegment *table, const int64_t *live, int n, int cur, off_t size);
 
 // inline Functions
 
@@ -504,6 +726,10 @@ Vol::open_read(const CryptoHash *key)
 TS_INLINE int
 Vol::within_hit_evacuate_window(Dir *xdir)
 {
+  if (lseg_table) {
+    off_t delta = lseg_ahead(xdir) - AGG_SIZE / CACHE_BLOCK_SIZE;
+    return delta >= 0 && delta < hit_evacuate_window;
+  }
   off_t oft       = dir_offset(xdir) - 1;
   off_t write_off = (header->write_pos + AGG_SIZE - start) / CACHE_BLOCK_SIZE;
   off_t delta     = oft - write_off;
@@ -513,6 +739,26 @@ Vol::within_hit_evacuate_window(Dir *xdir)
     return -delta > (data_blocks - hit_evacuate_window) && -delta < data_blocks;
 }
 
+/*
+  Whether the write head is far enough behind the document of @a xdir for
+  its data to be sent to a client from disk. It is checked without the
+  stripe lock, the margin covers the head moving while the data is sent.
+*/
+TS_INLINE bool
+Vol::clear_of_write_head(Dir *xdir)
+{
+  off_t margin = ZERO_COPY_MARGIN / CACHE_BLOCK_SIZE;
+  if (lseg_table) {
+    off_t ahead = lseg_ahead(xdir);
+    return ahead < 0 || ahead >= margin;
+  }
+  off_t ahead = dir_offset(xdir) - 1 - (header->write_pos - start) / CACHE_BLOCK_SIZE;
+  if (ahead < 0) {
+    ahead += data_blocks;
+  }
+  return ahead >= margin;
+}
+
 TS_INLINE uint32_t
 Vol::round_to_approx_size(uint32_t l)
 {
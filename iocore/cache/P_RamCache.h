@@ -25,16 +25,42 @@
 
 #include "I_Cache.h"
 
+#include <utility>
+#include <vector>
+
+// An object held by a RAM cache, as saved in the snapshot used to warm it up after a restart.
+struct RamCacheSnapshotEntry {
+  CryptoHash key;
+  uint64_t auxkey;
+  uint32_t hits; // how popular the object was, as the algorithm counts it
+  uint32_t len;
+};
+
+// The objects of one stripe in the snapshot, by the hash_id of the stripe.
+using RamCacheSnapshotVol = std::pair<CryptoHash, std::vector<RamCacheSnapshotEntry>>;
+
 // Generic Ram Cache interface
 
 class RamCache
 {
 public:
   // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
-  virtual int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey = 0)                         = 0;
-  virtual int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint64_t auxkey = 0) = 0;
-  virtual int fixup(const CryptoHash *key, uint64_t old_auxkey, uint64_t new_auxkey)                         = 0;
-  virtual int64_t size() const                                                                               = 0;
+  virtual int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey = 0) = 0;
+  // compressible is a hint that the data is not already compressed, for RAM caches that compress
+  virtual int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint64_t auxkey = 0,
+                  bool compressible = true)                                          = 0;
+  virtual int fixup(const CryptoHash *key, uint64_t old_auxkey, uint64_t new_auxkey) = 0;
+  virtual int64_t size() const                                                       = 0;
+  // append the objects held in memory, least recently used first, called with the Vol lock held
+  virtual void
+  snapshot(std::vector<RamCacheSnapshotEntry> & /* entries ATS_UNUSED */) const
+  {
+  }
+  // give an object put back from a snapshot the popularity it had then
+  virtual void
+  restore_hits(const CryptoHash * /* key ATS_UNUSED */, uint64_t /* auxkey ATS_UNUSED */, uint32_t /* hits ATS_UNUSED */)
+  {
+  }
 
   virtual void init(int64_t max_bytes, Vol *vol) = 0;
   virtual ~RamCache(){};
@@ -42,3 +68,5 @@ public:
 
 RamCache *new_RamCacheLRU();
 RamCache *new_RamCacheCLFUS();
+void compress_RamCacheCLFUS(RamCache *rc, EThread *thread);
+RamCache *new_RamCacheTinyLFU();
@@ -33,12 +33,27 @@
 #ifdef HAVE_LZMA_H
 #include <lzma.h>
 #endif
+#ifdef HAVE_ZSTD_H
+#include <zstd.h>
+#ifdef HAVE_ZDICT_H
+#include <zdict.h>
+#endif
+#endif
+#ifdef HAVE_LZ4_H
+#include <lz4.h>
+#endif
+#include <algorithm>
+#include <vector>
 
 #define REQUIRED_COMPRESSION 0.9 // must get to this size or declared incompressible
 #define REQUIRED_SHRINK 0.8      // must get to this size or keep original buffer (with padding)
 #define HISTORY_HYSTERIA 10      // extra temporary history
 #define ENTRY_OVERHEAD 256       // per-entry overhead to consider when computing cache value/size
 #define LZMA_BASE_MEMLIMIT (64 * 1024 * 1024)
+#define ZSTD_LEVEL 1                     // favor speed, every object in the RAM cache may be compressed
+#define DICTIONARY_SAMPLE_FACTOR 100     // train the dictionary on this many times its size of samples
+#define DICTIONARY_MAX_SAMPLE 16384      // bytes taken from the start of each object for training
+#define DICTIONARY_MAX_SAMPLES (8 << 20) // bytes of samples kept for training, whatever the dictionary size
 //#define CHECK_ACOUNTING 1 // very expensive double checking of all sizes
 
 #define REQUEUE_HITS(_h) ((_h) ? ((_h)-1) : 0)
@@ -61,6 +76,7 @@ struct RamCacheCLFUSEntry {
       uint32_t incompressible : 1;
       uint32_t lru : 1;
       uint32_t copy : 1; // copy-in-copy-out
+      uint32_t dict : 1; // compressed with the trained zstd dictionary
     } flag_bits;
     uint32_t flags;
   };
@@ -76,9 +92,12 @@ public:
 
   // returns 1 on found/stored, 0 on not found/stored, if provided auxkey1 and auxkey2 must match
   int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey = 0) override;
-  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint64_t auxkey = 0) override;
+  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint64_t auxkey = 0,
+          bool compressible = true) override;
   int fixup(const CryptoHash *key, uint64_t old_auxkey, uint64_t new_auxkey) override;
   int64_t size() const override;
+  void snapshot(std::vector<RamCacheSnapshotEntry> &entries) const override;
+  void restore_hits(const CryptoHash *key, uint64_t auxkey, uint32_t hits) override;
 
   void init(int64_t max_bytes, Vol *vol) override;
 
@@ -107,6 +126,19 @@ private:
   RamCacheCLFUSEntry *_destroy(RamCacheCLFUSEntry *e);
   void _requeue_victims(Que(RamCacheCLFUSEntry, lru_link) & victims);
   void _tick(); // move CLOCK on history
+
+#ifdef HAVE_ZSTD_H
+  // The compression side is only used by compress_entries(), the decompression side under the Vol lock.
+  ZSTD_CCtx *_zstd_cctx   = nullptr;
+  ZSTD_DCtx *_zstd_dctx   = nullptr;
+  ZSTD_CDict *_zstd_cdict = nullptr;
+  ZSTD_DDict *_zstd_ddict = nullptr;
+  std::vector<char> _dict_samples;
+  std::vector<size_t> _dict_sample_sizes;
+  bool _dict_done = false;
+
+  void _train_dictionary(const char *data, uint32_t len);
+#endif
 };
 
 int64_t
@@ -126,6 +158,31 @@ RamCacheCLFUS::size() const
   return s;
 }
 
+void
+RamCacheCLFUS::snapshot(std::vector<RamCacheSnapshotEntry> &entries) const
+{
+  // Only what is in memory, the history is rebuilt as the objects are read in again.
+  forl_LL(RamCacheCLFUSEntry, e, this->_lru[0])
+  {
+    entries.push_back({e->key, e->auxkey, static_cast<uint32_t>(std::min<uint64_t>(e->hits, UINT32_MAX)), e->len});
+  }
+}
+
+void
+RamCacheCLFUS::restore_hits(const CryptoHash *key, uint64_t auxkey, uint32_t hits)
+{
+  if (!this->_max_bytes) {
+    return;
+  }
+  uint32_t i = key->slice32(3) % this->_nbuckets;
+  for (RamCacheCLFUSEntry *e = this->_bucket[i].head; e; e = e->hash_link.next) {
+    if (e->key == *key && e->auxkey == auxkey) {
+      e->hits = std::max<uint64_t>(e->hits, hits);
+      return;
+    }
+  }
+}
+
 class RamCacheCLFUSCompressor : public Continuation
 {
 public:
@@ -152,6 +209,16 @@ RamCacheCLFUSCompressor::mainEvent(int /* event ATS_UNUSED */, Event *e)
   case CACHE_COMPRESSION_LIBLZMA:
 #ifndef HAVE_LZMA_H
     Warning("lzma not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_ZSTD:
+#ifndef HAVE_ZSTD_H
+    Warning("zstd not available for RAM cache compression");
+#endif
+    break;
+  case CACHE_COMPRESSION_LZ4:
+#ifndef HAVE_LZ4_H
+    Warning("lz4 not available for RAM cache compression");
 #endif
     break;
   }
@@ -205,11 +272,63 @@ RamCacheCLFUS::init(int64_t abytes, Vol *avol)
     return;
   }
   this->_resize_hashtable();
+#ifdef HAVE_ZSTD_H
+  if (cache_config_ram_cache_compress == CACHE_COMPRESSION_ZSTD) {
+    this->_zstd_cctx = ZSTD_createCCtx();
+    this->_zstd_dctx = ZSTD_createDCtx();
+  }
+#endif
   if (cache_config_ram_cache_compress) {
     eventProcessor.schedule_every(new RamCacheCLFUSCompressor(this), HRTIME_SECOND, ET_TASK);
   }
 }
 
+#ifdef HAVE_ZSTD_H
+// Keep the start of the objects being compressed until there are enough samples, then train a
+// dictionary on them for the rest of the objects in this volume. This runs without the Vol lock;
+// no entry is marked as compressed with the dictionary until the lock is taken again, so get()
+// never sees a half built one.
+void
+RamCacheCLFUS::_train_dictionary(const char *data, uint32_t len)
+{
+#ifdef HAVE_ZDICT_H
+  size_t dict_size = cache_config_ram_cache_compress_dict_size;
+  if (this->_dict_done || !dict_size) {
+    return;
+  }
+  // The samples are held outside of the RAM cache size, so keep them small and allocate them once.
+  size_t budget = std::min<size_t>(dict_size * DICTIONARY_SAMPLE_FACTOR, DICTIONARY_MAX_SAMPLES);
+  if (this->_dict_samples.empty()) {
+    this->_dict_samples.reserve(budget);
+  }
+  size_t n = std::min<size_t>({len, DICTIONARY_MAX_SAMPLE, budget - this->_dict_samples.size()});
+  this->_dict_samples.insert(this->_dict_samples.end(), data, data + n);
+  this->_dict_sample_sizes.push_back(n);
+  if (this->_dict_samples.size() < budget) {
+    return;
+  }
+
+  std::vector<char> dictionary(dict_size);
+  size_t l = ZDICT_trainFromBuffer(dictionary.data(), dict_size, this->_dict_samples.data(), this->_dict_sample_sizes.data(),
+                                   this->_dict_sample_sizes.size());
+  if (ZDICT_isError(l)) {
+    Warning("could not train the RAM cache compression dictionary for '%s': %s", vol->hash_text.get(), ZDICT_getErrorName(l));
+  } else {
+    this->_zstd_ddict = ZSTD_createDDict(dictionary.data(), l);
+    this->_zstd_cdict = ZSTD_createCDict(dictionary.data(), l, ZSTD_LEVEL);
+    Debug("ram_cache", "trained a %zu byte compression dictionary for '%s' on %zu samples", l, vol->hash_text.get(),
+          this->_dict_sample_sizes.size());
+  }
+  this->_dict_done = true;
+  std::vector<char>().swap(this->_dict_samples);
+  std::vector<size_t>().swap(this->_dict_sample_sizes);
+#else
+  (void)data;
+  (void)len;
+#endif
+}
+#endif
+
 #ifdef CHECK_ACOUNTING
 static void
 check_accounting(RamCacheCLFUS *c)
@@ -254,7 +373,8 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey
         e->hits++;
         uint32_t ram_hit_state = RAM_HIT_COMPRESS_NONE;
         if (e->flag_bits.compressed) {
-          b = static_cast<char *>(ats_malloc(e->len));
+          ink_hrtime start = Thread::get_hrtime_updated();
+          b                = static_cast<char *>(ats_malloc(e->len));
           switch (e->flag_bits.compressed) {
           default:
             goto Lfailed;
@@ -289,7 +409,34 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey
             break;
           }
 #endif
+#ifdef HAVE_ZSTD_H
+          case CACHE_COMPRESSION_ZSTD: {
+            size_t l;
+            if (e->flag_bits.dict) {
+              l = ZSTD_decompress_usingDDict(this->_zstd_dctx, b, e->len, e->data->data(), e->compressed_len, this->_zstd_ddict);
+            } else {
+              l = ZSTD_decompressDCtx(this->_zstd_dctx, b, e->len, e->data->data(), e->compressed_len);
+            }
+            if (ZSTD_isError(l) || l != e->len) {
+              goto Lfailed;
+            }
+            ram_hit_state = RAM_HIT_COMPRESS_ZSTD;
+            break;
           }
+#endif
+#ifdef HAVE_LZ4_H
+          case CACHE_COMPRESSION_LZ4: {
+            int l = static_cast<int>(e->len);
+            if (l != LZ4_decompress_safe(e->data->data(), b, static_cast<int>(e->compressed_len), l)) {
+              goto Lfailed;
+            }
+            ram_hit_state = RAM_HIT_COMPRESS_LZ4;
+            break;
+          }
+#endif
+          }
+          CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_decompress_time_stat + e->flag_bits.compressed - 1,
+                                    ink_hrtime_to_usec(Thread::get_hrtime_updated() - start));
           IOBufferData *data = new_xmalloc_IOBufferData(b, e->len);
           data->_mem_type    = DEFAULT_ALLOC;
           if (!e->flag_bits.copy) { // don't bother if we have to copy anyway
@@ -299,6 +446,7 @@ RamCacheCLFUS::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey
             e->size = e->compressed_len;
             check_accounting(this);
             e->flag_bits.compressed = 0;
+            e->flag_bits.dict       = 0;
             e->data                 = data;
           }
           (*ret_data) = data;
@@ -451,6 +599,16 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
       case CACHE_COMPRESSION_LIBLZMA:
         l = e->len;
         break;
+#endif
+#ifdef HAVE_ZSTD_H
+      case CACHE_COMPRESSION_ZSTD:
+        l = static_cast<uint32_t>(ZSTD_compressBound(e->len));
+        break;
+#endif
+#ifdef HAVE_LZ4_H
+      case CACHE_COMPRESSION_LZ4:
+        l = static_cast<uint32_t>(LZ4_compressBound(e->len));
+        break;
 #endif
       }
       // store transient data for lock release
@@ -458,8 +616,10 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
       uint32_t elen           = e->len;
       CryptoHash key          = e->key;
       MUTEX_UNTAKE_LOCK(vol->mutex, thread);
-      b           = static_cast<char *>(ats_malloc(l));
-      bool failed = false;
+      b                = static_cast<char *>(ats_malloc(l));
+      bool failed      = false;
+      bool dict        = false;
+      ink_hrtime start = Thread::get_hrtime_updated();
       switch (ctype) {
       default:
         goto Lfailed;
@@ -492,9 +652,42 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
         l = static_cast<int>(pos);
         break;
       }
+#endif
+#ifdef HAVE_ZSTD_H
+      case CACHE_COMPRESSION_ZSTD: {
+        size_t ll;
+        if (this->_zstd_cdict) {
+          ll   = ZSTD_compress_usingCDict(this->_zstd_cctx, b, l, edata->data(), elen, this->_zstd_cdict);
+          dict = true;
+        } else {
+          ll = ZSTD_compressCCtx(this->_zstd_cctx, b, l, edata->data(), elen, ZSTD_LEVEL);
+        }
+        if (ZSTD_isError(ll)) {
+          failed = true;
+        }
+        l = static_cast<uint32_t>(ll);
+        this->_train_dictionary(edata->data(), elen);
+        break;
+      }
+#endif
+#ifdef HAVE_LZ4_H
+      case CACHE_COMPRESSION_LZ4: {
+        int ll = LZ4_compress_default(edata->data(), b, static_cast<int>(elen), static_cast<int>(l));
+        if (ll <= 0) {
+          failed = true;
+        }
+        l = static_cast<uint32_t>(ll);
+        break;
+      }
 #endif
       }
       MUTEX_TAKE_LOCK(vol->mutex, thread);
+      if (!failed) {
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_in_bytes_stat + ctype - 1, elen);
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_out_bytes_stat + ctype - 1, l);
+      }
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_time_stat + ctype - 1, ink_hrtime_to_usec(Thread::get_hrtime_updated() - start));
+
       // see if the entry is till around
       {
         if (failed) {
@@ -521,7 +714,8 @@ RamCacheCLFUS::compress_entries(EThread *thread, int do_at_most)
         goto Lfailed;
       }
       if (l < e->len) {
-        e->flag_bits.compressed = cache_config_ram_cache_compress;
+        e->flag_bits.compressed = ctype;
+        e->flag_bits.dict       = dict;
         bb                      = static_cast<char *>(ats_malloc(l));
         memcpy(bb, b, l);
         ats_free(b);
@@ -574,7 +768,7 @@ void RamCacheCLFUS::_requeue_victims(Que(RamCacheCLFUSEntry, lru_link) & victims
 }
 
 int
-RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy, uint64_t auxkey)
+RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy, uint64_t auxkey, bool compressible)
 {
   if (!this->_max_bytes) {
     return 0;
@@ -616,6 +810,11 @@ RamCacheCLFUS::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy,
       check_accounting(this);
       e->flag_bits.copy       = copy;
       e->flag_bits.compressed = 0;
+      e->flag_bits.dict       = 0;
+      if (!compressible && cache_config_ram_cache_compress) {
+        e->flag_bits.incompressible = 1;
+        CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_skipped_stat, 1);
+      }
       DDebug("ram_cache", "put %X %" PRId64 " size %d HIT", key->slice32(3), auxkey, e->size);
       return 1;
     } else {
@@ -722,6 +921,11 @@ Linsert:
     e->data->_mem_type = DEFAULT_ALLOC;
   }
   e->flag_bits.copy = copy;
+  if (!compressible && cache_config_ram_cache_compress) {
+    // Already compressed content, don't spend time finding that out again.
+    e->flag_bits.incompressible = 1;
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_compress_skipped_stat, 1);
+  }
   this->_bytes += size + ENTRY_OVERHEAD;
   CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, size);
   e->size = size;
@@ -772,3 +976,10 @@ new_RamCacheCLFUS()
   RamCacheCLFUS *r = new RamCacheCLFUS;
   return r;
 }
+
+// Compress the objects of @a rc, a CLFUS RAM cache, now instead of on the next run of its compressor.
+void
+compress_RamCacheCLFUS(RamCache *rc, EThread *thread)
+{
+  static_cast<RamCacheCLFUS *>(rc)->compress_entries(thread);
+}
@@ -40,9 +40,11 @@ struct RamCacheLRU : public RamCache {
 
   // returns 1 on found/stored, 0 on not found/stored, if provided auxkey must match
   int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey = 0) override;
-  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint64_t auxkey = 0) override;
+  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint64_t auxkey = 0,
+          bool compressible = true) override;
   int fixup(const CryptoHash *key, uint64_t old_auxkey, uint64_t new_auxkey) override;
   int64_t size() const override;
+  void snapshot(std::vector<RamCacheSnapshotEntry> &entries) const override;
 
   void init(int64_t max_bytes, Vol *vol) override;
 
@@ -71,6 +73,15 @@ RamCacheLRU::size() const
   return s;
 }
 
+void
+RamCacheLRU::snapshot(std::vector<RamCacheSnapshotEntry> &entries) const
+{
+  forl_LL(RamCacheLRUEntry, e, lru)
+  {
+    entries.push_back({e->key, e->auxkey, 1, static_cast<uint32_t>(e->data->block_size())});
+  }
+}
+
 ClassAllocator<RamCacheLRUEntry> ramCacheLRUEntryAllocator("RamCacheLRUEntry");
 
 static const int bucket_sizes[] = {127,     251,      509,      1021,     2039,      4093,      8191,     16381,
@@ -158,7 +169,7 @@ RamCacheLRU::remove(RamCacheLRUEntry *e)
 
 // ignore 'copy' since we don't touch the data
 int
-RamCacheLRU::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool, uint64_t auxkey)
+RamCacheLRU::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool, uint64_t auxkey, bool)
 {
   if (!max_bytes) {
     return 0;
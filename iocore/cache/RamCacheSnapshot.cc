@@ -0,0 +1,444 @@
+/** @file
+
+  Warm restart of the RAM cache from a snapshot of its keys.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// With proxy.config.cache.ram_cache.snapshot.enabled, the key, directory offset
+// and hit count of every object in the RAM cache of each stripe are saved to
+// ram_cache.snapshot in the local state directory. This is done every
+// proxy.config.cache.ram_cache.snapshot.interval seconds and when the server
+// shuts down. Only the keys are saved, the objects themselves are on disk.
+//
+// When a stripe comes online, the objects of its part of the snapshot are read
+// back into its RAM cache, the most popular first, at no more than
+// proxy.config.cache.ram_cache.snapshot.warm_rate bytes per second. Each one is
+// looked up in the directory by key and offset, so objects overwritten or
+// removed since are skipped, and is put in the RAM cache as handleReadDone()
+// does after a read.
+//
+// No snapshot is written while a stripe is still coming online or warming up,
+// which would lose its part or save a RAM cache that is only partly filled. The
+// previous snapshot is kept instead.
+
+#include "P_Cache.h"
+#include "tscore/I_Layout.h"
+
+#include <algorithm>
+
+#define RAM_CACHE_SNAPSHOT_FILE "ram_cache.snapshot"
+#define RAM_CACHE_SNAPSHOT_MAGIC 0x52414D53 // "RAMS"
+#define RAM_CACHE_SNAPSHOT_VERSION 1
+#define RAM_CACHE_WARM_PROBES 64 // directory lookups under one hold of the Vol lock
+
+struct RamCacheSnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t nvols;
+  uint32_t entry_size; // sizeof(RamCacheSnapshotEntry)
+};
+
+// Followed by count entries.
+struct RamCacheSnapshotVolHeader {
+  CryptoHash hash_id;
+  uint64_t count;
+};
+
+// The stripes of the snapshot read at startup that have not come online yet, under vol_online_mutex.
+static std::vector<RamCacheSnapshotVol> snapshot_vols;
+static bool snapshot_loaded = false;
+// Stripes still warming up.
+static std::atomic<int> snapshot_warming{0};
+static ink_mutex snapshot_write_mutex = INK_MUTEX_INIT;
+
+static std::string
+snapshot_path()
+{
+  return Layout::relative_to(RecConfigReadRuntimeDir(), RAM_CACHE_SNAPSHOT_FILE);
+}
+
+/*
+  Read the snapshot at @a path into @a vols, false if there is none or it is
+  unusable. The entry count of each stripe is checked against what is left of
+  the file before anything is allocated for it.
+*/
+bool
+ram_cache_snapshot_read(const std::string &path, std::vector<RamCacheSnapshotVol> &vols)
+{
+  FILE *f = fopen(path.c_str(), "r");
+  if (!f) {
+    Debug("ram_cache_snapshot", "no RAM cache snapshot at %s: %s", path.c_str(), strerror(errno));
+    return false;
+  }
+
+  struct stat st;
+  RamCacheSnapshotHeader header;
+  bool ok = fstat(fileno(f), &st) == 0 && fread(&header, sizeof(header), 1, f) == 1 && header.magic == RAM_CACHE_SNAPSHOT_MAGIC &&
+            header.version == RAM_CACHE_SNAPSHOT_VERSION && header.entry_size == sizeof(RamCacheSnapshotEntry);
+  for (uint32_t i = 0; ok && i < header.nvols; ++i) {
+    RamCacheSnapshotVolHeader vh;
+    if (fread(&vh, sizeof(vh), 1, f) != 1 || vh.count > (st.st_size - ftell(f)) / sizeof(RamCacheSnapshotEntry)) {
+      ok = false;
+      break;
+    }
+    vols.emplace_back(vh.hash_id, std::vector<RamCacheSnapshotEntry>(vh.count));
+    auto &entries = vols.back().second;
+    ok            = entries.empty() || fread(entries.data(), sizeof(RamCacheSnapshotEntry), entries.size(), f) == entries.size();
+  }
+  fclose(f);
+  if (!ok) {
+    Warning("ignoring the RAM cache snapshot %s, it is truncated or from another version", path.c_str());
+    vols.clear();
+    return false;
+  }
+  return true;
+}
+
+// Write @a vols to @a path, through a temporary file renamed over it once it is on disk.
+bool
+ram_cache_snapshot_save(const std::string &path, const std::vector<RamCacheSnapshotVol> &vols)
+{
+  std::string tmp = path + ".tmp";
+  FILE *f         = fopen(tmp.c_str(), "w");
+  if (!f) {
+    Warning("unable to write the RAM cache snapshot %s: %s", tmp.c_str(), strerror(errno));
+    return false;
+  }
+
+  RamCacheSnapshotHeader header = {RAM_CACHE_SNAPSHOT_MAGIC, RAM_CACHE_SNAPSHOT_VERSION, static_cast<uint32_t>(vols.size()),
+                                   sizeof(RamCacheSnapshotEntry)};
+  bool ok                       = fwrite(&header, sizeof(header), 1, f) == 1;
+  for (auto const &[hash_id, entries] : vols) {
+    RamCacheSnapshotVolHeader vh = {hash_id, entries.size()};
+    ok = ok && fwrite(&vh, sizeof(vh), 1, f) == 1 &&
+         (entries.empty() || fwrite(entries.data(), sizeof(RamCacheSnapshotEntry), entries.size(), f) == entries.size());
+  }
+  ok = ok && fflush(f) == 0 && fsync(fileno(f)) == 0;
+  ok = fclose(f) == 0 && ok;
+  if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+    Warning("unable to write the RAM cache snapshot %s: %s", path.c_str(), strerror(errno));
+    unlink(tmp.c_str());
+    return false;
+  }
+  return true;
+}
+
+static void
+snapshot_load()
+{
+  std::string path = snapshot_path();
+  if (ram_cache_snapshot_read(path, snapshot_vols)) {
+    Debug("ram_cache_snapshot", "read the RAM cache snapshot of %zu stripes from %s", snapshot_vols.size(), path.c_str());
+  }
+}
+
+/*
+  Save the RAM cache keys of every stripe that is online. The Vol locks are
+  taken as @a thread one after the other, and only long enough to copy the keys.
+  Unless @a wait, a Vol lock that is busy gives up the snapshot and returns
+  false, to be tried again later.
+*/
+static bool
+snapshot_write(EThread *thread, bool wait)
+{
+  if (snapshot_warming > 0) {
+    Debug("ram_cache_snapshot", "%d stripes are still warming up, keeping the previous snapshot", snapshot_warming.load());
+    return true;
+  }
+
+  std::vector<RamCacheSnapshotVol> vols;
+  size_t objects = 0;
+  for (int i = 0; i < gnvol; i++) {
+    Vol *vol = gvol[i];
+    if (!vol->ready) {
+      Debug("ram_cache_snapshot", "%s is not online yet, keeping the previous snapshot", vol->hash_text.get());
+      return true;
+    }
+    if (!vol->ram_cache || DISK_BAD(vol->disk)) {
+      continue;
+    }
+    if (wait) {
+      MUTEX_TAKE_LOCK(vol->mutex, thread);
+    } else if (!MUTEX_TAKE_TRY_LOCK(vol->mutex, thread)) {
+      Debug("ram_cache_snapshot", "%s is busy, retrying the snapshot", vol->hash_text.get());
+      return false;
+    }
+    vols.emplace_back(vol->hash_id, std::vector<RamCacheSnapshotEntry>());
+    vol->ram_cache->snapshot(vols.back().second);
+    MUTEX_UNTAKE_LOCK(vol->mutex, thread);
+    objects += vols.back().second.size();
+  }
+
+  ink_scoped_mutex_lock lock(snapshot_write_mutex);
+  std::string path = snapshot_path();
+  if (ram_cache_snapshot_save(path, vols)) {
+    Debug("ram_cache_snapshot", "wrote %zu objects of %zu stripes to %s", objects, vols.size(), path.c_str());
+  }
+  return true;
+}
+
+// Writes the snapshot every interval, sooner again when a Vol lock was busy.
+struct RamCacheSnapshotter : public Continuation {
+  int
+  mainEvent(int /* event ATS_UNUSED */, Event *e)
+  {
+    ink_hrtime delay = HRTIME_SECONDS(cache_config_ram_cache_snapshot_interval);
+    if (!snapshot_write(e->ethread, false)) {
+      delay = HRTIME_MSECONDS(cache_config_mutex_retry_delay);
+    }
+    eventProcessor.schedule_in(this, delay, ET_TASK);
+    return EVENT_DONE;
+  }
+
+  RamCacheSnapshotter() : Continuation(new_ProxyMutex()) { SET_HANDLER(&RamCacheSnapshotter::mainEvent); }
+};
+
+void
+ram_cache_snapshot_init()
+{
+  if (cache_config_ram_cache_snapshot_interval > 0) {
+    eventProcessor.schedule_in(new RamCacheSnapshotter, HRTIME_SECONDS(cache_config_ram_cache_snapshot_interval), ET_TASK);
+  }
+}
+
+/*
+  Called when the process is going down, before sync_cache_dir_on_shutdown()
+  which keeps the Vol locks. The locks are taken as a thread that is not an
+  EThread, the same way.
+*/
+void
+ram_cache_snapshot_on_shutdown()
+{
+  if (!cache_config_ram_cache_snapshot || CacheProcessor::initialized != CACHE_INITIALIZED) {
+    return;
+  }
+  snapshot_write(reinterpret_cast<EThread *>(0xdeadbeef), true);
+}
+
+/*
+  Reads the objects of a stripe's snapshot back into its RAM cache, one at a
+  time. The Vol lock is only held to look up the object and to put it in the
+  RAM cache, not during the read.
+*/
+class RamCacheWarmer : public Continuation
+{
+public:
+  RamCacheWarmer(Vol *avol, std::vector<RamCacheSnapshotEntry> &&aentries)
+    : Continuation(new_ProxyMutex()), vol(avol), entries(std::move(aentries))
+  {
+    SET_HANDLER(&RamCacheWarmer::startRead);
+  }
+
+  int startRead(int event, Event *e);
+  int readDone(int event, Event *e);
+
+private:
+  Vol *vol;
+  std::vector<RamCacheSnapshotEntry> entries;
+  size_t next = 0;
+  Dir dir;
+  AIOCallbackInternal io;
+  Ptr<IOBufferData> buf;
+
+  void schedule(ink_hrtime delay);
+  int done();
+};
+
+/*
+  Whether the RAM cache may compress @a doc, as handleReadDone() decides it
+  from the response of the alternate. With its headers left marshalled (@a
+  copy) they are unmarshalled in a copy to find that response, the alternate
+  whose first fragment is @a doc. Content-Type and Content-Encoding are never
+  shared in a compact vector, there is no need to expand it.
+*/
+static bool
+warm_compressible(Doc *doc, bool copy)
+{
+  if (!copy || !cache_config_ram_cache_compress_adaptive) {
+    return ram_cache_compressible(doc, nullptr);
+  }
+
+  int okay               = 1;
+  int64_t len            = sizeof(Doc) + doc->hlen;
+  Ptr<IOBufferData> hdrs = make_ptr(new_IOBufferData(iobuffer_size_to_index(len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED));
+  Doc *d                 = reinterpret_cast<Doc *>(hdrs->data());
+  memcpy(static_cast<void *>(d), doc, len);
+  unmarshal_helper(d, hdrs, okay);
+
+  CacheHTTPInfoVector vector;
+  HTTPHdr *response = nullptr;
+  if (okay && vector.get_handles(d->hdr(), d->hlen, hdrs.get()) == d->hlen) {
+    for (int i = 0; i < vector.count(); i++) {
+      if (vector.get(i)->valid() && vector.get(i)->object_key_get() == doc->key) {
+        response = vector.get(i)->response_get();
+        // As load_http_info() fixes up objects from older versions.
+        if (ts::VersionNumber(doc->v_major, doc->v_minor) < CACHE_DB_VERSION) {
+          response->m_mime->recompute_accelerators_and_presence_bits();
+        }
+        break;
+      }
+    }
+  }
+  bool compressible = ram_cache_compressible(doc, response);
+  vector.clear(false);
+  return compressible;
+}
+
+void
+RamCacheWarmer::schedule(ink_hrtime delay)
+{
+  eventProcessor.schedule_in(this, delay, ET_TASK);
+}
+
+int
+RamCacheWarmer::done()
+{
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_warm_pending_stat, -static_cast<int64_t>(entries.size() - next));
+  Debug("ram_cache_snapshot", "%s: warm up done", vol->hash_text.get());
+  --snapshot_warming;
+  delete this;
+  return EVENT_DONE;
+}
+
+int
+RamCacheWarmer::startRead(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  if (DISK_BAD(vol->disk)) {
+    return done();
+  }
+  MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  if (!lock.is_locked()) {
+    schedule(HRTIME_MSECONDS(cache_config_mutex_retry_delay));
+    return EVENT_CONT;
+  }
+
+  for (int probes = 0; next < entries.size(); ++next) {
+    if (++probes > RAM_CACHE_WARM_PROBES) {
+      schedule(0);
+      return EVENT_CONT;
+    }
+    RamCacheSnapshotEntry &entry = entries[next];
+    Dir *last_collision          = nullptr;
+    bool found                   = false;
+    while (dir_probe(&entry.key, vol, &dir, &last_collision)) {
+      if (static_cast<uint64_t>(dir_offset(&dir)) == entry.auxkey) {
+        found = true;
+        break;
+      }
+    }
+    // The aggregation buffer is only written since the restart, the RAM cache fills from it.
+    if (!found || dir_agg_buf_valid(vol, &dir)) {
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_warm_misses_stat, 1);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_warm_pending_stat, -1);
+      continue;
+    }
+
+    io.aiocb.aio_fildes = vol->fd;
+    io.aiocb.aio_offset = vol->vol_offset(&dir);
+    io.aiocb.aio_nbytes = dir_approx_size(&dir);
+    if (static_cast<off_t>(io.aiocb.aio_offset + io.aiocb.aio_nbytes) > static_cast<off_t>(vol->skip + vol->len)) {
+      io.aiocb.aio_nbytes = vol->skip + vol->len - io.aiocb.aio_offset;
+    }
+    buf              = new_IOBufferData(iobuffer_size_to_index(io.aiocb.aio_nbytes, MAX_BUFFER_SIZE_INDEX), MEMALIGNED);
+    io.aiocb.aio_buf = buf->data();
+    io.action        = this;
+    io.thread        = AIO_CALLBACK_THREAD_ANY;
+    SET_HANDLER(&RamCacheWarmer::readDone);
+    ink_assert(ink_aio_read(&io) >= 0);
+    return EVENT_CONT;
+  }
+  lock.release();
+  return done();
+}
+
+int
+RamCacheWarmer::readDone(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+{
+  MUTEX_TRY_LOCK(lock, vol->mutex, mutex->thread_holding);
+  if (!lock.is_locked()) {
+    schedule(HRTIME_MSECONDS(cache_config_mutex_retry_delay));
+    return EVENT_CONT;
+  }
+
+  RamCacheSnapshotEntry &entry = entries[next];
+  Doc *doc                     = reinterpret_cast<Doc *>(buf->data());
+  int okay                     = io.ok() && dir_valid(vol, &dir) && doc->magic == DOC_MAGIC &&
+             ts::VersionNumber(doc->v_major, doc->v_minor) <= CACHE_DB_VERSION &&
+             (doc->key == entry.key || doc->first_key == entry.key);
+  if (okay) {
+    // Marshalled headers stay that way in the RAM cache only when it may compress them, as in handleReadDone().
+    bool copy = cache_config_ram_cache_compress && doc->doc_type == CACHE_FRAG_TYPE_HTTP && doc->hlen;
+    if (!copy && doc->doc_type == CACHE_FRAG_TYPE_HTTP && doc->hlen) {
+      unmarshal_helper(doc, buf, okay);
+    }
+    if (okay && vol->ram_cache->put(&entry.key, buf.get(), doc->len, copy, entry.auxkey, warm_compressible(doc, copy))) {
+      vol->ram_cache->restore_hits(&entry.key, entry.auxkey, entry.hits);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_warm_objects_stat, 1);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_warm_bytes_stat, doc->len);
+    }
+  }
+  if (!okay) {
+    CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_warm_misses_stat, 1);
+  }
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_warm_pending_stat, -1);
+  buf = nullptr;
+  ++next;
+  lock.release();
+
+  SET_HANDLER(&RamCacheWarmer::startRead);
+  ink_hrtime delay = 0;
+  if (cache_config_ram_cache_warm_rate > 0) {
+    delay = io.aiocb.aio_nbytes * HRTIME_SECOND / cache_config_ram_cache_warm_rate;
+  }
+  schedule(delay);
+  return EVENT_CONT;
+}
+
+/*
+  Start warming up the RAM cache of @a vol from the snapshot, if it is in it.
+  Called from CacheProcessor::vol_online(), with vol_online_mutex held.
+*/
+void
+ram_cache_warm(Vol *vol)
+{
+  if (!snapshot_loaded) {
+    snapshot_load();
+    snapshot_loaded = true;
+  }
+  auto spot = std::find_if(snapshot_vols.begin(), snapshot_vols.end(),
+                           [vol](RamCacheSnapshotVol const &v) { return v.first == vol->hash_id; });
+  if (spot == snapshot_vols.end()) {
+    return;
+  }
+  std::vector<RamCacheSnapshotEntry> entries = std::move(spot->second);
+  snapshot_vols.erase(spot);
+  if (entries.empty()) {
+    return;
+  }
+
+  // Most popular first, so a rate limited warm up brings back the objects that matter most early.
+  std::stable_sort(entries.begin(), entries.end(),
+                   [](RamCacheSnapshotEntry const &a, RamCacheSnapshotEntry const &b) { return a.hits > b.hits; });
+  Debug("ram_cache_snapshot", "%s: warming up %zu objects", vol->hash_text.get(), entries.size());
+  ProxyMutex *mutex = this_ethread()->mutex.get();
+  CACHE_SUM_DYN_STAT(cache_ram_cache_warm_pending_stat, entries.size());
+  ++snapshot_warming;
+  eventProcessor.schedule_imm(new RamCacheWarmer(vol, std::move(entries)), ET_TASK);
+}
@@ -0,0 +1,390 @@
+/** @file
+
+  RAM cache with TinyLFU admission in front of a segmented LRU.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+// Every lookup is counted in a count-min sketch of 4 bit counters, which is halved
+// periodically so it tracks recent popularity. Once the cache is full a new object
+// is only admitted if the sketch says it is more popular than the object it would
+// evict, which keeps one-hit wonders from flushing the cache.
+//
+// Admitted objects start in the probationary segment of the LRU and are promoted
+// to the protected segment on their next hit. The protected segment is capped at
+// TINYLFU_PROTECTED_PERCENT of the cache, anything pushed out of it drops back to
+// probation, and eviction always takes the least recently used probationary object
+// first.
+
+#include "P_Cache.h"
+
+#define TINYLFU_SKETCH_DEPTH 4        // rows in the count-min sketch
+#define TINYLFU_COUNTER_MAX 15        // 4 bit counters
+#define TINYLFU_SAMPLE_FACTOR 10      // halve the counters after this many increments per counter in a row
+#define TINYLFU_PROTECTED_PERCENT 80  // share of the cache held by objects hit at least twice
+#define TINYLFU_MIN_SKETCH_WIDTH 1024 // counters per row
+
+// 64 bytes, RamCacheCLFUSEntry is 88.
+struct RamCacheTinyLFUEntry {
+  CryptoHash key;
+  uint64_t auxkey;
+  Ptr<IOBufferData> data;
+  LINK(RamCacheTinyLFUEntry, lru_link);
+  SLINK(RamCacheTinyLFUEntry, hash_link);
+  uint32_t size;       // bytes charged against max_bytes
+  bool protected_list; // in the protected segment, otherwise on probation
+};
+
+static_assert(sizeof(RamCacheTinyLFUEntry) <= 64, "TinyLFU entries should stay smaller than the CLFUS ones");
+
+// per-entry overhead to consider when computing sizes
+static const int64_t ENTRY_OVERHEAD = sizeof(RamCacheTinyLFUEntry) + sizeof(IOBufferData);
+
+struct RamCacheTinyLFU : public RamCache {
+  int64_t max_bytes       = 0;
+  int64_t bytes           = 0;
+  int64_t protected_bytes = 0;
+  int64_t objects         = 0;
+
+  // returns 1 on found/stored, 0 on not found/stored, if provided auxkey must match
+  int get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey = 0) override;
+  int put(CryptoHash *key, IOBufferData *data, uint32_t len, bool copy = false, uint64_t auxkey = 0,
+          bool compressible = true) override;
+  int fixup(const CryptoHash *key, uint64_t old_auxkey, uint64_t new_auxkey) override;
+  int64_t size() const override;
+  void snapshot(std::vector<RamCacheSnapshotEntry> &entries) const override;
+  void restore_hits(const CryptoHash *key, uint64_t auxkey, uint32_t hits) override;
+
+  void init(int64_t max_bytes, Vol *vol) override;
+  ~RamCacheTinyLFU() override;
+
+  // private
+  Que(RamCacheTinyLFUEntry, lru_link) probation;
+  Que(RamCacheTinyLFUEntry, lru_link) protect;
+  SList(RamCacheTinyLFUEntry, hash_link) *bucket = nullptr;
+  int nbuckets                                   = 0;
+  int ibuckets                                   = 0;
+  Vol *vol                                       = nullptr;
+
+  // count-min sketch, 16 counters per word, TINYLFU_SKETCH_DEPTH rows of sketch_width counters each
+  uint64_t *sketch       = nullptr;
+  uint32_t sketch_width  = 0;
+  uint32_t sketch_adds   = 0;
+  uint32_t sketch_sample = 0;
+
+  void resize_hashtable();
+  void remove(RamCacheTinyLFUEntry *e);
+  void evict_one();
+  void sketch_increment(const CryptoHash *key);
+  int sketch_frequency(const CryptoHash *key) const;
+  uint32_t sketch_index(const CryptoHash *key, int row) const;
+};
+
+ClassAllocator<RamCacheTinyLFUEntry> ramCacheTinyLFUEntryAllocator("RamCacheTinyLFUEntry");
+
+static const int bucket_sizes[] = {127,     251,      509,      1021,     2039,      4093,      8191,     16381,
+                                   32749,   65521,    131071,   262139,   524287,    1048573,   2097143,  4194301,
+                                   8388593, 16777213, 33554393, 67108859, 134217689, 268435399, 536870909};
+
+int64_t
+RamCacheTinyLFU::size() const
+{
+  int64_t s = 0;
+  forl_LL(RamCacheTinyLFUEntry, e, probation)
+  {
+    s += sizeof(*e);
+    s += sizeof(*e->data);
+    s += e->data->block_size();
+  }
+  forl_LL(RamCacheTinyLFUEntry, e, protect)
+  {
+    s += sizeof(*e);
+    s += sizeof(*e->data);
+    s += e->data->block_size();
+  }
+  return s;
+}
+
+void
+RamCacheTinyLFU::snapshot(std::vector<RamCacheSnapshotEntry> &entries) const
+{
+  forl_LL(RamCacheTinyLFUEntry, e, probation)
+  {
+    entries.push_back({e->key, e->auxkey, static_cast<uint32_t>(sketch_frequency(&e->key)), e->size});
+  }
+  forl_LL(RamCacheTinyLFUEntry, e, protect)
+  {
+    entries.push_back({e->key, e->auxkey, static_cast<uint32_t>(sketch_frequency(&e->key)), e->size});
+  }
+}
+
+void
+RamCacheTinyLFU::restore_hits(const CryptoHash *key, uint64_t /* auxkey ATS_UNUSED */, uint32_t hits)
+{
+  if (!max_bytes) {
+    return;
+  }
+  int n = std::min<uint32_t>(hits, TINYLFU_COUNTER_MAX);
+  for (int f = sketch_frequency(key); f < n; ++f) {
+    sketch_increment(key);
+  }
+}
+
+uint32_t
+RamCacheTinyLFU::sketch_index(const CryptoHash *key, int row) const
+{
+  // Double hashing over the two halves of the key gives independent enough rows.
+  return row * sketch_width + ((key->u64[0] + row * (key->u64[1] | 1)) & (sketch_width - 1));
+}
+
+void
+RamCacheTinyLFU::sketch_increment(const CryptoHash *key)
+{
+  for (int row = 0; row < TINYLFU_SKETCH_DEPTH; ++row) {
+    uint32_t i  = sketch_index(key, row);
+    uint64_t &w = sketch[i >> 4];
+    int shift   = (i & 15) * 4;
+    if (((w >> shift) & 0xf) < TINYLFU_COUNTER_MAX) {
+      w += static_cast<uint64_t>(1) << shift;
+    }
+  }
+  if (++sketch_adds >= sketch_sample) {
+    // Age every counter by half so old popularity fades out.
+    for (uint32_t i = 0; i < TINYLFU_SKETCH_DEPTH * sketch_width / 16; ++i) {
+      sketch[i] = (sketch[i] >> 1) & 0x7777777777777777ULL;
+    }
+    sketch_adds /= 2;
+  }
+}
+
+int
+RamCacheTinyLFU::sketch_frequency(const CryptoHash *key) const
+{
+  int f = TINYLFU_COUNTER_MAX;
+  for (int row = 0; row < TINYLFU_SKETCH_DEPTH; ++row) {
+    uint32_t i = sketch_index(key, row);
+    f          = std::min(f, static_cast<int>((sketch[i >> 4] >> ((i & 15) * 4)) & 0xf));
+  }
+  return f;
+}
+
+void
+RamCacheTinyLFU::resize_hashtable()
+{
+  int anbuckets = bucket_sizes[ibuckets];
+  DDebug("ram_cache", "resize hashtable %d", anbuckets);
+  int64_t s                                          = anbuckets * sizeof(SList(RamCacheTinyLFUEntry, hash_link));
+  SList(RamCacheTinyLFUEntry, hash_link) *new_bucket = static_cast<SList(RamCacheTinyLFUEntry, hash_link) *>(ats_malloc(s));
+  memset(static_cast<void *>(new_bucket), 0, s);
+  if (bucket) {
+    for (int64_t i = 0; i < nbuckets; i++) {
+      RamCacheTinyLFUEntry *e = nullptr;
+      while ((e = bucket[i].pop())) {
+        new_bucket[e->key.slice32(3) % anbuckets].push(e);
+      }
+    }
+    ats_free(bucket);
+  }
+  bucket   = new_bucket;
+  nbuckets = anbuckets;
+}
+
+void
+RamCacheTinyLFU::init(int64_t abytes, Vol *avol)
+{
+  vol       = avol;
+  max_bytes = abytes;
+  DDebug("ram_cache", "initializing ram_cache %" PRId64 " bytes", abytes);
+  if (!max_bytes) {
+    return;
+  }
+  resize_hashtable();
+
+  // One counter per row for every object of the minimum average size that fits.
+  int64_t expected = max_bytes / std::max(cache_config_min_average_object_size, 1);
+  sketch_width     = TINYLFU_MIN_SKETCH_WIDTH;
+  while (sketch_width < expected && sketch_width < (1U << 28)) {
+    sketch_width <<= 1;
+  }
+  sketch_sample = TINYLFU_SAMPLE_FACTOR * sketch_width;
+  sketch        = static_cast<uint64_t *>(ats_malloc(TINYLFU_SKETCH_DEPTH * sketch_width / 2));
+  memset(sketch, 0, TINYLFU_SKETCH_DEPTH * sketch_width / 2);
+}
+
+RamCacheTinyLFU::~RamCacheTinyLFU()
+{
+  RamCacheTinyLFUEntry *e;
+  while ((e = probation.head) || (e = protect.head)) {
+    remove(e);
+  }
+  ats_free(bucket);
+  ats_free(sketch);
+}
+
+int
+RamCacheTinyLFU::get(CryptoHash *key, Ptr<IOBufferData> *ret_data, uint64_t auxkey)
+{
+  if (!max_bytes) {
+    return 0;
+  }
+  sketch_increment(key);
+  uint32_t i              = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey == auxkey) {
+      if (e->protected_list) {
+        protect.remove(e);
+      } else {
+        probation.remove(e);
+        e->protected_list = true;
+        protected_bytes += e->size;
+        // Make room in the protected segment by moving its oldest objects back to probation.
+        while (protected_bytes > max_bytes * TINYLFU_PROTECTED_PERCENT / 100 && protect.head) {
+          RamCacheTinyLFUEntry *d = protect.dequeue();
+          d->protected_list       = false;
+          protected_bytes -= d->size;
+          probation.enqueue(d);
+        }
+      }
+      protect.enqueue(e);
+      (*ret_data) = e->data;
+      DDebug("ram_cache", "get %X %" PRIu64 " HIT", key->slice32(3), auxkey);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_hits_stat, 1);
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  DDebug("ram_cache", "get %X %" PRIu64 " MISS", key->slice32(3), auxkey);
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_misses_stat, 1);
+  return 0;
+}
+
+void
+RamCacheTinyLFU::remove(RamCacheTinyLFUEntry *e)
+{
+  uint32_t b = e->key.slice32(3) % nbuckets;
+  if (bucket[b].head == e) {
+    bucket[b].pop();
+  } else {
+    RamCacheTinyLFUEntry *p = bucket[b].head;
+    while (p->hash_link.next != e) {
+      p = p->hash_link.next;
+    }
+    p->hash_link.next = e->hash_link.next;
+  }
+  if (e->protected_list) {
+    protect.remove(e);
+    protected_bytes -= e->size;
+  } else {
+    probation.remove(e);
+  }
+  bytes -= e->size;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, -static_cast<int64_t>(e->size));
+  DDebug("ram_cache", "put %X %" PRIu64 " FREED", e->key.slice32(3), e->auxkey);
+  e->data = nullptr;
+  THREAD_FREE(e, ramCacheTinyLFUEntryAllocator, this_thread());
+  objects--;
+}
+
+void
+RamCacheTinyLFU::evict_one()
+{
+  remove(probation.head ? probation.head : protect.head);
+}
+
+// ignore 'copy' since we don't touch the data
+int
+RamCacheTinyLFU::put(CryptoHash *key, IOBufferData *data, uint32_t len, bool, uint64_t auxkey, bool)
+{
+  if (!max_bytes) {
+    return 0;
+  }
+  uint32_t i              = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    RamCacheTinyLFUEntry *next = e->hash_link.next;
+    if (e->key == *key) {
+      if (e->auxkey == auxkey) {
+        return 1;
+      } else { // discard when aux keys conflict
+        remove(e);
+      }
+    }
+    e = next;
+  }
+
+  int64_t size = ENTRY_OVERHEAD + data->block_size();
+  if (size > max_bytes) {
+    return 0;
+  }
+  // Once full, only admit objects that have been asked for more often than the one they would push out.
+  if (bytes + size > max_bytes) {
+    RamCacheTinyLFUEntry *victim = probation.head ? probation.head : protect.head;
+    if (victim && sketch_frequency(key) <= sketch_frequency(&victim->key)) {
+      DDebug("ram_cache", "put %X %" PRIu64 " len %d REJECTED", key->slice32(3), auxkey, len);
+      CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_admission_rejected_stat, 1);
+      return 0;
+    }
+  }
+  while (bytes + size > max_bytes && objects) {
+    evict_one();
+  }
+
+  e                 = THREAD_ALLOC(ramCacheTinyLFUEntryAllocator, this_ethread());
+  e->key            = *key;
+  e->auxkey         = auxkey;
+  e->data           = data;
+  e->size           = size;
+  e->protected_list = false;
+  bucket[i].push(e);
+  probation.enqueue(e);
+  bytes += size;
+  objects++;
+  CACHE_SUM_DYN_STAT_THREAD(cache_ram_cache_bytes_stat, size);
+  DDebug("ram_cache", "put %X %" PRIu64 " INSERTED", key->slice32(3), auxkey);
+  if (objects > nbuckets) {
+    ++ibuckets;
+    resize_hashtable();
+  }
+  return 1;
+}
+
+int
+RamCacheTinyLFU::fixup(const CryptoHash *key, uint64_t old_auxkey, uint64_t new_auxkey)
+{
+  if (!max_bytes) {
+    return 0;
+  }
+  uint32_t i              = key->slice32(3) % nbuckets;
+  RamCacheTinyLFUEntry *e = bucket[i].head;
+  while (e) {
+    if (e->key == *key && e->auxkey == old_auxkey) {
+      e->auxkey = new_auxkey;
+      return 1;
+    }
+    e = e->hash_link.next;
+  }
+  return 0;
+}
+
+RamCache *
+new_RamCacheTinyLFU()
+{
+  return new RamCacheTinyLFU;
+}
@@ -0,0 +1,225 @@
+/** @file
+
+  Helpers for the cache directory tests and benchmarks, a Vol directory in memory.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "main.h"
+#include "tscore/hugepages.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+#include <atomic>
+#include <random>
+#include <vector>
+
+// The same keys on every run.
+inline std::mt19937_64 dir_test_rng(0x5eed);
+
+inline CryptoHash
+random_key()
+{
+  CryptoHash key;
+  key.u64[0] = dir_test_rng();
+  key.u64[1] = dir_test_rng();
+  return key;
+}
+
+// Build a volume directory in memory, sized the way Vol::init() does it but without a disk behind it. If @a page_size
+// is set the directory is mapped on pages of that size, with @a actual set to the hugepage size it got. With @a lsegs
+// the volume has the segmented layout, with that many log segments.
+inline Vol *
+make_vol(off_t len, bool wide_tags = false, size_t page_size = 0, size_t *actual = nullptr, int lsegs = 0)
+{
+  if (cache_rsb == nullptr) {
+    cache_rsb = RecAllocateRawStatBlock(static_cast<int>(cache_stat_count));
+  }
+
+  Vol *vol                = new Vol();
+  vol->cache_vol          = new CacheVol();
+  vol->cache_vol->vol_rsb = RecAllocateRawStatBlock(static_cast<int>(cache_stat_count));
+  vol->wide_tags          = wide_tags;
+  vol->segmented          = lsegs > 0;
+  vol->lsegs              = std::max(lsegs, 1);
+  vol->len                = len;
+  vol->skip               = START_POS;
+  vol->start              = vol->skip;
+  for (int i = 0; i < 3; ++i) {
+    off_t total_entries = (vol->len - (vol->start - vol->skip)) / cache_config_min_average_object_size;
+    off_t total_buckets = total_entries / DIR_DEPTH;
+    vol->segments       = (total_buckets + (((1 << 16) - 1) / DIR_DEPTH)) / ((1 << 16) / DIR_DEPTH);
+    vol->buckets        = (total_buckets + vol->segments - 1) / vol->segments;
+    vol->start          = vol->skip + 2 * vol->dirlen();
+  }
+  if (vol->segmented) {
+    vol->lseg_size     = ROUND_DOWN_TO_STORE_BLOCK((vol->skip + vol->len - vol->start) / vol->lsegs);
+    vol->lseg_live     = new int64_t[vol->lsegs]();
+    vol->evacuate_size = static_cast<int>(vol->len / EVACUATION_BUCKET_SIZE) + 2;
+    vol->evacuate      = static_cast<DLL<EvacuationBlock> *>(ats_calloc(vol->evacuate_size, sizeof(DLL<EvacuationBlock>)));
+    vol->agg_buffer    = static_cast<char *>(ats_memalign(ats_pagesize(), AGG_SIZE));
+  }
+
+  vol->dir_seq       = new std::atomic<uint32_t>[vol->segments]();
+  vol->dir_seg_dirty = new uint8_t[vol->segments];
+  memset(vol->dir_seg_dirty, DIR_SEG_DIRTY_ALL, vol->segments);
+  if (page_size == ats_pagesize()) {
+    // Keep transparent hugepages out of the baseline.
+    vol->raw_dir = static_cast<char *>(mmap(nullptr, vol->dirlen(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+    ats_madvise(vol->raw_dir, vol->dirlen(), MADV_NOHUGEPAGE);
+    *actual = 0;
+  } else if (page_size) {
+    vol->raw_dir = static_cast<char *>(ats_alloc_hugepage_sized(vol->dirlen(), page_size, actual));
+  } else {
+    vol->raw_dir = static_cast<char *>(ats_memalign(ats_pagesize(), vol->dirlen()));
+  }
+  memset(vol->raw_dir, 0, vol->dirlen());
+  vol->dir    = reinterpret_cast<Dir *>(vol->raw_dir + vol->headerlen());
+  vol->header = reinterpret_cast<VolHeaderFooter *>(vol->raw_dir);
+  vol->footer = reinterpret_cast<VolHeaderFooter *>(vol->raw_dir + vol->dirlen() - ROUND_TO_STORE_BLOCK(sizeof(VolHeaderFooter)));
+  if (vol->segmented) {
+    vol->lseg_geometry = reinterpret_cast<VolLogSegmentGeometry *>(reinterpret_cast<char *>(vol->footer) - vol->lseg_table_len());
+    vol->lseg_table    = reinterpret_cast<VolLogSegment *>(vol->lseg_geometry + 1);
+  }
+  if (wide_tags) {
+    vol->tag_ext =
+      reinterpret_cast<uint16_t *>(reinterpret_cast<char *>(vol->footer) - vol->lseg_table_len() - vol->tag_ext_len());
+  }
+  vol_init_dir(vol);
+  vol->lseg_clear();
+  // Everything written so far is in phase and valid.
+  vol->header->phase     = 0;
+  vol->header->write_pos = vol->skip + vol->len;
+  vol->header->agg_pos   = vol->header->write_pos;
+  return vol;
+}
+
+// Insert @a key into the directory, pointing at a random block of the volume.
+inline bool
+insert_key(Vol *vol, const CryptoHash &key)
+{
+  off_t blocks = (vol->len - (vol->start - vol->skip)) / CACHE_BLOCK_SIZE;
+  Dir dir;
+  dir_clear(&dir);
+  dir_set_offset(&dir, 1 + static_cast<int64_t>(dir_test_rng() % (blocks - 1)));
+  dir_set_approx_size(&dir, cache_config_min_average_object_size);
+  dir_set_phase(&dir, vol->header->phase);
+  dir_set_head(&dir, 1);
+  return dir_insert(&key, vol, &dir);
+}
+
+// Insert @a n random keys, returning them so they can be replayed as hits.
+inline std::vector<CryptoHash>
+populate(Vol *vol, int n)
+{
+  std::vector<CryptoHash> keys;
+
+  keys.reserve(n);
+  for (int i = 0; i < n; ++i) {
+    CryptoHash key = random_key();
+    if (insert_key(vol, key)) {
+      keys.push_back(key);
+    }
+  }
+  return keys;
+}
+
+// A volume like make_vol()'s with an empty data area on a temporary file, ready to write through @a agg_buffers aggregation
+// buffers of @a agg_size bytes, or the configured ones when 0.
+inline Vol *
+make_file_vol(off_t len, int agg_buffers = 0, int agg_size = 0)
+{
+  Vol *vol    = make_vol(len);
+  char path[] = "/tmp/test_cache_vol.XXXXXX";
+  int fd      = mkstemp(path);
+  REQUIRE(fd >= 0);
+  unlink(path);
+  REQUIRE(ftruncate(fd, vol->skip + vol->len) == 0);
+
+  vol->hash_text     = ats_strdup(path);
+  vol->disk          = new CacheDisk();
+  vol->disk->fd      = fd;
+  vol->fd            = fd;
+  vol->evacuate_size = static_cast<int>(vol->len / EVACUATION_BUCKET_SIZE) + 2;
+  vol->evacuate      = static_cast<DLL<EvacuationBlock> *>(ats_calloc(vol->evacuate_size, sizeof(DLL<EvacuationBlock>)));
+
+  vol->cache_vol->agg_buffers = agg_buffers;
+  vol->cache_vol->agg_size    = agg_size;
+  vol->agg_buffers_init();
+  // Nothing written yet, the write head is at the start of the data.
+  vol->header->write_pos = vol->start;
+  vol->header->agg_pos   = vol->start;
+  vol->ready             = true;
+  return vol;
+}
+
+// A document of @a size bytes of data under @a key, the way agg_copy() lays out a single fragment.
+inline Ptr<IOBufferData>
+make_doc(const CryptoHash &key, int size)
+{
+  int len                = sizeof(Doc) + size;
+  Ptr<IOBufferData> data = make_ptr(new_IOBufferData(iobuffer_size_to_index(len, MAX_BUFFER_SIZE_INDEX), MEMALIGNED));
+  Doc *doc               = reinterpret_cast<Doc *>(data->data());
+  memset(static_cast<void *>(doc), 0, sizeof(Doc));
+  doc->magic     = DOC_MAGIC;
+  doc->len       = len;
+  doc->total_len = size;
+  doc->first_key = key;
+  doc->key       = key;
+  doc->doc_type  = CACHE_FRAG_TYPE_NONE;
+  doc->v_major   = CACHE_DB_MAJOR_VERSION;
+  doc->v_minor   = CACHE_DB_MINOR_VERSION;
+  doc->checksum  = DOC_NO_CHECKSUM;
+  for (int i = 0; i < size; ++i) {
+    doc->data()[i] = static_cast<char>(dir_test_rng());
+  }
+  return data;
+}
+
+// Whether the document at @a dir on the disk of @a vol has the data of @a doc.
+inline bool
+doc_on_disk(Vol *vol, Dir *dir, Doc *doc)
+{
+  std::vector<char> buf(doc->len);
+  if (pread(vol->fd, buf.data(), buf.size(), vol->vol_offset(dir)) != static_cast<ssize_t>(buf.size())) {
+    return false;
+  }
+  Doc *d = reinterpret_cast<Doc *>(buf.data());
+  return d->magic == DOC_MAGIC && d->len == doc->len && d->first_key == doc->first_key &&
+         memcmp(d->data(), doc->data(), doc->data_len()) == 0;
+}
+
+// Wait up to 10s for @a done, checked under the lock of @a vol, while the event and AIO threads do the work.
+template <typename F>
+bool
+wait_for(Vol *vol, F done)
+{
+  for (int i = 0; i < 1000; ++i) {
+    {
+      SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+      if (done()) {
+        return true;
+      }
+    }
+    usleep(10000);
+  }
+  return false;
+}
@@ -0,0 +1,188 @@
+/** @file
+
+  Alternate selection latency for the legacy and the compact alternate vector formats.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+#include "HttpTransactCache.h"
+#include "InkAPIInternal.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace
+{
+// One object varying on Accept-Language, with the kind of headers a CDN origin sends.
+constexpr int BENCH_ALTERNATES = 32;
+
+void
+parse(HTTPHdr &hdr, HTTPType type, const std::string &text)
+{
+  HTTPParser parser;
+  const char *start = text.data();
+  const char *end   = start + text.size();
+  ParseResult err;
+
+  hdr.create(type);
+  http_parser_init(&parser);
+  do {
+    err = type == HTTP_TYPE_REQUEST ? hdr.parse_req(&parser, &start, end, true) : hdr.parse_resp(&parser, &start, end, true);
+  } while (err == PARSE_RESULT_CONT);
+  REQUIRE(err == PARSE_RESULT_DONE);
+  http_parser_clear(&parser);
+}
+
+std::string
+language(int i)
+{
+  return "l" + std::to_string(i);
+}
+
+void
+build_alternate(CacheHTTPInfo &info, int i)
+{
+  HTTPHdr req;
+  HTTPHdr resp;
+  std::string cookie(512, 'c');
+
+  parse(req, HTTP_TYPE_REQUEST,
+        "GET http://www.example.com/catalog/item?id=42 HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64) AppleWebKit/537.36 (KHTML, like Gecko) Chrome/80.0 Safari/537.36\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+        "Accept-Encoding: gzip\r\n"
+        "Accept-Language: " +
+          language(i) +
+          "\r\n"
+          "Referer: http://www.example.com/catalog/index.html\r\n"
+          "Cookie: session=" +
+          cookie + "\r\n\r\n");
+  parse(resp, HTTP_TYPE_RESPONSE,
+        "HTTP/1.1 200 OK\r\n"
+        "Server: origin/1.0\r\n"
+        "Date: Thu, 14 Mar 2019 08:47:40 GMT\r\n"
+        "Last-Modified: Thu, 14 Mar 2019 08:47:40 GMT\r\n"
+        "Expires: Fri, 15 Mar 2219 08:55:45 GMT\r\n"
+        "Cache-Control: public, max-age=86400\r\n"
+        "Content-Type: text/html; charset=utf-8\r\n"
+        "Content-Encoding: gzip\r\n"
+        "Content-Language: " +
+          language(i) +
+          "\r\n"
+          "Vary: Accept-Language\r\n"
+          "Access-Control-Allow-Origin: *\r\n"
+          "Strict-Transport-Security: max-age=31536000; includeSubDomains\r\n"
+          "X-Content-Type-Options: nosniff\r\n"
+          "X-Frame-Options: SAMEORIGIN\r\n"
+          "Content-Security-Policy: default-src 'self'; img-src 'self' https://img.example.com; script-src 'self'\r\n"
+          "ETag: \"5c8a157c-" +
+          std::to_string(i) + "\"\r\n\r\n");
+
+  info.create();
+  info.request_set(&req);
+  info.response_set(&resp);
+  info.request_sent_time_set(ink_get_hrtime_internal() / HRTIME_SECOND);
+  info.response_received_time_set(ink_get_hrtime_internal() / HRTIME_SECOND);
+  req.destroy();
+  resp.destroy();
+}
+
+// Marshal the same alternates into a first fragment header, compact or not.
+std::vector<char>
+marshal(std::vector<CacheHTTPInfo> &alts, int compact)
+{
+  CacheHTTPInfoVector vector;
+  for (auto &alt : alts) {
+    vector.insert(&alt);
+  }
+
+  cache_config_alt_vector_compact = compact;
+  int len                         = vector.marshal_length();
+  std::vector<char> buf(len);
+  REQUIRE(vector.marshal(buf.data(), len) == len);
+  // The alternates are still owned by the caller.
+  vector.clear(false);
+  return buf;
+}
+
+// What a lookup does with the first fragment: unmarshal it, select an alternate and get the whole of it.
+int
+lookup(const std::vector<char> &doc, std::vector<char> &scratch, HTTPHdr *client_request, const OverridableHttpConfigParams *params)
+{
+  CacheHTTPInfoVector vector;
+  memcpy(scratch.data(), doc.data(), doc.size());
+  REQUIRE(vector.unmarshal(scratch.data(), doc.size(), nullptr) == static_cast<int>(doc.size()));
+  vector.get_handles(scratch.data(), doc.size());
+  int idx = HttpTransactCache::SelectFromAlternates(&vector, client_request, params);
+  REQUIRE(idx >= 0);
+  vector.expand(idx);
+  int fields = vector.get(idx)->response_get()->fields_count();
+  vector.clear();
+  return fields;
+}
+
+} // namespace
+
+TEST_CASE("Alternate selection", "[cache][alternates][benchmark]")
+{
+  if (http_global_hooks == nullptr) {
+    http_global_hooks = new HttpAPIHooks;
+  }
+
+  std::vector<CacheHTTPInfo> alts(BENCH_ALTERNATES);
+  for (int i = 0; i < BENCH_ALTERNATES; ++i) {
+    build_alternate(alts[i], i);
+  }
+
+  std::vector<char> legacy  = marshal(alts, 0);
+  std::vector<char> compact = marshal(alts, 1);
+  std::vector<char> scratch(std::max(legacy.size(), compact.size()));
+  printf("%d alternates: legacy vector %zu bytes, compact vector %zu bytes\n", BENCH_ALTERNATES, legacy.size(), compact.size());
+
+  HTTPHdr client_request;
+  parse(client_request, HTTP_TYPE_REQUEST,
+        "GET http://www.example.com/catalog/item?id=42 HTTP/1.1\r\n"
+        "Host: www.example.com\r\n"
+        "Accept-Encoding: gzip\r\n"
+        "Accept-Language: " +
+          language(BENCH_ALTERNATES - 1) + "\r\n\r\n");
+  OverridableHttpConfigParams params;
+
+  // Both formats must select the same alternate and hand back the same response.
+  REQUIRE(lookup(legacy, scratch, &client_request, &params) == lookup(compact, scratch, &client_request, &params));
+
+  BENCHMARK("legacy vector")
+  {
+    return lookup(legacy, scratch, &client_request, &params);
+  };
+  BENCHMARK("compact vector")
+  {
+    return lookup(compact, scratch, &client_request, &params);
+  };
+
+  client_request.destroy();
+  for (auto &alt : alts) {
+    alt.destroy();
+  }
+  cache_config_alt_vector_compact = 0;
+}
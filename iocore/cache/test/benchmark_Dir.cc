@@ -0,0 +1,306 @@
+/** @file
+
+  Micro benchmarks for the cache directory.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+#include <chrono>
+#include <thread>
+
+namespace
+{
+// 8GB volume, roughly 1M directory entries with the default average object size.
+constexpr off_t BENCH_VOL_SIZE = static_cast<off_t>(8) * 1024 * 1024 * 1024;
+// Fraction of the directory entries populated before probing.
+constexpr double BENCH_FILL = 0.75;
+constexpr int BENCH_PROBES  = 1 << 16;
+// Probes per thread for the multi-threaded lookups.
+constexpr int BENCH_THREAD_PROBES = 1 << 20;
+// 64GB volume for the page size comparison, so the directory is far larger than the TLB reaches with 4KB pages.
+constexpr off_t BENCH_HUGE_VOL_SIZE = static_cast<off_t>(64) * 1024 * 1024 * 1024;
+
+// Run @a fn on @a n threads at once, each with its own EThread, and return the lookups per second over all of them.
+template <typename F>
+double
+run_threads(int n, F &&fn)
+{
+  std::vector<std::thread> threads;
+  std::atomic<int> ready{0};
+  std::atomic<bool> go{false};
+
+  for (int i = 0; i < n; ++i) {
+    threads.emplace_back([&, i]() {
+      EThread *thread = new EThread();
+      thread->set_specific();
+      ready++;
+      while (!go) {
+        std::this_thread::yield();
+      }
+      fn(i);
+    });
+  }
+  while (ready < n) {
+    std::this_thread::yield();
+  }
+  auto start = std::chrono::steady_clock::now();
+  go         = true;
+  for (auto &t : threads) {
+    t.join();
+  }
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return static_cast<double>(n) * BENCH_THREAD_PROBES / elapsed.count();
+}
+
+int
+replay(Vol *vol, const std::vector<CryptoHash> &keys)
+{
+  int found = 0;
+  for (const CryptoHash &key : keys) {
+    Dir result;
+    Dir *last_collision = nullptr;
+    found += dir_probe(&key, vol, &result, &last_collision);
+  }
+  return found;
+}
+
+} // namespace
+
+TEST_CASE("dir_probe", "[cache][dir][benchmark]")
+{
+  bool wide_tags = GENERATE(false, true);
+  Vol *vol       = make_vol(BENCH_VOL_SIZE, wide_tags);
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+  std::vector<CryptoHash> inserted = populate(vol, static_cast<int>(vol->direntries() * BENCH_FILL));
+  std::vector<CryptoHash> hits, misses;
+  for (int i = 0; i < BENCH_PROBES; ++i) {
+    hits.push_back(inserted[dir_test_rng() % inserted.size()]);
+    misses.push_back(random_key());
+  }
+  printf("dir_probe: %d segments, %" PRId64 " buckets, %d entries, %zu inserted, simd %d, wide tags %d\n", vol->segments,
+         static_cast<int64_t>(vol->buckets), vol->direntries(), inserted.size(), DIR_PROBE_SIMD, wide_tags);
+
+  BENCHMARK("hits")
+  {
+    return replay(vol, hits);
+  };
+  BENCHMARK("misses")
+  {
+    return replay(vol, misses);
+  };
+}
+
+TEST_CASE("dir_probe page size", "[cache][dir][benchmark][hugepages]")
+{
+  size_t page_size = GENERATE(ats_pagesize(), CACHE_HUGEPAGE_2MB, CACHE_HUGEPAGE_1GB);
+  size_t actual    = 0;
+  Vol *vol         = make_vol(BENCH_HUGE_VOL_SIZE, false, page_size, &actual);
+  if (page_size != ats_pagesize() && actual != page_size) {
+    WARN("no " << (page_size >> 20) << "MB hugepages available, skipping");
+    ats_free_hugepage_sized(vol->raw_dir, vol->dirlen(), actual);
+    return;
+  }
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+  std::vector<CryptoHash> inserted = populate(vol, static_cast<int>(vol->direntries() * BENCH_FILL));
+  std::vector<CryptoHash> hits, misses;
+  for (int i = 0; i < BENCH_PROBES; ++i) {
+    hits.push_back(inserted[dir_test_rng() % inserted.size()]);
+    misses.push_back(random_key());
+  }
+
+  // A rough per probe latency to compare page sizes at a glance, the BENCHMARKs below have the detail.
+  auto start = std::chrono::steady_clock::now();
+  replay(vol, hits);
+  replay(vol, misses);
+  std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+  printf("dir_probe: %zu byte directory on %zuKB pages, %.1f ns per probe\n", vol->dirlen(), page_size >> 10,
+         elapsed.count() / (2 * BENCH_PROBES));
+
+  std::string pages = std::to_string(page_size >> 10) + "KB pages";
+  BENCHMARK("hits, " + pages)
+  {
+    return replay(vol, hits);
+  };
+  BENCHMARK("misses, " + pages)
+  {
+    return replay(vol, misses);
+  };
+  ats_free_hugepage_sized(vol->raw_dir, vol->dirlen(), actual);
+}
+
+TEST_CASE("dir_probe threads", "[cache][dir][benchmark]")
+{
+  Vol *vol = make_vol(BENCH_VOL_SIZE);
+  {
+    SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+    populate(vol, static_cast<int>(vol->direntries() * BENCH_FILL));
+  }
+  std::vector<CryptoHash> misses;
+  for (int i = 0; i < BENCH_PROBES; ++i) {
+    misses.push_back(random_key());
+  }
+
+  for (int n : {1, 2, 4, 8}) {
+    double locked = run_threads(n, [&](int id) {
+      for (int i = 0; i < BENCH_THREAD_PROBES; ++i) {
+        const CryptoHash &key = misses[(i + id * 7919) % misses.size()];
+        Dir result;
+        Dir *last_collision = nullptr;
+        SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+        dir_probe(&key, vol, &result, &last_collision);
+      }
+    });
+    double unlocked = run_threads(n, [&](int id) {
+      for (int i = 0; i < BENCH_THREAD_PROBES; ++i) {
+        dir_probe_unlocked(&misses[(i + id * 7919) % misses.size()], vol);
+      }
+    });
+    printf("dir_probe misses, %d threads: %.0f/s under the Vol lock, %.0f/s unlocked\n", n, locked, unlocked);
+  }
+}
+
+TEST_CASE("dir sync plan", "[cache][dir][benchmark]")
+{
+  bool wide_tags  = GENERATE(false, true);
+  Vol *vol        = make_vol(BENCH_VOL_SIZE, wide_tags);
+  CacheSync *sync = new CacheSync();
+  sync->buf       = static_cast<char *>(ats_memalign(ats_pagesize(), vol->dirlen()));
+  int saved       = cache_config_dir_sync_incremental;
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+  cache_config_dir_sync_incremental = 1;
+  sync->plan(vol, 0);
+  sync->plan(vol, 1);
+  BENCHMARK("incremental, 1% of inserts")
+  {
+    populate(vol, vol->direntries() / 100);
+    sync->plan(vol, 0);
+    return sync->segments.size();
+  };
+
+  cache_config_dir_sync_incremental = 0;
+  BENCHMARK("full")
+  {
+    populate(vol, vol->direntries() / 100);
+    sync->plan(vol, 0);
+    return sync->segments.size();
+  };
+
+  cache_config_dir_sync_incremental = saved;
+}
+
+TEST_CASE("dir filter", "[cache][dir][benchmark]")
+{
+  bool wide_tags = GENERATE(false, true);
+  Vol *vol       = make_vol(BENCH_VOL_SIZE, wide_tags);
+  int saved      = cache_config_dir_filter;
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+  // Built on the empty directory, so everything below is tracked by the directory functions.
+  cache_config_dir_filter = 1;
+  dir_filter_build(vol);
+  REQUIRE(vol->dir_filter);
+
+  std::vector<CryptoHash> inserted = populate(vol, static_cast<int>(vol->direntries() * BENCH_FILL));
+  // Remove some keys one by one and a range of the volume at once.
+  for (size_t i = 0; i < inserted.size(); i += 8) {
+    Dir result;
+    Dir *last_collision = nullptr;
+    if (dir_probe(&inserted[i], vol, &result, &last_collision)) {
+      dir_delete(&inserted[i], vol, &result);
+    }
+  }
+  off_t blocks = (vol->len - (vol->start - vol->skip)) / CACHE_BLOCK_SIZE;
+  dir_clear_range(1, blocks / 16, vol);
+
+  // Every key still in the directory must pass the filter.
+  std::vector<CryptoHash> hits, misses;
+  for (const CryptoHash &key : inserted) {
+    Dir result;
+    Dir *last_collision = nullptr;
+    if (dir_probe(&key, vol, &result, &last_collision)) {
+      REQUIRE(dir_probe_unlocked(&key, vol));
+      if (static_cast<int>(hits.size()) < BENCH_PROBES) {
+        hits.push_back(key);
+      }
+    }
+  }
+
+  // The filter kept in step may only count more than one built from scratch, never less.
+  DirFilter *kept = vol->dir_filter;
+  vol->dir_filter = nullptr;
+  dir_filter_build(vol);
+  DirFilter *fresh = vol->dir_filter;
+  int64_t differ   = 0;
+  for (int64_t i = 0; i < vol->segments * kept->seg_words; ++i) {
+    uint64_t k = kept->words[i].load();
+    uint64_t f = fresh->words[i].load();
+    for (int c = 0; c < 64; c += 4) {
+      REQUIRE(((k >> c) & 0xF) >= ((f >> c) & 0xF));
+    }
+    differ += k != f;
+  }
+  delete fresh;
+  vol->dir_filter = kept;
+
+  int passed = 0, found = 0;
+  for (int i = 0; i < BENCH_PROBES; ++i) {
+    CryptoHash key = random_key();
+    misses.push_back(key);
+    passed += kept->maybe_contains(key.slice32(0) % vol->segments, key.slice32(1) % vol->buckets, DIR_MASK_TAG(key.slice32(2)),
+                                   wide_tags ? DIR_TAG_EXT(&key) : 0);
+    found += dir_probe_unlocked(&key, vol);
+  }
+  printf("dir filter: %zu bytes for %d entries, wide tags %d, %" PRId64 " words above a rebuilt filter, %.2f%% of misses pass the "
+         "filter, %.2f%% the directory\n",
+         kept->size(), vol->direntries(), wide_tags, differ, 100.0 * passed / BENCH_PROBES, 100.0 * found / BENCH_PROBES);
+
+  BENCHMARK("unlocked hits, filter")
+  {
+    int n = 0;
+    for (const CryptoHash &key : hits) {
+      n += dir_probe_unlocked(&key, vol);
+    }
+    return n;
+  };
+  BENCHMARK("unlocked misses, filter")
+  {
+    int n = 0;
+    for (const CryptoHash &key : misses) {
+      n += dir_probe_unlocked(&key, vol);
+    }
+    return n;
+  };
+  vol->dir_filter = nullptr;
+  BENCHMARK("unlocked misses, no filter")
+  {
+    int n = 0;
+    for (const CryptoHash &key : misses) {
+      n += dir_probe_unlocked(&key, vol);
+    }
+    return n;
+  };
+
+  delete kept;
+  cache_config_dir_filter = saved;
+}
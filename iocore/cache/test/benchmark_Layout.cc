@@ -0,0 +1,314 @@
+/** @file
+
+  Trace driven write amplification comparison of the cyclic and segmented volume layouts.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+// Synthetic trace: Zipf distributed requests over objects that are now and then replaced by a new version or removed.
+constexpr int BENCH_OBJECTS     = 200000;
+constexpr int BENCH_REQUESTS    = 2000000;
+constexpr double BENCH_ZIPF     = 0.8;
+constexpr double BENCH_UPDATE   = 0.05;
+constexpr double BENCH_REMOVE   = 0.01;
+constexpr uint32_t BENCH_MIN_SZ = 4 * 1024;
+constexpr uint32_t BENCH_MAX_SZ = 1024 * 1024;
+// Log segments per simulated stripe, the size of the stripe is a fraction of the trace footprint.
+constexpr int BENCH_SEGMENTS = 64;
+
+struct Request {
+  uint64_t key;
+  uint32_t size; // 0 removes the object
+};
+
+std::vector<Request>
+synthetic_trace()
+{
+  std::mt19937_64 rng(0x5eed);
+  std::vector<double> cdf(BENCH_OBJECTS);
+  std::vector<uint32_t> sizes(BENCH_OBJECTS);
+  std::vector<uint64_t> versions(BENCH_OBJECTS);
+  std::vector<Request> trace;
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  double sum = 0;
+
+  auto object_size = [&]() {
+    return static_cast<uint32_t>(BENCH_MIN_SZ * std::pow(static_cast<double>(BENCH_MAX_SZ) / BENCH_MIN_SZ, uniform(rng)));
+  };
+  for (int i = 0; i < BENCH_OBJECTS; ++i) {
+    sum += 1.0 / std::pow(i + 1, BENCH_ZIPF);
+    cdf[i]   = sum;
+    sizes[i] = object_size();
+  }
+  trace.reserve(BENCH_REQUESTS);
+  while (trace.size() < static_cast<size_t>(BENCH_REQUESTS)) {
+    int id   = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng) * sum) - cdf.begin();
+    id       = std::min(id, BENCH_OBJECTS - 1);
+    double r = uniform(rng);
+    if (r < BENCH_REMOVE) {
+      trace.push_back({static_cast<uint64_t>(id), 0});
+      continue;
+    } else if (r < BENCH_REMOVE + BENCH_UPDATE) {
+      // a new version, likely of a different size
+      sizes[id] = object_size();
+      ++versions[id];
+    }
+    trace.push_back({static_cast<uint64_t>(id) | (versions[id] << 32), sizes[id]});
+  }
+  return trace;
+}
+
+// Read a trace of "<key> <size>" lines, one request per line. A size of 0 removes
+// the object, a size different from the last one requested is a new version.
+std::vector<Request>
+file_trace(const char *path)
+{
+  std::ifstream in(path);
+  std::vector<Request> trace;
+  std::string line;
+  std::unordered_map<uint64_t, std::pair<uint32_t, uint32_t>> last; // key -> size, version
+
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string name;
+    uint64_t size = 0;
+    if (!(fields >> name >> size)) {
+      continue;
+    }
+    uint64_t h = std::hash<std::string>{}(name) & 0xFFFFFFFF;
+    auto &l    = last[h];
+    if (size && l.first && size != l.first) {
+      ++l.second;
+    }
+    l.first = static_cast<uint32_t>(std::min<uint64_t>(size, BENCH_MAX_SZ));
+    trace.push_back({h | (static_cast<uint64_t>(l.second) << 32), l.first});
+  }
+  return trace;
+}
+
+const std::vector<Request> &
+trace()
+{
+  static std::vector<Request> requests;
+  if (requests.empty()) {
+    const char *path = getenv("TS_LAYOUT_TRACE");
+    requests         = path ? file_trace(path) : synthetic_trace();
+    REQUIRE(!requests.empty());
+  }
+  return requests;
+}
+
+struct ReplayResult {
+  uint64_t requests      = 0;
+  uint64_t hits          = 0;
+  uint64_t written       = 0; // bytes written for misses and new versions
+  uint64_t evacuated     = 0; // bytes rewritten to keep documents read since they were written
+  uint64_t overwritten   = 0; // bytes of valid documents lost to the write head
+  uint64_t segments_used = 0;
+};
+
+/*
+  A stripe reduced to what decides where the write head goes: which documents
+  are in each log segment and whether they are still valid. Documents are
+  appended at the head. When a segment is full the head moves to the next one
+  on disk (cyclic) or to the one vol_lseg_victim() picks (segmented), the way
+  Vol::agg_wrap() does. The documents of that segment that were read since
+  they were written are evacuated, like hit evacuation does, the other valid
+  ones are lost.
+*/
+class Stripe
+{
+public:
+  Stripe(off_t size, int n, bool segmented) : seg_size(size / n), segmented(segmented), table(n), live(n), docs(n)
+  {
+    for (int i = 0; i < n; i++) {
+      table[i].index = i;
+    }
+    table[0].seq = 1;
+  }
+
+  void
+  replay(const Request &r, ReplayResult &result)
+  {
+    uint32_t object = static_cast<uint32_t>(r.key);
+    auto d          = index.find(object);
+    bool valid      = d != index.end() && valid_doc(d->second);
+
+    ++result.requests;
+    if (!r.size) {
+      if (valid) {
+        drop(d->second);
+      }
+      return;
+    }
+    if (valid && d->second.key == r.key) {
+      ++result.hits;
+      d->second.read = true;
+      return;
+    }
+    if (valid) {
+      drop(d->second);
+    }
+    result.written += r.size;
+    write(object, r.key, ROUND_TO_CACHE_BLOCK(r.size + sizeof(Doc)), result);
+  }
+
+private:
+  struct Location {
+    uint64_t key;
+    int seg;
+    uint32_t seq; // of the segment when it was written
+    uint32_t size;
+    bool read;
+  };
+
+  bool
+  valid_doc(const Location &l) const
+  {
+    return l.seq == table[l.seg].seq;
+  }
+
+  void
+  drop(Location &l)
+  {
+    live[l.seg] -= l.size;
+    l.seq = 0;
+  }
+
+  void
+  write(uint32_t object, uint64_t key, uint32_t size, ReplayResult &result)
+  {
+    if (pos + size > seg_size) {
+      open(result);
+    }
+    index[object] = {key, cur, table[cur].seq, size, false};
+    docs[cur].push_back(object);
+    live[cur] += size;
+    pos += size;
+  }
+
+  void
+  open(ReplayResult &result)
+  {
+    int n        = static_cast<int>(table.size());
+    int s        = segmented ? vol_lseg_victim(table.data(), live.data(), n, cur, seg_size) : (cur + 1) % n;
+    uint32_t seq = table[s].seq;
+    std::vector<uint32_t> victims;
+
+    victims.swap(docs[s]);
+    table[s].seq = table[cur].seq + 1;
+    live[s]      = 0;
+    cur          = s;
+    pos          = 0;
+    ++result.segments_used;
+    for (uint32_t object : victims) {
+      Location &l = index[object];
+      // still the document written to s before it was opened again
+      if (l.seg != s || l.seq != seq || !seq) {
+        continue;
+      }
+      if (l.read && pos + l.size <= seg_size) {
+        result.evacuated += l.size;
+        l.seq  = table[s].seq;
+        l.read = false;
+        docs[s].push_back(object);
+        live[s] += l.size;
+        pos += l.size;
+      } else {
+        result.overwritten += l.size;
+        l.seq = 0;
+      }
+    }
+  }
+
+  off_t seg_size;
+  bool segmented;
+  std::vector<VolLogSegment> table;
+  std::vector<int64_t> live;
+  std::vector<std::vector<uint32_t>> docs; // objects written to each segment since it was opened
+  std::unordered_map<uint32_t, Location> index;
+  int cur   = 0;
+  off_t pos = 0;
+};
+
+} // namespace
+
+TEST_CASE("Volume layout write amplification", "[cache][layout][benchmark]")
+{
+  const std::vector<Request> &requests = trace();
+  uint64_t footprint                   = 0;
+
+  // Size the stripes against the bytes of the distinct objects requested.
+  {
+    std::unordered_map<uint32_t, uint32_t> objects;
+    for (auto &r : requests) {
+      objects[static_cast<uint32_t>(r.key)] = std::max(objects[static_cast<uint32_t>(r.key)], r.size);
+    }
+    for (auto &o : objects) {
+      footprint += o.second;
+    }
+  }
+  printf("layout trace: %zu requests, %" PRIu64 " bytes of distinct objects, %d log segments\n", requests.size(), footprint,
+         BENCH_SEGMENTS);
+
+  for (double fraction : {0.25, 0.5}) {
+    for (bool segmented : {false, true}) {
+      Stripe stripe(static_cast<off_t>(footprint * fraction), BENCH_SEGMENTS, segmented);
+      ReplayResult r;
+      for (auto &request : requests) {
+        stripe.replay(request, r);
+      }
+      printf("%-9s %3.0f%% of footprint: write amplification %.3f, %5.2f%% of written bytes overwritten while valid, "
+             "%5.2f%% hits\n",
+             segmented ? "segmented" : "cyclic", fraction * 100, static_cast<double>(r.written + r.evacuated) / r.written,
+             100.0 * r.overwritten / r.written, 100.0 * r.hits / r.requests);
+      CHECK(r.written > 0);
+      CHECK(r.segments_used > 0);
+    }
+  }
+
+  // Cost of picking the next segment, paid once per segment written.
+  for (int n : {64, 4096, MAX_LOG_SEGMENTS}) {
+    std::vector<VolLogSegment> table(n);
+    std::vector<int64_t> live(n);
+    std::mt19937_64 rng(n);
+    for (int i = 0; i < n; i++) {
+      table[i].seq = rng() % n;
+      live[i]      = rng() % MIN_LOG_SEGMENT_SIZE;
+    }
+    BENCHMARK(std::to_string(n) + " segments victim")
+    {
+      return vol_lseg_victim(table.data(), live.data(), n, 0, MIN_LOG_SEGMENT_SIZE);
+    };
+  }
+}
@@ -0,0 +1,244 @@
+/** @file
+
+  Trace driven hit ratio comparison of the RAM cache algorithms.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+#include "P_RamCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <functional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Synthetic trace: a Zipf distributed popular set mixed with one-hit wonders and periodic scans.
+constexpr int BENCH_OBJECTS     = 200000;
+constexpr int BENCH_REQUESTS    = 2000000;
+constexpr double BENCH_ZIPF     = 0.9;
+constexpr double BENCH_ONE_HIT  = 0.2;
+constexpr int BENCH_SCAN_EVERY  = 100000;
+constexpr int BENCH_SCAN_LENGTH = 10000;
+// Object sizes are drawn from these buffer size indexes, 1KB to 128KB.
+constexpr int BENCH_MIN_INDEX = BUFFER_SIZE_INDEX_1K;
+constexpr int BENCH_MAX_INDEX = BUFFER_SIZE_INDEX_128K;
+
+struct Request {
+  CryptoHash key;
+  uint32_t size;
+  int index;
+};
+
+struct Algorithm {
+  const char *name;
+  RamCache *(*create)();
+};
+
+const Algorithm algorithms[] = {
+  {"LRU", new_RamCacheLRU},
+  {"CLFUS", new_RamCacheCLFUS},
+  {"TinyLFU", new_RamCacheTinyLFU},
+};
+
+CryptoHash
+object_key(uint64_t id)
+{
+  CryptoHash key;
+  key.u64[0] = id * 0x9E3779B97F4A7C15ULL;
+  key.u64[1] = id;
+  return key;
+}
+
+std::vector<Request>
+synthetic_trace()
+{
+  std::mt19937_64 rng(0x5eed);
+  std::vector<double> cdf(BENCH_OBJECTS);
+  std::vector<int> sizes(BENCH_OBJECTS);
+  std::vector<Request> trace;
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  std::uniform_int_distribution<int> size_index(BENCH_MIN_INDEX, BENCH_MAX_INDEX);
+  uint64_t unique = BENCH_OBJECTS;
+  double sum      = 0;
+
+  for (int i = 0; i < BENCH_OBJECTS; ++i) {
+    sum += 1.0 / std::pow(i + 1, BENCH_ZIPF);
+    cdf[i]   = sum;
+    sizes[i] = size_index(rng);
+  }
+  trace.reserve(BENCH_REQUESTS);
+  while (trace.size() < static_cast<size_t>(BENCH_REQUESTS)) {
+    if (trace.size() % BENCH_SCAN_EVERY == BENCH_SCAN_EVERY - 1) {
+      for (int i = 0; i < BENCH_SCAN_LENGTH; ++i, ++unique) {
+        trace.push_back({object_key(unique), static_cast<uint32_t>(BUFFER_SIZE_FOR_INDEX(BENCH_MIN_INDEX)), BENCH_MIN_INDEX});
+      }
+    } else if (uniform(rng) < BENCH_ONE_HIT) {
+      int index = size_index(rng);
+      trace.push_back({object_key(unique++), static_cast<uint32_t>(BUFFER_SIZE_FOR_INDEX(index)), index});
+    } else {
+      int id = std::lower_bound(cdf.begin(), cdf.end(), uniform(rng) * sum) - cdf.begin();
+      id     = std::min(id, BENCH_OBJECTS - 1);
+      trace.push_back({object_key(id), static_cast<uint32_t>(BUFFER_SIZE_FOR_INDEX(sizes[id])), sizes[id]});
+    }
+  }
+  return trace;
+}
+
+// Read a trace of "<key> <size>" lines, one request per line.
+std::vector<Request>
+file_trace(const char *path)
+{
+  std::ifstream in(path);
+  std::vector<Request> trace;
+  std::string line;
+
+  while (std::getline(in, line)) {
+    std::istringstream fields(line);
+    std::string name;
+    uint64_t size = 0;
+    if (!(fields >> name >> size) || size == 0) {
+      continue;
+    }
+    size_t h = std::hash<std::string>{}(name);
+    Request r;
+    r.key.u64[0] = h;
+    r.key.u64[1] = h ^ (name.size() * 0x9E3779B97F4A7C15ULL);
+    r.size       = static_cast<uint32_t>(std::min<uint64_t>(size, BUFFER_SIZE_FOR_INDEX(MAX_BUFFER_SIZE_INDEX)));
+    r.index      = iobuffer_size_to_index(r.size, MAX_BUFFER_SIZE_INDEX);
+    trace.push_back(r);
+  }
+  return trace;
+}
+
+const std::vector<Request> &
+trace()
+{
+  static std::vector<Request> requests;
+  if (requests.empty()) {
+    const char *path = getenv("TS_RAM_CACHE_TRACE");
+    requests         = path ? file_trace(path) : synthetic_trace();
+    REQUIRE(!requests.empty());
+  }
+  return requests;
+}
+
+// One buffer per size class, shared by every put, so the replay measures the RAM cache and not the allocator.
+Ptr<IOBufferData> buffers[MAX_BUFFER_SIZE_INDEX + 1];
+
+Vol *
+make_vol()
+{
+  if (cache_rsb == nullptr) {
+    cache_rsb = RecAllocateRawStatBlock(static_cast<int>(cache_stat_count));
+  }
+  Vol *vol                = new Vol();
+  vol->cache_vol          = new CacheVol();
+  vol->cache_vol->vol_rsb = RecAllocateRawStatBlock(static_cast<int>(cache_stat_count));
+  for (int i = 0; i <= MAX_BUFFER_SIZE_INDEX; ++i) {
+    if (!buffers[i]) {
+      buffers[i] = new_IOBufferData(i, MEMALIGNED);
+    }
+  }
+  return vol;
+}
+
+struct ReplayResult {
+  uint64_t hits        = 0;
+  uint64_t requests    = 0;
+  uint64_t hit_bytes   = 0;
+  uint64_t total_bytes = 0;
+};
+
+// Replay @a requests the way the cache drives the RAM cache, a get followed by a put on a miss.
+ReplayResult
+replay(RamCache *ram_cache, const Request *requests, size_t n)
+{
+  ReplayResult result;
+  Ptr<IOBufferData> data;
+
+  for (size_t i = 0; i < n; ++i) {
+    const Request &r = requests[i];
+    CryptoHash key   = r.key;
+    if (ram_cache->get(&key, &data)) {
+      ++result.hits;
+      result.hit_bytes += r.size;
+    } else {
+      ram_cache->put(&key, buffers[r.index].get(), r.size);
+    }
+    ++result.requests;
+    result.total_bytes += r.size;
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("RAM cache hit ratio", "[cache][ram_cache][benchmark]")
+{
+  const std::vector<Request> &requests = trace();
+  Vol *vol                             = make_vol();
+  uint64_t footprint                   = 0;
+
+  // Size the RAM caches against the bytes of the distinct objects requested.
+  {
+    std::vector<Request> objects(requests);
+    auto by_key = [](const Request &a, const Request &b) { return a.key.u64[0] < b.key.u64[0]; };
+    auto same   = [](const Request &a, const Request &b) { return a.key == b.key; };
+    std::sort(objects.begin(), objects.end(), by_key);
+    objects.erase(std::unique(objects.begin(), objects.end(), same), objects.end());
+    for (auto &r : objects) {
+      footprint += r.size;
+    }
+  }
+  printf("RAM cache trace: %zu requests, %" PRIu64 " bytes of distinct objects\n", requests.size(), footprint);
+
+  for (double fraction : {0.01, 0.05, 0.1}) {
+    int64_t bytes = static_cast<int64_t>(footprint * fraction);
+    for (auto &algorithm : algorithms) {
+      RamCache *ram_cache = algorithm.create();
+      ram_cache->init(bytes, vol);
+      ReplayResult r = replay(ram_cache, requests.data(), requests.size());
+      printf("%-8s %5.1f%% of footprint: %5.2f%% object hits, %5.2f%% byte hits\n", algorithm.name, fraction * 100,
+             100.0 * r.hits / r.requests, 100.0 * r.hit_bytes / r.total_bytes);
+      CHECK(r.hits > 0);
+      delete ram_cache;
+    }
+  }
+
+  // Throughput of the get/put path with the RAM cache at 5% of the footprint.
+  for (auto &algorithm : algorithms) {
+    RamCache *ram_cache = algorithm.create();
+    size_t offset       = 0;
+    size_t n            = std::min<size_t>(10000, requests.size());
+    ram_cache->init(static_cast<int64_t>(footprint * 0.05), vol);
+    BENCHMARK(std::string(algorithm.name) + " 10K requests")
+    {
+      offset = (offset + n) % (requests.size() - n + 1);
+      return replay(ram_cache, requests.data() + offset, n).hits;
+    };
+    delete ram_cache;
+  }
+}
@@ -157,18 +157,19 @@ ts::svtoi(TextView src, TextView *out, int base)
 }
 
 void
-HostStatus::setHostStatus(const char *name, TSHostStatus status, const unsigned int down_time, const unsigned int reason)
+HostStatus::setHostStatus(const std::string_view name, const TSHostStatus status, const unsigned int down_time,
+                          const unsigned int reason)
 {
 }
 
 HostStatRec *
-HostStatus::getHostStatus(const char *name)
+HostStatus::getHostStatus(const std::string_view name)
 {
   return nullptr;
 }
 
 void
-HostStatus::createHostStat(const char *name, const char *data)
+HostStatus::createHostStat(const std::string_view name, const char *data)
 {
 }
 
@@ -270,3 +271,11 @@ INKContInternal::free()
 INKVConnInternal::INKVConnInternal() : INKContInternal() {}
 
 INKVConnInternal::INKVConnInternal(TSEventFunc funcp, TSMutex mutexp) : INKContInternal(funcp, mutexp) {}
+
+void
+api_init()
+{
+}
+
+#include "tscore/I_Version.h"
+AppVersionInfo appVersionInfo;
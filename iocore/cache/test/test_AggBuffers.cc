@@ -0,0 +1,116 @@
+/** @file
+
+  Catch based unit tests for writes queued while every aggregation buffer is being written.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+namespace
+{
+constexpr off_t TEST_VOL_SIZE  = static_cast<off_t>(64) << 20;
+constexpr int TEST_AGG_BUFFERS = 2;
+// Every document fills more than half a buffer, so each one is written as soon as it is copied.
+constexpr int TEST_AGG_SIZE = 4096;
+constexpr int TEST_DOC_SIZE = 3000;
+constexpr int TEST_DOCS     = 6;
+
+// A CacheVC that rewrites @a data to @a vol the way evacuated documents are, it publishes the copy in tierMoveDone().
+CacheVC *
+new_mover(Vol *vol, IOBufferData *data)
+{
+  CacheVC *c      = new_CacheVC(vol);
+  Doc *doc        = reinterpret_cast<Doc *>(data->data());
+  c->buf          = data;
+  c->vol          = vol;
+  c->f.evacuator  = 1;
+  c->first_key    = doc->first_key;
+  c->key          = doc->key;
+  c->earliest_key = zero_key;
+  dir_clear(&c->overwrite_dir);
+  dir_set_head(&c->overwrite_dir, 1);
+  c->first_dir = c->overwrite_dir;
+  SET_CONTINUATION_HANDLER(c, &CacheVC::tierMoveStart);
+  return c;
+}
+
+bool
+probe(Vol *vol, const CryptoHash &key, Dir *dir)
+{
+  Dir *collision = nullptr;
+  return dir_probe(&key, vol, dir, &collision);
+}
+} // namespace
+
+TEST_CASE("agg_todo overflow with every buffer in flight", "[cache][agg]")
+{
+  Vol *vol = make_file_vol(TEST_VOL_SIZE, TEST_AGG_BUFFERS, TEST_AGG_SIZE);
+  REQUIRE(vol->agg_buffer_count == TEST_AGG_BUFFERS);
+
+  CryptoHash keys[TEST_DOCS];
+  Ptr<IOBufferData> docs[TEST_DOCS];
+  int agg_len = 0;
+  for (int i = 0; i < TEST_DOCS; ++i) {
+    keys[i] = random_key();
+    docs[i] = make_doc(keys[i], TEST_DOC_SIZE);
+    agg_len = vol->round_to_approx_size(reinterpret_cast<Doc *>(docs[i]->data())->len);
+  }
+
+  {
+    // aggWriteDone() cannot take the lock, so no write is retired while it is held.
+    SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+    for (int i = 0; i < TEST_DOCS; ++i) {
+      new_mover(vol, docs[i].get())->handleEvent(EVENT_IMMEDIATE, nullptr);
+    }
+
+    // One document written from each buffer, the rest waiting for one of them.
+    CHECK(vol->agg_writes == TEST_AGG_BUFFERS);
+    CHECK(vol->is_io_in_progress());
+    CHECK(vol->agg.head != nullptr);
+    CHECK(vol->agg_todo_size == (TEST_DOCS - TEST_AGG_BUFFERS) * agg_len);
+    CHECK(vol->agg_buf_pos == 0);
+    for (int i = 0; i < TEST_DOCS; ++i) {
+      Dir dir;
+      bool copied = probe(vol, keys[i], &dir);
+      CHECK(copied == (i < TEST_AGG_BUFFERS));
+      // Readers find what is being written in the buffers.
+      if (copied) {
+        Doc *doc = reinterpret_cast<Doc *>(docs[i]->data());
+        char *p  = vol->agg_buf_data(vol->vol_offset(&dir), doc->len);
+        REQUIRE(p != nullptr);
+        CHECK(memcmp(p, doc, doc->len) == 0);
+      }
+    }
+  }
+
+  // Each retired write frees a buffer for the next document in the queue.
+  REQUIRE(wait_for(vol, [&] { return !vol->agg.head && !vol->agg_writes && !vol->agg_buf_pos; }));
+  CHECK(vol->agg_todo_size == 0);
+  CHECK(vol->header->write_pos == vol->start + TEST_DOCS * agg_len);
+  off_t last = 0;
+  for (int i = 0; i < TEST_DOCS; ++i) {
+    Dir dir;
+    REQUIRE(probe(vol, keys[i], &dir));
+    // Written in the order they were queued.
+    CHECK(vol->vol_offset(&dir) > last);
+    last = vol->vol_offset(&dir);
+    CHECK(doc_on_disk(vol, &dir, reinterpret_cast<Doc *>(docs[i]->data())));
+  }
+}
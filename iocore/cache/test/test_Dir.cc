@@ -0,0 +1,460 @@
+/** @file
+
+  Catch based unit tests for the cache directory, on a Vol directory in memory.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+#include <thread>
+
+namespace
+{
+// 1GB volume, a directory of a few segments.
+constexpr off_t TEST_VOL_SIZE = static_cast<off_t>(1) << 30;
+constexpr int TEST_PROBES     = 1 << 14;
+// 8GB volume, a directory of 16 segments.
+constexpr off_t TEST_SYNC_VOL_SIZE = static_cast<off_t>(8) << 30;
+
+// The chain walk of dir_probe(), without any shortcut, collision retry or cleanup.
+int
+walk_chain(const CryptoHash &key, Vol *vol)
+{
+  Dir *seg = vol->dir_segment(key.slice32(0) % vol->segments);
+  Dir *e   = dir_bucket(key.slice32(1) % vol->buckets, seg);
+
+  if (!dir_offset(e)) {
+    return 0;
+  }
+  do {
+    if (dir_offset(e) && dir_tag(e) == DIR_MASK_TAG(key.slice32(2)) &&
+        (!vol->tag_ext || vol->tag_ext[e - vol->dir] == DIR_TAG_EXT(&key))) {
+      return 1;
+    }
+    e = next_dir(e, seg);
+  } while (e);
+  return 0;
+}
+
+int
+probe(const CryptoHash &key, Vol *vol)
+{
+  Dir result;
+  Dir *last_collision = nullptr;
+  return dir_probe(&key, vol, &result, &last_collision);
+}
+
+// A key on the same segment, bucket and tag as @a key and different everywhere else, the wide tag bits included.
+CryptoHash
+same_tag_key(const CryptoHash &key)
+{
+  CryptoHash other = random_key();
+  other.u32[0]     = key.u32[0];
+  other.u32[1]     = key.u32[1];
+  other.u32[2]     = (other.u32[2] & ~DIR_MASK_TAG(~0u)) | DIR_MASK_TAG(key.u32[2]);
+  other.u32[3]     = key.u32[3] ^ 0x10000;
+  return other;
+}
+
+// Insert @a key pointing at block @a offset of the volume, as written in @a phase.
+bool
+insert_at(Vol *vol, const CryptoHash &key, off_t offset, int phase)
+{
+  Dir dir;
+  dir_clear(&dir);
+  dir_set_offset(&dir, offset);
+  dir_set_approx_size(&dir, cache_config_min_average_object_size);
+  dir_set_phase(&dir, phase);
+  dir_set_head(&dir, 1);
+  return dir_insert(&key, vol, &dir);
+}
+
+// Move the write head of @a vol to @a pos, as if everything before it had been written.
+void
+move_write_head(Vol *vol, off_t pos)
+{
+  vol->header->write_pos = pos;
+  vol->header->agg_pos   = pos;
+  vol->agg_buf_pos       = 0;
+}
+
+} // namespace
+
+TEST_CASE("dir_probe", "[cache][dir]")
+{
+  Vol *vol = make_vol(TEST_VOL_SIZE);
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+  // Filled past what the buckets hold, so chains leave their bucket for entries off the freelist.
+  std::vector<CryptoHash> inserted = populate(vol, vol->direntries() * 9 / 10);
+  REQUIRE(!inserted.empty());
+
+  // Later inserts can push earlier entries out of a full segment, so not every key has to hit, but dir_probe() must
+  // agree with the chain on every one of them.
+  int hits = 0, differ = 0;
+  for (const CryptoHash &key : inserted) {
+    int found = probe(key, vol);
+    hits += found;
+    differ += found != walk_chain(key, vol);
+  }
+  CHECK(hits > 0);
+  CHECK(differ == 0);
+
+  differ = 0;
+  for (int i = 0; i < TEST_PROBES; ++i) {
+    CryptoHash key = random_key();
+    differ += probe(key, vol) != walk_chain(key, vol);
+  }
+  CHECK(differ == 0);
+
+  // Any entry carrying the tag makes it a hit, there is nothing else in the entry to tell keys apart.
+  for (int i = 0; i < TEST_PROBES; ++i) {
+    const CryptoHash &key = inserted[i % inserted.size()];
+    if (walk_chain(key, vol)) {
+      REQUIRE(probe(same_tag_key(key), vol) == 1);
+    }
+  }
+}
+
+TEST_CASE("dir_probe wide tags", "[cache][dir]")
+{
+  Vol *vol = make_vol(TEST_VOL_SIZE, true);
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+  REQUIRE(vol->tag_ext);
+
+  std::vector<CryptoHash> inserted = populate(vol, vol->direntries() * 9 / 10);
+  REQUIRE(!inserted.empty());
+
+  int hits = 0, differ = 0;
+  for (const CryptoHash &key : inserted) {
+    int found = probe(key, vol);
+    hits += found;
+    differ += found != walk_chain(key, vol);
+  }
+  CHECK(hits > 0);
+  CHECK(differ == 0);
+
+  // The upper tag bits tell apart keys the directory tag alone would take for the same document.
+  int collisions = 0;
+  for (int i = 0; i < TEST_PROBES; ++i) {
+    const CryptoHash &key = inserted[i % inserted.size()];
+    CryptoHash other      = same_tag_key(key);
+    if (walk_chain(key, vol) && !walk_chain(other, vol)) {
+      collisions += probe(other, vol);
+    }
+  }
+  CHECK(collisions == 0);
+}
+
+TEST_CASE("dir_delete moves the wide tag with the entry", "[cache][dir]")
+{
+  Vol *vol = make_vol(TEST_VOL_SIZE, true);
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+  // Two keys in one bucket: the first in the bucket head, the second chained after it.
+  CryptoHash head = random_key();
+  CryptoHash next = random_key();
+  next.u32[0]     = head.u32[0];
+  next.u32[1]     = head.u32[1];
+  if (DIR_MASK_TAG(next.u32[2]) == DIR_MASK_TAG(head.u32[2])) {
+    next.u32[2] ^= 1;
+  }
+  REQUIRE(insert_key(vol, head));
+  REQUIRE(insert_key(vol, next));
+  REQUIRE(probe(head, vol) == 1);
+  REQUIRE(probe(next, vol) == 1);
+
+  // Deleting the head copies the next entry into the bucket, its upper tag bits have to come along.
+  Dir result;
+  Dir *last_collision = nullptr;
+  REQUIRE(dir_probe(&head, vol, &result, &last_collision));
+  REQUIRE(dir_delete(&head, vol, &result));
+  CHECK(probe(head, vol) == 0);
+  CHECK(probe(next, vol) == 1);
+  CHECK(probe(same_tag_key(next), vol) == 0);
+}
+
+TEST_CASE("dir_probe_unlocked", "[cache][dir]")
+{
+  Vol *vol = make_vol(TEST_VOL_SIZE);
+  std::vector<CryptoHash> inserted;
+  {
+    SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+    inserted = populate(vol, vol->direntries() * 3 / 4);
+  }
+  REQUIRE(!inserted.empty());
+
+  // The unlocked probe may let a miss through, but every key it rules out must also be a miss under the lock.
+  for (int i = 0; i < TEST_PROBES; ++i) {
+    CryptoHash key = random_key();
+    if (!dir_probe_unlocked(&key, vol)) {
+      SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+      REQUIRE(probe(key, vol) == 0);
+    }
+  }
+  for (const CryptoHash &key : inserted) {
+    SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+    if (probe(key, vol)) {
+      REQUIRE(dir_probe_unlocked(&key, vol));
+    }
+  }
+
+  // Readers racing a writer must never miss an entry that is in the directory before and after the race.
+  std::atomic<bool> stop{false};
+  std::thread writer([&]() {
+    EThread *thread = new EThread();
+    thread->set_specific();
+    while (!stop) {
+      SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+      CryptoHash key = random_key();
+      if (insert_key(vol, key)) {
+        Dir result;
+        Dir *last_collision = nullptr;
+        if (dir_probe(&key, vol, &result, &last_collision)) {
+          dir_delete(&key, vol, &result);
+        }
+      }
+    }
+  });
+  std::vector<std::vector<CryptoHash>> lost(4);
+  std::vector<std::thread> readers;
+  for (size_t id = 0; id < lost.size(); ++id) {
+    readers.emplace_back([&, id]() {
+      EThread *thread = new EThread();
+      thread->set_specific();
+      for (int i = 0; i < 4 * TEST_PROBES; ++i) {
+        const CryptoHash &key = inserted[(i + id * 7919) % inserted.size()];
+        if (!dir_probe_unlocked(&key, vol)) {
+          lost[id].push_back(key);
+        }
+      }
+    });
+  }
+  for (auto &t : readers) {
+    t.join();
+  }
+  stop = true;
+  writer.join();
+
+  // The writer can push keys out of a full segment, so only keys still present count.
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+  int missed = 0;
+  for (auto &keys : lost) {
+    for (const CryptoHash &key : keys) {
+      missed += probe(key, vol);
+    }
+  }
+  CHECK(missed == 0);
+}
+
+TEST_CASE("dir sync plan", "[cache][dir]")
+{
+  bool wide_tags  = GENERATE(false, true);
+  Vol *vol        = make_vol(TEST_SYNC_VOL_SIZE, wide_tags);
+  CacheSync *sync = new CacheSync();
+  sync->buf       = static_cast<char *>(ats_memalign(ats_pagesize(), vol->dirlen()));
+  int saved       = cache_config_dir_sync_incremental;
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+  REQUIRE(vol->segments >= 8);
+
+  cache_config_dir_sync_incremental = 1;
+  // Everything starts out dirty for both copies, each copy is cleaned by its own sync.
+  for (int copy = 0; copy < 2; ++copy) {
+    sync->plan(vol, copy);
+    CHECK(sync->segments.size() == static_cast<size_t>(vol->segments));
+    sync->plan(vol, copy);
+    CHECK(sync->segments.empty());
+  }
+
+  // A single insert dirties exactly one segment, for both copies.
+  CryptoHash key = random_key();
+  REQUIRE(insert_key(vol, key));
+  int seg = key.slice32(0) % vol->segments;
+  for (int copy = 0; copy < 2; ++copy) {
+    sync->plan(vol, copy);
+    REQUIRE(sync->segments.size() == 1);
+    CHECK(sync->segments[0] == seg);
+    off_t written = 0;
+    for (auto &r : sync->ranges) {
+      written += r.second - r.first;
+      CHECK(memcmp(sync->buf + r.first, vol->raw_dir + r.first, r.second - r.first) == 0);
+    }
+    CHECK(written < static_cast<off_t>(vol->dirlen() / 4));
+  }
+
+  // The entry and its upper tag bits are both in what gets written.
+  Dir result;
+  Dir *last_collision = nullptr;
+  REQUIRE(dir_probe(&key, vol, &result, &last_collision));
+  Dir *e = last_collision;
+  std::vector<off_t> dirty = {reinterpret_cast<char *>(e) - vol->raw_dir};
+  if (wide_tags) {
+    dirty.push_back(reinterpret_cast<char *>(&vol->tag_ext[e - vol->dir]) - vol->raw_dir);
+  }
+  for (off_t pos : dirty) {
+    bool covered = false;
+    for (auto &r : sync->ranges) {
+      covered = covered || (pos >= r.first && pos < r.second);
+    }
+    CHECK(covered);
+  }
+
+  cache_config_dir_sync_incremental = 0;
+  populate(vol, vol->direntries() / 100);
+  sync->plan(vol, 0);
+  CHECK(sync->segments.size() == static_cast<size_t>(vol->segments));
+  CHECK(memcmp(sync->buf, vol->raw_dir, vol->dirlen()) == 0);
+
+  cache_config_dir_sync_incremental = saved;
+}
+
+TEST_CASE("log segment reopened twice", "[cache][dir]")
+{
+  Vol *vol = make_vol(TEST_VOL_SIZE, false, 0, nullptr, 4);
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+  REQUIRE(vol->lseg_table);
+  move_write_head(vol, vol->lseg_start(0));
+
+  // A document written the last time segment 1 was open, in the middle of it.
+  CryptoHash key = random_key();
+  off_t middle   = vol->lseg_start(1) + vol->lseg_size / 2;
+  int phase      = vol->lseg_table[1].phase;
+  REQUIRE(insert_at(vol, key, vol->offset_to_vol_offset(middle), phase));
+  REQUIRE(probe(key, vol) == 1);
+
+  // Once the segment is opened again the document is valid until the write head gets to it.
+  vol->lseg_open(1);
+  CHECK(probe(key, vol) == 1);
+  move_write_head(vol, vol->lseg_end(1));
+
+  // Opened a second time the segment has the phase of the document again, which must not come back as the write head
+  // passes its offset.
+  vol->lseg_open(2);
+  vol->lseg_open(1);
+  REQUIRE(vol->lseg_table[1].phase == phase);
+  CHECK(walk_chain(key, vol) == 0);
+  move_write_head(vol, middle + CACHE_BLOCK_SIZE);
+  CHECK(probe(key, vol) == 0);
+  vol->lseg_count_live();
+  CHECK(vol->lseg_live[1] == 0);
+}
+
+TEST_CASE("dir filter after churn", "[cache][dir]")
+{
+  bool wide_tags = GENERATE(false, true);
+  Vol *vol       = make_vol(TEST_VOL_SIZE, wide_tags);
+  int saved      = cache_config_dir_filter;
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+
+  // Built on the empty directory, so everything below is tracked by the directory functions.
+  cache_config_dir_filter = 1;
+  dir_filter_build(vol);
+  REQUIRE(vol->dir_filter);
+
+  off_t blocks = (vol->len - (vol->start - vol->skip)) / CACHE_BLOCK_SIZE;
+  auto offset  = [&]() { return 1 + static_cast<off_t>(dir_test_rng() % (blocks - 1)); };
+  // The filter must count every entry a full scan of the directory finds, and match one rebuilt from that scan.
+  auto check = [&]() {
+    DirFilter *kept = vol->dir_filter;
+    for (int s = 0; s < vol->segments; ++s) {
+      Dir *seg = vol->dir_segment(s);
+      for (int64_t b = 0; b < vol->buckets; ++b) {
+        Dir *e = dir_bucket(b, seg);
+        if (!dir_offset(e)) {
+          continue;
+        }
+        for (; e; e = next_dir(e, seg)) {
+          if (dir_offset(e)) {
+            REQUIRE(kept->maybe_contains(s, b, dir_tag(e), wide_tags ? *dir_tag_ext(e, vol) : 0));
+          }
+        }
+      }
+    }
+    // A counter stuck at the maximum may stay above the scan, any other must be equal.
+    vol->dir_filter = nullptr;
+    dir_filter_build(vol);
+    DirFilter *fresh = vol->dir_filter;
+    for (int64_t i = 0; i < vol->segments * kept->seg_words; ++i) {
+      uint64_t k = kept->words[i].load();
+      uint64_t f = fresh->words[i].load();
+      for (int c = 0; c < 64; c += 4) {
+        if (((k >> c) & 0xF) != DIR_FILTER_COUNTER_MAX) {
+          REQUIRE(((k >> c) & 0xF) == ((f >> c) & 0xF));
+        }
+      }
+    }
+    delete fresh;
+    vol->dir_filter = kept;
+  };
+
+  std::vector<CryptoHash> keys = populate(vol, vol->direntries() * 3 / 4);
+  REQUIRE(!keys.empty());
+  check();
+
+  for (int round = 0; round < 4; ++round) {
+    for (int i = 0; i < TEST_PROBES; ++i) {
+      CryptoHash &key = keys[dir_test_rng() % keys.size()];
+      Dir result;
+      dir_clear(&result);
+      Dir *last_collision = nullptr;
+      bool found          = dir_probe(&key, vol, &result, &last_collision);
+      switch (dir_test_rng() % 4) {
+      case 0:
+        // Insert a new key, possibly pushing another out of a full segment.
+        if (insert_key(vol, key = random_key())) {
+          REQUIRE(dir_probe_unlocked(&key, vol));
+        }
+        break;
+      case 1:
+        if (found) {
+          dir_delete(&key, vol, &result);
+        }
+        break;
+      case 2: {
+        // Rewrite the object somewhere else, or insert it if it is gone.
+        Dir dir;
+        dir_clear(&dir);
+        dir_set_offset(&dir, offset());
+        dir_set_approx_size(&dir, cache_config_min_average_object_size);
+        dir_set_phase(&dir, vol->header->phase);
+        dir_set_head(&dir, 1);
+        dir_overwrite(&key, vol, &dir, &result, found);
+        REQUIRE(dir_probe_unlocked(&key, vol));
+        break;
+      }
+      case 3:
+        // Another key of the same bucket and tag takes the entry over, with different wide tag bits.
+        if (found) {
+          CryptoHash other = same_tag_key(key);
+          Dir dir          = result;
+          REQUIRE(dir_overwrite(&other, vol, &dir, &result));
+          REQUIRE(dir_probe_unlocked(&other, vol));
+          key = other;
+        }
+        break;
+      }
+    }
+    check();
+  }
+
+  cache_config_dir_filter = saved;
+  delete vol->dir_filter;
+  vol->dir_filter = nullptr;
+}
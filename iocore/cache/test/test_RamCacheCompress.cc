@@ -0,0 +1,125 @@
+/** @file
+
+  Catch based unit tests for the zstd and LZ4 compression of the CLFUS RAM cache.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr off_t TEST_VOL_SIZE   = static_cast<off_t>(256) << 20;
+constexpr int TEST_OBJECTS      = 64;
+constexpr uint32_t TEST_OBJ_LEN = 8000;
+
+// Text of words picked at random, which compresses well but not to nothing.
+std::string
+make_body()
+{
+  static const char *words[] = {
+    "cache ", "object ", "stripe ", "volume ", "header ", "alternate ", "fragment ", "<div>", "</div>\n",
+  };
+  std::string body;
+  while (body.size() < TEST_OBJ_LEN) {
+    body += words[dir_test_rng() % (sizeof(words) / sizeof(words[0]))];
+  }
+  body.resize(TEST_OBJ_LEN);
+  return body;
+}
+
+/*
+  Put TEST_OBJECTS objects in a CLFUS RAM cache compressing with @a type,
+  compress them, and check that each one reads back as it was put, having
+  been decompressed as @a hit.
+*/
+void
+round_trip(int type, int hit)
+{
+  cache_config_ram_cache_compress         = type;
+  cache_config_ram_cache_compress_percent = 100;
+  cache_config_ram_cache_use_seen_filter  = 0;
+
+  EThread *thread = this_ethread();
+  Vol *vol        = make_vol(TEST_VOL_SIZE);
+  RamCache *rc    = new_RamCacheCLFUS();
+  rc->init(static_cast<int64_t>(64) << 20, vol);
+
+  std::vector<std::pair<CryptoHash, std::string>> objects;
+  {
+    SCOPED_MUTEX_LOCK(lock, vol->mutex, thread);
+    for (int i = 0; i < TEST_OBJECTS; ++i) {
+      objects.emplace_back(random_key(), make_body());
+      Ptr<IOBufferData> data = make_ptr(new_IOBufferData(BUFFER_SIZE_INDEX_8K, MEMALIGNED));
+      memcpy(data->data(), objects.back().second.data(), TEST_OBJ_LEN);
+      REQUIRE(rc->put(&objects.back().first, data.get(), TEST_OBJ_LEN, false, i));
+    }
+  }
+  int64_t before = rc->size();
+  compress_RamCacheCLFUS(rc, thread);
+  CHECK(rc->size() < before);
+
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, thread);
+  for (int i = 0; i < TEST_OBJECTS; ++i) {
+    Ptr<IOBufferData> data;
+    CHECK(rc->get(&objects[i].first, &data, i) == hit);
+    REQUIRE(data);
+    CHECK(std::string(data->data(), TEST_OBJ_LEN) == objects[i].second);
+  }
+}
+} // namespace
+
+TEST_CASE("RAM cache compression", "[cache][ram_cache]")
+{
+  SECTION("zstd")
+  {
+#ifdef HAVE_ZSTD_H
+    cache_config_ram_cache_compress_dict_size = 0;
+    round_trip(CACHE_COMPRESSION_ZSTD, RAM_HIT_COMPRESS_ZSTD);
+#else
+    WARN("built without zstd, skipped");
+#endif
+  }
+
+  SECTION("zstd with a dictionary")
+  {
+#ifdef HAVE_ZSTD_H
+    // Trained on the first objects compressed, the rest are compressed with it.
+    cache_config_ram_cache_compress_dict_size = 1024;
+    round_trip(CACHE_COMPRESSION_ZSTD, RAM_HIT_COMPRESS_ZSTD);
+    cache_config_ram_cache_compress_dict_size = 0;
+#else
+    WARN("built without zstd, skipped");
+#endif
+  }
+
+  SECTION("LZ4")
+  {
+#ifdef HAVE_LZ4_H
+    round_trip(CACHE_COMPRESSION_LZ4, RAM_HIT_COMPRESS_LZ4);
+#else
+    WARN("built without lz4, skipped");
+#endif
+  }
+
+  cache_config_ram_cache_compress = CACHE_COMPRESSION_NONE;
+}
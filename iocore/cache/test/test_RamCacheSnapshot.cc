@@ -0,0 +1,104 @@
+/** @file
+
+  Catch based unit tests for the file format of the RAM cache snapshot.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+#include <unistd.h>
+
+namespace
+{
+// The sizes of the file header and of the header of each stripe.
+constexpr long SNAPSHOT_HEADER_SIZE     = 16;
+constexpr long SNAPSHOT_VOL_HEADER_SIZE = sizeof(CryptoHash) + sizeof(uint64_t);
+
+// A stripe's part of a snapshot, with @a n entries that differ in every field.
+RamCacheSnapshotVol
+make_snapshot_vol(int n)
+{
+  RamCacheSnapshotVol vol(random_key(), std::vector<RamCacheSnapshotEntry>(n));
+  for (int i = 0; i < n; ++i) {
+    vol.second[i] = {random_key(), dir_test_rng(), static_cast<uint32_t>(i * 3 + 1), static_cast<uint32_t>(i * 512)};
+  }
+  return vol;
+}
+
+bool
+same_snapshot(const std::vector<RamCacheSnapshotVol> &a, const std::vector<RamCacheSnapshotVol> &b)
+{
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (!(a[i].first == b[i].first) || a[i].second.size() != b[i].second.size() ||
+        memcmp(a[i].second.data(), b[i].second.data(), a[i].second.size() * sizeof(RamCacheSnapshotEntry)) != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+TEST_CASE("RAM cache snapshot", "[cache][ram_cache]")
+{
+  char dir[] = "/tmp/test_RamCacheSnapshot.XXXXXX";
+  REQUIRE(mkdtemp(dir) != nullptr);
+  std::string path = std::string(dir) + "/ram_cache.snapshot";
+
+  std::vector<RamCacheSnapshotVol> saved = {make_snapshot_vol(1000), make_snapshot_vol(0), make_snapshot_vol(17)};
+  REQUIRE(ram_cache_snapshot_save(path, saved));
+  std::vector<RamCacheSnapshotVol> loaded;
+
+  SECTION("round trip")
+  {
+    CHECK(ram_cache_snapshot_read(path, loaded));
+    CHECK(same_snapshot(saved, loaded));
+    // Nothing is left behind from the write.
+    CHECK(access((path + ".tmp").c_str(), F_OK) != 0);
+  }
+
+  SECTION("truncated")
+  {
+    // One entry short of the first stripe.
+    REQUIRE(truncate(path.c_str(), SNAPSHOT_HEADER_SIZE + SNAPSHOT_VOL_HEADER_SIZE + 999 * sizeof(RamCacheSnapshotEntry)) == 0);
+    CHECK(!ram_cache_snapshot_read(path, loaded));
+    CHECK(loaded.empty());
+  }
+
+  SECTION("count past the end of the file")
+  {
+    // The count of the first stripe, just after its hash, as if it were corrupted.
+    FILE *f        = fopen(path.c_str(), "r+");
+    uint64_t count = UINT64_MAX / sizeof(RamCacheSnapshotEntry);
+    REQUIRE(f != nullptr);
+    REQUIRE(fseek(f, SNAPSHOT_HEADER_SIZE + sizeof(CryptoHash), SEEK_SET) == 0);
+    REQUIRE(fwrite(&count, sizeof(count), 1, f) == 1);
+    fclose(f);
+    CHECK(!ram_cache_snapshot_read(path, loaded));
+    CHECK(loaded.empty());
+  }
+
+  SECTION("missing") { CHECK(!ram_cache_snapshot_read(path + ".missing", loaded)); }
+
+  unlink(path.c_str());
+  rmdir(dir);
+}
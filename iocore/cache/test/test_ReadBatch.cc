@@ -0,0 +1,138 @@
+/** @file
+
+  Batched cache reads: hits and misses in one call, each called back on its own.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "main.h"
+
+#define SMALL_FILE 10 * 1024
+#define LARGE_FILE 3 * 1024 * 1024
+
+namespace
+{
+const char *const HIT_URLS[] = {"http://www.scw00.com/", "http://www.scw11.com/", "http://www.scw22.com/"};
+const char *const MISS_URL   = "http://www.scw33.com/";
+constexpr int N_HITS         = sizeof(HIT_URLS) / sizeof(HIT_URLS[0]);
+constexpr int N_KEYS         = N_HITS + 1;
+
+class ReadBatchTest;
+
+// Called back for one key of the batch.
+struct KeyCont : public Continuation {
+  KeyCont(ReadBatchTest *t, Ptr<ProxyMutex> &m, int i) : Continuation(m), test(t), index(i)
+  {
+    SET_HANDLER(&KeyCont::event_handler);
+  }
+
+  int event_handler(int event, void *e);
+
+  ReadBatchTest *test;
+  int index;
+  int event = 0;
+};
+
+class ReadBatchTest : public TestContChain
+{
+public:
+  ReadBatchTest() { SET_HANDLER(&ReadBatchTest::start_test); }
+
+  int
+  start_test(int /* event ATS_UNUSED */, void * /* e ATS_UNUSED */)
+  {
+    CacheReadRequest reqs[N_KEYS];
+
+    for (int i = 0; i < N_KEYS; i++) {
+      infos[i].create();
+      build_hdrs(infos[i], i < N_HITS ? HIT_URLS[i] : MISS_URL);
+      keys[i] = generate_key(infos[i]);
+
+      conts[i]         = new KeyCont(this, this->mutex, i);
+      reqs[i].cont     = conts[i];
+      reqs[i].key      = &keys[i].hash;
+      reqs[i].hostname = keys[i].hostname;
+      reqs[i].host_len = keys[i].hostlen;
+    }
+    // This may be the last thing done, all of the callbacks can be made before it returns.
+    cacheProcessor.open_read_batch(reqs, N_KEYS, CACHE_FRAG_TYPE_HTTP);
+    return 0;
+  }
+
+  void
+  key_done()
+  {
+    if (++done < N_KEYS) {
+      return;
+    }
+    for (int i = 0; i < N_KEYS; i++) {
+      CHECK(conts[i]->event == (i < N_HITS ? CACHE_EVENT_OPEN_READ : CACHE_EVENT_OPEN_READ_FAILED));
+      delete conts[i];
+      infos[i].destroy();
+    }
+    delete this;
+  }
+
+  HTTPInfo infos[N_KEYS];
+  HttpCacheKey keys[N_KEYS];
+  KeyCont *conts[N_KEYS] = {nullptr};
+  int done               = 0;
+};
+
+int
+KeyCont::event_handler(int e, void *data)
+{
+  REQUIRE(event == 0);
+  event = e;
+  if (e == CACHE_EVENT_OPEN_READ) {
+    CacheVC *vc = static_cast<CacheVC *>(data);
+    CHECK(vc->get_object_size() == (index == 1 ? LARGE_FILE : SMALL_FILE));
+    vc->do_io_close();
+  }
+  test->key_done();
+  return 0;
+}
+
+class CacheCommInit : public CacheInit
+{
+public:
+  CacheCommInit() {}
+  int
+  cache_init_success_callback(int event, void *e) override
+  {
+    CacheTestHandler *h = new CacheTestHandler(SMALL_FILE, HIT_URLS[0]);
+    h->add(new CacheTestHandler(LARGE_FILE, HIT_URLS[1]));
+    h->add(new CacheTestHandler(SMALL_FILE, HIT_URLS[2]));
+    h->add(new ReadBatchTest);
+    h->add(new TerminalTest);
+    this_ethread()->schedule_imm(h);
+    delete this;
+    return 0;
+  }
+};
+} // namespace
+
+TEST_CASE("cache read batch", "cache")
+{
+  init_cache(256 * 1024 * 1024);
+  CacheCommInit *init = new CacheCommInit;
+
+  this_ethread()->schedule_imm(init);
+  this_thread()->execute();
+}
@@ -0,0 +1,128 @@
+/** @file
+
+  Catch based unit tests for the promotion of objects to the fast tier, and their demotion back.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+extern Queue<CacheVol> cp_list;
+extern int cp_list_len;
+
+namespace
+{
+constexpr off_t TEST_VOL_SIZE = static_cast<off_t>(64) << 20;
+// Small enough that every copy is written as soon as it is in the aggregation buffer.
+constexpr int TEST_AGG_SIZE = 4096;
+constexpr int TEST_DOC_SIZE = 3000;
+constexpr int TEST_OFFSET   = 1000;
+
+// Add @a vol to the volumes of volume.config, as the only stripe of its volume.
+void
+add_volume(Vol *vol, bool fast)
+{
+  CacheVol *cp  = vol->cache_vol;
+  cp->scheme    = CACHE_HTTP_TYPE;
+  cp->fast_tier = fast;
+  cp->num_vols  = 1;
+  cp->vols      = static_cast<Vol **>(ats_malloc(sizeof(Vol *)));
+  cp->vols[0]   = vol;
+  cp_list.enqueue(cp);
+  cp_list_len++;
+  vol->cache = theCache;
+}
+
+bool
+probe(Vol *vol, const CryptoHash &key, Dir *dir)
+{
+  Dir *collision = nullptr;
+  return dir_probe(&key, vol, dir, &collision);
+}
+} // namespace
+
+TEST_CASE("tier promotion and demotion", "[cache][tier]")
+{
+  theCache  = new Cache();
+  Vol *slow = make_file_vol(TEST_VOL_SIZE, 1, TEST_AGG_SIZE);
+  Vol *fast = make_file_vol(TEST_VOL_SIZE, 1, TEST_AGG_SIZE);
+  add_volume(slow, false);
+  add_volume(fast, true);
+  // No hosting.config here, every key goes to the generic volume.
+  theCache->hosttable = new CacheHostTable(theCache, CACHE_HTTP_TYPE);
+
+  CryptoHash key         = random_key();
+  Ptr<IOBufferData> data = make_doc(key, TEST_DOC_SIZE);
+  Doc *doc               = reinterpret_cast<Doc *>(data->data());
+  REQUIRE(theCache->key_to_vol(&key, nullptr, 0) == slow);
+  REQUIRE(theCache->key_to_tier_vol(&key) == fast);
+
+  // The object as a read found it on the slow tier.
+  Dir sdir;
+  dir_clear(&sdir);
+  dir_set_offset(&sdir, TEST_OFFSET);
+  dir_set_approx_size(&sdir, slow->round_to_approx_size(doc->len));
+  dir_set_head(&sdir, 1);
+  // Written in the last cycle, ahead of the write head.
+  dir_set_phase(&sdir, !slow->header->phase);
+  {
+    SCOPED_MUTEX_LOCK(lock, slow->mutex, this_ethread());
+    REQUIRE(dir_insert(&key, slow, &sdir));
+    REQUIRE(probe(slow, key, &sdir));
+  }
+
+  cache_config_tier_promote_hits = 2;
+  for (int hit = 1; hit <= cache_config_tier_promote_hits; ++hit) {
+    SCOPED_MUTEX_LOCK(lock, slow->mutex, this_ethread());
+    CacheVC *vc           = new_CacheVC(slow);
+    vc->vol               = slow;
+    vc->first_key         = key;
+    vc->frag_type         = CACHE_FRAG_TYPE_NONE;
+    vc->f.single_fragment = 1;
+    vc->dir               = sdir;
+    tier_read_done(vc, doc);
+    free_CacheVC(vc);
+  }
+
+  // Promoted on the last read, into the fast tier and on its disk.
+  Dir fdir;
+  REQUIRE(wait_for(fast, [&] { return probe(fast, key, &fdir) && !fast->agg_writes && !fast->agg_buf_pos; }));
+  CHECK(dir_head(&fdir));
+  CHECK(doc_on_disk(fast, &fdir, doc));
+  CHECK(tier_read_vol(&key, slow) == fast);
+
+  // Evicted from the fast tier once the slow tier lost it, what evacuateDocReadDone() does with the head about to be
+  // overwritten writes it back.
+  {
+    SCOPED_MUTEX_LOCK(lock, slow->mutex, this_ethread());
+    dir_delete(&key, slow, &sdir);
+    REQUIRE(!probe(slow, key, &sdir));
+  }
+  {
+    SCOPED_MUTEX_LOCK(lock, fast->mutex, this_ethread());
+    CacheVC *ev = new_DocEvacuator(doc->len, fast);
+    REQUIRE(pread(fast->fd, ev->buf->data(), doc->len, fast->vol_offset(&fdir)) == static_cast<ssize_t>(doc->len));
+    tier_demote(fast, ev, &fdir);
+    free_CacheVC(ev);
+  }
+  REQUIRE(wait_for(slow, [&] { return probe(slow, key, &sdir) && !slow->agg_writes && !slow->agg_buf_pos; }));
+  CHECK(dir_head(&sdir));
+  CHECK(dir_offset(&sdir) != TEST_OFFSET);
+  CHECK(doc_on_disk(slow, &sdir, doc));
+}
@@ -0,0 +1,81 @@
+/** @file
+
+  Catch based unit tests for stripes that finish initializing, or fail to.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+namespace
+{
+constexpr off_t TEST_VOL_SIZE = static_cast<off_t>(256) << 20;
+
+// A stripe on a span of its own, with its directory read as far as dir_init_done().
+Vol *
+make_stripe(Cache *cache, const char *name)
+{
+  Vol *vol       = make_vol(TEST_VOL_SIZE);
+  vol->cache     = cache;
+  vol->hash_text = ats_strdup(name);
+  vol->disk      = new CacheDisk();
+  vol->disk->fd  = 1000;
+  vol->fd        = vol->disk->fd;
+  return vol;
+}
+} // namespace
+
+TEST_CASE("stripe that fails to initialize", "[cache][init]")
+{
+  theCache                  = new Cache();
+  theCache->cache_read_done = 1;
+  // Neither stripe is the last one, the cache does not open here.
+  theCache->total_nvol = 3;
+  gvol                 = static_cast<Vol **>(ats_calloc(theCache->total_nvol, sizeof(Vol *)));
+  gnvol                = 0;
+
+  Vol *good = make_stripe(theCache, "good");
+  Vol *bad  = make_stripe(theCache, "bad");
+  // What handle_dir_clear() leaves when it could not write the directory.
+  bad->fd = -1;
+
+  SECTION("before the cache opens")
+  {
+    CacheProcessor::initialized = CACHE_INITIALIZING;
+    good->dir_init_done(EVENT_IMMEDIATE, nullptr);
+    bad->dir_init_done(EVENT_IMMEDIATE, nullptr);
+  }
+  SECTION("after the cache opened")
+  {
+    CacheProcessor::initialized = CACHE_INITIALIZED;
+    bad->dir_init_done(EVENT_IMMEDIATE, nullptr);
+    CacheProcessor::initialized = CACHE_INITIALIZING;
+    good->dir_init_done(EVENT_IMMEDIATE, nullptr);
+  }
+
+  // The failed stripe is accounted for, and its span is out of service, so it is not in the volume hash tables.
+  CHECK(gnvol == 2);
+  CHECK(theCache->total_initialized_vol == 2);
+  CHECK(theCache->total_good_nvol == 1);
+  CHECK(DISK_BAD(bad->disk));
+  CHECK(!bad->disk->online);
+  CHECK(!bad->ready);
+  CHECK(!DISK_BAD(good->disk));
+  CHECK(good->disk->online);
+}
@@ -0,0 +1,179 @@
+/** @file
+
+  Catch based unit tests for the read latency of cache disks, and the writes turned away while it is too high.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "DirTest.h"
+
+namespace
+{
+constexpr off_t TEST_VOL_SIZE = static_cast<off_t>(64) << 20;
+constexpr int TEST_READ_P99   = 50; // ms
+
+// Complete @a n reads of @a latency each.
+void
+reads(CacheDiskLoad &load, int n, ink_hrtime latency)
+{
+  for (int i = 0; i < n; ++i) {
+    load.read_start();
+    load.read_done(latency);
+  }
+}
+
+// Complete reads of @a latency on the disk of @a vol, its next check closes the window on them.
+void
+window(Vol *vol, ink_hrtime latency)
+{
+  reads(vol->disk->load, 100, latency);
+  vol->disk->load.window_start = Thread::get_hrtime_updated() - HRTIME_MSECONDS(cache_config_write_throttle_interval);
+}
+
+CacheVC *
+new_writer(Vol *vol, const CryptoHash &key)
+{
+  CacheVC *c   = new_CacheVC(vol);
+  c->vol       = vol;
+  c->first_key = key;
+  return c;
+}
+
+// What Vol::admit_write() says about a new write of @a key.
+int
+admit(Vol *vol, const CryptoHash &key, bool update = false)
+{
+  SCOPED_MUTEX_LOCK(lock, vol->mutex, this_ethread());
+  CacheVC *c  = new_writer(vol, key);
+  c->f.update = update;
+  int err     = vol->admit_write(c);
+  free_CacheVC(c);
+  return err;
+}
+} // namespace
+
+TEST_CASE("CacheDiskLoad buckets", "[cache][throttle]")
+{
+  // Each bucket is at most a quarter wider than the latencies it holds.
+  for (ink_hrtime us : {1, 3, 4, 7, 100, 999, 1000, 1024, 50000, 1000000}) {
+    ink_hrtime latency = HRTIME_USECONDS(us);
+    ink_hrtime limit   = CacheDiskLoad::bucket_limit(CacheDiskLoad::bucket(latency));
+    CHECK(limit > latency);
+    CHECK(limit <= latency + latency / 4 + HRTIME_USECOND);
+  }
+  // Longer than the last bucket goes into it.
+  CHECK(CacheDiskLoad::bucket(HRTIME_SECONDS(3600)) == DISK_LOAD_BUCKETS - 1);
+  CHECK(CacheDiskLoad::bucket(0) == 0);
+}
+
+TEST_CASE("CacheDiskLoad p99", "[cache][throttle]")
+{
+  cache_config_write_throttle_interval    = 1000;
+  cache_config_write_throttle_read_p99    = TEST_READ_P99;
+  cache_config_write_throttle_queue_depth = 0;
+
+  CacheDiskLoad load;
+  ink_hrtime fast = HRTIME_MSECONDS(1);
+  ink_hrtime slow = HRTIME_MSECONDS(100);
+  ink_hrtime now  = HRTIME_SECONDS(100);
+
+  // 1% of slow reads is still under the p99.
+  reads(load, 990, fast);
+  reads(load, 10, slow);
+  CHECK(load.reads.load() == 0);
+  CHECK(!load.roll(now));
+  CHECK(load.read_p99.load() == CacheDiskLoad::bucket_limit(CacheDiskLoad::bucket(fast)));
+  CHECK(!load.slow);
+  CHECK(!load.overloaded());
+
+  // Not before the window is over.
+  reads(load, 980, fast);
+  reads(load, 20, slow);
+  CHECK(!load.roll(now + HRTIME_MSECONDS(500)));
+  CHECK(!load.slow);
+
+  // 2% is above it.
+  CHECK(load.roll(now + HRTIME_SECONDS(1)));
+  CHECK(load.read_p99.load() == CacheDiskLoad::bucket_limit(CacheDiskLoad::bucket(slow)));
+  CHECK(load.slow);
+  CHECK(load.overloaded());
+
+  // Still slow, no change to report.
+  reads(load, 100, slow);
+  CHECK(!load.roll(now + HRTIME_SECONDS(2)));
+  CHECK(load.slow);
+
+  // Recovered.
+  reads(load, 1000, fast);
+  CHECK(load.roll(now + HRTIME_SECONDS(3)));
+  CHECK(load.read_p99.load() == CacheDiskLoad::bucket_limit(CacheDiskLoad::bucket(fast)));
+  CHECK(!load.slow);
+  CHECK(!load.overloaded());
+
+  // Too many requests in flight is overloaded whatever the latency.
+  cache_config_write_throttle_queue_depth = 4;
+  for (int i = 0; i < 3; ++i) {
+    load.read_start();
+  }
+  load.write_start();
+  CHECK(!load.overloaded());
+  load.write_start();
+  CHECK(load.overloaded());
+  load.write_done();
+  CHECK(!load.overloaded());
+  cache_config_write_throttle_queue_depth = 0;
+}
+
+TEST_CASE("Vol::admit_write", "[cache][throttle]")
+{
+  cache_config_write_throttle             = 1;
+  cache_config_write_throttle_read_p99    = TEST_READ_P99;
+  cache_config_write_throttle_interval    = 1000;
+  cache_config_write_throttle_queue_depth = 0;
+
+  Vol *vol        = make_vol(TEST_VOL_SIZE);
+  vol->disk       = new CacheDisk();
+  vol->disk->path = ats_strdup("test");
+  CryptoHash a    = random_key();
+  CryptoHash b    = random_key();
+
+  // Under the target, everything is written.
+  window(vol, HRTIME_MSECONDS(TEST_READ_P99 / 2));
+  CHECK(admit(vol, a) == 0);
+  CHECK(!vol->disk->load.slow);
+
+  // Above it, a new object is turned away the first time and written when asked for again.
+  window(vol, HRTIME_MSECONDS(TEST_READ_P99 * 2));
+  CHECK(admit(vol, b) == ECACHE_WRITE_FAIL);
+  CHECK(vol->disk->load.slow);
+  CHECK(admit(vol, b) == 0);
+  CHECK(admit(vol, a) == ECACHE_WRITE_FAIL);
+  // Updates always go through.
+  CHECK(admit(vol, random_key(), true) == 0);
+
+  // Back under the target, a new object is written the first time.
+  window(vol, HRTIME_MSECONDS(TEST_READ_P99 / 2));
+  CHECK(admit(vol, random_key()) == 0);
+  CHECK(!vol->disk->load.slow);
+
+  // Nothing is turned away with throttling off.
+  window(vol, HRTIME_MSECONDS(TEST_READ_P99 * 2));
+  cache_config_write_throttle = 0;
+  CHECK(admit(vol, random_key()) == 0);
+}
@@ -122,7 +122,7 @@ MIOBuffer::write(IOBufferBlock const *b, int64_t alen, int64_t offset)
       bytes = len;
     }
     IOBufferBlock *bb = b->clone();
-    bb->_start += offset;
+    bb->consume(offset);
     bb->_buf_end = bb->_end = bb->_start + bytes;
     append_block(bb);
     offset = 0;
@@ -28,8 +28,9 @@
 #include "tscore/ink_rand.h"
 #include "tscore/I_Version.h"
 #include "I_Thread.h"
-#include "I_PriorityEventQueue.h"
+#include "I_TimerWheel.h"
 #include "I_ProtectedQueue.h"
+#include "I_TaskPool.h"
 
 // TODO: This would be much nicer to have "run-time" configurable (or something),
 // perhaps based on proxy.config.stat_api.max_stats_allowed or other configs. XXX
@@ -315,7 +316,9 @@ public:
   Que(Continuation, link) aio_ops;
 
   ProtectedQueue EventQueueExternal;
-  PriorityEventQueue EventQueue;
+  TimerWheel EventQueue;
+  /// Immediate events shared with the other threads of the group, if it is a task pool.
+  TaskPool *task_pool = nullptr;
 
   static constexpr int NO_ETHREAD_ID = -1;
   int id                             = NO_ETHREAD_ID;
@@ -355,34 +358,21 @@ public:
 
   /** Default handler used until it is overridden.
 
-      This uses the cond var wait in @a ExternalQueue.
+      This blocks in poll() on the event fd (or pipe) of the thread, which is what
+      @c signalActivity writes to.
   */
   class DefaultTailHandler : public LoopTailHandler
   {
     // cppcheck-suppress noExplicitConstructor; allow implicit conversion
-    DefaultTailHandler(ProtectedQueue &q) : _q(q) {}
-
-    int
-    waitForActivity(ink_hrtime timeout) override
-    {
-      _q.wait(Thread::get_hrtime() + timeout);
-      return 0;
-    }
-    void
-    signalActivity() override
-    {
-      /* Try to acquire the `EThread::lock` of the Event Thread:
-       *   - Acquired, indicating that the Event Thread is sleep,
-       *               must send a wakeup signal to the Event Thread.
-       *   - Failed, indicating that the Event Thread is busy, do nothing.
-       */
-      (void)_q.try_signal();
-    }
-
-    ProtectedQueue &_q;
+    DefaultTailHandler(EThread &t) : _t(t) {}
+
+    int waitForActivity(ink_hrtime timeout) override;
+    void signalActivity() override;
+
+    EThread &_t;
 
     friend class EThread;
-  } DEFAULT_TAIL_HANDLER = EventQueueExternal;
+  } DEFAULT_TAIL_HANDLER = *this;
 
   /// Statistics data for event dispatching.
   struct EventMetrics {
@@ -401,8 +391,17 @@ public:
       Events() {}
     } _events;
 
-    int _count = 0; ///< # of times the loop executed.
-    int _wait  = 0; ///< # of timed wait for events
+    /// Events scheduled from other threads, and how long they waited in the external queue.
+    struct Enqueue {
+      ink_hrtime _total = 0; ///< Sum of the waits.
+      ink_hrtime _max   = 0; ///< Longest wait.
+      int _count        = 0; ///< # of events.
+      Enqueue() {}
+    } _enqueue;
+
+    int _count   = 0; ///< # of times the loop executed.
+    int _wait    = 0; ///< # of timed wait for events
+    int _wakeups = 0; ///< # of waits cut short by another thread scheduling an event.
 
     /// Add @a that to @a this data.
     /// This embodies the custom logic per member concerning whether each is a sum, min, or max.
@@ -426,14 +425,18 @@ public:
       More than one part of the code depends on this exact order. Be careful and thorough when changing.
   */
   enum STAT_ID {
-    STAT_LOOP_COUNT,      ///< # of event loops executed.
-    STAT_LOOP_EVENTS,     ///< # of events
-    STAT_LOOP_EVENTS_MIN, ///< min # of events dispatched in a loop
-    STAT_LOOP_EVENTS_MAX, ///< max # of events dispatched in a loop
-    STAT_LOOP_WAIT,       ///< # of loops that did a conditional wait.
-    STAT_LOOP_TIME_MIN,   ///< Shortest time spent in loop.
-    STAT_LOOP_TIME_MAX,   ///< Longest time spent in loop.
-    N_EVENT_STATS         ///< NOT A VALID STAT INDEX - # of different stat types.
+    STAT_LOOP_COUNT,       ///< # of event loops executed.
+    STAT_LOOP_EVENTS,      ///< # of events
+    STAT_LOOP_EVENTS_MIN,  ///< min # of events dispatched in a loop
+    STAT_LOOP_EVENTS_MAX,  ///< max # of events dispatched in a loop
+    STAT_LOOP_WAIT,        ///< # of loops that did a conditional wait.
+    STAT_LOOP_TIME_MIN,    ///< Shortest time spent in loop.
+    STAT_LOOP_TIME_MAX,    ///< Longest time spent in loop.
+    STAT_ENQUEUE_COUNT,    ///< # of events scheduled from other threads.
+    STAT_ENQUEUE_TIME,     ///< Average time those events waited in the external queue.
+    STAT_ENQUEUE_TIME_MAX, ///< Longest time one of them waited.
+    STAT_LOOP_WAKEUPS,     ///< # of waits ended by another thread.
+    N_EVENT_STATS          ///< NOT A VALID STAT INDEX - # of different stat types.
   };
 
   static char const *const STAT_NAME[N_EVENT_STATS];
@@ -208,7 +208,7 @@ public:
   unsigned int in_the_priority_queue : 1;
   unsigned int immediate : 1;
   unsigned int globally_allocated : 1;
-  unsigned int in_heap : 4;
+  unsigned int in_heap : 12; // list of the TimerWheel holding the event
   int callback_event = 0;
 
   ink_hrtime timeout_at = 0;
@@ -228,6 +228,9 @@ public:
 
   Event *init(Continuation *c, ink_hrtime atimeout_at = 0, ink_hrtime aperiod = 0);
 
+  /// When the event was put on the external queue of @a ethread, 0 if it was queued locally.
+  ink_hrtime enqueue_time = 0;
+
 #ifdef ENABLE_TIME_TRACE
   ink_hrtime start_time;
 #endif
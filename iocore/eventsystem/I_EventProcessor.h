@@ -131,6 +131,18 @@ public:
   /// This registers @a name as an event type using @c registerEventType and then calls the real @c spawn_event_threads
   EventType spawn_event_threads(const char *name, int n_thread, size_t stacksize = DEFAULT_STACKSIZE);
 
+  /** Spawn a group of @a n_threads event dispatching threads which share their immediate events.
+
+      The group works as one from @c spawn_event_threads, except that immediate events scheduled on it
+      wait in per thread deques which idle threads of the group steal from. Scheduling on the group does
+      not give a continuation an affinity for the thread picked, one it already has keeps its events on
+      that thread.
+      @see TaskPool
+
+      @return EventType for the new group of threads (@a ev_type)
+   */
+  EventType spawn_task_pool(EventType ev_type, int n_threads, size_t stacksize = DEFAULT_STACKSIZE);
+
   /**
     Schedules the continuation on a specific EThread to receive an event
     at the given timeout.  Requests the EventProcessor to schedule
@@ -295,6 +307,7 @@ public:
     Que(Event, link) _spawnQueue;                    ///< Events to dispatch when thread is spawned.
     EThread *_thread[MAX_THREADS_IN_EACH_TYPE] = {}; ///< The actual threads in this group.
     std::function<void()> _afterStartCallback  = nullptr;
+    TaskPool *_pool                            = nullptr; ///< Shared immediate events, if spawned as a task pool.
   };
 
   /// Storage for per group data.
@@ -37,8 +37,10 @@
 
 #include "I_Lock.h"
 #include "I_PriorityEventQueue.h"
+#include "I_TimerWheel.h"
 #include "I_Processor.h"
 #include "I_ProtectedQueue.h"
+#include "I_TaskPool.h"
 #include "I_Thread.h"
 #include "I_VIO.h"
 #include "I_VConnection.h"
@@ -114,6 +114,32 @@ extern Allocator ioBufAllocator[DEFAULT_BUFFER_SIZES];
 
 void init_buffer_allocators(int iobuffer_advice);
 
+/**
+  A file that the bytes of an IOBufferData are in, instead of memory.
+
+  Blocks of such data are written to a socket straight from the file, with
+  sendfile(2), and have no memory behind them. They are only put in buffers
+  whose readers all know to do that, see @c MIOBuffer::file_blocks.
+
+*/
+class IOBufferFile : public RefCountObj
+{
+public:
+  /**
+    Whether the @a len bytes at @a offset in the file are still the ones
+    the block was made for. Checked right before they are sent, the block
+    cannot be sent at all if they have been overwritten since.
+
+  */
+  virtual bool
+  stable(off_t /* offset ATS_UNUSED */, int64_t /* len ATS_UNUSED */)
+  {
+    return true;
+  }
+
+  int fd = -1;
+};
+
 /**
   A reference counted wrapper around fast allocated or malloced memory.
   The IOBufferData class provides two basic services around a portion
@@ -226,6 +252,21 @@ public:
 
   const char *_location = nullptr;
 
+  /**
+    File the data is in when it is not in memory, and the offset in the
+    file of its first byte. Set by new_file_IOBufferData, '_data' is null.
+
+  */
+  Ptr<IOBufferFile> _file;
+  off_t _file_offset = 0;
+
+  /**
+    The memory is not written to any more for as long as it is referenced,
+    so a socket write may leave it to the kernel to copy it out later.
+
+  */
+  bool _immutable = false;
+
   /**
     Constructor. Initializes state for a IOBufferData object. Do not use
     this method. Use one of the functions with the 'new_' prefix instead.
@@ -301,6 +342,28 @@ public:
     return _buf_end;
   }
 
+  /**
+    The file the inuse area is in, if it is not in memory.
+
+    @return the file of the underlying IOBufferData or nullptr.
+
+  */
+  IOBufferFile *
+  file() const
+  {
+    return data->_file.get();
+  }
+
+  /**
+    Offset in file() of the start of the inuse area.
+
+  */
+  off_t
+  file_offset() const
+  {
+    return _file_offset;
+  }
+
   /**
     Size of the inuse area. Returns the size of the current inuse area.
 
@@ -452,6 +515,13 @@ public:
   char *_end     = nullptr;
   char *_buf_end = nullptr;
 
+  /**
+    Offset in the file of the data of '_start'. A file has no memory
+    behind it, so this is kept with the block and moved along by consume().
+
+  */
+  off_t _file_offset = 0;
+
   const char *_location = nullptr;
 
   /**
@@ -1208,8 +1278,9 @@ public:
   clear()
   {
     dealloc();
-    size_index = BUFFER_SIZE_NOT_ALLOCATED;
-    water_mark = 0;
+    size_index  = BUFFER_SIZE_NOT_ALLOCATED;
+    water_mark  = 0;
+    file_blocks = false;
   }
 
   int64_t size_index;
@@ -1224,6 +1295,14 @@ public:
   */
   int64_t water_mark;
 
+  /**
+    Blocks of file data (see IOBufferFile) may be appended. Set by the
+    owner of the buffer when all of its readers write to a socket that
+    can send them.
+
+  */
+  bool file_blocks = false;
+
   Ptr<IOBufferBlock> _writer;
   IOBufferReader readers[MAX_MIOBUFFER_READERS];
 
@@ -1353,6 +1432,8 @@ extern IOBufferData *new_IOBufferData_internal(const char *location, int64_t siz
 
 extern IOBufferData *new_xmalloc_IOBufferData_internal(const char *location, void *b, int64_t size);
 
+extern IOBufferData *new_file_IOBufferData_internal(const char *location, IOBufferFile *file, off_t offset, int64_t size);
+
 class IOBufferData_tracker
 {
   const char *loc;
@@ -1369,6 +1450,7 @@ public:
 // TODO: remove new_xmalloc_IOBufferData. Because ats_xmalloc() doesn't exist anymore.
 #define new_IOBufferData IOBufferData_tracker(RES_PATH("memory/IOBuffer/"))
 #define new_xmalloc_IOBufferData(b, size) new_xmalloc_IOBufferData_internal(RES_PATH("memory/IOBuffer/"), (b), (size))
+#define new_file_IOBufferData(f, offset, size) new_file_IOBufferData_internal(RES_PATH("memory/IOBuffer/"), (f), (offset), (size))
 
 extern int64_t iobuffer_size_to_index(int64_t size, int64_t max);
 extern int64_t index_to_buffer_size(int64_t idx);
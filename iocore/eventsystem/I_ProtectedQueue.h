@@ -23,12 +23,12 @@
 
 /****************************************************************************
 
-  Protected Queue, a FIFO queue with the following functionality:
-  (1). Multiple threads could be simultaneously trying to enqueue
-       and dequeue. Hence the queue needs to be protected with mutex.
-  (2). In case the queue is empty, dequeue() sleeps for a specified
-       amount of time, or until a new element is inserted, whichever
-       is earlier
+  Protected Queue, the queue of events of an EThread:
+  (1). Any number of threads enqueue events for the owning thread
+       without a lock, only the owning thread dequeues them.
+  (2). The owning thread announces when it is about to block, and only
+       the first enqueue after that signals it, through the tail
+       handler of the thread.
 
 
  ****************************************************************************/
@@ -36,20 +36,21 @@
 
 #include "tscore/ink_platform.h"
 #include "I_Event.h"
+
+#include <atomic>
+
 struct ProtectedQueue {
   void enqueue(Event *e);
-  void signal();
-  int try_signal();             // Use non blocking lock and if acquired, signal
   void enqueue_local(Event *e); // Safe when called from the same thread
-  void remove(Event *e);
   Event *dequeue_local();
-  void dequeue_external();       // Dequeue any external events.
-  void wait(ink_hrtime timeout); // Wait for @a timeout nanoseconds on a condition variable if there are no events.
-
-  InkAtomicList al;
-  ink_mutex lock;
-  ink_cond might_have_data;
+  void dequeue_external(); // Dequeue any external events.
+  bool begin_wait();       // The owning thread is about to block, false if events are already waiting.
+  bool end_wait();         // The owning thread stopped blocking, true if it was signalled.
+  bool wake(EThread *t);   // Signal the owning thread @a t if it is blocked, true if it was.
+
+  /// External events, most recent first. Pushed by any thread, taken all at once by the owning thread.
+  std::atomic<Event *> al{nullptr};
+  /// Set by the owning thread while it blocks, cleared by the first producer to signal it.
+  std::atomic<bool> sleeping{false};
   Que(Event, link) localQueue;
-
-  ProtectedQueue();
 };
@@ -0,0 +1,80 @@
+/** @file
+
+  Work stealing queues shared by the threads of a thread group
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "tscore/ink_platform.h"
+#include "tscore/ink_mutex.h"
+#include "I_Event.h"
+
+#include <atomic>
+
+class EThread;
+
+/**
+  Immediate events of a thread group spawned with EventProcessor::spawn_task_pool().
+
+  Each thread of the group has a deque. An event scheduled on the group goes
+  to the deque of the thread picked for it, as it would go to the external
+  queue of that thread otherwise. A thread runs the oldest event of its own
+  deque and, when that is empty, steals the oldest event of the longest deque
+  of the group whose continuation is not pinned to another thread with
+  Continuation::setThreadAffinity(). So a slow event holds up its own thread,
+  not the events queued behind it. If the thread an event is queued for is busy, an idle
+  thread of the group is woken to steal it.
+
+  Timed and periodic events are not shared, they run on the thread they were
+  scheduled on.
+*/
+class TaskPool
+{
+public:
+  /// The threads are read from @a threads as the events come, they need not be created yet.
+  TaskPool(EThread *const *threads, int n_threads);
+  ~TaskPool();
+
+  /// Queue @a e for @a e->ethread and wake a thread of the group to run it.
+  void enqueue(Event *e);
+  /// The next event for @a t to run, its own or stolen. The event is moved to @a t.
+  Event *dequeue(EThread *t);
+  /// No event is waiting in any of the deques.
+  bool empty() const;
+
+  /// Register the stats shared by the task pools.
+  static void register_stats();
+
+private:
+  /// The oldest event of deque @a idx, the oldest one @a thief may run if it is stealing.
+  Event *take(int idx, EThread *thief);
+  static bool stealable(Event *e, EThread *t);
+
+  struct Deque {
+    ink_mutex lock;
+    Que(Event, link) events;
+    std::atomic<int> size{0};
+  };
+
+  EThread *const *threads;
+  int n_threads;
+  Deque *deques;
+};
@@ -0,0 +1,86 @@
+/** @file
+
+  Hierarchical timing wheel of the timed events of an EThread or a NetHandler
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "tscore/ink_platform.h"
+#include "I_Event.h"
+
+#define TW_TICK HRTIME_MSECOND // resolution of the wheel
+#define TW_LEVELS 4
+#define TW_SLOT_BITS 8
+#define TW_SLOTS (1 << TW_SLOT_BITS) // per level, the levels span 256ms, 65s, 4.6h and 49 days
+#define TW_READY (TW_LEVELS * TW_SLOTS)
+#define TW_OVERFLOW (TW_READY + 1)
+#define TW_LISTS (TW_OVERFLOW + 1)
+
+class EThread;
+
+/**
+  Timed events of an EThread, in a hierarchical timing wheel.
+
+  Level 0 has a slot per tick and each slot of level n spans all of level
+  n - 1. An event goes into the slot of the lowest level which reaches its
+  timeout, so enqueue() and remove() are O(1) however many events are
+  outstanding. As the wheel turns past a slot of level 0 the whole slot is
+  due and moves to the ready list in one batch. When level 0 wraps, the next
+  slot of level 1 is spread over it, and so on up. Events fire at most a tick
+  after their timeout, never before.
+
+  This has the interface of the PriorityEventQueue it replaces. Besides the
+  EThread, a NetHandler keeps one of its own for the inactivity and active
+  timeouts of its connections, each of which files an embedded Event in it.
+  A wheel is only used by the thread owning it.
+*/
+class TimerWheel
+{
+public:
+  TimerWheel();
+
+  void enqueue(Event *e, ink_hrtime now);
+  void remove(Event *e);
+  /// Turn the wheel up to @a now, @a t frees the cancelled events found on the way.
+  void check_ready(ink_hrtime now, EThread *t);
+  Event *dequeue_ready(ink_hrtime now);
+  ink_hrtime earliest_timeout();
+
+  /// # of events outstanding, due or not.
+  int64_t
+  size() const
+  {
+    return pending + ready;
+  }
+
+private:
+  void insert(Event *e);
+  void cascade(int level, EThread *t);
+  void expire(int slot);
+  static int next_slot(const uint64_t *map, int from);
+
+  Que(Event, link) lists[TW_LISTS]; // the slots of each level, then the ready and the overflow lists
+  uint64_t occupied[TW_LEVELS][TW_SLOTS / 64] = {}; // slots which are not empty
+  uint64_t cur_tick                           = 0;  // the wheel has turned past every slot up to this tick
+  int64_t pending                             = 0;  // events in the slots and the overflow list
+  int64_t ready                               = 0;  // events in the ready list
+  ink_hrtime last_check_time                  = 0;
+};
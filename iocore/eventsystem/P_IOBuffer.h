@@ -94,7 +94,7 @@ iobufferblock_clone(IOBufferBlock *src, int64_t offset, int64_t len)
     }
 
     IOBufferBlock *new_buf = src->clone();
-    new_buf->_start += offset;
+    new_buf->consume(offset);
     new_buf->_buf_end = new_buf->_end = new_buf->_start + bytes;
 
     if (!start_buf) {
@@ -214,6 +214,15 @@ new_xmalloc_IOBufferData_internal(const char *location, void *b, int64_t size)
   return new_IOBufferData_internal(location, b, size, BUFFER_SIZE_INDEX_FOR_XMALLOC_SIZE(size));
 }
 
+TS_INLINE IOBufferData *
+new_file_IOBufferData_internal(const char *location, IOBufferFile *file, off_t offset, int64_t size)
+{
+  IOBufferData *d = new_IOBufferData_internal(location, nullptr, size, BUFFER_SIZE_INDEX_FOR_CONSTANT_SIZE(size));
+  d->_file        = file;
+  d->_file_offset = offset;
+  return d;
+}
+
 TS_INLINE IOBufferData *
 new_IOBufferData_internal(const char *loc, int64_t size_index, AllocType type)
 {
@@ -282,6 +291,8 @@ IOBufferData::dealloc()
   _data       = nullptr;
   _size_index = BUFFER_SIZE_NOT_ALLOCATED;
   _mem_type   = NO_ALLOC;
+  _file       = nullptr;
+  _immutable  = false;
 }
 
 TS_INLINE void
@@ -324,6 +335,7 @@ TS_INLINE void
 IOBufferBlock::consume(int64_t len)
 {
   _start += len;
+  _file_offset += len;
   ink_assert(_start <= _end);
 }
 
@@ -339,6 +351,7 @@ IOBufferBlock::reset()
 {
   _end = _start = buf();
   _buf_end      = buf() + data->block_size();
+  _file_offset  = data->_file_offset;
 }
 
 TS_INLINE void
@@ -383,6 +396,7 @@ IOBufferBlock::clone() const
   b->_start        = _start;
   b->_end          = _end;
   b->_buf_end      = _end;
+  b->_file_offset  = _file_offset;
   b->_location     = _location;
   return b;
 }
@@ -414,10 +428,11 @@ IOBufferBlock::set_internal(void *b, int64_t len, int64_t asize_index)
 TS_INLINE void
 IOBufferBlock::set(IOBufferData *d, int64_t len, int64_t offset)
 {
-  data     = d;
-  _start   = buf() + offset;
-  _end     = _start + len;
-  _buf_end = buf() + d->block_size();
+  data         = d;
+  _start       = buf() + offset;
+  _end         = _start + len;
+  _buf_end     = buf() + d->block_size();
+  _file_offset = d->_file_offset + offset;
 }
 
 //////////////////////////////////////////////////////////////////
@@ -31,56 +31,16 @@
 
 #include "I_EventSystem.h"
 
-TS_INLINE
-ProtectedQueue::ProtectedQueue()
-{
-  Event e;
-  ink_mutex_init(&lock);
-  ink_atomiclist_init(&al, "ProtectedQueue", (char *)&e.link.next - (char *)&e);
-  ink_cond_init(&might_have_data);
-}
-
-TS_INLINE void
-ProtectedQueue::signal()
-{
-  // Need to get the lock before you can signal the thread
-  ink_mutex_acquire(&lock);
-  ink_cond_signal(&might_have_data);
-  ink_mutex_release(&lock);
-}
-
-TS_INLINE int
-ProtectedQueue::try_signal()
-{
-  // Need to get the lock before you can signal the thread
-  if (ink_mutex_try_acquire(&lock)) {
-    ink_cond_signal(&might_have_data);
-    ink_mutex_release(&lock);
-    return 1;
-  } else {
-    return 0;
-  }
-}
-
 // Called from the same thread (don't need to signal)
 TS_INLINE void
 ProtectedQueue::enqueue_local(Event *e)
 {
   ink_assert(!e->in_the_prot_queue && !e->in_the_priority_queue);
   e->in_the_prot_queue = 1;
+  e->enqueue_time      = 0;
   localQueue.enqueue(e);
 }
 
-TS_INLINE void
-ProtectedQueue::remove(Event *e)
-{
-  ink_assert(e->in_the_prot_queue);
-  if (!ink_atomiclist_remove(&al, e)) {
-    localQueue.remove(e);
-  }
-  e->in_the_prot_queue = 0;
-}
-
 TS_INLINE Event *
 ProtectedQueue::dequeue_local()
 {
@@ -91,3 +51,22 @@ ProtectedQueue::dequeue_local()
   }
   return e;
 }
+
+// The store of @a sleeping and the load of @a al pair with the push and the load
+// of @a sleeping in enqueue(), so either the producer signals or the thread sees the event.
+TS_INLINE bool
+ProtectedQueue::begin_wait()
+{
+  sleeping.store(true);
+  if (al.load() != nullptr) {
+    sleeping.store(false);
+    return false;
+  }
+  return true;
+}
+
+TS_INLINE bool
+ProtectedQueue::end_wait()
+{
+  return !sleeping.exchange(false);
+}
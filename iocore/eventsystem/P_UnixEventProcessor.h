@@ -108,7 +108,8 @@ EventProcessor::schedule(Event *e, EventType etype)
     } else {
       e->ethread = assign_thread(etype);
     }
-    if (affinity_thread == nullptr) {
+    // A task pool moves the events of continuations that are not pinned, it does not pin them here.
+    if (affinity_thread == nullptr && !e->ethread->task_pool) {
       e->continuation->setThreadAffinity(e->ethread);
     }
   }
@@ -117,7 +118,9 @@ EventProcessor::schedule(Event *e, EventType etype)
     e->mutex = e->continuation->mutex;
   }
 
-  if (curr_thread != nullptr && e->ethread == curr_thread) {
+  if (e->timeout_at == 0 && e->ethread->task_pool) {
+    e->ethread->task_pool->enqueue(e);
+  } else if (curr_thread != nullptr && e->ethread == curr_thread) {
     e->ethread->EventQueueExternal.enqueue_local(e);
   } else {
     e->ethread->EventQueueExternal.enqueue(e);
@@ -22,25 +22,17 @@
 
   @section details Details
 
-  ProtectedQueue implements a FIFO queue with the following functionality:
-    -# Multiple threads could be simultaneously trying to enqueue and
-      dequeue. Hence the queue needs to be protected with mutex.
-    -# In case the queue is empty, dequeue() sleeps for a specified amount
-      of time, or until a new element is inserted, whichever is earlier.
+  ProtectedQueue implements the event queue of an EThread:
+    -# Any number of threads enqueue events with a compare and swap on the
+      head of a list, the owning thread takes the whole list at once and
+      puts it back in order. Nobody takes a lock.
+    -# A producer signals the owning thread only when it is blocked waiting
+      for activity, and only the first producer after it started waiting does.
 
 */
 
 #include "P_EventSystem.h"
 
-// The protected queue is designed to delay signaling of threads
-// until some amount of work has been completed on the current thread
-// in order to prevent excess context switches.
-//
-// Defining EAGER_SIGNALLING disables this behavior and causes
-// threads to be made runnable immediately.
-//
-// #define EAGER_SIGNALLING
-
 extern ClassAllocator<Event> eventAllocator;
 
 void
@@ -49,22 +41,33 @@ ProtectedQueue::enqueue(Event *e)
   ink_assert(!e->in_the_prot_queue && !e->in_the_priority_queue);
   EThread *e_ethread   = e->ethread;
   e->in_the_prot_queue = 1;
-  bool was_empty       = (ink_atomiclist_push(&al, e) == nullptr);
+  e->enqueue_time      = ink_get_hrtime_internal();
 
-  if (was_empty) {
-    EThread *inserting_thread = this_ethread();
-    // queue e->ethread in the list of threads to be signalled
-    // inserting_thread == 0 means it is not a regular EThread
-    if (inserting_thread != e_ethread) {
-      e_ethread->tail_cb->signalActivity();
-    }
+  Event *head = al.load(std::memory_order_relaxed);
+  do {
+    e->link.next = head;
+  } while (!al.compare_exchange_weak(head, e));
+
+  // Wake the thread if it is blocked, once for all the events queued while it was.
+  if (this_ethread() != e_ethread && sleeping.load() && sleeping.exchange(false)) {
+    e_ethread->tail_cb->signalActivity();
+  }
+}
+
+bool
+ProtectedQueue::wake(EThread *t)
+{
+  if (sleeping.load() && sleeping.exchange(false)) {
+    t->tail_cb->signalActivity();
+    return true;
   }
+  return false;
 }
 
 void
 ProtectedQueue::dequeue_external()
 {
-  Event *e = static_cast<Event *>(ink_atomiclist_popall(&al));
+  Event *e = al.exchange(nullptr, std::memory_order_acquire);
   // invert the list, to preserve order
   SLL<Event, Event::Link_link> l, t;
   t.head = e;
@@ -81,18 +84,3 @@ ProtectedQueue::dequeue_external()
     }
   }
 }
-
-void
-ProtectedQueue::wait(ink_hrtime timeout)
-{
-  /* If there are no external events available, will do a cond_timedwait.
-   *
-   *   - The `EThread::lock` will be released,
-   *   - And then the Event Thread goes to sleep and waits for the wakeup signal of `EThread::might_have_data`,
-   *   - The `EThread::lock` will be locked again when the Event Thread wakes up.
-   */
-  if (INK_ATOMICLIST_EMPTY(al) && localQueue.empty()) {
-    timespec ts = ink_hrtime_to_timespec(timeout);
-    ink_cond_timedwait(&might_have_data, &lock, &ts);
-  }
-}
@@ -0,0 +1,175 @@
+/** @file
+
+  Work stealing queues shared by the threads of a thread group
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_EventSystem.h"
+
+namespace
+{
+enum {
+  task_pool_events_stat,     // events run from the deques
+  task_pool_queue_time_stat, // total time they waited in a deque, in nanoseconds
+  task_pool_steals_stat,     // events run by another thread than the one they were queued for
+  task_pool_stat_count
+};
+
+RecRawStatBlock *task_pool_rsb = nullptr;
+} // namespace
+
+TaskPool::TaskPool(EThread *const *threads, int n_threads) : threads(threads), n_threads(n_threads)
+{
+  deques = new Deque[n_threads];
+  for (int i = 0; i < n_threads; ++i) {
+    ink_mutex_init(&deques[i].lock);
+  }
+}
+
+TaskPool::~TaskPool()
+{
+  for (int i = 0; i < n_threads; ++i) {
+    ink_mutex_destroy(&deques[i].lock);
+  }
+  delete[] deques;
+}
+
+void
+TaskPool::register_stats()
+{
+  if (task_pool_rsb != nullptr) {
+    return;
+  }
+  task_pool_rsb = RecAllocateRawStatBlock(task_pool_stat_count);
+  RecRegisterRawStat(task_pool_rsb, RECT_PROCESS, "proxy.process.task_pool.events", RECD_INT, RECP_NON_PERSISTENT,
+                     task_pool_events_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(task_pool_rsb, RECT_PROCESS, "proxy.process.task_pool.queue_time", RECD_INT, RECP_NON_PERSISTENT,
+                     task_pool_queue_time_stat, RecRawStatSyncSum);
+  RecRegisterRawStat(task_pool_rsb, RECT_PROCESS, "proxy.process.task_pool.steals", RECD_INT, RECP_NON_PERSISTENT,
+                     task_pool_steals_stat, RecRawStatSyncSum);
+}
+
+void
+TaskPool::enqueue(Event *e)
+{
+  EThread *owner = e->ethread;
+  int idx        = owner->id;
+  Deque &d       = deques[idx];
+
+  ink_assert(owner->task_pool == this && idx >= 0 && idx < n_threads);
+  e->enqueue_time = ink_get_hrtime_internal();
+
+  ink_mutex_acquire(&d.lock);
+  d.events.enqueue(e);
+  ++d.size;
+  ink_mutex_release(&d.lock);
+  // @a e may already be running elsewhere.
+
+  // The increment of @a size pairs with the check of empty() by a thread about to block, so either
+  // the thread sees the event or it is woken here.
+  if (owner->EventQueueExternal.wake(owner)) {
+    return;
+  }
+  // The owner is running, possibly something slow, let an idle thread steal the event.
+  for (int i = 1; i < n_threads; ++i) {
+    EThread *t = threads[(idx + i) % n_threads];
+    if (t->EventQueueExternal.wake(t)) {
+      break;
+    }
+  }
+}
+
+Event *
+TaskPool::take(int idx, EThread *thief)
+{
+  Deque &d = deques[idx];
+  Event *e = nullptr;
+
+  if (d.size.load() > 0) {
+    ink_mutex_acquire(&d.lock);
+    e = d.events.head;
+    // A thief passes over the events whose continuation is pinned to another thread.
+    while (thief && e && !stealable(e, thief)) {
+      e = e->link.next;
+    }
+    if (e != nullptr) {
+      d.events.remove(e);
+      --d.size;
+    }
+    ink_mutex_release(&d.lock);
+  }
+  return e;
+}
+
+bool
+TaskPool::stealable(Event *e, EThread *t)
+{
+  EThread *affinity = e->continuation ? e->continuation->getThreadAffinity() : nullptr;
+  return affinity == nullptr || affinity == t;
+}
+
+Event *
+TaskPool::dequeue(EThread *t)
+{
+  Event *e = take(t->id, nullptr);
+
+  if (e == nullptr) {
+    int victim  = -1;
+    int longest = 0;
+    for (int i = 0; i < n_threads; ++i) {
+      int size = deques[i].size.load(std::memory_order_relaxed);
+      if (i != t->id && size > longest) {
+        victim  = i;
+        longest = size;
+      }
+    }
+    if (victim < 0) {
+      return nullptr;
+    }
+    // The longest deque first, the others if everything in it is pinned.
+    for (int i = 0; i < n_threads && e == nullptr; ++i) {
+      int idx = (victim + i) % n_threads;
+      if (idx != t->id) {
+        e = take(idx, t);
+      }
+    }
+    if (e == nullptr) {
+      return nullptr;
+    }
+    e->ethread = t;
+    RecIncrRawStat(task_pool_rsb, t, task_pool_steals_stat, 1);
+  }
+
+  RecIncrRawStat(task_pool_rsb, t, task_pool_events_stat, 1);
+  RecIncrRawStat(task_pool_rsb, t, task_pool_queue_time_stat, Thread::get_hrtime_updated() - e->enqueue_time);
+  e->enqueue_time = 0;
+  return e;
+}
+
+bool
+TaskPool::empty() const
+{
+  for (int i = 0; i < n_threads; ++i) {
+    if (deques[i].size.load() > 0) {
+      return false;
+    }
+  }
+  return true;
+}
@@ -39,6 +39,13 @@ TasksProcessor::register_event_type()
 int
 TasksProcessor::start(int task_threads, size_t stacksize)
 {
-  eventProcessor.spawn_event_threads(ET_TASK, std::max(1, task_threads), stacksize);
+  int work_stealing = 0;
+
+  REC_ReadConfigInteger(work_stealing, "proxy.config.task_threads.work_stealing");
+  if (work_stealing) {
+    eventProcessor.spawn_task_pool(ET_TASK, std::max(1, task_threads), stacksize);
+  } else {
+    eventProcessor.spawn_event_threads(ET_TASK, std::max(1, task_threads), stacksize);
+  }
   return 0;
 }
@@ -0,0 +1,207 @@
+/** @file
+
+  Hierarchical timing wheel of the timed events of an EThread, see I_TimerWheel.h
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_EventSystem.h"
+
+#include <algorithm>
+
+#define TW_MASK (TW_SLOTS - 1)
+#define TW_SHIFT(_level) (TW_SLOT_BITS * (_level))
+
+TimerWheel::TimerWheel()
+{
+  last_check_time = Thread::get_hrtime_updated();
+  cur_tick        = last_check_time / TW_TICK;
+}
+
+// Distance from @a from to the next slot set in @a map, wrapping around, or -1 if none is.
+int
+TimerWheel::next_slot(const uint64_t *map, int from)
+{
+  int w      = from >> 6;
+  uint64_t m = map[w] & (~0ULL << (from & 63));
+  for (int i = 1; i <= TW_SLOTS / 64 + 1; ++i) {
+    if (m) {
+      return ((((w + i - 1) % (TW_SLOTS / 64)) << 6) + __builtin_ctzll(m) - from) & TW_MASK;
+    }
+    m = map[(w + i) % (TW_SLOTS / 64)];
+  }
+  return -1;
+}
+
+void
+TimerWheel::insert(Event *e)
+{
+  // Round up, so the event never fires before its timeout.
+  uint64_t expire = (e->timeout_at + TW_TICK - 1) / TW_TICK;
+  int list        = TW_READY;
+  if (expire > cur_tick) {
+    uint64_t delta = expire - cur_tick;
+    int level      = 0;
+    while (level < TW_LEVELS && delta >= (1ULL << TW_SHIFT(level + 1))) {
+      ++level;
+    }
+    if (level < TW_LEVELS) {
+      int slot = (expire >> TW_SHIFT(level)) & TW_MASK;
+      list     = level * TW_SLOTS + slot;
+      occupied[level][slot >> 6] |= 1ULL << (slot & 63);
+    } else {
+      list = TW_OVERFLOW;
+    }
+    ++pending;
+  } else {
+    ++ready;
+  }
+  e->in_heap = list;
+  lists[list].enqueue(e);
+}
+
+void
+TimerWheel::enqueue(Event *e, ink_hrtime /* now ATS_UNUSED */)
+{
+  e->in_the_priority_queue = 1;
+  insert(e);
+}
+
+void
+TimerWheel::remove(Event *e)
+{
+  ink_assert(e->in_the_priority_queue);
+  e->in_the_priority_queue = 0;
+  int list                 = e->in_heap;
+  lists[list].remove(e);
+  if (list == TW_READY) {
+    --ready;
+    return;
+  }
+  --pending;
+  if (list < TW_READY && !lists[list].head) {
+    occupied[list / TW_SLOTS][(list & TW_MASK) >> 6] &= ~(1ULL << (list & 63));
+  }
+}
+
+// The wheel turned past a slot of level 0, all of it is due.
+void
+TimerWheel::expire(int slot)
+{
+  Que(Event, link) &q = lists[slot];
+  Event *e;
+  while ((e = q.dequeue()) != nullptr) {
+    e->in_heap = TW_READY;
+    lists[TW_READY].enqueue(e);
+    --pending;
+    ++ready;
+  }
+  occupied[0][slot >> 6] &= ~(1ULL << (slot & 63));
+}
+
+// Level @a level - 1 wrapped, spread the current slot of @a level over the levels below.
+void
+TimerWheel::cascade(int level, EThread *t)
+{
+  int list;
+  if (level < TW_LEVELS) {
+    int slot = (cur_tick >> TW_SHIFT(level)) & TW_MASK;
+    list     = level * TW_SLOTS + slot;
+    occupied[level][slot >> 6] &= ~(1ULL << (slot & 63));
+  } else {
+    list = TW_OVERFLOW;
+  }
+  Que(Event, link) q = lists[list];
+  lists[list].clear();
+  Event *e;
+  while ((e = q.dequeue()) != nullptr) {
+    --pending;
+    if (e->cancelled) {
+      e->in_the_priority_queue = 0;
+      e->cancelled             = 0;
+      EVENT_FREE(e, eventAllocator, t);
+    } else {
+      insert(e);
+    }
+  }
+}
+
+void
+TimerWheel::check_ready(ink_hrtime now, EThread *t)
+{
+  uint64_t target = now / TW_TICK;
+  last_check_time = now;
+  while (cur_tick < target) {
+    if (!pending) {
+      cur_tick = target;
+      break;
+    }
+    // Skip to the next occupied slot of level 0, or to where level 0 wraps, whichever is first.
+    uint64_t next = (cur_tick | TW_MASK) + 1;
+    int d         = next_slot(occupied[0], (cur_tick + 1) & TW_MASK);
+    if (d >= 0) {
+      next = std::min(next, cur_tick + 1 + d);
+    }
+    if (next > target) {
+      cur_tick = target;
+      break;
+    }
+    cur_tick = next;
+    for (int level = 1; level <= TW_LEVELS && !(cur_tick & ((1ULL << TW_SHIFT(level)) - 1)); ++level) {
+      cascade(level, t);
+    }
+    expire(cur_tick & TW_MASK);
+  }
+}
+
+Event *
+TimerWheel::dequeue_ready(ink_hrtime /* now ATS_UNUSED */)
+{
+  Event *e = lists[TW_READY].dequeue();
+  if (e) {
+    ink_assert(e->in_the_priority_queue);
+    e->in_the_priority_queue = 0;
+    --ready;
+  }
+  return e;
+}
+
+ink_hrtime
+TimerWheel::earliest_timeout()
+{
+  if (ready) {
+    return last_check_time;
+  }
+  if (!pending) {
+    return last_check_time + HRTIME_FOREVER;
+  }
+  // The next slot of level 0 to expire, or the next slot of a higher level to cascade.
+  uint64_t next = UINT64_MAX;
+  for (int level = 0; level < TW_LEVELS; ++level) {
+    uint64_t block = cur_tick >> TW_SHIFT(level);
+    int d          = next_slot(occupied[level], (block + 1) & TW_MASK);
+    if (d >= 0) {
+      next = std::min(next, (block + 1 + d) << TW_SHIFT(level));
+    }
+  }
+  if (lists[TW_OVERFLOW].head) {
+    next = std::min(next, ((cur_tick >> TW_SHIFT(TW_LEVELS)) + 1) << TW_SHIFT(TW_LEVELS));
+  }
+  return std::max(last_check_time, static_cast<ink_hrtime>(next * TW_TICK));
+}
@@ -34,6 +34,7 @@
 #include <sys/eventfd.h>
 #endif
 
+#include <poll.h>
 #include <typeinfo>
 
 struct AIOCallback;
@@ -42,10 +43,12 @@ struct AIOCallback;
 #define THREAD_MAX_HEARTBEAT_MSECONDS 60
 
 // !! THIS MUST BE IN THE ENUM ORDER !!
-char const *const EThread::STAT_NAME[] = {"proxy.process.eventloop.count",      "proxy.process.eventloop.events",
-                                          "proxy.process.eventloop.events.min", "proxy.process.eventloop.events.max",
-                                          "proxy.process.eventloop.wait",       "proxy.process.eventloop.time.min",
-                                          "proxy.process.eventloop.time.max"};
+char const *const EThread::STAT_NAME[] = {"proxy.process.eventloop.count",        "proxy.process.eventloop.events",
+                                          "proxy.process.eventloop.events.min",   "proxy.process.eventloop.events.max",
+                                          "proxy.process.eventloop.wait",         "proxy.process.eventloop.time.min",
+                                          "proxy.process.eventloop.time.max",     "proxy.process.eventloop.enqueue.count",
+                                          "proxy.process.eventloop.enqueue.time", "proxy.process.eventloop.enqueue.time.max",
+                                          "proxy.process.eventloop.wakeups"};
 
 int const EThread::SAMPLE_COUNT[N_EVENT_TIMESCALES] = {10, 100, 1000};
 
@@ -100,11 +103,8 @@ EThread::EThread(ThreadType att, int anid) : id(anid), tt(att)
       Fatal("EThread::EThread: %d=eventfd(0,EFD_NONBLOCK | EFD_CLOEXEC),errno(%d)", evfd, errno);
     }
   }
-#elif TS_USE_PORT
-/* Solaris ports requires no crutches to do cross thread signaling.
- * We'll just port_send the event straight over the port.
- */
 #else
+  // Solaris ports signal a NetHandler with port_send, the pipe is for the default tail handler.
   ink_release_assert(pipe(evpipe) >= 0);
   fcntl(evpipe[0], F_SETFD, FD_CLOEXEC);
   fcntl(evpipe[0], F_SETFL, O_NONBLOCK);
@@ -180,6 +180,40 @@ EThread::process_event(Event *e, int calling_code)
   }
 }
 
+int
+EThread::DefaultTailHandler::waitForActivity(ink_hrtime timeout)
+{
+  struct pollfd pfd;
+#if HAVE_EVENTFD
+  pfd.fd = _t.evfd;
+#else
+  pfd.fd = _t.evpipe[0];
+#endif
+  pfd.events = POLLIN;
+  if (poll(&pfd, 1, ink_hrtime_to_msec(timeout + HRTIME_MSECOND - 1)) > 0) {
+#if HAVE_EVENTFD
+    uint64_t counter;
+    ATS_UNUSED_RETURN(read(_t.evfd, &counter, sizeof(uint64_t)));
+#else
+    char dummy[1024];
+    ATS_UNUSED_RETURN(read(_t.evpipe[0], &dummy[0], 1024));
+#endif
+  }
+  return 0;
+}
+
+void
+EThread::DefaultTailHandler::signalActivity()
+{
+#if HAVE_EVENTFD
+  uint64_t counter = 1;
+  ATS_UNUSED_RETURN(write(_t.evfd, &counter, sizeof(uint64_t)));
+#else
+  char dummy = 1;
+  ATS_UNUSED_RETURN(write(_t.evpipe[1], &dummy, 1));
+#endif
+}
+
 void
 EThread::process_queue(Que(Event, link) * NegativeQueue, int *ev_count, int *nq_count)
 {
@@ -187,11 +221,21 @@ EThread::process_queue(Que(Event, link) * NegativeQueue, int *ev_count, int *nq_
 
   // Move events from the external thread safe queues to the local queue.
   EventQueueExternal.dequeue_external();
+  ink_hrtime now = Thread::get_hrtime_updated();
 
   // execute all the available external events that have
   // already been dequeued
   while ((e = EventQueueExternal.dequeue_local())) {
     ++(*ev_count);
+    if (e->enqueue_time) {
+      ink_hrtime queued = now - e->enqueue_time;
+      ++(current_metric->_enqueue._count);
+      current_metric->_enqueue._total += queued;
+      if (queued > current_metric->_enqueue._max) {
+        current_metric->_enqueue._max = queued;
+      }
+      e->enqueue_time = 0;
+    }
     if (e->cancelled) {
       free_event(e);
     } else if (!e->timeout_at) { // IMMEDIATE
@@ -254,6 +298,16 @@ EThread::execute_regular()
 
     process_queue(&NegativeQueue, &ev_count, &nq_count);
 
+    // One shared event per loop, so a backlog in the pool does not hold up the timers.
+    if (task_pool && (e = task_pool->dequeue(this))) {
+      ++ev_count;
+      if (e->cancelled) {
+        free_event(e);
+      } else {
+        process_event(e, e->callback_event);
+      }
+    }
+
     bool done_one;
     do {
       done_one = false;
@@ -296,7 +350,20 @@ EThread::execute_regular()
       sleep_time = 0;
     }
 
-    tail_cb->waitForActivity(sleep_time);
+    // Other threads only signal this one after it announced that it is going to block.
+    bool wait = sleep_time > 0 && EventQueueExternal.begin_wait();
+    if (wait && task_pool && !task_pool->empty()) {
+      EventQueueExternal.end_wait();
+      wait = false;
+    }
+    if (wait) {
+      tail_cb->waitForActivity(sleep_time);
+      if (EventQueueExternal.end_wait()) {
+        ++(current_metric->_wakeups);
+      }
+    } else {
+      tail_cb->waitForActivity(0);
+    }
 
     // loop cleanup
     loop_finish_time = Thread::get_hrtime_updated();
@@ -349,16 +416,7 @@ EThread::execute()
 
   switch (tt) {
   case REGULAR: {
-    /* The Event Thread has two status: busy and sleep:
-     *   - Keep `EThread::lock` locked while Event Thread is busy,
-     *   - The `EThread::lock` is released while Event Thread is sleep.
-     * When other threads try to acquire the `EThread::lock` of the target Event Thread:
-     *   - Acquired, indicating that the target Event Thread is sleep,
-     *   - Failed, indicating that the target Event Thread is busy.
-     */
-    ink_mutex_acquire(&EventQueueExternal.lock);
     this->execute_regular();
-    ink_mutex_release(&EventQueueExternal.lock);
     break;
   }
   case DEDICATED: {
@@ -379,8 +437,12 @@ EThread::EventMetrics::operator+=(EventMetrics const &that)
   this->_events._total += that._events._total;
   this->_loop_time._min = std::min(this->_loop_time._min, that._loop_time._min);
   this->_loop_time._max = std::max(this->_loop_time._max, that._loop_time._max);
+  this->_enqueue._total += that._enqueue._total;
+  this->_enqueue._max = std::max(this->_enqueue._max, that._enqueue._max);
+  this->_enqueue._count += that._enqueue._count;
   this->_count += that._count;
   this->_wait += that._wait;
+  this->_wakeups += that._wakeups;
   return *this;
 }
 
@@ -112,6 +112,20 @@ EventMetricStatSync(const char *, RecDataT, RecData *, RecRawStatBlock *rsb, int
     rsb->global[id + EThread::STAT_LOOP_EVENTS_MAX]->sum   = m->_events._max;
     rsb->global[id + EThread::STAT_LOOP_EVENTS_MAX]->count = 1;
     RecRawStatUpdateSum(rsb, id + EThread::STAT_LOOP_EVENTS_MAX);
+
+    rsb->global[id + EThread::STAT_ENQUEUE_COUNT]->sum   = m->_enqueue._count;
+    rsb->global[id + EThread::STAT_ENQUEUE_COUNT]->count = 1;
+    RecRawStatUpdateSum(rsb, id + EThread::STAT_ENQUEUE_COUNT);
+    rsb->global[id + EThread::STAT_ENQUEUE_TIME]->sum   = m->_enqueue._count ? m->_enqueue._total / m->_enqueue._count : 0;
+    rsb->global[id + EThread::STAT_ENQUEUE_TIME]->count = 1;
+    RecRawStatUpdateSum(rsb, id + EThread::STAT_ENQUEUE_TIME);
+    rsb->global[id + EThread::STAT_ENQUEUE_TIME_MAX]->sum   = m->_enqueue._max;
+    rsb->global[id + EThread::STAT_ENQUEUE_TIME_MAX]->count = 1;
+    RecRawStatUpdateSum(rsb, id + EThread::STAT_ENQUEUE_TIME_MAX);
+
+    rsb->global[id + EThread::STAT_LOOP_WAKEUPS]->sum   = m->_wakeups;
+    rsb->global[id + EThread::STAT_LOOP_WAKEUPS]->count = 1;
+    RecRawStatUpdateSum(rsb, id + EThread::STAT_LOOP_WAKEUPS);
   }
 
   ink_mutex_release(&(rsb->mutex));
@@ -375,6 +389,7 @@ EventProcessor::spawn_event_threads(EventType ev_type, int n_threads, size_t sta
     all_ethreads[n_ethreads + i] = t;
     tg->_thread[i]               = t;
     t->id                        = i; // unfortunately needed to support affinity and NUMA logic.
+    t->task_pool                 = tg->_pool;
     t->set_event_type(ev_type);
     t->schedule_spawn(&thread_initializer);
   }
@@ -397,6 +412,17 @@ EventProcessor::spawn_event_threads(EventType ev_type, int n_threads, size_t sta
   return ev_type; // useless but not sure what would be better.
 }
 
+EventType
+EventProcessor::spawn_task_pool(EventType ev_type, int n_threads, size_t stacksize)
+{
+  ThreadGroupDescriptor *tg = &(thread_group[ev_type]);
+
+  ink_release_assert(tg->_pool == nullptr && tg->_count == 0);
+  TaskPool::register_stats();
+  tg->_pool = new TaskPool(tg->_thread, n_threads);
+  return this->spawn_event_threads(ev_type, n_threads, stacksize);
+}
+
 // This is called from inside a thread as the @a start_event for that thread.  It chains to the
 // startup events for the appropriate thread group start events.
 void
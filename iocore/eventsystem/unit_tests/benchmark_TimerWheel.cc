@@ -0,0 +1,147 @@
+/** @file
+
+  Timer queue cost with a million outstanding timers, TimerWheel against PriorityEventQueue
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "I_EventSystem.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+// Inactivity timeouts of a busy proxy: many connections, timeouts of seconds to minutes.
+constexpr int BENCH_TIMERS = 1000000;
+constexpr int BENCH_LOOPS  = 10000; // event loops of 1ms, so 10s
+
+// Run the event loop @a loops times, re-arming every timer that fires like a periodic timeout would.
+template <class Q>
+int64_t
+turn(Q &q, ink_hrtime &now, int loops, ink_hrtime timeout, bool exact)
+{
+  int64_t fired = 0;
+  for (int i = 0; i < loops; ++i) {
+    now += HRTIME_MSECOND;
+    q.check_ready(now, this_ethread());
+    Event *e;
+    while ((e = q.dequeue_ready(now))) {
+      if (exact) {
+        // Never early, at most a tick late.
+        REQUIRE(e->timeout_at <= now);
+        REQUIRE(e->timeout_at > now - 2 * TW_TICK);
+      }
+      ++fired;
+      e->timeout_at = now + timeout;
+      q.enqueue(e, now);
+    }
+  }
+  return fired;
+}
+
+template <class Q>
+void
+run(const char *name, std::vector<Event *> &events, const std::vector<ink_hrtime> &timeouts, bool exact)
+{
+  Q *q           = new Q;
+  ink_hrtime now = Thread::get_hrtime_updated();
+
+  ink_hrtime start = ink_get_hrtime_internal();
+  for (int i = 0; i < BENCH_TIMERS; ++i) {
+    events[i]->timeout_at = now + timeouts[i];
+    q->enqueue(events[i], now);
+  }
+  ink_hrtime scheduled = ink_get_hrtime_internal();
+  // Activity on every connection pushes its timeout back.
+  for (int i = 0; i < BENCH_TIMERS; ++i) {
+    q->remove(events[i]);
+    events[i]->timeout_at = now + timeouts[i] + HRTIME_SECOND;
+    q->enqueue(events[i], now);
+  }
+  ink_hrtime rescheduled = ink_get_hrtime_internal();
+  int64_t fired          = turn(*q, now, BENCH_LOOPS, HRTIME_SECONDS(60), exact);
+  ink_hrtime turned      = ink_get_hrtime_internal();
+
+  printf("%s: %d timers, schedule %.1f ns, reschedule %.1f ns per timer, %.1f us per 1ms loop, %" PRId64 " fired\n", name,
+         BENCH_TIMERS, static_cast<double>(scheduled - start) / BENCH_TIMERS,
+         static_cast<double>(rescheduled - scheduled) / BENCH_TIMERS,
+         static_cast<double>(turned - rescheduled) / BENCH_LOOPS / HRTIME_USECOND, fired);
+
+  int i = 0;
+  BENCHMARK(std::string(name) + ": reschedule one of 1M")
+  {
+    Event *e = events[i % BENCH_TIMERS];
+    q->remove(e);
+    e->timeout_at = now + timeouts[i++ % BENCH_TIMERS];
+    q->enqueue(e, now);
+    return e;
+  };
+
+  for (Event *e : events) {
+    q->remove(e);
+  }
+  delete q;
+}
+
+} // namespace
+
+TEST_CASE("Timer queues", "[eventsystem][timer][benchmark]")
+{
+  std::mt19937_64 rng(42);
+  std::uniform_int_distribution<ink_hrtime> spread(HRTIME_SECONDS(1), HRTIME_SECONDS(120));
+  std::vector<Event *> events(BENCH_TIMERS);
+  std::vector<ink_hrtime> timeouts(BENCH_TIMERS);
+  for (int i = 0; i < BENCH_TIMERS; ++i) {
+    events[i]   = eventAllocator.alloc();
+    timeouts[i] = spread(rng);
+  }
+
+  run<PriorityEventQueue>("priority queue", events, timeouts, false);
+  run<TimerWheel>("timer wheel", events, timeouts, true);
+
+  for (Event *e : events) {
+    eventAllocator.free(e);
+  }
+}
+
+struct EventSystemListener : Catch::TestEventListenerBase {
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void
+  testRunStarting(Catch::TestRunInfo const &testRunInfo) override
+  {
+    Layout::create();
+    init_diags("", nullptr);
+    RecProcessInit(RECM_STAND_ALONE);
+    ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
+
+    EThread *main_thread = new EThread;
+    main_thread->set_specific();
+  }
+};
+
+CATCH_REGISTER_LISTENER(EventSystemListener);
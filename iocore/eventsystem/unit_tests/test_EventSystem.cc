@@ -30,9 +30,135 @@
 
 #include "diags.i"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 #define TEST_TIME_SECOND 60
 #define TEST_THREADS 2
 
+// Runs before "EventSystem", which shuts the event system down.
+TEST_CASE("EventSystem external queue", "[iocore][event_queue]")
+{
+  static constexpr int PRODUCERS = 4;
+  static constexpr int EVENTS    = 10000;
+  static std::atomic<int> received{0};
+
+  struct counter : public Continuation {
+    counter(ProxyMutex *m) : Continuation(m) { SET_HANDLER(&counter::count); }
+
+    int
+    count(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+    {
+      received++;
+      return 0;
+    }
+  };
+
+  // Schedule from threads which are not event threads, so every event goes through the external queue.
+  EThread *target = eventProcessor.thread_group[ET_CALL]._thread[0];
+  counter *c      = new counter(new_ProxyMutex());
+  std::vector<std::thread> producers;
+  for (int p = 0; p < PRODUCERS; ++p) {
+    producers.emplace_back([target, c]() {
+      for (int i = 0; i < EVENTS; ++i) {
+        target->schedule_imm(c);
+      }
+    });
+  }
+  for (auto &t : producers) {
+    t.join();
+  }
+
+  for (int i = 0; i < 1000 && received < PRODUCERS * EVENTS; ++i) {
+    usleep(10000);
+  }
+  REQUIRE(received == PRODUCERS * EVENTS);
+}
+
+// Runs before "EventSystem", which shuts the event system down.
+TEST_CASE("EventSystem task pool", "[iocore][task_pool]")
+{
+  static constexpr int QUICK = 100;
+  static std::atomic<int> pinned_done{0};
+  static std::atomic<int> unpinned_done{0};
+  static std::atomic<bool> slow_done{false};
+  static std::atomic<EThread *> slow_thread{nullptr};
+
+  struct slow_job : public Continuation {
+    slow_job(ProxyMutex *m) : Continuation(m) { SET_HANDLER(&slow_job::run); }
+
+    int
+    run(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+    {
+      slow_thread = this_ethread();
+      sleep(2);
+      slow_done = true;
+      return 0;
+    }
+  };
+
+  struct quick_job : public Continuation {
+    quick_job(ProxyMutex *m) : Continuation(m) { SET_HANDLER(&quick_job::run); }
+
+    int
+    run(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+    {
+      if (pinned) {
+        // Left to the thread it is pinned to, behind the slow job.
+        CHECK(this_ethread() == slow_thread);
+        CHECK(slow_done);
+        pinned_done++;
+      } else {
+        // Queued for either thread, stolen from the busy one.
+        CHECK(this_ethread() != slow_thread);
+        CHECK(!slow_done);
+        unpinned_done++;
+      }
+      return 0;
+    }
+
+    bool pinned = false;
+  };
+
+  EventType pool = eventProcessor.register_event_type("ET_TEST_POOL");
+  eventProcessor.spawn_task_pool(pool, 2, 1048576);
+  for (int i = 0; i < 100 && eventProcessor.thread_group[pool]._started < 2; ++i) {
+    usleep(10000);
+  }
+  REQUIRE(eventProcessor.thread_group[pool]._started == 2);
+
+  // Keep the first thread of the pool busy.
+  EThread *first = eventProcessor.thread_group[pool]._thread[0];
+  slow_job *slow = new slow_job(new_ProxyMutex());
+  slow->setThreadAffinity(first);
+  eventProcessor.schedule_imm(slow, pool);
+  while (slow_thread == nullptr) {
+    usleep(1000);
+  }
+  REQUIRE(slow_thread == first);
+
+  for (int i = 0; i < QUICK; ++i) {
+    quick_job *pinned = new quick_job(new_ProxyMutex());
+    pinned->pinned    = true;
+    pinned->setThreadAffinity(first);
+    eventProcessor.schedule_imm(pinned, pool);
+    eventProcessor.schedule_imm(new quick_job(new_ProxyMutex()), pool);
+  }
+
+  for (int i = 0; i < 100 && unpinned_done < QUICK; ++i) {
+    usleep(10000);
+  }
+  REQUIRE(unpinned_done == QUICK);
+  CHECK(pinned_done == 0);
+  CHECK(!slow_done);
+
+  for (int i = 0; i < 400 && pinned_done < QUICK; ++i) {
+    usleep(10000);
+  }
+  CHECK(pinned_done == QUICK);
+}
+
 TEST_CASE("EventSystem", "[iocore]")
 {
   static int count;
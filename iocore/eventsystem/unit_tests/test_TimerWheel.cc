@@ -0,0 +1,235 @@
+/** @file
+
+  Catch based unit tests for TimerWheel
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "I_EventSystem.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+#include <vector>
+
+namespace
+{
+// The first tick boundary after the current time, which the wheel of @a q has not turned past yet.
+ink_hrtime
+start_tick(TimerWheel &q)
+{
+  ink_hrtime now = (Thread::get_hrtime_updated() / TW_TICK + 1) * TW_TICK;
+  q.check_ready(now, this_ethread());
+  return now;
+}
+
+Event *
+new_timer(TimerWheel &q, ink_hrtime now, ink_hrtime timeout_at)
+{
+  Event *e      = eventAllocator.alloc();
+  e->timeout_at = timeout_at;
+  q.enqueue(e, now);
+  return e;
+}
+
+// Turn the wheel up to @a now and return what it found due.
+std::vector<Event *>
+turn(TimerWheel &q, ink_hrtime now)
+{
+  std::vector<Event *> fired;
+  q.check_ready(now, this_ethread());
+  Event *e;
+  while ((e = q.dequeue_ready(now))) {
+    CHECK(!e->in_the_priority_queue);
+    fired.push_back(e);
+  }
+  return fired;
+}
+
+void
+free_timers(const std::vector<Event *> &events)
+{
+  for (Event *e : events) {
+    eventAllocator.free(e);
+  }
+}
+} // namespace
+
+TEST_CASE("TimerWheel fires on the tick", "[eventsystem][timer]")
+{
+  TimerWheel q;
+  ink_hrtime start = start_tick(q);
+  CHECK(q.size() == 0);
+  CHECK(q.earliest_timeout() == start + HRTIME_FOREVER);
+
+  std::vector<Event *> events;
+  for (int i = 1; i <= 5; ++i) {
+    events.push_back(new_timer(q, start, start + i * TW_TICK));
+  }
+  // Between two ticks, rounded up to the later one.
+  Event *late = new_timer(q, start, start + 3 * TW_TICK + 1);
+  CHECK(q.size() == 6);
+  CHECK(q.earliest_timeout() == start + TW_TICK);
+
+  for (int i = 1; i <= 5; ++i) {
+    ink_hrtime tick = start + i * TW_TICK;
+    // Never before the timeout.
+    CHECK(turn(q, tick - 1).empty());
+    std::vector<Event *> fired = turn(q, tick);
+    if (i == 4) {
+      REQUIRE(fired.size() == 2);
+      CHECK(fired[1] == late);
+    } else {
+      REQUIRE(fired.size() == 1);
+    }
+    CHECK(fired[0] == events[i - 1]);
+  }
+  CHECK(q.size() == 0);
+
+  events.push_back(late);
+  free_timers(events);
+}
+
+TEST_CASE("TimerWheel remove", "[eventsystem][timer]")
+{
+  TimerWheel q;
+  ink_hrtime start = start_tick(q);
+
+  Event *a = new_timer(q, start, start + 10 * TW_TICK);
+  Event *b = new_timer(q, start, start + 10 * TW_TICK);
+  Event *c = new_timer(q, start, start + HRTIME_SECONDS(30));
+  // Already due, straight to the ready list.
+  Event *d = new_timer(q, start, start - TW_TICK);
+  CHECK(q.size() == 4);
+
+  q.remove(b);
+  q.remove(c);
+  q.remove(d);
+  CHECK(!b->in_the_priority_queue);
+  CHECK(q.size() == 1);
+  // Nothing left but in the slot of a.
+  CHECK(q.earliest_timeout() == start + 10 * TW_TICK);
+
+  std::vector<Event *> fired = turn(q, start + HRTIME_SECONDS(60));
+  REQUIRE(fired.size() == 1);
+  CHECK(fired[0] == a);
+  CHECK(q.size() == 0);
+
+  // Re-armed after a remove, it fires at its new timeout.
+  b->timeout_at = start + HRTIME_SECONDS(61);
+  q.enqueue(b, start + HRTIME_SECONDS(60));
+  q.remove(b);
+  b->timeout_at = start + HRTIME_SECONDS(62);
+  q.enqueue(b, start + HRTIME_SECONDS(60));
+  CHECK(turn(q, start + HRTIME_SECONDS(62) - 1).empty());
+  fired = turn(q, start + HRTIME_SECONDS(62));
+  REQUIRE(fired.size() == 1);
+  CHECK(fired[0] == b);
+
+  free_timers({a, b, c, d});
+}
+
+TEST_CASE("TimerWheel cascades across the levels", "[eventsystem][timer]")
+{
+  TimerWheel q;
+  ink_hrtime start = start_tick(q);
+
+  // One timeout for each level, 256ms, 65s, 4.6h and 49 days, and one past them in the overflow list.
+  std::vector<ink_hrtime> timeouts = {HRTIME_MSECONDS(100), HRTIME_MSECONDS(300), HRTIME_SECONDS(70), HRTIME_HOURS(5),
+                                      HRTIME_DAYS(60)};
+  std::vector<Event *> events;
+  for (ink_hrtime timeout : timeouts) {
+    events.push_back(new_timer(q, start, start + timeout));
+  }
+  CHECK(q.size() == static_cast<int64_t>(timeouts.size()));
+
+  // Sleep until the earliest timeout like the event loop does, every event fires on its own tick and in order.
+  ink_hrtime now = start;
+  size_t next    = 0;
+  while (q.size()) {
+    ink_hrtime wake = q.earliest_timeout();
+    REQUIRE(wake > now);
+    REQUIRE(wake <= events[next]->timeout_at);
+    now                        = wake;
+    std::vector<Event *> fired = turn(q, now);
+    for (Event *e : fired) {
+      REQUIRE(next < events.size());
+      CHECK(e == events[next]);
+      CHECK(e->timeout_at == now);
+      ++next;
+    }
+  }
+  CHECK(next == events.size());
+
+  // Stepping by ticks instead, nothing fires a tick early after cascading from the top level.
+  for (size_t i = 0; i < timeouts.size(); ++i) {
+    events[i]->timeout_at = now + timeouts[i];
+    q.enqueue(events[i], now);
+  }
+  for (size_t i = 0; i < timeouts.size(); ++i) {
+    CHECK(turn(q, events[i]->timeout_at - TW_TICK).empty());
+    CHECK(turn(q, events[i]->timeout_at - 1).empty());
+    std::vector<Event *> fired = turn(q, events[i]->timeout_at);
+    REQUIRE(fired.size() == 1);
+    CHECK(fired[0] == events[i]);
+  }
+  CHECK(q.size() == 0);
+
+  free_timers(events);
+}
+
+TEST_CASE("TimerWheel frees cancelled events as they cascade", "[eventsystem][timer]")
+{
+  TimerWheel q;
+  ink_hrtime start = start_tick(q);
+
+  Event *kept      = new_timer(q, start, start + HRTIME_SECONDS(70));
+  Event *cancelled = new_timer(q, start, start + HRTIME_SECONDS(70));
+  // Cancelled without a remove(), like Event::cancel() from another thread.
+  cancelled->cancelled = 1;
+  CHECK(q.size() == 2);
+
+  std::vector<Event *> fired = turn(q, start + HRTIME_SECONDS(70));
+  REQUIRE(fired.size() == 1);
+  CHECK(fired[0] == kept);
+  CHECK(q.size() == 0);
+
+  free_timers(fired);
+}
+
+struct EventSystemListener : Catch::TestEventListenerBase {
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void
+  testRunStarting(Catch::TestRunInfo const &testRunInfo) override
+  {
+    Layout::create();
+    init_diags("", nullptr);
+    RecProcessInit(RECM_STAND_ALONE);
+    ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
+
+    EThread *main_thread = new EThread;
+    main_thread->set_specific();
+  }
+};
+
+CATCH_REGISTER_LISTENER(EventSystemListener);
@@ -656,6 +656,16 @@ public:
     return 0;
   }
 
+  /**
+   * Returns true if blocks of file data (IOBufferFile) can be written
+   * to this connection, the kernel sends them from the file.
+   */
+  virtual bool
+  sends_file_blocks() const
+  {
+    return false;
+  }
+
   /** Structure holding user options. */
   NetVCOptions options;
 
@@ -79,6 +79,9 @@ public:
 
   bool default_inactivity_timeout = false;
 
+  /// Files this NetEvent in the NetHandler timeout wheel, the cookie points back here.
+  Event timeout_event;
+
   LINK(NetEvent, open_link);
   LINK(NetEvent, cop_link);
   LINKM(NetEvent, read, ready_link)
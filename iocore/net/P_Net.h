@@ -59,6 +59,7 @@ enum Net_Stats {
   net_connections_throttled_in_stat,
   net_connections_throttled_out_stat,
   net_requests_max_throttled_in_stat,
+  net_zero_copy_write_bytes_stat,
   Net_Stat_Count
 };
 
@@ -184,6 +184,12 @@ public:
   UDPConnection *get_udp_con();
   virtual void net_read_io(NetHandler *nh, EThread *lthread) override;
   virtual int64_t load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf, int64_t &total_written, int &needs) override;
+  // Data is encrypted on its way out, it cannot be sent straight from a file.
+  bool
+  sends_file_blocks() const override
+  {
+    return false;
+  }
 
   int populate_protocol(std::string_view *results, int n) const override;
   const char *protocol_contains(std::string_view tag) const override;
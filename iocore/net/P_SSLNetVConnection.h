@@ -134,6 +134,20 @@ public:
   int sslClientHandShakeEvent(int &err);
   void net_read_io(NetHandler *nh, EThread *lthread) override;
   int64_t load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf, int64_t &total_written, int &needs) override;
+  // Data is encrypted on its way out, it cannot be sent straight from a file.
+  bool
+  sends_file_blocks() const override
+  {
+    return false;
+  }
+#if TS_USE_LINUX_IO_URING_NET
+  // The SSL library does its own socket reads and writes.
+  NetURing *
+  get_uring() const override
+  {
+    return nullptr;
+  }
+#endif
   void do_io_close(int lerrno = -1) override;
 
   ////////////////////////////////////////////////////////////
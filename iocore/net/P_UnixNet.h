@@ -79,6 +79,7 @@ class NetEvent;
 class UnixUDPConnection;
 struct DNSConnection;
 struct NetAccept;
+struct NetURingOp;
 
 /// Unified API for setting and clearing kernel and epoll events.
 struct EventIO {
@@ -96,6 +97,9 @@ struct EventIO {
     NetAccept *na;
     UnixUDPConnection *uc;
   } data; ///< a kind of continuation
+#if TS_USE_LINUX_IO_URING_NET
+  NetURingOp *uring_op = nullptr; ///< the multishot poll or accept when the event loop is an io_uring
+#endif
 
   /** The start methods all logically Setup a class to be called
      when a file descriptor is available for read or write.
@@ -141,6 +145,7 @@ struct EventIO {
 #include "P_DNSConnection.h"
 #include "P_UnixUDPConnection.h"
 #include "P_UnixPollDescriptor.h"
+#include "P_UnixNetURing.h"
 #include <limits>
 
 class NetEvent;
@@ -316,6 +321,23 @@ public:
   /// This enables signaling the correct instances when the configuration is updated.
   /// Event type threads that use @c NetHandler must set the corresponding bit.
   static std::bitset<std::numeric_limits<unsigned int>::digits> active_thread_types;
+  /// Pipe that memory written with vmsplice(2) goes through to a socket, made on first use.
+  int splice_pipe[2] = {NO_FD, NO_FD};
+
+  /** Per connection timeouts.
+
+      Each NetEvent in the open_list files its @c timeout_event in this wheel, due at the earliest of
+      its inactivity and active timeouts. Activity only pushes a deadline out, so it does not touch
+      the wheel: when the event comes due the NetEvent is checked and filed again if its deadline
+      moved. Only connections that expired, or whose deadline moved, are visited.
+
+      If @c per_connection_timeouts is off the InactivityCop scans the open_list every
+      proxy.config.net.inactivity_check_frequency seconds instead.
+  */
+  TimerWheel timeout_wheel;
+  bool per_connection_timeouts = true;
+  /// How long a NetEvent waits to be looked at again when a timeout callback left it in place.
+  ink_hrtime timeout_retry = HRTIME_SECONDS(1);
 
   int mainNetEvent(int event, Event *data);
   int waitForActivity(ink_hrtime timeout) override;
@@ -355,7 +377,8 @@ public:
 
   /**
     Start to handle active timeout and inactivity timeout on a NetEvent.
-    Put the ne into open_list. All NetEvents in the open_list is checked for timeout by InactivityCop.
+    Put the ne into open_list. All NetEvents in the open_list is checked for timeout by InactivityCop,
+    or by the timeout wheel if per_connection_timeouts is set.
     Only be called when holding the mutex of this NetHandler and must call startIO(ne) first.
 
     @param ne NetEvent to be managed by InactivityCop
@@ -371,6 +394,18 @@ public:
    */
   void stopCop(NetEvent *ne);
 
+  /**
+    Make sure the timeout wheel looks at @a ne no later than its earliest timeout.
+    Only be called on the thread of this NetHandler.
+
+    @param ne NetEvent whose timeouts were set or shortened.
+   */
+  void arm_timeout(NetEvent *ne);
+  /// Take @a ne out of the timeout wheel.
+  void disarm_timeout(NetEvent *ne);
+  /// Check the NetEvents whose timeout wheel events are due at @a now.
+  void expire_timeouts(ink_hrtime now);
+
   // Signal the epoll_wait to terminate.
   void signalActivity() override;
 
@@ -382,9 +417,12 @@ public:
   void free_netevent(NetEvent *ne);
 
   NetHandler();
+  ~NetHandler() override;
 
 private:
   void _close_ne(NetEvent *ne, ink_hrtime now, int &handle_event, int &closed, int &total_idle_time, int &total_idle_count);
+  void _file_timeout(NetEvent *ne, ink_hrtime at);
+  void _check_timeout(NetEvent *ne, ink_hrtime now);
 
   /// Static method used as the callback for runtime configuration updates.
   static int update_nethandler_config(const char *name, RecDataT, RecData data, void *);
@@ -654,6 +692,11 @@ EventIO::start_common(EventLoop l, int afd, int e)
 
   fd         = afd;
   event_loop = l;
+#if TS_USE_LINUX_IO_URING_NET
+  if (l->uring) {
+    return l->uring->start(this, e);
+  }
+#endif
 #if TS_USE_EPOLL
   struct epoll_event ev;
   memset(&ev, 0, sizeof(ev));
@@ -819,6 +862,13 @@ EventIO::stop()
   }
   if (event_loop) {
     int retval = 0;
+#if TS_USE_LINUX_IO_URING_NET
+    if (event_loop->uring) {
+      event_loop->uring->stop(this);
+      event_loop = nullptr;
+      return retval;
+    }
+#endif
 #if TS_USE_EPOLL
     struct epoll_event ev;
     memset(&ev, 0, sizeof(struct epoll_event));
@@ -889,6 +939,9 @@ NetHandler::startCop(NetEvent *ne)
   ink_assert(!open_list.in(ne));
 
   open_list.enqueue(ne);
+  if (per_connection_timeouts) {
+    arm_timeout(ne);
+  }
 }
 
 TS_INLINE void
@@ -898,6 +951,7 @@ NetHandler::stopCop(NetEvent *ne)
 
   open_list.remove(ne);
   cop_list.remove(ne);
+  disarm_timeout(ne);
   remove_from_keep_alive_queue(ne);
   remove_from_active_queue(ne);
 }
@@ -0,0 +1,171 @@
+/** @file
+
+  A per thread io_uring that can stand in for epoll in the NetHandler loop.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include "tscore/ink_config.h"
+
+#if TS_USE_LINUX_IO_URING_NET
+
+#include <liburing.h>
+#include <deque>
+
+#include "I_EventSystem.h"
+#include "I_Net.h"
+
+struct EventIO;
+struct PollDescriptor;
+class UnixNetVConnection;
+
+/** One request on a @c NetURing, the ring's user data points at it.
+
+    Readiness (@c POLL) and accepts (@c ACCEPT) are multishot requests owned by an @c EventIO.
+    Receives and sends are single requests owned by a @c UnixNetVConnection, which picks up the
+    result on its next pass through the read or write code. An owner that goes away only clears
+    its pointer, the ring frees the request once the kernel is done with it.
+ */
+struct NetURingOp {
+  enum Type { POLL, ACCEPT, RECV, SEND };
+
+  Type type;
+  int fd                 = NO_FD;
+  int events             = 0;       ///< Poll mask, for @c POLL.
+  EventIO *ep            = nullptr; ///< Owner of a @c POLL or @c ACCEPT, cleared when it stops.
+  UnixNetVConnection *vc = nullptr; ///< Owner of a @c RECV or @c SEND, cleared when it lets go.
+  bool armed             = false;   ///< The request is still active in the kernel.
+  bool delayed           = false;   ///< Waiting on the re-arm list.
+  bool remote            = false;   ///< Stopped from another thread, waiting for the owner to cancel it.
+  int pending            = 0;       ///< Submissions the kernel has yet to complete for this request.
+  int64_t result         = 0;       ///< Completion result of a @c RECV or @c SEND.
+  int64_t length         = 0;       ///< Bytes a @c RECV asked for.
+  int buffer             = -1;      ///< Provided buffer holding the data of a @c RECV.
+  int64_t offset         = 0;       ///< Bytes of @a buffer already moved to the VIO buffer.
+  /// Read readiness a @c POLL has reported, and for a @c RECV how much of it its owner's poll had when it completed.
+  unsigned readable = 0;
+  std::deque<int> accepted;         ///< Accepted sockets, or negated errors, not yet taken by the @c NetAccept.
+
+  // A @c SEND keeps the blocks it points into alive. @a reader is only compared, never followed.
+  Ptr<IOBufferBlock> blocks;
+  IOBufferReader *reader = nullptr;
+  IOVec iov[NET_MAX_IOV];
+  struct msghdr msg;
+
+  SLINK(NetURingOp, link);
+  SLINK(NetURingOp, remote_link);
+
+  explicit NetURingOp(Type t) : type(t) {}
+
+  bool
+  in_flight() const
+  {
+    return armed;
+  }
+
+  /// Take the next connection off an @c ACCEPT, @c -EAGAIN if there is none.
+  int
+  pop_accepted()
+  {
+    if (accepted.empty()) {
+      return -EAGAIN;
+    }
+    int fd = accepted.front();
+    accepted.pop_front();
+    return fd;
+  }
+};
+
+/** An io_uring that takes the place of epoll for a net thread.
+
+    @c EventIO readiness becomes multishot polls, and listen sockets get a multishot accept. The
+    completions are translated into the @c PollDescriptor result array so the rest of the
+    NetHandler loop is unchanged. Plain TCP connections also queue their receives, into a ring of
+    provided buffers, and their sends on the ring. Everything queued during a loop iteration goes
+    to the kernel in the single submit and wait at the top of the next one.
+
+    All of it runs on the owning thread, except @c stop which may be called from another thread
+    when a connection migrates.
+ */
+class NetURing
+{
+public:
+  static constexpr unsigned ENTRIES          = 4096;
+  static constexpr unsigned RECV_BUFFERS     = 512;
+  static constexpr unsigned RECV_BUFFER_SIZE = 16384;
+  static constexpr int RECV_GROUP            = 0;
+
+  /// Set up a ring for @a thread, @c nullptr if the kernel can't provide what the net loop needs.
+  static NetURing *create(EThread *thread);
+  ~NetURing();
+
+  /// Start readiness, or accepting for a @c NetAccept, for @a ep.
+  int start(EventIO *ep, int events);
+  /// Stop what @c start set up for @a ep.
+  void stop(EventIO *ep);
+
+  /// Queue a receive of up to @a len bytes for @a vc.
+  NetURingOp *recv(UnixNetVConnection *vc, int64_t len);
+  /// Queue a send of @a niov vectors for @a vc, pointing into the blocks of @a reader.
+  NetURingOp *send(UnixNetVConnection *vc, const IOVec *iov, unsigned niov, IOBufferReader *reader);
+  /// Data of a completed receive not yet moved to the VIO buffer.
+  const char *recv_data(const NetURingOp *op) const;
+  /// The owner is done with @a op, cancel it if it is still in flight.
+  void release(NetURingOp *op);
+  /** Cancel @a op from any thread and wait for the kernel to let go of it.
+
+      @return @c true if @a op was cancelled before it completed, @c false if it had completed already
+      or the kernel can't cancel synchronously. The owner still has to @c release it.
+   */
+  bool cancel_sync(NetURingOp *op);
+
+  /** Submit everything queued and wait up to @a timeout_ms for completions.
+
+      Readiness and accepts are stored in @a pd, receives and sends put their connection on the
+      NetHandler ready lists.
+   */
+  void poll(PollDescriptor *pd, int timeout_ms);
+
+private:
+  explicit NetURing(EThread *thread);
+
+  io_uring_sqe *_get_sqe();
+  void _arm(NetURingOp *op);
+  void _cancel(NetURingOp *op);
+  void _complete(PollDescriptor *pd, io_uring_cqe *cqe);
+  void _trigger(PollDescriptor *pd, EventIO *ep, int events);
+  void _unref(NetURingOp *op);
+  void _recycle(int bid);
+
+  EThread *_thread = nullptr;
+  io_uring _ring;
+  bool _ring_ready             = false;
+  io_uring_buf_ring *_buf_ring = nullptr;
+  char *_buf_base              = nullptr;
+
+  /// Requests stopped from another thread, cancelled on the next @c poll.
+  ASLL(NetURingOp, remote_link) _remote_stops;
+  /// Accepts that ended on an error, re-armed after the accept throttle delay.
+  SList(NetURingOp, link) _rearm;
+  ink_hrtime _rearm_at = 0;
+};
+
+#endif // TS_USE_LINUX_IO_URING_NET
@@ -41,6 +41,8 @@
 class UnixNetVConnection;
 class NetHandler;
 struct PollDescriptor;
+class NetURing;
+struct NetURingOp;
 
 inline void
 NetVCOptions::reset()
@@ -158,6 +160,8 @@ public:
   // UNIX implementation //
   /////////////////////////
   void set_enabled(VIO *vio);
+  /// Tell the NetHandler a timeout was set or moved closer.
+  void rearm_timeout();
 
   void get_local_sa();
 
@@ -224,6 +228,14 @@ public:
   }
 
   virtual int64_t load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf, int64_t &total_written, int &needs);
+  bool sends_file_blocks() const override;
+  bool zero_copy_block(IOBufferBlock *b) const;
+  int64_t zero_copy_write(IOBufferReader *reader, int64_t len);
+  void release_spliced(bool closing);
+#if TS_USE_LINUX_IO_URING_NET
+  /// The thread's io_uring, if reads and writes of this connection may go through it.
+  virtual NetURing *get_uring() const;
+#endif
   void readDisable(NetHandler *nh);
   void readSignalError(NetHandler *nh, int err);
   int readSignalDone(int event, NetHandler *nh);
@@ -247,6 +259,16 @@ public:
   bool from_accept_thread  = false;
   NetAccept *accept_object = nullptr;
 
+  /// Memory written with vmsplice(2), held until the socket has sent it.
+  Ptr<IOBufferBlock> spliced;
+  IOBufferBlock *spliced_tail = nullptr;
+
+#if TS_USE_LINUX_IO_URING_NET
+  /// Receive and send on the thread's io_uring, in flight or completed but not yet picked up.
+  NetURingOp *read_op  = nullptr;
+  NetURingOp *write_op = nullptr;
+#endif
+
   int startEvent(int event, Event *e);
   int acceptEvent(int event, Event *e);
   int mainEvent(int event, Event *e);
@@ -339,6 +361,7 @@ UnixNetVConnection::set_active_timeout(ink_hrtime timeout_in)
   Debug("socket", "Set active timeout=%" PRId64 ", NetVC=%p", timeout_in, this);
   active_timeout_in        = timeout_in;
   next_activity_timeout_at = (active_timeout_in > 0) ? Thread::get_hrtime() + timeout_in : 0;
+  rearm_timeout();
 }
 
 inline void
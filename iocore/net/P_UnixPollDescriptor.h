@@ -44,6 +44,8 @@
 
 typedef struct pollfd Pollfd;
 
+class NetURing;
+
 struct PollDescriptor {
   int result; // result of poll
 #if TS_USE_EPOLL
@@ -52,6 +54,9 @@ struct PollDescriptor {
   Pollfd pfd[POLL_DESCRIPTOR_SIZE];
   struct epoll_event ePoll_Triggered_Events[POLL_DESCRIPTOR_SIZE];
 #endif
+#if TS_USE_LINUX_IO_URING_NET
+  NetURing *uring = nullptr; // polls through an io_uring instead of epoll_fd when set
+#endif
 #if TS_USE_KQUEUE
   int kqueue_fd;
 #endif
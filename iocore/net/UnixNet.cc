@@ -41,7 +41,9 @@ extern "C" void fd_reify(struct ev_loop *);
 
 // INKqa10496
 // One Inactivity cop runs on each thread once every second and
-// loops through the list of NetEvents and calls the timeouts
+// loops through the list of NetEvents and calls the timeouts.
+// With per connection timeouts the NetHandler timeout wheel calls
+// the timeouts and the cop only manages the connection queues.
 class InactivityCop : public Continuation
 {
 public:
@@ -53,6 +55,12 @@ public:
     ink_hrtime now = Thread::get_hrtime();
     NetHandler &nh = *get_NetHandler(this_ethread());
 
+    if (nh.per_connection_timeouts) {
+      nh.manage_active_queue(nullptr, true);
+      nh.manage_keep_alive_queue();
+      return 0;
+    }
+
     Debug("inactivity_cop_check", "Checking inactivity on Thread-ID #%d", this_ethread()->id);
     // The rest NetEvents in cop_list which are not triggered between InactivityCop runs.
     // Use pop() to catch any closes caused by callbacks.
@@ -172,6 +180,12 @@ PollCont::do_poll(ink_hrtime timeout)
     }
   }
 // wait for fd's to trigger, or don't wait if timeout is 0
+#if TS_USE_LINUX_IO_URING_NET
+  if (pollDescriptor->uring) {
+    pollDescriptor->uring->poll(pollDescriptor, poll_timeout);
+    return;
+  }
+#endif
 #if TS_USE_EPOLL
   pollDescriptor->result =
     epoll_wait(pollDescriptor->epoll_fd, pollDescriptor->ePoll_Triggered_Events, POLL_DESCRIPTOR_SIZE, poll_timeout);
@@ -246,12 +260,25 @@ initialize_thread_for_net(EThread *thread)
 
   InactivityCop *inactivityCop = new InactivityCop(get_NetHandler(thread)->mutex);
   int cop_freq                 = 1;
+  int per_connection_timeouts  = 1;
 
   REC_ReadConfigInteger(cop_freq, "proxy.config.net.inactivity_check_frequency");
+  REC_ReadConfigInteger(per_connection_timeouts, "proxy.config.net.per_connection_timeouts");
   memcpy(&nh->config, &NetHandler::global_config, sizeof(NetHandler::global_config));
   nh->configure_per_thread_values();
+  nh->per_connection_timeouts = per_connection_timeouts != 0;
+  nh->timeout_retry           = HRTIME_SECONDS(cop_freq);
   thread->schedule_every(inactivityCop, HRTIME_SECONDS(cop_freq));
 
+#if TS_USE_LINUX_IO_URING_NET
+  int io_uring = 0;
+  REC_ReadConfigInteger(io_uring, "proxy.config.net.io_uring");
+  if (io_uring) {
+    // Must be in place before anything starts an EventIO on this thread.
+    pd->uring = NetURing::create(thread);
+  }
+#endif
+
   thread->set_tail_handler(nh);
   thread->ep = static_cast<EventIO *>(ats_malloc(sizeof(EventIO)));
   new (thread->ep) EventIO();
@@ -270,6 +297,16 @@ NetHandler::NetHandler() : Continuation(nullptr)
   SET_HANDLER((NetContHandler)&NetHandler::mainNetEvent);
 }
 
+NetHandler::~NetHandler()
+{
+  for (int &fd : splice_pipe) {
+    if (fd != NO_FD) {
+      ::close(fd);
+      fd = NO_FD;
+    }
+  }
+}
+
 int
 NetHandler::update_nethandler_config(const char *str, RecDataT, RecData data, void *)
 {
@@ -383,6 +420,10 @@ NetHandler::process_enabled_list()
     if ((ne->read.enabled && ne->read.triggered) || ne->closed) {
       read_ready_list.in_or_enqueue(ne);
     }
+    if (per_connection_timeouts) {
+      // Timeouts set from another thread come through here, whether or not there is something to read.
+      arm_timeout(ne);
+    }
   }
 
   SListM(NetEvent, NetState, write, enable_link) wq(write_enable_list.popall());
@@ -551,6 +592,10 @@ NetHandler::waitForActivity(ink_hrtime timeout)
 
   process_ready_list();
 
+  if (per_connection_timeouts) {
+    expire_timeouts(Thread::get_hrtime());
+  }
+
   return EVENT_CONT;
 }
 
@@ -706,6 +751,125 @@ NetHandler::_close_ne(NetEvent *ne, ink_hrtime now, int &handle_event, int &clos
   }
 }
 
+void
+NetHandler::arm_timeout(NetEvent *ne)
+{
+  // The timeout wheel is only used from its own thread.
+  ink_assert(this->thread == this_ethread());
+
+  // Not handed to the cop yet, startCop() files it.
+  if (!per_connection_timeouts || !open_list.in(ne)) {
+    return;
+  }
+
+  ink_hrtime at = ne->next_inactivity_timeout_at;
+  if (at == 0 && config.default_inactivity_timeout > 0) {
+    // Come back to set the default inactivity timeout, as the InactivityCop would. One that is not
+    // enabled yet is looked at again in case it gets enabled without going through set_enabled().
+    at = Thread::get_hrtime() +
+         ((ne->read.enabled || ne->write.enabled) ? timeout_retry : HRTIME_SECONDS(config.default_inactivity_timeout));
+  }
+  if (ne->next_activity_timeout_at && (at == 0 || ne->next_activity_timeout_at < at)) {
+    at = ne->next_activity_timeout_at;
+  }
+
+  // A NetEvent filed earlier than its deadline is checked and filed again then.
+  Event *e = &ne->timeout_event;
+  if (e->in_the_priority_queue && (at == 0 || e->timeout_at <= at)) {
+    return;
+  }
+  _file_timeout(ne, at);
+}
+
+void
+NetHandler::disarm_timeout(NetEvent *ne)
+{
+  if (ne->timeout_event.in_the_priority_queue) {
+    timeout_wheel.remove(&ne->timeout_event);
+  }
+}
+
+void
+NetHandler::_file_timeout(NetEvent *ne, ink_hrtime at)
+{
+  disarm_timeout(ne);
+  if (at == 0) {
+    return;
+  }
+
+  Event *e      = &ne->timeout_event;
+  e->cookie     = ne;
+  e->timeout_at = at;
+  timeout_wheel.enqueue(e, Thread::get_hrtime());
+}
+
+void
+NetHandler::expire_timeouts(ink_hrtime now)
+{
+  timeout_wheel.check_ready(now, this->thread);
+  // Use dequeue_ready() to catch any closes caused by callbacks.
+  while (Event *e = timeout_wheel.dequeue_ready(now)) {
+    _check_timeout(static_cast<NetEvent *>(e->cookie), now);
+  }
+}
+
+// The InactivityCop check for a single NetEvent.
+void
+NetHandler::_check_timeout(NetEvent *ne, ink_hrtime now)
+{
+  MUTEX_TRY_LOCK(lock, ne->get_mutex(), this->thread);
+  if (!lock.is_locked()) {
+    NET_INCREMENT_DYN_STAT(inactivity_cop_lock_acquire_failure_stat);
+    // Try again on the next loop.
+    _file_timeout(ne, now + TW_TICK);
+    return;
+  }
+
+  if (ne->closed) {
+    free_netevent(ne);
+    return;
+  }
+
+  // set a default inactivity timeout if one is not set
+  if (ne->next_inactivity_timeout_at == 0 && config.default_inactivity_timeout > 0 && (ne->read.enabled || ne->write.enabled)) {
+    Debug("inactivity_cop", "vc: %p inactivity timeout not set, setting a default of %d", ne, config.default_inactivity_timeout);
+    ne->set_default_inactivity_timeout(HRTIME_SECONDS(config.default_inactivity_timeout));
+    NET_INCREMENT_DYN_STAT(default_inactivity_timeout_applied_stat);
+  }
+
+  int event = 0;
+  if (ne->next_inactivity_timeout_at && ne->next_inactivity_timeout_at <= now) {
+    if (ne->is_default_inactivity_timeout()) {
+      NET_INCREMENT_DYN_STAT(default_inactivity_timeout_count_stat);
+    }
+    if (keep_alive_queue.in(ne)) {
+      ink_hrtime diff = (now - (ne->next_inactivity_timeout_at - ne->inactivity_timeout_in)) / HRTIME_SECOND;
+      NET_SUM_DYN_STAT(keep_alive_queue_timeout_total_stat, diff);
+      NET_INCREMENT_DYN_STAT(keep_alive_queue_timeout_count_stat);
+    }
+    Debug("inactivity_cop_verbose", "ne: %p now: %" PRId64 " timeout at: %" PRId64 " timeout in: %" PRId64, ne,
+          ink_hrtime_to_sec(now), ne->next_inactivity_timeout_at, ne->inactivity_timeout_in);
+    event = VC_EVENT_INACTIVITY_TIMEOUT;
+  } else if (ne->next_activity_timeout_at && ne->next_activity_timeout_at <= now) {
+    Debug("inactivity_cop_verbose", "active ne: %p now: %" PRId64 " timeout at: %" PRId64 " timeout in: %" PRId64, ne,
+          ink_hrtime_to_sec(now), ne->next_activity_timeout_at, ne->active_timeout_in);
+    event = VC_EVENT_ACTIVE_TIMEOUT;
+  }
+
+  if (event == 0) {
+    arm_timeout(ne);
+    return;
+  }
+
+  // Look at it again if the callback leaves it open with the timeout still pending. The callback
+  // may free the NetEvent, which takes it out of the wheel.
+  _file_timeout(ne, now + timeout_retry);
+  // create a dummy event
+  Event e;
+  e.ethread = this->thread;
+  ne->callback(event, &e);
+}
+
 void
 NetHandler::add_to_keep_alive_queue(NetEvent *ne)
 {
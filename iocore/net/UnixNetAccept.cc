@@ -431,8 +431,27 @@ NetAccept::acceptFastEvent(int event, void *ep)
 
   do {
     socklen_t sz = sizeof(con.addr);
-    int fd       = socketManager.accept4(server.fd, &con.addr.sa, &sz, SOCK_NONBLOCK | SOCK_CLOEXEC);
-    con.fd       = fd;
+#if TS_USE_LINUX_IO_URING_NET
+    int fd;
+    if (this->ep.uring_op) {
+      // The ring's multishot accept has already taken the connection off the listen queue.
+      if (action_->cancelled) {
+        goto Lerror;
+      }
+      fd = this->ep.uring_op->pop_accepted();
+      if (fd >= 0) {
+        int namelen = sz;
+        safe_getpeername(fd, &con.addr.sa, &namelen);
+      } else {
+        errno = -fd;
+      }
+    } else {
+      fd = socketManager.accept4(server.fd, &con.addr.sa, &sz, SOCK_NONBLOCK | SOCK_CLOEXEC);
+    }
+#else
+    int fd = socketManager.accept4(server.fd, &con.addr.sa, &sz, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#endif
+    con.fd = fd;
 
     if (likely(fd >= 0)) {
       // check for throttle
@@ -532,6 +551,8 @@ Ldone:
   return EVENT_CONT;
 
 Lerror:
+  // Clones share the listen socket, so closing it doesn't take this one out of the event loop.
+  this->ep.stop();
   server.close();
   e->cancel();
   NET_DECREMENT_DYN_STAT(net_accepts_currently_open_stat);
@@ -0,0 +1,416 @@
+/** @file
+
+  A per thread io_uring that can stand in for epoll in the NetHandler loop.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "P_Net.h"
+
+#if TS_USE_LINUX_IO_URING_NET
+
+#include <algorithm>
+
+namespace
+{
+// A cancellation carries the request it cancels with this bit set, requests are 16 byte aligned.
+constexpr uint64_t CANCEL_TAG = 1;
+
+ClassAllocator<NetURingOp, true> netURingOpAllocator("netURingOpAllocator");
+} // namespace
+
+NetURing::NetURing(EThread *thread) : _thread(thread) {}
+
+NetURing *
+NetURing::create(EThread *thread)
+{
+  NetURing *uring = new NetURing(thread);
+
+  int ret = io_uring_queue_init(ENTRIES, &uring->_ring, 0);
+  if (ret < 0) {
+    Warning("io_uring_queue_init failed, the net loop stays on epoll: %s (%d)", strerror(-ret), -ret);
+    delete uring;
+    return nullptr;
+  }
+  uring->_ring_ready = true;
+
+  // Provided buffer rings came in the same kernel as multishot accept, so this also tells us the
+  // kernel can do everything else we ask of it.
+  uring->_buf_ring = io_uring_setup_buf_ring(&uring->_ring, RECV_BUFFERS, RECV_GROUP, 0, &ret);
+  if (uring->_buf_ring == nullptr) {
+    Warning("io_uring_setup_buf_ring failed, the net loop stays on epoll: %s (%d)", strerror(-ret), -ret);
+    delete uring;
+    return nullptr;
+  }
+
+  uring->_buf_base = static_cast<char *>(ats_memalign(ats_pagesize(), static_cast<size_t>(RECV_BUFFERS) * RECV_BUFFER_SIZE));
+  for (unsigned i = 0; i < RECV_BUFFERS; ++i) {
+    io_uring_buf_ring_add(uring->_buf_ring, uring->_buf_base + static_cast<size_t>(i) * RECV_BUFFER_SIZE, RECV_BUFFER_SIZE, i,
+                          io_uring_buf_ring_mask(RECV_BUFFERS), i);
+  }
+  io_uring_buf_ring_advance(uring->_buf_ring, RECV_BUFFERS);
+
+  return uring;
+}
+
+NetURing::~NetURing()
+{
+  if (_buf_ring) {
+    io_uring_free_buf_ring(&_ring, _buf_ring, RECV_BUFFERS, RECV_GROUP);
+  }
+  if (_ring_ready) {
+    io_uring_queue_exit(&_ring);
+  }
+  ats_free(_buf_base);
+}
+
+int
+NetURing::start(EventIO *ep, int events)
+{
+  ink_assert(this_ethread() == _thread);
+  ink_assert(ep->uring_op == nullptr);
+
+  NetURingOp *op = netURingOpAllocator.alloc(ep->type == EVENTIO_NETACCEPT ? NetURingOp::ACCEPT : NetURingOp::POLL);
+  op->fd         = ep->fd;
+  // Multishot polls are edge triggered already and don't take the epoll only flags.
+  op->events   = events & (EPOLLIN | EPOLLOUT | EPOLLPRI | EPOLLRDHUP);
+  op->ep       = ep;
+  ep->uring_op = op;
+  _arm(op);
+
+  return 0;
+}
+
+void
+NetURing::stop(EventIO *ep)
+{
+  NetURingOp *op = ep->uring_op;
+  if (op == nullptr) {
+    return;
+  }
+  ep->uring_op = nullptr;
+
+  if (this_ethread() == _thread) {
+    op->ep = nullptr;
+    _cancel(op);
+  } else {
+    // Migrating connections stop their events from the thread they move to. Only the owner may
+    // touch the ring, so leave the cancel to it and keep it from freeing the request meanwhile.
+    op->remote = true;
+    INK_WRITE_MEMORY_BARRIER;
+    op->ep = nullptr;
+    _remote_stops.push(op);
+  }
+}
+
+NetURingOp *
+NetURing::recv(UnixNetVConnection *vc, int64_t len)
+{
+  NetURingOp *op = netURingOpAllocator.alloc(NetURingOp::RECV);
+  op->fd         = vc->con.fd;
+  op->vc         = vc;
+
+  // The kernel picks the buffer when data arrives, so an idle connection doesn't hold one.
+  op->length        = std::min<int64_t>(len, RECV_BUFFER_SIZE);
+  io_uring_sqe *sqe = _get_sqe();
+  io_uring_prep_recv(sqe, op->fd, nullptr, op->length, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = RECV_GROUP;
+  io_uring_sqe_set_data(sqe, op);
+  op->armed = true;
+  ++op->pending;
+
+  return op;
+}
+
+NetURingOp *
+NetURing::send(UnixNetVConnection *vc, const IOVec *iov, unsigned niov, IOBufferReader *reader)
+{
+  ink_assert(niov > 0 && niov <= NET_MAX_IOV);
+
+  NetURingOp *op = netURingOpAllocator.alloc(NetURingOp::SEND);
+  op->fd         = vc->con.fd;
+  op->vc         = vc;
+  op->blocks     = reader->block;
+  op->reader     = reader;
+  std::copy(iov, iov + niov, op->iov);
+  ink_zero(op->msg);
+  op->msg.msg_iov    = op->iov;
+  op->msg.msg_iovlen = niov;
+
+  io_uring_sqe *sqe = _get_sqe();
+  io_uring_prep_sendmsg(sqe, op->fd, &op->msg, 0);
+  io_uring_sqe_set_data(sqe, op);
+  op->armed = true;
+  ++op->pending;
+
+  return op;
+}
+
+const char *
+NetURing::recv_data(const NetURingOp *op) const
+{
+  ink_assert(op->type == NetURingOp::RECV && op->buffer >= 0);
+  return _buf_base + static_cast<size_t>(op->buffer) * RECV_BUFFER_SIZE + op->offset;
+}
+
+void
+NetURing::release(NetURingOp *op)
+{
+  ink_assert(this_ethread() == _thread);
+  op->vc = nullptr;
+  _cancel(op);
+}
+
+bool
+NetURing::cancel_sync(NetURingOp *op)
+{
+  io_uring_sync_cancel_reg reg;
+  ink_zero(reg);
+  reg.addr            = reinterpret_cast<uint64_t>(op);
+  reg.timeout.tv_sec  = -1;
+  reg.timeout.tv_nsec = -1;
+
+  // Only a system call, it leaves the queues to the owning thread. The completion of a cancelled
+  // request still goes through the owner's next poll.
+  int ret = io_uring_register_sync_cancel(&_ring, &reg);
+  if (ret < 0 && ret != -ENOENT) {
+    Debug("iocore_net_uring", "synchronous cancel failed: %s (%d)", strerror(-ret), -ret);
+  }
+  return ret == 0;
+}
+
+void
+NetURing::poll(PollDescriptor *pd, int timeout_ms)
+{
+  NetURingOp *op = nullptr;
+
+  SList(NetURingOp, remote_link) stops(_remote_stops.popall());
+  while ((op = stops.pop())) {
+    op->remote = false;
+    _cancel(op);
+  }
+
+  if (_rearm.head && Thread::get_hrtime() >= _rearm_at) {
+    while ((op = _rearm.pop())) {
+      op->delayed = false;
+      if (op->ep) {
+        _arm(op);
+      } else {
+        _unref(op);
+      }
+    }
+  }
+
+  // Everything queued since the last call goes to the kernel with the wait.
+  int ret;
+  if (timeout_ms == 0 || io_uring_cq_ready(&_ring) > 0) {
+    ret = io_uring_submit(&_ring);
+  } else {
+    io_uring_cqe *cqe = nullptr;
+    __kernel_timespec ts;
+    ts.tv_sec  = timeout_ms / 1000;
+    ts.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+    ret        = io_uring_submit_and_wait_timeout(&_ring, &cqe, 1, timeout_ms > 0 ? &ts : nullptr, nullptr);
+  }
+  if (ret < 0 && ret != -ETIME && ret != -EINTR) {
+    Debug("iocore_net_uring", "io_uring submit failed: %s (%d)", strerror(-ret), -ret);
+  }
+
+  io_uring_cqe *cqe;
+  unsigned head;
+  unsigned seen = 0;
+
+  pd->result = 0;
+  io_uring_for_each_cqe(&_ring, head, cqe)
+  {
+    // Leave the rest for the next call, which won't wait while they are there.
+    if (pd->result >= POLL_DESCRIPTOR_SIZE) {
+      break;
+    }
+    _complete(pd, cqe);
+    ++seen;
+  }
+  io_uring_cq_advance(&_ring, seen);
+
+  NetDebug("v_iocore_net_poll", "[NetURing::poll] timeout: %d, completions: %u, results: %d", timeout_ms, seen, pd->result);
+}
+
+io_uring_sqe *
+NetURing::_get_sqe()
+{
+  io_uring_sqe *sqe = io_uring_get_sqe(&_ring);
+  if (sqe == nullptr) {
+    // The submission queue is full, hand it to the kernel early.
+    io_uring_submit(&_ring);
+    sqe = io_uring_get_sqe(&_ring);
+  }
+  ink_release_assert(sqe != nullptr);
+  return sqe;
+}
+
+void
+NetURing::_arm(NetURingOp *op)
+{
+  io_uring_sqe *sqe = _get_sqe();
+
+  if (op->type == NetURingOp::POLL) {
+    io_uring_prep_poll_multishot(sqe, op->fd, op->events);
+  } else {
+    ink_assert(op->type == NetURingOp::ACCEPT);
+    io_uring_prep_multishot_accept(sqe, op->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+  }
+  io_uring_sqe_set_data(sqe, op);
+  op->armed = true;
+  ++op->pending;
+}
+
+void
+NetURing::_cancel(NetURingOp *op)
+{
+  if (!op->armed) {
+    _unref(op);
+    return;
+  }
+
+  io_uring_sqe *sqe = _get_sqe();
+  io_uring_prep_cancel64(sqe, reinterpret_cast<uint64_t>(op), 0);
+  io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(op) | CANCEL_TAG);
+  ++op->pending;
+}
+
+void
+NetURing::_complete(PollDescriptor *pd, io_uring_cqe *cqe)
+{
+  uint64_t data  = io_uring_cqe_get_data64(cqe);
+  NetURingOp *op = reinterpret_cast<NetURingOp *>(data & ~CANCEL_TAG);
+
+  if (data & CANCEL_TAG) {
+    --op->pending;
+    if (cqe->res == -ENOENT && op->armed) {
+      // The cancel got to the kernel ahead of the request it was meant for.
+      _cancel(op);
+    } else {
+      _unref(op);
+    }
+    return;
+  }
+
+  bool more = cqe->flags & IORING_CQE_F_MORE;
+  if (!more) {
+    op->armed = false;
+    --op->pending;
+  }
+
+  switch (op->type) {
+  case NetURingOp::POLL:
+    if (cqe->res > 0 && (cqe->res & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))) {
+      ++op->readable;
+    }
+    if (op->ep && cqe->res > 0) {
+      _trigger(pd, op->ep, cqe->res);
+    }
+    // A multishot poll may end on its own, e.g. when the completion queue overflows.
+    if (!more && op->ep) {
+      if (cqe->res >= 0) {
+        _arm(op);
+      } else {
+        Debug("iocore_net_uring", "poll on fd %d ended: %s (%d)", op->fd, strerror(-cqe->res), -cqe->res);
+      }
+    }
+    break;
+  case NetURingOp::ACCEPT:
+    if (op->ep) {
+      // Errors go to the NetAccept too, it handles them as it does those from accept4().
+      op->accepted.push_back(cqe->res);
+      _trigger(pd, op->ep, EPOLLIN);
+      if (!more) {
+        if (cqe->res < 0) {
+          // Most likely out of descriptors, back off before accepting again.
+          op->delayed = true;
+          _rearm.push(op);
+          _rearm_at = Thread::get_hrtime() + HRTIME_MSECONDS(net_throttle_delay);
+        } else {
+          _arm(op);
+        }
+      }
+    } else if (cqe->res >= 0) {
+      socketManager.close(cqe->res);
+    }
+    break;
+  case NetURingOp::RECV:
+    op->result = cqe->res;
+    if (cqe->flags & IORING_CQE_F_BUFFER) {
+      op->buffer = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+    }
+    if (op->vc) {
+      // Readiness reported after this is for data the receive didn't get.
+      op->readable = op->vc->ep.uring_op ? op->vc->ep.uring_op->readable : 0;
+      op->vc->read.triggered = 1;
+      op->vc->nh->read_ready_list.in_or_enqueue(op->vc);
+    }
+    break;
+  case NetURingOp::SEND:
+    op->result = cqe->res;
+    if (op->vc) {
+      op->vc->write.triggered = 1;
+      op->vc->nh->write_ready_list.in_or_enqueue(op->vc);
+    }
+    break;
+  }
+
+  _unref(op);
+}
+
+void
+NetURing::_trigger(PollDescriptor *pd, EventIO *ep, int events)
+{
+  pd->ePoll_Triggered_Events[pd->result].events   = events;
+  pd->ePoll_Triggered_Events[pd->result].data.ptr = ep;
+  ++pd->result;
+}
+
+void
+NetURing::_unref(NetURingOp *op)
+{
+  if (op->armed || op->pending > 0 || op->delayed || op->remote || op->ep || op->vc) {
+    return;
+  }
+
+  if (op->buffer >= 0) {
+    _recycle(op->buffer);
+  }
+  // Connections accepted after the NetAccept went away.
+  for (int fd : op->accepted) {
+    if (fd >= 0) {
+      socketManager.close(fd);
+    }
+  }
+  netURingOpAllocator.free(op);
+}
+
+void
+NetURing::_recycle(int bid)
+{
+  io_uring_buf_ring_add(_buf_ring, _buf_base + static_cast<size_t>(bid) * RECV_BUFFER_SIZE, RECV_BUFFER_SIZE, bid,
+                        io_uring_buf_ring_mask(RECV_BUFFERS), 0);
+  io_uring_buf_ring_advance(_buf_ring, 1);
+}
+
+#endif // TS_USE_LINUX_IO_URING_NET
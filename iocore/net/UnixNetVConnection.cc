@@ -28,6 +28,13 @@
 
 #include <termios.h>
 
+#if HAVE_SPLICE && HAVE_VMSPLICE && HAVE_SYS_SENDFILE_H
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <linux/sockios.h>
+#define ZERO_COPY_WRITE 1
+#endif
+
 #define STATE_VIO_OFFSET ((uintptr_t) & ((NetState *)0)->vio)
 #define STATE_FROM_VIO(_x) ((NetState *)(((char *)(_x)) - STATE_VIO_OFFSET))
 
@@ -181,6 +188,63 @@ write_signal_error(NetHandler *nh, UnixNetVConnection *vc, int lerrno)
   return write_signal_done(VC_EVENT_ERROR, nh, vc);
 }
 
+#if TS_USE_LINUX_IO_URING_NET
+// Read through the thread's io_uring. The first pass queues a receive into a provided buffer and
+// sets r to -EINPROGRESS, the completion puts the vc back on the read ready list and the next pass
+// copies the data into the VIO buffer. Returns false if the socket should be read here instead.
+static bool
+read_from_ring(UnixNetVConnection *vc, MIOBufferAccessor &buf, int64_t toread, int64_t &r)
+{
+  NetURing *uring = vc->get_uring();
+  NetURingOp *op  = vc->read_op;
+
+  if (uring == nullptr) {
+    return false;
+  }
+  if (op == nullptr) {
+    vc->read_op = uring->recv(vc, toread);
+    r           = -EINPROGRESS;
+    return true;
+  }
+  if (op->in_flight()) {
+    r = -EINPROGRESS;
+    return true;
+  }
+
+  if (op->result <= 0) {
+    r           = op->result;
+    vc->read_op = nullptr;
+    uring->release(op);
+    // Out of provided buffers, read this one the usual way.
+    return r != -ENOBUFS;
+  }
+
+  // The VIO may have less room than when the receive was queued, the rest waits for the next pass.
+  r                = std::min(op->result - op->offset, toread);
+  const char *data = uring->recv_data(op);
+  int64_t left     = r;
+  for (IOBufferBlock *b = buf.writer()->first_write_block(); b && left > 0; b = b->next.get()) {
+    int64_t n = std::min(b->write_avail(), left);
+    memcpy(b->end(), data, n);
+    data += n;
+    left -= n;
+  }
+  op->offset += r;
+  if (op->offset == op->result) {
+    // A short receive drained the socket. Unless the poll has seen more data since, wait for it to,
+    // as on EAGAIN, rather than leave a receive queued on an idle connection.
+    NetURingOp *poll_op = vc->ep.uring_op;
+    if (op->result < op->length && (poll_op == nullptr || poll_op->readable == op->readable)) {
+      vc->read.triggered = 0;
+      vc->nh->read_ready_list.remove(vc);
+    }
+    vc->read_op = nullptr;
+    uring->release(op);
+  }
+  return true;
+}
+#endif
+
 // Read the data for a UnixNetVConnection.
 // Rescheduling the UnixNetVConnection by moving the VC
 // onto or off of the ready_list.
@@ -231,50 +295,62 @@ read_from_net(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
   unsigned niov = 0;
   IOVec tiovec[NET_MAX_IOV];
   if (toread) {
-    IOBufferBlock *b = buf.writer()->first_write_block();
-    do {
-      niov       = 0;
-      rattempted = 0;
-      while (b && niov < NET_MAX_IOV) {
-        int64_t a = b->write_avail();
-        if (a > 0) {
-          tiovec[niov].iov_base = b->_end;
-          int64_t togo          = toread - total_read - rattempted;
-          if (a > togo) {
-            a = togo;
-          }
-          tiovec[niov].iov_len = a;
-          rattempted += a;
-          niov++;
-          if (a >= togo) {
-            break;
+    bool ring_read = false;
+#if TS_USE_LINUX_IO_URING_NET
+    ring_read = read_from_ring(vc, buf, toread, r);
+    if (ring_read && r == -EINPROGRESS) {
+      // The completion puts the vc back on the read ready list.
+      vc->read.triggered = 0;
+      nh->read_ready_list.remove(vc);
+      return;
+    }
+#endif
+    if (!ring_read) {
+      IOBufferBlock *b = buf.writer()->first_write_block();
+      do {
+        niov       = 0;
+        rattempted = 0;
+        while (b && niov < NET_MAX_IOV) {
+          int64_t a = b->write_avail();
+          if (a > 0) {
+            tiovec[niov].iov_base = b->_end;
+            int64_t togo          = toread - total_read - rattempted;
+            if (a > togo) {
+              a = togo;
+            }
+            tiovec[niov].iov_len = a;
+            rattempted += a;
+            niov++;
+            if (a >= togo) {
+              break;
+            }
           }
+          b = b->next.get();
         }
-        b = b->next.get();
-      }
 
-      ink_assert(niov > 0);
-      ink_assert(niov <= countof(tiovec));
-      struct msghdr msg;
+        ink_assert(niov > 0);
+        ink_assert(niov <= countof(tiovec));
+        struct msghdr msg;
 
-      ink_zero(msg);
-      msg.msg_name    = const_cast<sockaddr *>(vc->get_remote_addr());
-      msg.msg_namelen = ats_ip_size(vc->get_remote_addr());
-      msg.msg_iov     = &tiovec[0];
-      msg.msg_iovlen  = niov;
-      r               = socketManager.recvmsg(vc->con.fd, &msg, 0);
+        ink_zero(msg);
+        msg.msg_name    = const_cast<sockaddr *>(vc->get_remote_addr());
+        msg.msg_namelen = ats_ip_size(vc->get_remote_addr());
+        msg.msg_iov     = &tiovec[0];
+        msg.msg_iovlen  = niov;
+        r               = socketManager.recvmsg(vc->con.fd, &msg, 0);
 
-      NET_INCREMENT_DYN_STAT(net_calls_to_read_stat);
+        NET_INCREMENT_DYN_STAT(net_calls_to_read_stat);
 
-      total_read += rattempted;
-    } while (rattempted && r == rattempted && total_read < toread);
+        total_read += rattempted;
+      } while (rattempted && r == rattempted && total_read < toread);
 
-    // if we have already moved some bytes successfully, summarize in r
-    if (total_read != rattempted) {
-      if (r <= 0) {
-        r = total_read - rattempted;
-      } else {
-        r = total_read - rattempted + r;
+      // if we have already moved some bytes successfully, summarize in r
+      if (total_read != rattempted) {
+        if (r <= 0) {
+          r = total_read - rattempted;
+        } else {
+          r = total_read - rattempted + r;
+        }
       }
     }
     // check for errors
@@ -417,6 +493,15 @@ write_to_net_io(NetHandler *nh, UnixNetVConnection *vc, EThread *thread)
     return;
   }
 
+#if TS_USE_LINUX_IO_URING_NET
+  // A send is in flight on the ring, its completion puts the vc back on the write ready list.
+  if (vc->write_op && vc->write_op->in_flight()) {
+    vc->write.triggered = 0;
+    nh->write_ready_list.remove(vc);
+    return;
+  }
+#endif
+
   // If it is not enabled,add to WaitList.
   if (!s->enabled || s->vio.op != VIO::WRITE) {
     write_disable(nh, vc);
@@ -680,6 +765,15 @@ UnixNetVConnection::do_io_close(int alerrno /* = -1 */)
     } else {
       this->free(t);
     }
+  } else if (!recursion && nh->per_connection_timeouts) {
+    // There is no InactivityCop scan to find it, have the NetHandler free it from the enable list.
+    int isin = ink_atomic_swap(&read.in_enabled_list, 1);
+    if (!isin) {
+      nh->read_enable_list.push(this);
+    }
+    if (nh->thread != t) {
+      nh->thread->tail_cb->signalActivity();
+    }
   }
 }
 
@@ -844,6 +938,25 @@ UnixNetVConnection::set_enabled(VIO *vio)
   if (!next_inactivity_timeout_at && inactivity_timeout_in) {
     next_inactivity_timeout_at = Thread::get_hrtime() + inactivity_timeout_in;
   }
+  rearm_timeout();
+}
+
+void
+UnixNetVConnection::rearm_timeout()
+{
+  if (nh == nullptr || !nh->per_connection_timeouts) {
+    return;
+  }
+  if (nh->thread == this_ethread()) {
+    nh->arm_timeout(this);
+  } else {
+    // The NetHandler picks the new deadline up from the enable list.
+    int isin = ink_atomic_swap(&read.in_enabled_list, 1);
+    if (!isin) {
+      nh->read_enable_list.push(this);
+    }
+    nh->thread->tail_cb->signalActivity();
+  }
 }
 
 void
@@ -858,6 +971,47 @@ UnixNetVConnection::net_write_io(NetHandler *nh, EThread *lthread)
   write_to_net(nh, this, lthread);
 }
 
+#if TS_USE_LINUX_IO_URING_NET
+NetURing *
+UnixNetVConnection::get_uring() const
+{
+  return ep.event_loop ? ep.event_loop->uring : nullptr;
+}
+
+// Queue a send of up to towrite bytes from the head of reader on the ring. File and immutable
+// blocks are left to zero_copy_write(), returns false if the data starts with one.
+static bool
+send_from_ring(UnixNetVConnection *vc, NetURing *uring, IOBufferReader *reader, int64_t towrite)
+{
+  IOBufferReader *tmp_reader = reader->clone();
+  IOVec tiovec[NET_MAX_IOV];
+  unsigned niov   = 0;
+  int64_t to_send = 0;
+
+  while (niov < NET_MAX_IOV && to_send < towrite) {
+    int64_t len = tmp_reader->block_read_avail();
+    if (len <= 0 || vc->zero_copy_block(tmp_reader->get_current_block())) {
+      break;
+    }
+    if (len > towrite - to_send) {
+      len = towrite - to_send;
+    }
+    tiovec[niov].iov_len  = len;
+    tiovec[niov].iov_base = tmp_reader->start();
+    niov++;
+    to_send += len;
+    tmp_reader->consume(len);
+  }
+  tmp_reader->dealloc();
+
+  if (niov == 0) {
+    return false;
+  }
+  vc->write_op = uring->send(vc, tiovec, niov, reader);
+  return true;
+}
+#endif
+
 // This code was pulled out of write_to_net so
 // I could overwrite it for the SSL implementation
 // (SSL read does not support overlapped i/o)
@@ -865,6 +1019,36 @@ UnixNetVConnection::net_write_io(NetHandler *nh, EThread *lthread)
 int64_t
 UnixNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &buf, int64_t &total_written, int &needs)
 {
+#if TS_USE_LINUX_IO_URING_NET
+  NetURing *uring = get_uring();
+  // A TCP Fast Open connect goes out with the first write, that one is sent here.
+  if (uring && (con.is_connected || !options.f_tcp_fastopen)) {
+    int64_t r = -EAGAIN;
+    if (write_op) {
+      // The send queued by the last pass has completed, account for it as if it was just written.
+      // If the VIO has moved to another reader since, the old one may be gone and is left alone.
+      r = write_op->result;
+      if (r > 0 && buf.reader() == write_op->reader) {
+        buf.reader()->consume(r);
+        total_written += r;
+      }
+      uring->release(write_op);
+      write_op = nullptr;
+      if (r < 0) {
+        return r;
+      }
+    }
+    // Queue the next send right away, its completion puts the vc back on the write ready list.
+    if (total_written < towrite && send_from_ring(this, uring, buf.reader(), towrite - total_written)) {
+      return r > 0 ? r : -EAGAIN;
+    }
+    if (r > 0) {
+      needs |= EVENTIO_WRITE;
+      return r;
+    }
+  }
+#endif
+
   int64_t r                  = 0;
   int64_t try_to_write       = 0;
   IOBufferReader *tmp_reader = buf.reader()->clone();
@@ -892,6 +1076,14 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &bu
         break;
       }
 
+      // File and immutable blocks are written on their own, without copying them.
+      if (zero_copy_block(tmp_reader->get_current_block())) {
+        if (niov == 0) {
+          try_to_write = len;
+        }
+        break;
+      }
+
       // build an iov entry
       tiovec[niov].iov_len  = len;
       tiovec[niov].iov_base = tmp_reader->start();
@@ -901,6 +1093,21 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &bu
       tmp_reader->consume(len);
     }
 
+    ProxyMutex *mutex = thread->mutex.get();
+
+    if (niov == 0) {
+      ink_assert(try_to_write > 0);
+      r = zero_copy_write(tmp_reader, try_to_write);
+      if (r > 0) {
+        NET_SUM_DYN_STAT(net_zero_copy_write_bytes_stat, r);
+        tmp_reader->consume(r);
+        buf.reader()->consume(r);
+        total_written += r;
+      }
+      NET_INCREMENT_DYN_STAT(net_calls_to_write_stat);
+      continue;
+    }
+
     ink_assert(niov > 0);
     ink_assert(niov <= countof(tiovec));
 
@@ -937,17 +1144,149 @@ UnixNetVConnection::load_buffer_and_write(int64_t towrite, MIOBufferAccessor &bu
       total_written += r;
     }
 
-    ProxyMutex *mutex = thread->mutex.get();
     NET_INCREMENT_DYN_STAT(net_calls_to_write_stat);
   } while (r == try_to_write && total_written < towrite);
 
   tmp_reader->dealloc();
+  release_spliced(false);
 
   needs |= EVENTIO_WRITE;
 
   return r;
 }
 
+#if ZERO_COPY_WRITE
+namespace
+{
+// Keeps the memory vmsplice(2) gave the kernel for a while after the socket is
+// closed, the kernel may still be sending it.
+struct SplicedLinger : public Continuation {
+  explicit SplicedLinger(Ptr<IOBufferBlock> &b) : Continuation(nullptr), blocks(b) { SET_HANDLER(&SplicedLinger::expire); }
+
+  int
+  expire(int /* event ATS_UNUSED */, Event * /* e ATS_UNUSED */)
+  {
+    delete this;
+    return EVENT_DONE;
+  }
+
+  Ptr<IOBufferBlock> blocks;
+};
+
+constexpr ink_hrtime SPLICED_LINGER = HRTIME_SECONDS(120);
+} // namespace
+#endif
+
+bool
+UnixNetVConnection::sends_file_blocks() const
+{
+#if ZERO_COPY_WRITE
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool
+UnixNetVConnection::zero_copy_block(IOBufferBlock *b) const
+{
+#if ZERO_COPY_WRITE
+  return b->file() || b->data->_immutable;
+#else
+  ink_release_assert(!b->file());
+  return false;
+#endif
+}
+
+/*
+  Write up to @a len bytes of the block @a reader is at, without copying
+  them into the socket. Bytes in a file go with sendfile(2), immutable
+  memory through a pipe with vmsplice(2) and splice(2). The kernel still
+  refers to that memory once the call returns, so the data is held until
+  the socket has no more unacknowledged bytes (release_spliced).
+*/
+int64_t
+UnixNetVConnection::zero_copy_write(IOBufferReader *reader, int64_t len)
+{
+#if ZERO_COPY_WRITE
+  IOBufferBlock *b = reader->get_current_block();
+  int64_t r;
+
+  if (IOBufferFile *file = b->file()) {
+    off_t offset = b->file_offset() + reader->start_offset;
+    if (!file->stable(offset, len)) {
+      Warning("file data at %" PRId64 " was overwritten before it could be sent, closing connection %d", offset, con.fd);
+      return -EIO;
+    }
+    r = ::sendfile(con.fd, file->fd, &offset, len);
+    return r < 0 ? -errno : r;
+  }
+
+  int *p = nh->splice_pipe;
+  if (p[0] == NO_FD && pipe2(p, O_NONBLOCK | O_CLOEXEC) < 0) {
+    return -errno;
+  }
+
+  struct iovec iov = {reader->start(), static_cast<size_t>(len)};
+  int64_t piped    = vmsplice(p[1], &iov, 1, SPLICE_F_NONBLOCK);
+  if (piped <= 0) {
+    return -errno;
+  }
+  r         = splice(p[0], nullptr, con.fd, nullptr, piped, SPLICE_F_NONBLOCK | SPLICE_F_MOVE);
+  int error = errno;
+  if (r > 0) {
+    if (!spliced_tail || spliced_tail->data != b->data) {
+      IOBufferBlock *held = new_IOBufferBlock(b->data, 0, 0);
+      if (spliced_tail) {
+        spliced_tail->next = held;
+      } else {
+        spliced = held;
+      }
+      spliced_tail = held;
+    }
+  }
+  // Drop what did not go out, it is still in the buffer and goes on the next write.
+  for (int64_t left = piped - std::max<int64_t>(r, 0); left > 0;) {
+    char scratch[4096];
+    ssize_t n = ::read(p[0], scratch, std::min<int64_t>(left, sizeof(scratch)));
+    if (n <= 0) {
+      break;
+    }
+    left -= n;
+  }
+  return r < 0 ? -error : r;
+#else
+  (void)reader;
+  (void)len;
+  return -ENOTSUP;
+#endif
+}
+
+// Let go of the memory held for vmsplice(2) once the socket has sent it, or for a while longer when it is closing.
+void
+UnixNetVConnection::release_spliced(bool closing)
+{
+#if ZERO_COPY_WRITE
+  int unsent = 0;
+
+  if (!spliced) {
+    return;
+  }
+  if (con.fd != NO_FD && ioctl(con.fd, SIOCOUTQ, &unsent) == 0 && unsent == 0) {
+    closing = false;
+  } else if (!closing) {
+    return;
+  }
+  if (closing) {
+    this_ethread()->schedule_in(new SplicedLinger(spliced), SPLICED_LINGER);
+  }
+  spliced      = nullptr;
+  spliced_tail = nullptr;
+#else
+  (void)closing;
+#endif
+}
+
 void
 UnixNetVConnection::readDisable(NetHandler *nh)
 {
@@ -1296,6 +1635,21 @@ UnixNetVConnection::free(EThread *t)
   if (con.fd != NO_FD) {
     NET_SUM_GLOBAL_DYN_STAT(net_connections_currently_open_stat, -1);
   }
+  release_spliced(true);
+#if TS_USE_LINUX_IO_URING_NET
+  // The ring finishes anything still in flight on its own.
+  if (read_op || write_op) {
+    NetURing *uring = get_PollDescriptor(t)->uring;
+    if (read_op) {
+      uring->release(read_op);
+      read_op = nullptr;
+    }
+    if (write_op) {
+      uring->release(write_op);
+      write_op = nullptr;
+    }
+  }
+#endif
   con.close();
 
   clear();
@@ -1322,6 +1676,7 @@ UnixNetVConnection::set_inactivity_timeout(ink_hrtime timeout_in)
   Debug("socket", "Set inactive timeout=%" PRId64 ", for NetVC=%p", timeout_in, this);
   inactivity_timeout_in      = timeout_in;
   next_inactivity_timeout_at = (timeout_in > 0) ? Thread::get_hrtime() + inactivity_timeout_in : 0;
+  rearm_timeout();
 }
 
 TS_INLINE void
@@ -1331,6 +1686,7 @@ UnixNetVConnection::set_default_inactivity_timeout(ink_hrtime timeout_in)
   inactivity_timeout_in      = 0;
   default_inactivity_timeout = true;
   next_inactivity_timeout_at = Thread::get_hrtime() + timeout_in;
+  rearm_timeout();
 }
 
 TS_INLINE bool
@@ -1352,6 +1708,13 @@ UnixNetVConnection::migrateToCurrentThread(Continuation *cont, EThread *t)
     // We're already there!
     return this;
   }
+#if TS_USE_LINUX_IO_URING_NET
+  // Data the old thread's ring has read, or is still sending, can't move with the socket. A receive
+  // still waiting for data is cancelled, this vc releases it when it is freed on the old thread.
+  if (this->write_op || (this->read_op && !this->get_uring()->cancel_sync(this->read_op))) {
+    return nullptr;
+  }
+#endif
 
   Connection hold_con;
   hold_con.move(this->con);
@@ -0,0 +1,98 @@
+/** @file
+
+  Catch based unit tests for the per connection timeouts of the NetHandler
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "P_Net.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+namespace
+{
+EThread *main_thread = nullptr;
+
+struct NetTimeoutListener : Catch::TestEventListenerBase {
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void
+  testRunStarting(Catch::TestRunInfo const &testRunInfo) override
+  {
+    Layout::create();
+    init_diags("", nullptr);
+    RecProcessInit(RECM_STAND_ALONE);
+
+    ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
+
+    main_thread = new EThread;
+    main_thread->set_specific();
+  }
+};
+
+CATCH_REGISTER_LISTENER(NetTimeoutListener);
+} // namespace
+
+TEST_CASE("timeout shortened from another thread", "[iocore][net]")
+{
+  // Never started, it only stands in for a thread other than the NetHandler's.
+  static EThread *other = new EThread(REGULAR, 1);
+
+  NetHandler nh;
+  nh.thread              = main_thread;
+  UnixNetVConnection *vc = new UnixNetVConnection;
+  vc->nh                 = &nh;
+  vc->thread             = main_thread;
+  vc->ep.syscall         = false;
+  nh.open_list.enqueue(vc);
+
+  vc->set_inactivity_timeout(HRTIME_SECONDS(300));
+  REQUIRE(vc->timeout_event.in_the_priority_queue);
+  CHECK(vc->timeout_event.timeout_at == vc->next_inactivity_timeout_at);
+
+  bool ready = false;
+  SECTION("ready to read")
+  {
+    vc->read.enabled   = 1;
+    vc->read.triggered = 1;
+    ready              = true;
+  }
+  SECTION("not ready") {}
+
+  nh.thread = other;
+  vc->set_inactivity_timeout(HRTIME_SECONDS(1));
+  REQUIRE(vc->read.in_enabled_list);
+
+  // Back on the NetHandler's thread, the enable list brings the new deadline in.
+  nh.thread = main_thread;
+  nh.process_enabled_list();
+  CHECK(nh.read_ready_list.in(vc) == ready);
+  CHECK(vc->timeout_event.in_the_priority_queue);
+  CHECK(vc->timeout_event.timeout_at == vc->next_inactivity_timeout_at);
+
+  if (ready) {
+    nh.read_ready_list.remove(vc);
+  }
+  nh.open_list.remove(vc);
+  nh.disarm_timeout(vc);
+}
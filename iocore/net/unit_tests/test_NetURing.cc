@@ -0,0 +1,249 @@
+/** @file
+
+  Catch based unit tests for the io_uring net loop, over loopback sockets
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "P_Net.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+#if TS_USE_LINUX_IO_URING_NET
+
+#include <netinet/in.h>
+#include <thread>
+
+namespace
+{
+EThread *main_thread = nullptr;
+
+struct NetURingListener : Catch::TestEventListenerBase {
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void
+  testRunStarting(Catch::TestRunInfo const &testRunInfo) override
+  {
+    Layout::create();
+    init_diags("", nullptr);
+    RecProcessInit(RECM_STAND_ALONE);
+
+    ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
+
+    main_thread = new EThread;
+    main_thread->set_specific();
+  }
+};
+
+CATCH_REGISTER_LISTENER(NetURingListener);
+
+// Poll @a uring until @a done, or give up after about a second.
+template <typename F>
+bool
+poll_until(NetURing *uring, PollDescriptor *pd, F done)
+{
+  for (int i = 0; i < 100; ++i) {
+    uring->poll(pd, 10);
+    if (done()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool
+triggered(PollDescriptor *pd, EventIO *ep)
+{
+  for (int i = 0; i < pd->result; ++i) {
+    if (get_ev_data(pd, i) == ep) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int
+loopback_listen(sockaddr_in &addr)
+{
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  REQUIRE(fd >= 0);
+  ink_zero(addr);
+  addr.sin_family      = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len        = sizeof(addr);
+  REQUIRE(bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0);
+  REQUIRE(getsockname(fd, reinterpret_cast<sockaddr *>(&addr), &len) == 0);
+  REQUIRE(listen(fd, 16) == 0);
+  return fd;
+}
+
+int
+loopback_connect(const sockaddr_in &addr)
+{
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  REQUIRE(fd >= 0);
+  REQUIRE(connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) == 0);
+  return fd;
+}
+} // namespace
+
+TEST_CASE("NetURing", "[iocore][net][io_uring]")
+{
+  NetURing *uring = NetURing::create(main_thread);
+  if (uring == nullptr) {
+    WARN("the kernel can't run the io_uring net loop, skipped");
+    return;
+  }
+
+  PollDescriptor *pd = new PollDescriptor;
+  pd->uring          = uring;
+
+  sockaddr_in addr;
+  EventIO listen_ep;
+  listen_ep.type = EVENTIO_NETACCEPT;
+  listen_ep.fd   = loopback_listen(addr);
+  REQUIRE(uring->start(&listen_ep, EVENTIO_READ) == 0);
+
+  // Accepted on the ring, the NetAccept only picks the socket up.
+  int client = loopback_connect(addr);
+  REQUIRE(poll_until(uring, pd, [&] { return triggered(pd, &listen_ep); }));
+  int fd = listen_ep.uring_op->pop_accepted();
+  REQUIRE(fd >= 0);
+  CHECK(listen_ep.uring_op->pop_accepted() == -EAGAIN);
+
+  NetHandler nh;
+  UnixNetVConnection *vc = new UnixNetVConnection;
+  vc->con.fd             = fd;
+  vc->nh                 = &nh;
+
+  SECTION("recv")
+  {
+    REQUIRE(write(client, "hello", 5) == 5);
+    NetURingOp *op = uring->recv(vc, 4096);
+    REQUIRE(poll_until(uring, pd, [&] { return !op->in_flight(); }));
+    CHECK(op->result == 5);
+    CHECK(op->length == 4096);
+    CHECK(memcmp(uring->recv_data(op), "hello", 5) == 0);
+    CHECK(vc->read.triggered);
+    CHECK(nh.read_ready_list.in(vc));
+
+    // A VIO with less room takes part of it, the rest is there on the next pass.
+    op->offset += 2;
+    CHECK(memcmp(uring->recv_data(op), "llo", 3) == 0);
+    uring->release(op);
+  }
+
+  SECTION("provided buffers are recycled")
+  {
+    // Twice as many receives as there are buffers, each returned before the next.
+    for (unsigned i = 0; i < 2 * NetURing::RECV_BUFFERS; ++i) {
+      char c = 'a' + i % 26;
+      REQUIRE(write(client, &c, 1) == 1);
+      NetURingOp *op = uring->recv(vc, 4096);
+      REQUIRE(poll_until(uring, pd, [&] { return !op->in_flight(); }));
+      REQUIRE(op->result == 1);
+      REQUIRE(*uring->recv_data(op) == c);
+      uring->release(op);
+    }
+  }
+
+  SECTION("send")
+  {
+    MIOBuffer *buf         = new_MIOBuffer(BUFFER_SIZE_INDEX_4K);
+    IOBufferReader *reader = buf->alloc_reader();
+    buf->write("world", 5);
+
+    IOVec iov;
+    iov.iov_base   = reader->start();
+    iov.iov_len    = reader->read_avail();
+    NetURingOp *op = uring->send(vc, &iov, 1, reader);
+    REQUIRE(poll_until(uring, pd, [&] { return !op->in_flight(); }));
+    CHECK(op->result == 5);
+    CHECK(vc->write.triggered);
+    CHECK(nh.write_ready_list.in(vc));
+    uring->release(op);
+
+    char data[8];
+    REQUIRE(read(client, data, sizeof(data)) == 5);
+    CHECK(memcmp(data, "world", 5) == 0);
+    free_MIOBuffer(buf);
+  }
+
+  SECTION("a cancelled recv doesn't take data")
+  {
+    NetURingOp *op = uring->recv(vc, 4096);
+    uring->poll(pd, 0);
+    REQUIRE(op->in_flight());
+    uring->release(op);
+    uring->poll(pd, 10);
+
+    REQUIRE(write(client, "x", 1) == 1);
+    op = uring->recv(vc, 4096);
+    REQUIRE(poll_until(uring, pd, [&] { return !op->in_flight(); }));
+    CHECK(op->result == 1);
+    CHECK(*uring->recv_data(op) == 'x');
+    uring->release(op);
+  }
+
+  SECTION("cancel_sync from another thread")
+  {
+    NetURingOp *op = uring->recv(vc, 4096);
+    uring->poll(pd, 0);
+    REQUIRE(op->in_flight());
+
+    bool cancelled = false;
+    std::thread([&] { cancelled = uring->cancel_sync(op); }).join();
+    CHECK(cancelled);
+    REQUIRE(poll_until(uring, pd, [&] { return !op->in_flight(); }));
+    CHECK(op->result == -ECANCELED);
+    uring->release(op);
+
+    // Once the receive has completed there is nothing left to cancel.
+    REQUIRE(write(client, "y", 1) == 1);
+    op = uring->recv(vc, 4096);
+    REQUIRE(poll_until(uring, pd, [&] { return !op->in_flight(); }));
+    CHECK_FALSE(uring->cancel_sync(op));
+    CHECK(op->result == 1);
+    uring->release(op);
+  }
+
+  uring->stop(&listen_ep);
+  uring->poll(pd, 10);
+  nh.read_ready_list.remove(vc);
+  nh.write_ready_list.remove(vc);
+  close(client);
+  close(fd);
+  close(listen_ep.fd);
+  delete pd;
+  delete uring;
+}
+
+#else
+
+// Passing here says nothing about the io_uring loop, this needs a build with TS_USE_LINUX_IO_URING_NET to run.
+TEST_CASE("NetURing", "[iocore][net][io_uring]")
+{
+  WARN("built without the io_uring net loop, skipped: the io_uring net loop is NOT tested by this run");
+}
+
+#endif // TS_USE_LINUX_IO_URING_NET
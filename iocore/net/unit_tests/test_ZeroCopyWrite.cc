@@ -0,0 +1,187 @@
+/** @file
+
+  Catch based unit tests for the writes of file and immutable blocks without copying, over a socket pair
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "P_Net.h"
+#include "tscore/I_Layout.h"
+
+#include "diags.i"
+
+#include <sys/socket.h>
+#include <string>
+
+namespace
+{
+EThread *main_thread = nullptr;
+
+struct ZeroCopyWriteListener : Catch::TestEventListenerBase {
+  using TestEventListenerBase::TestEventListenerBase;
+
+  void
+  testRunStarting(Catch::TestRunInfo const &testRunInfo) override
+  {
+    Layout::create();
+    init_diags("", nullptr);
+    RecProcessInit(RECM_STAND_ALONE);
+
+    ink_event_system_init(EVENT_SYSTEM_MODULE_PUBLIC_VERSION);
+
+    main_thread = new EThread;
+    main_thread->set_specific();
+
+    net_rsb = RecAllocateRawStatBlock(static_cast<int>(Net_Stat_Count));
+  }
+};
+
+CATCH_REGISTER_LISTENER(ZeroCopyWriteListener);
+
+// A file of @a size bytes that differ from their neighbours, with @a bytes set to its content.
+int
+make_file(std::string &bytes, size_t size)
+{
+  char path[] = "/tmp/test_ZeroCopyWrite.XXXXXX";
+  int fd      = mkstemp(path);
+  REQUIRE(fd >= 0);
+  unlink(path);
+  bytes.resize(size);
+  for (size_t i = 0; i < size; ++i) {
+    bytes[i] = static_cast<char>(i * 7 + i / 251);
+  }
+  REQUIRE(write(fd, bytes.data(), size) == static_cast<ssize_t>(size));
+  return fd;
+}
+
+// Append whatever is waiting on @a fd to @a got.
+void
+drain(int fd, std::string &got)
+{
+  char data[65536];
+  ssize_t n;
+
+  while ((n = recv(fd, data, sizeof(data), MSG_DONTWAIT)) > 0) {
+    got.append(data, n);
+  }
+}
+
+// Write all of @a reader to @a vc as write_to_net() does, returning what came out at @a peer.
+std::string
+send_all(UnixNetVConnection *vc, IOBufferReader *reader, int peer)
+{
+  MIOBufferAccessor buf;
+  std::string got;
+  int64_t towrite = reader->read_avail();
+  int64_t total   = 0;
+
+  buf.reader_for(reader);
+  for (int i = 0; i < 1000 && total < towrite; ++i) {
+    int needs = 0;
+    int64_t r = vc->load_buffer_and_write(towrite, buf, total, needs);
+    REQUIRE((r > 0 || r == -EAGAIN));
+    drain(peer, got);
+  }
+  drain(peer, got);
+  CHECK(total == towrite);
+  return got;
+}
+} // namespace
+
+TEST_CASE("zero copy write", "[iocore][net]")
+{
+  SCOPED_MUTEX_LOCK(lock, main_thread->mutex, main_thread);
+  int sv[2];
+  REQUIRE(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) == 0);
+
+  NetHandler nh;
+  UnixNetVConnection *vc = new UnixNetVConnection;
+  vc->con.fd             = sv[0];
+  vc->nh                 = &nh;
+  vc->thread             = main_thread;
+  if (!vc->sends_file_blocks()) {
+    WARN("built without sendfile(2) and splice(2), skipped");
+    close(sv[0]);
+    close(sv[1]);
+    return;
+  }
+
+  MIOBuffer *buf         = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+  IOBufferReader *reader = buf->alloc_reader();
+  buf->file_blocks       = true;
+
+  SECTION("file data at an unaligned offset")
+  {
+    std::string bytes;
+    Ptr<IOBufferFile> file = make_ptr(new IOBufferFile);
+    file->fd               = make_file(bytes, 256 * 1024);
+
+    // Data the way the cache appends it, past a Doc header that is not a multiple of any block size.
+    constexpr off_t offset = 1001;
+    constexpr int64_t len  = 100000;
+    buf->append_block(new_IOBufferBlock(make_ptr(new_file_IOBufferData(file.get(), offset, len)), len, 0));
+    CHECK(reader->get_current_block()->file_offset() == offset);
+
+    SECTION("from a consumed reader")
+    {
+      reader->consume(77);
+      CHECK(send_all(vc, reader, sv[1]) == bytes.substr(offset + 77, len - 77));
+    }
+
+    SECTION("from a range copied to another buffer")
+    {
+      // MIOBuffer::write() clones the block and moves its start, the offset in the file has to follow.
+      MIOBuffer *copy         = new_MIOBuffer(BUFFER_SIZE_INDEX_32K);
+      IOBufferReader *creader = copy->alloc_reader();
+      copy->file_blocks       = true;
+      REQUIRE(copy->write(reader, 5000, 300) == 5000);
+      CHECK(creader->get_current_block()->file_offset() == offset + 300);
+      CHECK(send_all(vc, creader, sv[1]) == bytes.substr(offset + 300, 5000));
+      free_MIOBuffer(copy);
+    }
+
+    close(file->fd);
+  }
+
+  SECTION("immutable memory")
+  {
+    std::string bytes(64 * 1024, '\0');
+    for (size_t i = 0; i < bytes.size(); ++i) {
+      bytes[i] = static_cast<char>(i * 13 + i / 127);
+    }
+    Ptr<IOBufferData> data = make_ptr(new_IOBufferData(BUFFER_SIZE_INDEX_64K));
+    memcpy(data->data(), bytes.data(), bytes.size());
+    data->_immutable = true;
+    buf->append_block(new_IOBufferBlock(data, bytes.size(), 0));
+
+    CHECK(send_all(vc, reader, sv[1]) == bytes);
+    // Held until the socket has sent it, which it has once the peer read it all.
+    CHECK(vc->spliced);
+    vc->release_spliced(false);
+    CHECK(!vc->spliced);
+  }
+
+  free_MIOBuffer(buf);
+  vc->con.fd = NO_FD;
+  close(sv[0]);
+  close(sv[1]);
+}
@@ -83,6 +83,7 @@ public:
 
   virtual bool get_half_close_flag() const;
   virtual bool is_chunked_encoding_supported() const;
+  virtual bool sends_file_blocks() const;
 
   // Returns true if there is a request body for this request
   virtual bool has_request_body(int64_t content_length, bool is_chunked_set) const;
@@ -156,6 +157,12 @@ ProxyTransaction::is_chunked_encoding_supported() const
 {
   return _proxy_ssn ? _proxy_ssn->is_chunked_encoding_supported() : false;
 }
+// Whether the buffer of the response body may have blocks of file data, see MIOBuffer::file_blocks.
+inline bool
+ProxyTransaction::sends_file_blocks() const
+{
+  return false;
+}
 inline void
 ProxyTransaction::set_half_close_flag(bool flag)
 {
@@ -44,6 +44,7 @@ public:
   int get_transaction_id() const override;
   void set_reader(IOBufferReader *reader);
   void set_close_connection(HTTPHdr &hdr) const override;
+  bool sends_file_blocks() const override;
 
   ////////////////////
   // Variables
@@ -78,3 +79,11 @@ Http1Transaction::set_close_connection(HTTPHdr &hdr) const
 {
   hdr.value_set(MIME_FIELD_CONNECTION, MIME_LEN_CONNECTION, "close", 5);
 }
+
+// Writes go straight to the connection of the session.
+inline bool
+Http1Transaction::sends_file_blocks() const
+{
+  NetVConnection *netvc = get_netvc();
+  return netvc && netvc->sends_file_blocks();
+}
@@ -6427,6 +6427,8 @@ HttpSM::setup_cache_read_transfer()
 #endif
 
   buf->water_mark = static_cast<int>(t_state.txn_conf->default_buffer_water_mark);
+  // Nothing looks at the body on its way to the client, the cache may leave it on disk for the socket to send.
+  buf->file_blocks = !t_state.client_info.receive_chunked_response && ua_txn->sends_file_blocks();
 
   IOBufferReader *buf_start = buf->alloc_reader();
 
@@ -189,6 +189,11 @@ HttpTransactCache::SelectFromAlternates(CacheHTTPInfoVector *cache_vector, HTTPH
     return 0;
   }
 
+  // Plugins choosing among the alternates get to see their complete headers.
+  if (cache_vector->compact() && http_global_hooks->get(TS_HTTP_SELECT_ALT_HOOK)) {
+    cache_vector->expand();
+  }
+
   for (int i = 0; i < alt_count; i++) {
     float Q;
     CacheHTTPInfo *obj       = cache_vector->get(i);
@@ -0,0 +1,396 @@
+/** @file
+
+  Statistics of the objects in cache stripes, from their directories.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#include "CacheAnalyze.h"
+#include "HTTP.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cstring>
+#include <ctime>
+#include <sys/mman.h>
+
+namespace ct
+{
+namespace
+{
+  constexpr int64_t META_LEN = ROUND_TO_STORE_BLOCK(sizeof(StripeMeta));
+  // Most of the alternate vectors fit in the first read of a fragment.
+  constexpr int64_t HEAD_READ = 16 * 1024;
+  // As many as the cache makes in a segmented stripe.
+  constexpr uint32_t MAX_LOG_SEGMENTS = 65536;
+  constexpr time_t AGE_LIMITS[CacheStats::TIME_BUCKETS - 1] = {3600, 86400, 7 * 86400, 30 * 86400, 365 * 86400};
+
+  template <size_t N>
+  void
+  add(std::array<int64_t, N> &to, std::array<int64_t, N> const &from)
+  {
+    for (size_t i = 0; i < N; i++) {
+      to[i] += from[i];
+    }
+  }
+
+  template <size_t N>
+  void
+  write_array(std::ostream &out, char const *name, std::array<int64_t, N> const &a)
+  {
+    out << ", \"" << name << "\": [";
+    for (size_t i = 0; i < N; i++) {
+      out << (i ? ", " : "") << a[i];
+    }
+    out << "]";
+  }
+
+  // Length of the marshalled alternate at @a alt, which is not recorded on disk, or -1 if it overruns @a avail.
+  int64_t
+  marshalled_length(HTTPCacheAlt *alt, int64_t avail)
+  {
+    int64_t len = ts::round_up<HDR_PTR_SIZE>(sizeof(HTTPCacheAlt));
+    if (alt->m_frag_offset_count > HTTPCacheAlt::N_INTEGRAL_FRAG_OFFSETS) {
+      len += alt->m_frag_offset_count * sizeof(HTTPCacheAlt::FragOffset);
+    }
+    for (HTTPHdr *hdr : {&alt->m_request_hdr, &alt->m_response_hdr}) {
+      intptr_t off = reinterpret_cast<intptr_t>(hdr->m_heap);
+      if (!off) {
+        continue;
+      }
+      if (off < len || off + static_cast<int64_t>(sizeof(HdrHeap)) > avail) {
+        return -1;
+      }
+      auto *heap = reinterpret_cast<HdrHeap *>(reinterpret_cast<char *>(alt) + off);
+      len        = std::max<int64_t>(len, off + ts::round_up<HDR_PTR_SIZE>(heap->unmarshal_size()));
+    }
+    return len <= avail ? len : -1;
+  }
+
+  // Read the stripe metadata at @a pos, @c false if there is none.
+  bool
+  read_meta(int fd, Bytes pos, StripeMeta &meta)
+  {
+    alignas(CacheStoreBlocks::SCALE) char buff[CacheStoreBlocks::SCALE];
+
+    if (pread(fd, buff, sizeof(buff), pos.count()) != static_cast<ssize_t>(sizeof(buff))) {
+      return false;
+    }
+    memcpy(static_cast<void *>(&meta), buff, sizeof(meta));
+    return meta.magic == StripeMeta::MAGIC;
+  }
+} // namespace
+
+CacheStats &
+CacheStats::operator+=(CacheStats const &that)
+{
+  stripes += that.stripes;
+  data_bytes += that.data_bytes;
+  entries += that.entries;
+  used += that.used;
+  valid += that.valid;
+  heads += that.heads;
+  live_bytes += that.live_bytes;
+  tag_collisions += that.tag_collisions;
+  docs_read += that.docs_read;
+  bad_docs += that.bad_docs;
+  add(fragment_size, that.fragment_size);
+  add(write_age, that.write_age);
+  add(alternates, that.alternates);
+  add(object_size, that.object_size);
+  add(object_age, that.object_age);
+  return *this;
+}
+
+int
+CacheStats::size_bucket(int64_t size)
+{
+  int b = 0;
+  for (size >>= 10; size > 0 && b < SIZE_BUCKETS - 1; size >>= 1) {
+    ++b;
+  }
+  return b;
+}
+
+void
+CacheStats::write_json(std::ostream &out, bool headers) const
+{
+  out << "\"stripes\": " << stripes << ", \"data_bytes\": " << data_bytes << ", \"entries\": " << entries
+      << ", \"used\": " << used << ", \"valid\": " << valid << ", \"objects\": " << heads << ", \"live_bytes\": " << live_bytes
+      << ", \"fill\": " << (data_bytes ? static_cast<double>(live_bytes) / data_bytes : 0.0)
+      << ", \"fragments_per_object\": " << (heads ? static_cast<double>(valid) / heads : 0.0)
+      << ", \"stale_entries\": " << used - valid << ", \"tag_collisions\": " << tag_collisions
+      << ", \"tag_collision_rate\": " << (valid ? static_cast<double>(tag_collisions) / valid : 0.0);
+  write_array(out, "fragment_size", fragment_size);
+  write_array(out, "write_age", write_age);
+  if (headers) {
+    out << ", \"docs_read\": " << docs_read << ", \"bad_docs\": " << bad_docs;
+    write_array(out, "alternates", alternates);
+    write_array(out, "object_size", object_size);
+    write_array(out, "object_age", object_age);
+  }
+}
+
+/*
+  Find the directory copy in use, as the cache does when it opens the stripe.
+  The flags of header A tell whether the upper tag bits of a volume with wide
+  tags and the log segment table of a segmented one sit between the entries
+  and footer A, and the table starts with the geometry of the segments. That
+  gives the length of the directory and so where the content starts.
+*/
+Errata
+CacheAnalyze::load_meta()
+{
+  int fd          = stripe->_span->_fd;
+  int64_t entries = stripe->_buckets * DIR_DEPTH * stripe->_segments;
+  int64_t base    = stripe->vol_headerlen() + ROUND_TO_STORE_BLOCK(entries * SIZEOF_DIR);
+  int64_t tag_len = 0;
+  StripeMeta head[2], foot[2];
+
+  if (!read_meta(fd, stripe->_start, head[0])) {
+    return Errata::Message(0, 1, "Header A not found");
+  }
+  wide_tags = head[0].flags & StripeMeta::FLAG_WIDE_TAGS;
+  segmented = head[0].flags & StripeMeta::FLAG_SEGMENTED;
+  if (wide_tags) {
+    tag_len = ROUND_TO_STORE_BLOCK(entries * sizeof(uint16_t));
+  }
+  if (segmented) {
+    alignas(CacheStoreBlocks::SCALE) char buff[CacheStoreBlocks::SCALE];
+    LogSegmentGeometry geometry;
+
+    if (pread(fd, buff, sizeof(buff), (stripe->_start + Bytes(base + tag_len)).count()) != static_cast<ssize_t>(sizeof(buff))) {
+      return Errata::Message(0, errno, "Unable to read the log segment table: ", strerror(errno));
+    }
+    memcpy(&geometry, buff, sizeof(geometry));
+    if (geometry.count < 1 || geometry.count > MAX_LOG_SEGMENTS || geometry.size < CacheStoreBlocks::SCALE ||
+        geometry.size % CacheStoreBlocks::SCALE) {
+      return Errata::Message(0, 1, "Bad log segment geometry, ", geometry.count, " segments of ", geometry.size, " bytes");
+    }
+    lsegs     = geometry.count;
+    lseg_size = geometry.size;
+    lseg_len  = ROUND_TO_STORE_BLOCK(sizeof(LogSegmentGeometry) + lsegs * sizeof(LogSegment));
+  }
+  dirlen = base + tag_len + lseg_len + META_LEN;
+  if (!read_meta(fd, stripe->_start + Bytes(dirlen - META_LEN), foot[0]) || foot[0].sync_serial != head[0].sync_serial) {
+    return Errata::Message(0, 1, "Footer A not found");
+  }
+  content   = stripe->_start + Bytes(2 * dirlen);
+  dir_start = stripe->_start;
+  meta      = head[0];
+  if (read_meta(fd, stripe->_start + Bytes(dirlen), head[1]) &&
+      read_meta(fd, stripe->_start + Bytes(2 * dirlen - META_LEN), foot[1]) && head[1].sync_serial == foot[1].sync_serial &&
+      head[1].sync_serial > head[0].sync_serial && head[1].flags == head[0].flags) {
+    dir_start = stripe->_start + Bytes(dirlen);
+    meta      = head[1];
+  }
+  stats.stripes    = 1;
+  stats.entries    = entries;
+  stats.data_bytes = Bytes(stripe->_start + stripe->_len).count() - content.count();
+  return Errata();
+}
+
+/*
+  Whether the fragment of @a e is still there, as dir_valid() decides it,
+  and if so in @a age how much of the stripe has been written since.
+*/
+bool
+CacheAnalyze::valid(CacheDirEntry const *e, int64_t *age) const
+{
+  int64_t pos     = (dir_offset(e) - 1) * CACHE_BLOCK_SIZE;
+  int64_t head    = meta.write_pos - content.count();
+  int64_t agg_pos = meta.agg_pos - content.count();
+
+  if (segmented) {
+    // Another segment than the one being written holds what was written to it since it was opened.
+    int s = std::min<int64_t>(pos / lseg_size, lseg_table.size() - 1);
+    if (s != lseg_cur) {
+      *age = (lseg_table[lseg_cur].seq - lseg_table[s].seq) * lseg_size;
+      return dir_phase(e) == lseg_table[s].phase;
+    }
+  }
+  if (dir_phase(e) == meta.phase) {
+    *age = head - pos;
+    return pos < head;
+  }
+  *age = stats.data_bytes - pos + head;
+  return pos >= agg_pos;
+}
+
+// Walk the bucket chains of each segment, as dir_probe() does.
+void
+CacheAnalyze::walk_dir(CacheDirEntry *dir)
+{
+  std::bitset<65536> seen;
+  std::vector<uint32_t> tags;
+
+  for (int s = 0; s < stripe->_segments; s++) {
+    CacheDirEntry *seg = dir_in_seg(dir, s * stripe->_buckets * DIR_DEPTH);
+    seen.reset();
+    for (int b = 0; b < stripe->_buckets; b++) {
+      tags.clear();
+      for (CacheDirEntry *e = dir_bucket(b, seg); e && dir_offset(e) && !seen[dir_to_offset(e, seg)]; e = next_dir(e, seg)) {
+        int64_t age                 = 0;
+        seen[dir_to_offset(e, seg)] = true;
+        ++stats.used;
+        if (!valid(e, &age)) {
+          continue;
+        }
+        int64_t size = dir_approx_size(e);
+        ++stats.valid;
+        stats.live_bytes += size;
+        ++stats.fragment_size[CacheStats::size_bucket(size)];
+        ++stats.write_age[std::clamp<int64_t>(age * CacheStats::AGE_BUCKETS / std::max<int64_t>(stats.data_bytes, 1), 0,
+                                              CacheStats::AGE_BUCKETS - 1)];
+        uint32_t tag = dir_tag(e);
+        if (tag_ext) {
+          tag |= static_cast<uint32_t>(tag_ext[e - dir]) << DIR_TAG_WIDTH;
+        }
+        tags.push_back(tag);
+        if (dir_head(e)) {
+          ++stats.heads;
+          if (headers) {
+            head_frags.emplace_back(dir_offset(e), size);
+          }
+        }
+      }
+      // Every entry that shares its tag with another one of the bucket costs a read of the wrong fragment.
+      std::sort(tags.begin(), tags.end());
+      for (size_t i = 0; i < tags.size(); i++) {
+        if ((i > 0 && tags[i] == tags[i - 1]) || (i + 1 < tags.size() && tags[i] == tags[i + 1])) {
+          ++stats.tag_collisions;
+        }
+      }
+    }
+  }
+}
+
+// Read the first fragment of each object, in the order they are on disk, and count its alternates.
+void
+CacheAnalyze::read_heads()
+{
+  int fd      = stripe->_span->_fd;
+  int64_t len = HEAD_READ;
+  char *buff  = static_cast<char *>(ats_memalign(ats_pagesize(), len));
+  time_t now  = time(nullptr);
+
+  std::sort(head_frags.begin(), head_frags.end());
+  for (auto const &[offset, size] : head_frags) {
+    off_t pos    = content.count() + (offset - 1) * CACHE_BLOCK_SIZE;
+    int64_t want = std::min(size, HEAD_READ);
+    ssize_t n    = pread(fd, buff, want, pos);
+    Doc *doc     = reinterpret_cast<Doc *>(buff);
+
+    ++stats.docs_read;
+    // A vector longer than the first read is read again whole.
+    if (n == want && doc->magic == Doc::MAGIC && static_cast<int64_t>(sizeof(Doc) + doc->hlen) > want &&
+        static_cast<int64_t>(sizeof(Doc) + doc->hlen) <= size) {
+      want = INK_ALIGN(sizeof(Doc) + doc->hlen, CACHE_BLOCK_SIZE);
+      if (want > len) {
+        ats_free(buff);
+        len  = want;
+        buff = static_cast<char *>(ats_memalign(ats_pagesize(), len));
+      }
+      n   = pread(fd, buff, want, pos);
+      doc = reinterpret_cast<Doc *>(buff);
+    }
+    if (n < static_cast<ssize_t>(sizeof(Doc)) || doc->magic != Doc::MAGIC || !doc->hlen ||
+        static_cast<ssize_t>(sizeof(Doc) + doc->hlen) > n) {
+      ++stats.bad_docs;
+      continue;
+    }
+
+    char *p    = doc->hdr();
+    char *end  = p + doc->hlen;
+    int n_alts = 0;
+    // A compact vector has a header and an alternate with the shared response fields first.
+    if (end - p >= Doc::ALT_VECTOR_HEADER_LEN && *reinterpret_cast<uint32_t *>(p) == Doc::ALT_VECTOR_MAGIC) {
+      p += Doc::ALT_VECTOR_HEADER_LEN;
+      auto *shared       = reinterpret_cast<HTTPCacheAlt *>(p);
+      int64_t shared_len = end - p >= static_cast<ptrdiff_t>(sizeof(HTTPCacheAlt)) && shared->m_magic == CACHE_ALT_MAGIC_MARSHALED ?
+                             marshalled_length(shared, end - p) :
+                             -1;
+      if (shared_len < 0) {
+        ++stats.bad_docs;
+        continue;
+      }
+      p += shared_len;
+    }
+    while (end - p >= static_cast<ptrdiff_t>(sizeof(HTTPCacheAlt))) {
+      auto *alt       = reinterpret_cast<HTTPCacheAlt *>(p);
+      int64_t alt_len = alt->m_magic == CACHE_ALT_MAGIC_MARSHALED ? marshalled_length(alt, end - p) : -1;
+      if (alt_len < 0) {
+        break;
+      }
+      int64_t object_size;
+      memcpy(&object_size, alt->m_object_size, sizeof(object_size));
+      ++stats.object_size[CacheStats::size_bucket(object_size)];
+      time_t age = now - alt->m_response_received_time;
+      ++stats.object_age[std::upper_bound(std::begin(AGE_LIMITS), std::end(AGE_LIMITS), age) - std::begin(AGE_LIMITS)];
+      ++n_alts;
+      p += alt_len;
+    }
+    if (n_alts) {
+      ++stats.alternates[std::min(n_alts, CacheStats::ALT_BUCKETS) - 1];
+    } else {
+      ++stats.bad_docs;
+    }
+  }
+  ats_free(buff);
+}
+
+Errata
+CacheAnalyze::analyze()
+{
+  Errata zret = this->load_meta();
+  if (!zret.isOK()) {
+    return zret;
+  }
+
+  // Map the directory copy in use rather than read it, the page cache reads ahead.
+  off_t map_pos  = dir_start.count() & ~static_cast<off_t>(ats_pagesize() - 1);
+  size_t map_len = dirlen + (dir_start.count() - map_pos);
+  void *map      = mmap(nullptr, map_len, PROT_READ, MAP_SHARED, stripe->_span->_fd, map_pos);
+  if (map == MAP_FAILED) {
+    return Errata::Message(0, errno, "Unable to map the directory of stripe ", stripe->hashText, ": ", strerror(errno));
+  }
+  madvise(map, map_len, MADV_SEQUENTIAL);
+
+  char *raw    = static_cast<char *>(map) + (dir_start.count() - map_pos);
+  char *footer = raw + dirlen - META_LEN;
+  auto *dir    = reinterpret_cast<CacheDirEntry *>(raw + stripe->vol_headerlen());
+
+  if (segmented) {
+    auto *table = reinterpret_cast<LogSegment const *>(footer - lseg_len + sizeof(LogSegmentGeometry));
+    lseg_table.assign(table, table + lsegs);
+    lseg_cur = std::max_element(lseg_table.begin(), lseg_table.end(),
+                                [](LogSegment const &a, LogSegment const &b) { return a.seq < b.seq; }) -
+               lseg_table.begin();
+  }
+  if (wide_tags) {
+    tag_ext = reinterpret_cast<uint16_t const *>(footer - lseg_len - ROUND_TO_STORE_BLOCK(stats.entries * sizeof(uint16_t)));
+  }
+  this->walk_dir(dir);
+  munmap(map, map_len);
+  if (headers) {
+    this->read_heads();
+  }
+  return zret;
+}
+} // namespace ct
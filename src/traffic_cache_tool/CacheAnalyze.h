@@ -0,0 +1,116 @@
+/** @file
+
+  Statistics of the objects in cache stripes, from their directories.
+
+  @section license License
+
+  Licensed to the Apache Software Foundation (ASF) under one
+  or more contributor license agreements.  See the NOTICE file
+  distributed with this work for additional information
+  regarding copyright ownership.  The ASF licenses this file
+  to you under the Apache License, Version 2.0 (the
+  "License"); you may not use this file except in compliance
+  with the License.  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <ostream>
+#include <vector>
+#include "CacheDefs.h"
+
+namespace ct
+{
+/// Entry of the log segment table saved with the directory of a segmented stripe, nee VolLogSegment.
+struct LogSegment {
+  uint32_t seq;
+  uint32_t next;
+  uint32_t phase;
+  uint32_t index;
+};
+
+/// In front of the log segment table, nee VolLogSegmentGeometry.
+struct LogSegmentGeometry {
+  int64_t size;
+  uint32_t count;
+  uint32_t unused;
+};
+
+/// Counters of one stripe, or of all the stripes of a volume.
+struct CacheStats {
+  static constexpr int SIZE_BUCKETS = 22; ///< Powers of two from 512 bytes, the last one is 1GB or more.
+  static constexpr int AGE_BUCKETS  = 10; ///< Tenths of the stripe written since a fragment was.
+  static constexpr int ALT_BUCKETS  = 8;  ///< 1 to 8 or more alternates.
+  static constexpr int TIME_BUCKETS = 6;  ///< Up to an hour, a day, a week, 30 days, a year, older.
+
+  int64_t stripes        = 0;
+  int64_t data_bytes     = 0; ///< Content area of the stripes.
+  int64_t entries        = 0; ///< Directory entries.
+  int64_t used           = 0; ///< Entries in a bucket chain.
+  int64_t valid          = 0; ///< Used entries of fragments the write head has not gone over.
+  int64_t heads          = 0; ///< Valid entries of the first fragment of an object.
+  int64_t live_bytes     = 0; ///< Approximate size of the valid fragments.
+  int64_t tag_collisions = 0; ///< Valid entries with the same tag as another in their bucket.
+  std::array<int64_t, SIZE_BUCKETS> fragment_size{};
+  std::array<int64_t, AGE_BUCKETS> write_age{};
+
+  // Only filled in by reading the first fragments.
+  int64_t docs_read = 0;
+  int64_t bad_docs  = 0; ///< First fragments without an alternate vector.
+  std::array<int64_t, ALT_BUCKETS> alternates{};
+  std::array<int64_t, SIZE_BUCKETS> object_size{};
+  std::array<int64_t, TIME_BUCKETS> object_age{};
+
+  CacheStats &operator+=(CacheStats const &that);
+  static int size_bucket(int64_t size);
+  /// Write the counters as the members of a JSON object, @a headers for those of the first fragments.
+  void write_json(std::ostream &out, bool headers) const;
+};
+
+/** Analysis of one stripe.
+
+    The directory is mapped from the span and walked bucket by bucket. With
+    @a headers the first fragment of each object is read as well, in disk
+    order, for the sizes, ages and alternates of the objects.
+ */
+class CacheAnalyze
+{
+public:
+  CacheAnalyze(Stripe *stripe, bool headers) : stripe(stripe), headers(headers) {}
+
+  Errata analyze();
+
+  Stripe *stripe;
+  bool headers;
+  bool segmented = false;
+  bool wide_tags = false;
+  CacheStats stats;
+
+private:
+  Errata load_meta();
+  bool valid(CacheDirEntry const *e, int64_t *age) const;
+  void walk_dir(CacheDirEntry *dir);
+  void read_heads();
+
+  StripeMeta meta;       ///< Of the directory copy that is used.
+  Bytes dir_start;       ///< Of the directory copy that is used.
+  int64_t dirlen = 0;    ///< Length of a directory copy, header and footer included.
+  Bytes content;         ///< Start of the content area.
+  int64_t lseg_len  = 0; ///< Length of the log segment table and its geometry, segmented layout only.
+  int64_t lseg_size = 0; ///< Segmented layout only.
+  int lsegs         = 0; ///< Segmented layout only.
+  int lseg_cur      = 0; ///< Segment of the write head.
+  std::vector<LogSegment> lseg_table;
+  uint16_t const *tag_ext = nullptr;
+  std::vector<std::pair<int64_t, int64_t>> head_frags; ///< Offset and approximate size of the valid first fragments.
+};
+} // namespace ct
@@ -220,7 +220,6 @@ Stripe::Stripe(Span *span, const Bytes &start, const CacheStoreBlocks &len) : _s
 {
   ts::bwprint(hashText, "{} {}:{}", span->_path.view(), _start.count(), _len.count());
   CryptoContext().hash_immediate(hash_id, hashText.data(), static_cast<int>(hashText.size()));
-  printf("hash id of stripe is hash of %.*s\n", static_cast<int>(hashText.size()), hashText.data());
 }
 
 bool
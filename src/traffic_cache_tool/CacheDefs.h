@@ -144,6 +144,10 @@ class StripeMeta
 {
 public:
   static constexpr uint32_t MAGIC = 0xF1D0F00D;
+  /// The directory has the upper tag bits of each entry after the entries, nee VOL_FLAG_WIDE_TAGS.
+  static constexpr uint32_t FLAG_WIDE_TAGS = 0x1;
+  /// The directory has the log segment table before the footer, nee VOL_FLAG_SEGMENTED.
+  static constexpr uint32_t FLAG_SEGMENTED = 0x2;
 
   uint32_t magic;
   VersionNumber version;
@@ -158,11 +162,16 @@ public:
   uint32_t write_serial;
   uint32_t dirty;
   uint32_t sector_size;
-  uint32_t unused; // pad out to 8 byte boundary
+  uint32_t flags; // FLAG_*, zero in directories written before flags existed
   uint16_t freelist[1];
 };
 
 struct Doc {
+  static constexpr uint32_t MAGIC = 0x5F129B13;
+  /// A compact alternate vector starts with this magic and the alternate count.
+  static constexpr uint32_t ALT_VECTOR_MAGIC = 0xa17ec7a1;
+  static constexpr int ALT_VECTOR_HEADER_LEN = 8;
+
   uint32_t magic;     // DOC_MAGIC
   uint32_t len;       // length of this fragment (including hlen & sizeof(Doc), unrounded)
   uint64_t total_len; // total length of document
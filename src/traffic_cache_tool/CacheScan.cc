@@ -367,6 +367,21 @@ CacheScan::get_alternates(const char *buf, int length, bool search)
   RefCountObj *block_ref = nullptr;
   ts::MemSpan<char> doc_mem(const_cast<char *>(buf), length);
 
+  // A compact vector starts with a header and an alternate holding the shared response fields, skip both.
+  if (length >= Doc::ALT_VECTOR_HEADER_LEN && *reinterpret_cast<const uint32_t *>(buf) == Doc::ALT_VECTOR_MAGIC) {
+    buf += Doc::ALT_VECTOR_HEADER_LEN;
+    HTTPCacheAlt *a = (HTTPCacheAlt *)buf;
+    if (length - (buf - start) <= static_cast<int>(sizeof(HTTPCacheAlt)) || a->m_magic != CACHE_ALT_MAGIC_MARSHALED) {
+      return zret;
+    }
+    zret = this->unmarshal(const_cast<char *>(buf), length, block_ref);
+    if (zret.size()) {
+      std::cerr << zret << std::endl;
+      return zret;
+    }
+    buf += a->m_unmarshal_len;
+  }
+
   while (length - (buf - start) > static_cast<int>(sizeof(HTTPCacheAlt))) {
     HTTPCacheAlt *a = (HTTPCacheAlt *)buf;
 
@@ -26,6 +26,7 @@
 #include <memory>
 #include <vector>
 #include <map>
+#include <sstream>
 #include <system_error>
 #include <fcntl.h>
 #include <cctype>
@@ -42,9 +43,11 @@
 #include "tscore/CryptoHash.h"
 #include "tscore/ArgParser.h"
 #include <thread>
+#include <atomic>
 
 #include "CacheDefs.h"
 #include "CacheScan.h"
+#include "CacheAnalyze.h"
 
 using ts::Bytes;
 using ts::Megabytes;
@@ -64,6 +67,7 @@ extern int OPEN_RW_FLAG;
 const Bytes ts::CacheSpan::OFFSET{CacheStoreBlocks{1}};
 ts::file::path SpanFile;
 ts::file::path VolumeFile;
+int AnalyzeThreads = 0; ///< Threads of the analyze command, 0 for one per CPU.
 ts::ArgParser parser;
 
 Errata err;
@@ -1362,6 +1366,89 @@ Scan_Cache(ts::file::path const &regex_path)
   }
 }
 
+// Write @a text as a JSON string.
+void
+write_json_string(std::ostream &out, std::string_view text)
+{
+  out << '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (static_cast<unsigned char>(c) >= ' ') {
+      out << c;
+    }
+  }
+  out << '"';
+}
+
+void
+Analyze_Cache(bool headers)
+{
+  Cache cache;
+  std::vector<std::unique_ptr<CacheAnalyze>> stripes;
+  std::vector<Errata> errors;
+  std::vector<std::thread> threadPool;
+  std::atomic<size_t> next{0};
+
+  if ((err = cache.loadSpan(SpanFile))) {
+    if (err.size()) {
+      return;
+    }
+    for (auto sp : cache._spans) {
+      for (auto strp : sp->_stripes) {
+        if (!strp->isFree()) {
+          stripes.emplace_back(new CacheAnalyze(strp, headers));
+        }
+      }
+    }
+    // The stripes are shared out among the threads, a span can have stripes of very different sizes.
+    errors.resize(stripes.size());
+    size_t n = AnalyzeThreads > 0 ? AnalyzeThreads : std::max(std::thread::hardware_concurrency(), 1U);
+    n        = std::min(n, stripes.size());
+    for (size_t i = 0; i < n; ++i) {
+      threadPool.emplace_back([&]() {
+        for (size_t k = next++; k < stripes.size(); k = next++) {
+          errors[k] = stripes[k]->analyze();
+        }
+      });
+    }
+    for (auto &th : threadPool) {
+      th.join();
+    }
+
+    std::map<int, CacheStats> volumes;
+    for (size_t k = 0; k < stripes.size(); ++k) {
+      if (errors[k].isOK()) {
+        volumes[stripes[k]->stripe->_vol_idx] += stripes[k]->stats;
+      }
+    }
+    std::cout << "{\"volumes\": [";
+    for (auto const &[idx, stats] : volumes) {
+      std::cout << (idx == volumes.begin()->first ? "" : ",") << "\n  {\"volume\": " << idx << ", ";
+      stats.write_json(std::cout, headers);
+      std::cout << "}";
+    }
+    std::cout << "],\n\"stripes\": [";
+    for (size_t k = 0; k < stripes.size(); ++k) {
+      CacheAnalyze const &a = *stripes[k];
+      std::cout << (k ? "," : "") << "\n  {\"stripe\": ";
+      write_json_string(std::cout, a.stripe->hashText);
+      std::cout << ", \"volume\": " << static_cast<int>(a.stripe->_vol_idx);
+      if (!errors[k].isOK()) {
+        std::ostringstream text;
+        text << errors[k];
+        std::cout << ", \"error\": ";
+        write_json_string(std::cout, text.str());
+      } else {
+        std::cout << ", \"layout\": \"" << (a.segmented ? "segmented" : "cyclic") << (a.wide_tags ? ", wide tags" : "") << "\", ";
+        a.stats.write_json(std::cout, headers);
+      }
+      std::cout << "}";
+    }
+    std::cout << "]}" << std::endl;
+  }
+}
+
 int
 main(int argc, const char *argv[])
 {
@@ -1376,7 +1463,8 @@ main(int argc, const char *argv[])
     .add_option("--write", "-w", "")
     .add_option("--input", "-i", "", "", 1)
     .add_option("--device", "-d", "", "", 1)
-    .add_option("--aos", "-o", "", "", 1);
+    .add_option("--aos", "-o", "", "", 1)
+    .add_option("--threads", "-t", "Number of threads for analyze, one per CPU by default", "", 1);
 
   parser.add_command("list", "List elements of the cache", []() { List_Stripes(Cache::SpanDumpDepth::SPAN); })
     .add_command("stripes", "List the stripes", []() { List_Stripes(Cache::SpanDumpDepth::STRIPE); });
@@ -1397,6 +1485,11 @@ main(int argc, const char *argv[])
   parser.add_command("init", " Initializes uninitialized span", [&]() { Init_disk(input_url_file); });
   parser.add_command("scan", " Scans the whole cache and lists the urls of the cached contents",
                      [&]() { Scan_Cache(input_url_file); });
+  parser
+    .add_command("analyze", " Reports statistics of the cached objects from the stripe directories",
+                 []() { Analyze_Cache(false); })
+    .add_command("headers", "Also read the first fragment of each object for its alternates, size and age",
+                 []() { Analyze_Cache(true); });
 
   // parse the arguments
   auto arguments = parser.parse(argv);
@@ -1412,6 +1505,9 @@ main(int argc, const char *argv[])
   if (auto data = arguments.get("aos")) {
     cache_config_min_average_object_size = std::stoi(data.value());
   }
+  if (auto data = arguments.get("threads")) {
+    AnalyzeThreads = std::stoi(data.value());
+  }
   if (auto data = arguments.get("device")) {
     inputFile = data.value();
   }
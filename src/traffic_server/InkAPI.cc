@@ -26,6 +26,7 @@
 #include <string_view>
 #include <tuple>
 #include <unordered_map>
+#include <vector>
 #include <string_view>
 
 #include "tscore/ink_platform.h"
@@ -7607,6 +7608,41 @@ TSCacheRead(TSCont contp, TSCacheKey key)
   return (TSAction)cacheProcessor.open_read(i, &info->cache_key, info->frag_type, info->hostname, info->len);
 }
 
+void
+TSCacheReadBatch(TSCont *contps, TSCacheKey *keys, TSAction *actions, int nkeys)
+{
+  sdk_assert(nkeys >= 0);
+  if (nkeys == 0) {
+    return;
+  }
+  sdk_assert(sdk_sanity_check_null_ptr((void *)contps) == TS_SUCCESS);
+  sdk_assert(sdk_sanity_check_null_ptr((void *)keys) == TS_SUCCESS);
+
+  FORCE_PLUGIN_SCOPED_MUTEX(contps[0]);
+
+  std::vector<CacheReadRequest> reqs(nkeys);
+  CacheFragType frag_type = ((CacheInfo *)keys[0])->frag_type;
+
+  for (int i = 0; i < nkeys; i++) {
+    sdk_assert(sdk_sanity_check_iocore_structure(contps[i]) == TS_SUCCESS);
+    sdk_assert(sdk_sanity_check_cachekey(keys[i]) == TS_SUCCESS);
+
+    CacheInfo *info = (CacheInfo *)keys[i];
+    sdk_assert(((INKContInternal *)contps[i])->mutex == ((INKContInternal *)contps[0])->mutex);
+    sdk_assert(info->frag_type == frag_type);
+    reqs[i].cont     = (INKContInternal *)contps[i];
+    reqs[i].key      = &info->cache_key;
+    reqs[i].hostname = info->hostname;
+    reqs[i].host_len = info->len;
+  }
+  cacheProcessor.open_read_batch(reqs.data(), nkeys, frag_type);
+  if (actions) {
+    for (int i = 0; i < nkeys; i++) {
+      actions[i] = (TSAction)reqs[i].action;
+    }
+  }
+}
+
 TSAction
 TSCacheWrite(TSCont contp, TSCacheKey key)
 {
@@ -8487,7 +8523,7 @@ TSAIOWrite(int fd, off_t offset, char *buf, const size_t bufSize, TSCont contp)
 TSReturnCode
 TSAIOThreadNumSet(int thread_num)
 {
-#if AIO_MODE == AIO_MODE_NATIVE
+#if AIO_MODE == AIO_MODE_NATIVE || AIO_MODE == AIO_MODE_IO_URING
   (void)thread_num;
   return TS_SUCCESS;
 #else
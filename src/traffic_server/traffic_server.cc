@@ -2235,6 +2235,7 @@ main(int /* argc ATS_UNUSED */, const char **argv)
 
 static void mgmt_restart_shutdown_callback(ts::MemSpan<void>)
 {
+  ram_cache_snapshot_on_shutdown();
   sync_cache_dir_on_shutdown();
 }
 
@@ -23,6 +23,7 @@
 #include <sys/mman.h>
 #include "tscore/Diags.h"
 #include "tscore/ink_align.h"
+#include "tscore/ink_memory.h"
 
 #define DEBUG_TAG "hugepages"
 
@@ -34,6 +35,58 @@
 
 static int hugepage_size = -1;
 static bool hugepage_enabled;
+
+#ifndef MAP_HUGE_SHIFT
+#define MAP_HUGE_SHIFT 26
+#endif
+
+// The default hugepage size from /proc/meminfo, 0 if there is none.
+static size_t
+read_hugepage_size()
+{
+  FILE *fp;
+  char line[LINE_SIZE];
+  char *p, *ep;
+  size_t size = 0;
+
+  fp = fopen(MEMINFO_PATH, "r");
+
+  if (fp == nullptr) {
+    Debug(DEBUG_TAG "_init", "Cannot open file %s", MEMINFO_PATH);
+    return 0;
+  }
+
+  while (fgets(line, sizeof(line), fp)) {
+    if (strncmp(line, TOKEN, TOKEN_SIZE) == 0) {
+      p = line + TOKEN_SIZE;
+      while (*p == ' ') {
+        p++;
+      }
+      size = strtol(p, &ep, 10);
+      // What other values can this be?
+      if (strncmp(ep, " kB", 4)) {
+        size *= 1024;
+      }
+      break;
+    }
+  }
+
+  fclose(fp);
+  return size;
+}
+
+// Map @a size bytes of hugepages of @a page_size bytes, or of the default size if @a page_size is 0.
+static void *
+hugepage_mmap(size_t size, size_t page_size)
+{
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB;
+
+  if (page_size) {
+    flags |= (__builtin_ctzll(page_size) << MAP_HUGE_SHIFT);
+  }
+  void *mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return mem == MAP_FAILED ? nullptr : mem;
+}
 #endif
 
 size_t
@@ -61,10 +114,6 @@ void
 ats_hugepage_init(int enabled)
 {
 #ifdef MAP_HUGETLB
-  FILE *fp;
-  char line[LINE_SIZE];
-  char *p, *ep;
-
   hugepage_size = 0;
 
   if (!enabled) {
@@ -72,29 +121,7 @@ ats_hugepage_init(int enabled)
     return;
   }
 
-  fp = fopen(MEMINFO_PATH, "r");
-
-  if (fp == nullptr) {
-    Debug(DEBUG_TAG "_init", "Cannot open file %s", MEMINFO_PATH);
-    return;
-  }
-
-  while (fgets(line, sizeof(line), fp)) {
-    if (strncmp(line, TOKEN, TOKEN_SIZE) == 0) {
-      p = line + TOKEN_SIZE;
-      while (*p == ' ') {
-        p++;
-      }
-      hugepage_size = strtol(p, &ep, 10);
-      // What other values can this be?
-      if (strncmp(ep, " kB", 4)) {
-        hugepage_size *= 1024;
-      }
-      break;
-    }
-  }
-
-  fclose(fp);
+  hugepage_size = read_hugepage_size();
 
   if (hugepage_size) {
     hugepage_enabled = true;
@@ -146,3 +173,44 @@ ats_free_hugepage(void *ptr, size_t s)
   return false;
 #endif
 }
+
+void *
+ats_alloc_hugepage_sized(size_t s, size_t page_size, size_t *actual)
+{
+  void *mem = nullptr;
+
+  *actual = 0;
+#ifdef MAP_HUGETLB
+  static size_t default_size = read_hugepage_size();
+
+  if (page_size && (mem = hugepage_mmap(INK_ALIGN(s, page_size), page_size)) != nullptr) {
+    *actual = page_size;
+  } else if (default_size && default_size != page_size &&
+             (mem = hugepage_mmap(INK_ALIGN(s, default_size), 0)) != nullptr) {
+    *actual = default_size;
+  }
+  if (mem) {
+    Debug(DEBUG_TAG, "Request/Allocation (%zu/%zu) {%p} on %zu byte pages", s, INK_ALIGN(s, *actual), mem, *actual);
+    return mem;
+  }
+  Debug(DEBUG_TAG, "Could not allocate %zu bytes of hugepages, falling back to transparent hugepages", s);
+#else
+  (void)page_size;
+#endif
+
+  // Transparent hugepages, if the kernel will give them to us.
+  mem = mmap(nullptr, INK_ALIGN(s, ats_pagesize()), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mem == MAP_FAILED) {
+    return nullptr;
+  }
+#ifdef MADV_HUGEPAGE
+  ats_madvise(static_cast<caddr_t>(mem), INK_ALIGN(s, ats_pagesize()), MADV_HUGEPAGE);
+#endif
+  return mem;
+}
+
+bool
+ats_free_hugepage_sized(void *ptr, size_t s, size_t actual)
+{
+  return munmap(ptr, INK_ALIGN(s, actual ? actual : ats_pagesize())) == 0;
+}
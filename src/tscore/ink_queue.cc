@@ -164,6 +164,15 @@ ink_freelist_madvise_init(InkFreeList **fl, const char *name, uint32_t type_size
   (*fl)->advice = advice;
 }
 
+void
+ink_freelist_hugepage_init(InkFreeList *f, uint32_t page_size)
+{
+  // Fill whole hugepages with each chunk.
+  f->chunk_size    = INK_ALIGN(f->chunk_size * f->type_size, page_size) / f->type_size;
+  f->hugepage_size = page_size;
+  Debug(DEBUG_TAG "_init", "<%s> Chunk Size on %" PRIu32 " byte hugepages %" PRIu32, f->name, page_size, f->chunk_size);
+}
+
 InkFreeList *
 ink_freelist_create(const char *name, uint32_t type_size, uint32_t chunk_size, uint32_t alignment)
 {
@@ -206,7 +215,11 @@ freelist_new(InkFreeList *f)
       size_t alloc_size = f->chunk_size * f->type_size;
       size_t alignment  = 0;
 
-      if (ats_hugepage_enabled()) {
+      if (f->hugepage_size) {
+        size_t actual;
+        newp      = ats_alloc_hugepage_sized(alloc_size, f->hugepage_size, &actual);
+        alignment = actual ? actual : ats_pagesize();
+      } else if (ats_hugepage_enabled()) {
         alignment = ats_hugepage_size();
         newp      = ats_alloc_hugepage(alloc_size);
       }